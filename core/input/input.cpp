@@ -769,6 +769,10 @@ void Input::_parse_input_event_impl(const Ref<InputEvent> &p_event, bool p_is_em
 		}
 	}
 
+	if (event_monitor_function) {
+		event_monitor_function(event_monitor_userdata, p_event, true);
+	}
+
 	if (event_dispatch_function) {
 		_THREAD_SAFE_UNLOCK_
 		event_dispatch_function(p_event);
@@ -996,6 +1000,10 @@ void Input::parse_input_event(const Ref<InputEvent> &p_event) {
 
 	ERR_FAIL_COND(p_event.is_null());
 
+	if (event_monitor_function) {
+		event_monitor_function(event_monitor_userdata, p_event, false);
+	}
+
 #ifdef DEBUG_ENABLED
 	uint64_t curr_frame = Engine::get_singleton()->get_process_frames();
 	if (curr_frame != last_parsed_frame) {
@@ -1092,6 +1100,17 @@ void Input::set_event_dispatch_function(EventDispatchFunc p_function) {
 	event_dispatch_function = p_function;
 }
 
+void Input::set_event_monitor_function(EventMonitorFunc p_function, void *p_userdata) {
+	_THREAD_SAFE_METHOD_
+
+	event_monitor_function = p_function;
+	event_monitor_userdata = p_userdata;
+}
+
+Input::EventMonitorFunc Input::get_event_monitor_function() const {
+	return event_monitor_function;
+}
+
 void Input::joy_button(int p_device, JoyButton p_button, bool p_pressed, uint64_t p_timestamp) {
 	_THREAD_SAFE_METHOD_;
 	Joypad &joy = joy_names[p_device];
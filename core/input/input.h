@@ -82,6 +82,9 @@ public:
 	};
 
 	typedef void (*EventDispatchFunc)(const Ref<InputEvent> &p_event);
+	// Sees every event twice, when it's parsed and again right before it's dispatched (p_dispatched).
+	// Called with the input lock held, possibly from other threads.
+	typedef void (*EventMonitorFunc)(void *p_userdata, const Ref<InputEvent> &p_event, bool p_dispatched);
 
 private:
 	BitField<MouseButtonMask> mouse_button_mask;
@@ -263,6 +266,8 @@ private:
 	static void (*set_custom_mouse_cursor_func)(const Ref<Resource> &, CursorShape, const Vector2 &);
 
 	EventDispatchFunc event_dispatch_function = nullptr;
+	EventMonitorFunc event_monitor_function = nullptr;
+	void *event_monitor_userdata = nullptr;
 
 #ifndef DISABLE_DEPRECATED
 	void _vibrate_handheld_bind_compat_91143(int p_duration_ms = 500);
@@ -375,6 +380,8 @@ public:
 	void release_pressed_events();
 
 	void set_event_dispatch_function(EventDispatchFunc p_function);
+	void set_event_monitor_function(EventMonitorFunc p_function, void *p_userdata);
+	EventMonitorFunc get_event_monitor_function() const;
 
 	Input();
 	~Input();
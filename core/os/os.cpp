@@ -56,6 +56,10 @@ OS *OS::get_singleton() {
 	return singleton;
 }
 
+uint64_t OS::get_ticks_nsec() const {
+	return get_ticks_usec() * 1000ULL;
+}
+
 uint64_t OS::get_ticks_msec() const {
 	return get_ticks_usec() / 1000ULL;
 }
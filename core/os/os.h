@@ -238,6 +238,9 @@ public:
 	virtual void add_frame_delay(bool p_can_draw);
 
 	virtual uint64_t get_ticks_usec() const = 0;
+	// Same clock and origin as get_ticks_usec, at the best resolution the platform has.
+	// Input event timestamps and the audio clock are both measured against it.
+	virtual uint64_t get_ticks_nsec() const;
 	uint64_t get_ticks_msec() const;
 
 	virtual bool is_userfs_persistent() const { return true; }
@@ -48,7 +48,7 @@
 #endif
 
 #include "core/input/default_controller_mappings.h"
-#include "core/os/time.h"
+#include "core/os/os.h"
 #include "thirdparty/sdl_headers/SDL.h"
 
 JoypadSDL *JoypadSDL::singleton = nullptr;
@@ -90,9 +90,14 @@ void JoypadSDL::process_inputs_run() {
 			SDL_JoystickRumble(joy, weak, strong, ff_duration_ms);
 		}
 
+		// Axis values held back while the ring was full go out as soon as there's room again
+		_flush_axis_events(false);
+
 		SDL_Event e;
 		int has_event = SDL_WaitEventTimeout(&e, 16);
 		if (has_event != 0) {
+			// SDL's own event timestamps are in milliseconds, stamp in ticks as soon as we have the event instead
+			const uint64_t timestamp = OS::get_singleton()->get_ticks_usec();
 			switch (e.type) {
 				case SDL_JOYDEVICEADDED: {
 					JoypadEvent joypad_event;
@@ -131,8 +136,7 @@ void JoypadSDL::process_inputs_run() {
 					joypad_event.device_guid = StringName(String(guid));
 					joypad_event.device_supports_force_feedback = SDL_JoystickHasRumble(joy);
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_event(joypad_event);
 				} break;
 				case SDL_JOYDEVICEREMOVED: {
 					JoypadEvent joypad_event;
@@ -146,15 +150,14 @@ void JoypadSDL::process_inputs_run() {
 						SDL_JoystickClose(SDL_JoystickFromInstanceID(e.jdevice.which));
 					}
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_event(joypad_event);
 				} break;
 				case SDL_JOYAXISMOTION: {
 					if (SDL_GameControllerFromInstanceID(e.jbutton.which) != nullptr) {
 						continue;
 					}
 					JoypadEvent joypad_event;
-					joypad_event.timestamp = Time::get_singleton()->get_ticks_usec();
+					joypad_event.timestamp = timestamp;
 					joypad_event.type = JoypadEventType::AXIS;
 					// Godot joy axis constants are already intentionally the same as SDL's
 					joypad_event.axis = static_cast<JoyAxis>(e.jaxis.axis);
@@ -165,8 +168,7 @@ void JoypadSDL::process_inputs_run() {
 					joypad_event.value -= 0.5f;
 					joypad_event.value *= 2.0f;
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_axis_event(joypad_event);
 				} break;
 				case SDL_JOYBUTTONUP:
 				case SDL_JOYBUTTONDOWN: {
@@ -174,7 +176,7 @@ void JoypadSDL::process_inputs_run() {
 						continue;
 					}
 					JoypadEvent joypad_event;
-					joypad_event.timestamp = Time::get_singleton()->get_ticks_usec();
+					joypad_event.timestamp = timestamp;
 					joypad_event.type = JoypadEventType::BUTTON;
 					joypad_event.sdl_joystick_instance_id = e.jbutton.which;
 					joypad_event.pressed = e.jbutton.state == SDL_PRESSED;
@@ -182,8 +184,7 @@ void JoypadSDL::process_inputs_run() {
 					// Godot button constants are intentionally the same as SDL's, so we can just straight up use them
 					joypad_event.button = static_cast<JoyButton>(e.jbutton.button);
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_event(joypad_event);
 				} break;
 				case SDL_JOYHATMOTION: {
 					if (SDL_GameControllerFromInstanceID(e.jbutton.which) != nullptr) {
@@ -191,17 +192,16 @@ void JoypadSDL::process_inputs_run() {
 					}
 					// Godot hat masks are identical to SDL hat masks, so we can just use them as-is.
 					JoypadEvent joypad_event;
-					joypad_event.timestamp = Time::get_singleton()->get_ticks_usec();
+					joypad_event.timestamp = timestamp;
 					joypad_event.type = JoypadEventType::HAT;
 					joypad_event.hat_mask = e.jhat.value;
 					joypad_event.sdl_joystick_instance_id = e.jhat.which;
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_event(joypad_event);
 				} break;
 				case SDL_CONTROLLERAXISMOTION: {
 					JoypadEvent joypad_event;
-					joypad_event.timestamp = Time::get_singleton()->get_ticks_usec();
+					joypad_event.timestamp = timestamp;
 					joypad_event.type = JoypadEventType::AXIS;
 					// Godot joy axis constants are already intentionally the same as SDL's
 					joypad_event.axis = static_cast<JoyAxis>(e.caxis.axis);
@@ -218,14 +218,13 @@ void JoypadSDL::process_inputs_run() {
 						joypad_event.value *= 2.0f;
 					}
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_axis_event(joypad_event);
 				} break;
 				// Do note SDL game controllers do not have separate events for the dpad
 				case SDL_CONTROLLERBUTTONUP:
 				case SDL_CONTROLLERBUTTONDOWN: {
 					JoypadEvent joypad_event;
-					joypad_event.timestamp = Time::get_singleton()->get_ticks_usec();
+					joypad_event.timestamp = timestamp;
 					joypad_event.type = JoypadEventType::BUTTON;
 					joypad_event.sdl_joystick_instance_id = e.cbutton.which;
 					joypad_event.pressed = e.cbutton.state == SDL_PRESSED;
@@ -233,14 +232,84 @@ void JoypadSDL::process_inputs_run() {
 					// Godot button constants are intentionally the same as SDL's, so we can just straight up use them
 					joypad_event.button = static_cast<JoyButton>(e.cbutton.button);
 
-					MutexLock lock(joypad_event_queue_lock);
-					joypad_event_queue.push_back(joypad_event);
+					_push_event(joypad_event);
 				} break;
 			}
 		}
 	}
 }
 
+bool JoypadSDL::_wait_for_ring_slot() {
+	while (event_ring_head.get() - event_ring_tail.get() >= EVENT_RING_SIZE) {
+		if (process_inputs_exit.is_set()) {
+			return false;
+		}
+		OS::get_singleton()->delay_usec(1000);
+	}
+	return true;
+}
+
+void JoypadSDL::_write_ring_slot(const JoypadEvent &p_event) {
+	const uint32_t head = event_ring_head.get();
+	event_ring[head & EVENT_RING_MASK] = p_event;
+	// Publishes the slot, the main thread won't look at it before this
+	event_ring_head.set(head + 1);
+	event_queue_high_water.exchange_if_greater(head + 1 - event_ring_tail.get());
+}
+
+bool JoypadSDL::_flush_axis_events(bool p_wait) {
+	uint32_t flushed = 0;
+	for (; flushed < pending_axis_events.size(); flushed++) {
+		if (event_ring_head.get() - event_ring_tail.get() >= EVENT_RING_SIZE && (!p_wait || !_wait_for_ring_slot())) {
+			break;
+		}
+		_write_ring_slot(pending_axis_events[flushed]);
+	}
+	if (flushed == pending_axis_events.size()) {
+		pending_axis_events.clear();
+		return true;
+	}
+	// Keeps the rest in order for the next flush
+	for (uint32_t i = flushed; i < pending_axis_events.size(); i++) {
+		pending_axis_events[i - flushed] = pending_axis_events[i];
+	}
+	pending_axis_events.resize(pending_axis_events.size() - flushed);
+	return false;
+}
+
+void JoypadSDL::_push_axis_event(const JoypadEvent &p_event) {
+	for (JoypadEvent &pending : pending_axis_events) {
+		if (pending.sdl_joystick_instance_id == p_event.sdl_joystick_instance_id && pending.axis == p_event.axis) {
+			// Only the latest position of an axis matters, the one it replaces never reaches the main thread
+			pending = p_event;
+			dropped_event_count.increment();
+			_flush_axis_events(false);
+			return;
+		}
+	}
+	pending_axis_events.push_back(p_event);
+	_flush_axis_events(false);
+}
+
+bool JoypadSDL::_push_event(const JoypadEvent &p_event) {
+	// Axis values that came first go first, so the main thread sees everything in order
+	if (!_flush_axis_events(true) || !_wait_for_ring_slot()) {
+		// Only while shutting down
+		dropped_event_count.increment();
+		return false;
+	}
+	_write_ring_slot(p_event);
+	return true;
+}
+
+uint64_t JoypadSDL::get_dropped_event_count() const {
+	return dropped_event_count.get();
+}
+
+uint32_t JoypadSDL::get_event_queue_high_water() const {
+	return event_queue_high_water.get();
+}
+
 void JoypadSDL::joypad_vibration_start(int p_pad_idx, float p_weak, float p_strong, float p_duration, uint64_t p_timestamp) {
 	Joypad &pad = joypads[p_pad_idx];
 
@@ -329,14 +398,12 @@ Error JoypadSDL::initialize() {
 }
 
 void JoypadSDL::process_events() {
-	Vector<JoypadEvent> events;
-	joypad_event_queue_lock.lock();
-	events = joypad_event_queue;
-	joypad_event_queue.clear();
-	joypad_event_queue_lock.unlock();
+	// Only what was queued when we started is handled, so a busy device can't keep us here
+	const uint32_t head = event_ring_head.get();
+	uint32_t tail = event_ring_tail.get();
 
-	for (int i = 0; i < events.size(); i++) {
-		JoypadEvent event = events[i];
+	for (; tail != head; tail++) {
+		JoypadEvent &event = event_ring[tail & EVENT_RING_MASK];
 
 		switch (event.type) {
 			case DEVICE_ADDED: {
@@ -393,6 +460,15 @@ void JoypadSDL::process_events() {
 			} break;
 		}
 	}
+	// Hand the slots back to the polling thread only once we are done reading them
+	event_ring_tail.set(tail);
+
+	const uint64_t dropped = dropped_event_count.get();
+	if (dropped != reported_dropped_event_count) {
+		print_verbose(vformat("SDL: Joypad event queue overflowed, %d axis values superseded so far.", dropped));
+		reported_dropped_event_count = dropped;
+	}
+
 	for (int i = 0; i < Input::JOYPADS_MAX; i++) {
 		Joypad &joy = joypads[i];
 		if (joy.attached && joy.supports_force_feedback) {
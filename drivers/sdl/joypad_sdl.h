@@ -35,6 +35,8 @@
 
 #include "core/input/input.h"
 #include "core/os/thread.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 
 typedef int32_t SDL_JoystickID;
 
@@ -94,8 +96,30 @@ class JoypadSDL {
 		};
 	};
 
-	Vector<JoypadEvent> joypad_event_queue;
-	Mutex joypad_event_queue_lock;
+	// Single producer (the polling thread), single consumer (process_events) ring, head and tail only ever
+	// increase and are masked into the ring, so neither side takes a lock or allocates.
+	static constexpr uint32_t EVENT_RING_SIZE = 2048;
+	static constexpr uint32_t EVENT_RING_MASK = EVENT_RING_SIZE - 1;
+	static_assert((EVENT_RING_SIZE & EVENT_RING_MASK) == 0, "EVENT_RING_SIZE must be a power of two.");
+	JoypadEvent event_ring[EVENT_RING_SIZE];
+	// Padded apart since each is written by a different thread (memnew doesn't honor alignas)
+	SafeNumeric<uint32_t> event_ring_head;
+	uint8_t event_ring_head_padding[64];
+	SafeNumeric<uint32_t> event_ring_tail;
+	uint8_t event_ring_tail_padding[64];
+	SafeNumeric<uint64_t> dropped_event_count;
+	SafeNumeric<uint32_t> event_queue_high_water;
+	uint64_t reported_dropped_event_count = 0;
+	// Axis events that didn't fit in the ring, at most one per axis, only touched by the polling thread
+	LocalVector<JoypadEvent> pending_axis_events;
+
+	bool _wait_for_ring_slot();
+	void _write_ring_slot(const JoypadEvent &p_event);
+	bool _flush_axis_events(bool p_wait);
+	// Axis events are coalesced to the latest value per axis when the ring is full,
+	// everything else waits for room since a lost button release or device change can't be recovered
+	void _push_axis_event(const JoypadEvent &p_event);
+	bool _push_event(const JoypadEvent &p_event);
 
 	SafeFlag process_inputs_exit;
 	Thread process_inputs_thread;
@@ -112,6 +136,10 @@ public:
 	bool is_device_game_controller(int p_joy_device_idx) const;
 	StringName get_device_guid(int p_joy_device_idx) const;
 
+	// Axis values superseded because the main thread fell behind, and the most events ever waiting at once
+	uint64_t get_dropped_event_count() const;
+	uint32_t get_event_queue_high_water() const;
+
 	JoypadSDL(Input *in);
 	~JoypadSDL();
 };
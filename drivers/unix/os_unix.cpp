@@ -307,6 +307,48 @@ uint64_t OS_Unix::get_ticks_usec() const {
 	return longtime;
 }
 
+uint64_t OS_Unix::get_ticks_nsec() const {
+#if defined(__APPLE__)
+	uint64_t longtime = mach_absolute_time() * (_clock_scale * 1000.0);
+#else
+	struct timespec tv_now = { 0, 0 };
+	clock_gettime(GODOT_CLOCK, &tv_now);
+	uint64_t longtime = (uint64_t)tv_now.tv_nsec + (uint64_t)tv_now.tv_sec * 1000000000L;
+#endif
+	longtime -= _clock_start * 1000L;
+
+	return longtime;
+}
+
+#if !defined(__APPLE__)
+uint64_t OS_Unix::clock_monotonic_to_ticks_usec(uint64_t p_monotonic_usec) {
+	struct timespec tv_now = { 0, 0 };
+	clock_gettime(CLOCK_MONOTONIC, &tv_now);
+	uint64_t monotonic_now = ((uint64_t)tv_now.tv_nsec / 1000L) + (uint64_t)tv_now.tv_sec * 1000000L;
+	uint64_t ticks_now = OS::get_singleton()->get_ticks_usec();
+
+	// The two clocks only differ by NTP slewing, which is negligible over the age of an input event,
+	// so going back from now by the event's age is accurate.
+	if (p_monotonic_usec >= monotonic_now) {
+		return ticks_now;
+	}
+	uint64_t age = monotonic_now - p_monotonic_usec;
+	return age < ticks_now ? ticks_now - age : 0;
+}
+
+uint64_t OS_Unix::clock_monotonic_msec_to_ticks_usec(uint32_t p_monotonic_msec, uint32_t p_max_age_msec) {
+	struct timespec tv_now = { 0, 0 };
+	clock_gettime(CLOCK_MONOTONIC, &tv_now);
+	uint64_t now_msec = (uint64_t)tv_now.tv_sec * 1000 + tv_now.tv_nsec / 1000000;
+	// Wraps along with the stamp every 49 days
+	uint32_t age_msec = (uint32_t)now_msec - p_monotonic_msec;
+	if (age_msec > p_max_age_msec) {
+		return 0;
+	}
+	return clock_monotonic_to_ticks_usec((now_msec - age_msec) * 1000);
+}
+#endif
+
 Dictionary OS_Unix::get_memory_info() const {
 	Dictionary meminfo;
 
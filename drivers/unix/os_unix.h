@@ -79,6 +79,14 @@ public:
 
 	virtual void delay_usec(uint32_t p_usec) const override;
 	virtual uint64_t get_ticks_usec() const override;
+	virtual uint64_t get_ticks_nsec() const override;
+#if !defined(__APPLE__)
+	// Converts a CLOCK_MONOTONIC time (what evdev and the X server stamp events with) to get_ticks_usec time
+	static uint64_t clock_monotonic_to_ticks_usec(uint64_t p_monotonic_usec);
+	// Same for the 32-bit millisecond CLOCK_MONOTONIC stamps X11 and Wayland events carry. Returns 0 for stamps
+	// older than p_max_age_msec, which are taken to come from a server on another clock.
+	static uint64_t clock_monotonic_msec_to_ticks_usec(uint32_t p_monotonic_msec, uint32_t p_max_age_msec);
+#endif
 
 	virtual Dictionary get_memory_info() const override;
 
@@ -2698,6 +2698,7 @@ Error Main::setup2(bool p_show_boot_logo) {
 		OS::get_singleton()->benchmark_begin_measure("Servers", "Input");
 
 		input = memnew(Input);
+		GLOBAL_DEF_RST("input_devices/keyboard/use_evdev_timestamps", false);
 		OS::get_singleton()->initialize_joypads();
 
 		OS::get_singleton()->benchmark_end_measure("Servers", "Input");
@@ -62,6 +62,7 @@ public:
 	void apply_to_skeleton(Skeleton3D *p_skel);
 
 	friend class DIVABoneDB;
+	friend class DIVAMotion;
 };
 
 class DIVABoneDB : public RefCounted {
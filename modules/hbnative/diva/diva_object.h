@@ -89,7 +89,7 @@ class DIVAObjectSet : public RefCounted {
 		uint32_t material;
 		uint8_t uv_indices[8];
 		LocalVector<uint16_t> bone_index_array;
-		LocalVector<int32_t> index_array;
+		PackedInt32Array index_array;
 	};
 
 	struct DIVAMesh {
@@ -125,12 +125,21 @@ class DIVAObjectSet : public RefCounted {
 	LocalVector<DIVAObject> objects;
 	HashMap<StringName, int> name_to_object_map;
 
-	static void read_submesh_indices(DIVASubmesh *p_submesh, uint32_t p_index_count, Ref<StreamPeerBuffer> p_spb);
-	static void read_submesh(DIVASubmesh *p_submesh, Ref<StreamPeerBuffer> p_spb, uint32_t p_base_offset);
-	static void read_model_vertex_data(DIVAMesh *p_mesh, Ref<StreamPeerBuffer> p_spb, uint32_t p_base_offset, uint32_t p_vertex_offsets[20], uint32_t p_vertex_count, uint32_t p_vertex_format);
-	static void read_model_vertex_data_godot(DIVAMesh *p_mesh, Ref<StreamPeerBuffer> p_spb, uint32_t p_base_offset, uint32_t p_vertex_offsets[20], uint32_t p_vertex_count, uint32_t p_vertex_format);
-	static void read_mesh(DIVAMesh *p_mesh, Ref<StreamPeerBuffer> p_spb, uint32_t p_base_offset);
-	static void read_model(DIVAObject *p_obj, Ref<StreamPeerBuffer> p_spb, uint32_t p_base_offset);
+	// A mesh waiting to be read, meshes don't depend on each other so they are read in parallel
+	struct MeshReadJob {
+		DIVAMesh *mesh = nullptr;
+		const DIVAReadHelpers::Span *span = nullptr;
+		uint64_t mesh_offset = 0;
+		uint32_t base_offset = 0;
+	};
+
+	static void read_submesh_indices(DIVASubmesh *p_submesh, uint32_t p_index_count, const DIVAReadHelpers::Span &p_span, uint64_t p_offset);
+	static void read_submesh(DIVASubmesh *p_submesh, const DIVAReadHelpers::Span &p_span, uint64_t p_offset, uint32_t p_base_offset);
+	static void read_model_vertex_data(DIVAMesh *p_mesh, const DIVAReadHelpers::Span &p_span, uint32_t p_base_offset, uint32_t p_vertex_offsets[20], uint32_t p_vertex_count, uint32_t p_vertex_format);
+	static void read_model_vertex_data_godot(DIVAMesh *p_mesh, const DIVAReadHelpers::Span &p_span, uint32_t p_base_offset, uint32_t p_vertex_offsets[20], uint32_t p_vertex_count, uint32_t p_vertex_format);
+	static void read_mesh(DIVAMesh *p_mesh, const DIVAReadHelpers::Span &p_span, uint64_t p_offset, uint32_t p_base_offset);
+	static void read_model(DIVAObject *p_obj, const DIVAReadHelpers::Span &p_span, uint32_t p_base_offset, LocalVector<MeshReadJob> &r_mesh_jobs);
+	static void _read_mesh_task(void *p_userdata, uint32_t p_index);
 
 protected:
 	static void _bind_methods();
@@ -218,8 +227,7 @@ public:
 			}
 
 			for (const DIVASubmesh &submesh : mesh.submeshes) {
-				PackedInt32Array lv = submesh.index_array;
-				mesh_data[ArrayMesh::ARRAY_INDEX] = lv;
+				mesh_data[ArrayMesh::ARRAY_INDEX] = submesh.index_array;
 				am->add_surface_from_arrays(diva_primitive_to_godot(submesh.primitive), mesh_data, TypedArray<Array>(), Dictionary(), mesh.godot_vertex_data.format);
 			}
 			meshes.push_back(am);
@@ -23,9 +23,9 @@ DIVACharacter ModuleTable::get_character(const StringName &p_key) {
 	return i->value;
 }
 
-void ModuleTable::parse(const String &p_text, const Ref<DIVASpriteDB> &p_sprite_db) {
+void ModuleTable::parse(const PackedByteArray &p_data, const String &p_index_path, const Ref<DIVASpriteDB> &p_sprite_db) {
 	KVTable table;
-	table.parse(p_text);
+	table.parse_utf8_cached(p_data.ptr(), p_data.size(), p_index_path);
 
 	const static StringName module_sname = "module";
 	const static StringName id_sname = "id";
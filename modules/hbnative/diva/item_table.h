@@ -114,7 +114,8 @@ class ModuleTable {
 
 	static DIVACharacter get_character(const StringName &p_key);
 
-	void parse(const String &p_text, const Ref<DIVASpriteDB> &p_sprite_db);
+	// p_data is the raw module_tbl text, its parsed index is cached at p_index_path (usually under user://)
+	void parse(const PackedByteArray &p_data, const String &p_index_path, const Ref<DIVASpriteDB> &p_sprite_db);
 };
 
 // Per-character item table
@@ -154,9 +155,10 @@ class DIVAItemTable : public RefCounted {
 	HashMap<uint32_t, int> item_number_to_idx;
 
 public:
-	void parse(const String p_text) {
+	// p_data is the raw item table text, its parsed index is cached at p_index_path (usually under user://)
+	void parse(const PackedByteArray &p_data, const String &p_index_path) {
 		KVTable table;
-		table.parse(p_text);
+		table.parse_utf8_cached(p_data.ptr(), p_data.size(), p_index_path);
 
 		static const StringName cos_sname = "cos";
 		static const StringName item_sname = "item";
@@ -0,0 +1,392 @@
+#include "kv_table.h"
+#include "core/io/file_access.h"
+#include "core/templates/hashfuncs.h"
+
+static const uint32_t PATH_HASH_SEED = 5381;
+
+static int encode_utf8(char32_t p_char, uint8_t *r_bytes) {
+	if (p_char < 0x80) {
+		r_bytes[0] = p_char;
+		return 1;
+	} else if (p_char < 0x800) {
+		r_bytes[0] = 0xC0 | (p_char >> 6);
+		r_bytes[1] = 0x80 | (p_char & 0x3F);
+		return 2;
+	} else if (p_char < 0x10000) {
+		r_bytes[0] = 0xE0 | (p_char >> 12);
+		r_bytes[1] = 0x80 | ((p_char >> 6) & 0x3F);
+		r_bytes[2] = 0x80 | (p_char & 0x3F);
+		return 3;
+	}
+	r_bytes[0] = 0xF0 | ((p_char >> 18) & 0x07);
+	r_bytes[1] = 0x80 | ((p_char >> 12) & 0x3F);
+	r_bytes[2] = 0x80 | ((p_char >> 6) & 0x3F);
+	r_bytes[3] = 0x80 | (p_char & 0x3F);
+	return 4;
+}
+
+// Lookups hash their String keys as UTF-8 on the fly so they land on the same buckets as the parsed bytes
+uint32_t KVTable::_hash_utf8(const String &p_string, uint32_t p_hash) {
+	uint8_t bytes[4];
+	for (int i = 0; i < p_string.length(); i++) {
+		p_hash = hash_djb2_buffer(bytes, encode_utf8(p_string[i], bytes), p_hash);
+	}
+	return p_hash;
+}
+
+bool KVTable::_equals_utf8(const uint8_t *p_bytes, uint32_t p_length, const String &p_string) {
+	uint8_t bytes[4];
+	uint32_t position = 0;
+	for (int i = 0; i < p_string.length(); i++) {
+		int byte_count = encode_utf8(p_string[i], bytes);
+		if (position + byte_count > p_length || memcmp(p_bytes + position, bytes, byte_count) != 0) {
+			return false;
+		}
+		position += byte_count;
+	}
+	return position == p_length;
+}
+
+uint32_t KVTable::hash_source(const uint8_t *p_data, uint64_t p_length) {
+	return hash_murmur3_buffer(p_data, p_length, hash_murmur3_one_64(p_length));
+}
+
+bool KVTable::_bind_blob() {
+	header = nullptr;
+	nodes = nullptr;
+	buckets = nullptr;
+	children = nullptr;
+	strings = nullptr;
+
+	ERR_FAIL_COND_V_MSG((uint64_t)blob.size() < sizeof(Header), false, "KV table index is too small.");
+	const Header *blob_header = (const Header *)blob.ptr();
+	ERR_FAIL_COND_V_MSG(blob_header->magic != INDEX_MAGIC || blob_header->version != INDEX_VERSION, false, "KV table index has the wrong signature or version.");
+	ERR_FAIL_COND_V_MSG(blob_header->bucket_count == 0 || (blob_header->bucket_count & (blob_header->bucket_count - 1)) != 0, false, "KV table index bucket count isn't a power of two.");
+	const uint64_t expected_size = sizeof(Header) + (uint64_t)blob_header->node_count * sizeof(Node) + ((uint64_t)blob_header->bucket_count + blob_header->child_count) * sizeof(uint32_t) + blob_header->string_size;
+	ERR_FAIL_COND_V_MSG((uint64_t)blob.size() != expected_size, false, "KV table index size doesn't match its header.");
+
+	const Node *blob_nodes = (const Node *)(blob.ptr() + sizeof(Header));
+	const uint32_t *blob_buckets = (const uint32_t *)(blob_nodes + blob_header->node_count);
+	const uint32_t *blob_children = blob_buckets + blob_header->bucket_count;
+
+	// Validated once here so lookups never have to
+	for (uint32_t i = 0; i < blob_header->node_count; i++) {
+		const Node &node = blob_nodes[i];
+		ERR_FAIL_COND_V((uint64_t)node.path_offset + node.path_length > blob_header->string_size, false);
+		ERR_FAIL_COND_V(node.name_offset < node.path_offset || node.name_offset > node.path_offset + node.path_length, false);
+		ERR_FAIL_COND_V((uint64_t)node.value_offset + node.value_length > blob_header->string_size, false);
+		ERR_FAIL_COND_V((uint64_t)node.children_start + node.children_count > blob_header->child_count, false);
+	}
+	for (uint32_t i = 0; i < blob_header->bucket_count; i++) {
+		ERR_FAIL_COND_V(blob_buckets[i] != EMPTY_BUCKET && blob_buckets[i] >= blob_header->node_count, false);
+	}
+	for (uint32_t i = 0; i < blob_header->child_count; i++) {
+		ERR_FAIL_COND_V(blob_children[i] >= blob_header->node_count, false);
+	}
+
+	header = blob_header;
+	nodes = blob_nodes;
+	buckets = blob_buckets;
+	children = blob_children;
+	strings = (const uint8_t *)(blob_children + blob_header->child_count);
+	return true;
+}
+
+void KVTable::_parse(const uint8_t *p_data, uint64_t p_length, uint32_t p_source_hash) {
+	LocalVector<Node> parsed_nodes;
+	// Children are kept as linked lists while parsing and flattened at the end, keeping their order
+	LocalVector<uint32_t> first_child;
+	LocalVector<uint32_t> last_child;
+	LocalVector<uint32_t> next_sibling;
+	LocalVector<uint8_t> arena;
+	LocalVector<uint32_t> table;
+	table.resize(256);
+	for (uint32_t &bucket : table) {
+		bucket = EMPTY_BUCKET;
+	}
+	uint32_t child_count = 0;
+
+	uint64_t line_start = 0;
+	while (line_start < p_length) {
+		uint64_t line_end = line_start;
+		while (line_end < p_length && p_data[line_end] != '\n') {
+			line_end++;
+		}
+		const uint64_t next_line = line_end + 1;
+
+		while (line_start < line_end && p_data[line_start] <= 32) {
+			line_start++;
+		}
+		while (line_end > line_start && p_data[line_end - 1] <= 32) {
+			line_end--;
+		}
+		const uint8_t *line = p_data + line_start;
+		const uint32_t line_length = line_end - line_start;
+		line_start = next_line;
+
+		if (line_length > 0 && line[0] == '#') {
+			continue;
+		}
+
+		// Lines with more than one = are ignored, just like lines with none
+		uint32_t equals = line_length;
+		bool valid = false;
+		for (uint32_t i = 0; i < line_length; i++) {
+			if (line[i] == '=') {
+				valid = equals == line_length;
+				equals = i;
+				if (!valid) {
+					break;
+				}
+			}
+		}
+		if (!valid) {
+			continue;
+		}
+
+		uint32_t parent = EMPTY_BUCKET;
+		uint32_t hash = PATH_HASH_SEED;
+		uint32_t segment_start = 0;
+		uint32_t hashed_until = 0;
+		while (true) {
+			uint32_t segment_end = segment_start;
+			while (segment_end < equals && line[segment_end] != '.') {
+				segment_end++;
+			}
+			// The hash always covers the whole path up to here, dots included
+			hash = hash_djb2_buffer(line + hashed_until, segment_end - hashed_until, hash);
+			hashed_until = segment_end;
+
+			const uint32_t mask = table.size() - 1;
+			uint32_t bucket = hash_fmix32(hash) & mask;
+			uint32_t node_idx = EMPTY_BUCKET;
+			while (table[bucket] != EMPTY_BUCKET) {
+				const Node &candidate = parsed_nodes[table[bucket]];
+				if (candidate.path_hash == hash && candidate.path_length == segment_end && memcmp(arena.ptr() + candidate.path_offset, line, segment_end) == 0) {
+					node_idx = table[bucket];
+					break;
+				}
+				bucket = (bucket + 1) & mask;
+			}
+
+			if (node_idx == EMPTY_BUCKET) {
+				// No existing node in this path, create it
+				node_idx = parsed_nodes.size();
+				Node node = {};
+				node.path_hash = hash;
+				node.path_offset = arena.size();
+				node.path_length = segment_end;
+				node.name_offset = node.path_offset + segment_start;
+				arena.resize(arena.size() + segment_end);
+				memcpy(arena.ptr() + node.path_offset, line, segment_end);
+				parsed_nodes.push_back(node);
+				first_child.push_back(EMPTY_BUCKET);
+				last_child.push_back(EMPTY_BUCKET);
+				next_sibling.push_back(EMPTY_BUCKET);
+
+				if (parent != EMPTY_BUCKET) {
+					if (last_child[parent] == EMPTY_BUCKET) {
+						first_child[parent] = node_idx;
+					} else {
+						next_sibling[last_child[parent]] = node_idx;
+					}
+					last_child[parent] = node_idx;
+					parsed_nodes[parent].children_count++;
+					child_count++;
+				}
+
+				table[bucket] = node_idx;
+				if (parsed_nodes.size() * 2 > table.size()) {
+					table.resize(table.size() * 2);
+					for (uint32_t &entry : table) {
+						entry = EMPTY_BUCKET;
+					}
+					const uint32_t new_mask = table.size() - 1;
+					for (uint32_t i = 0; i < parsed_nodes.size(); i++) {
+						uint32_t new_bucket = hash_fmix32(parsed_nodes[i].path_hash) & new_mask;
+						while (table[new_bucket] != EMPTY_BUCKET) {
+							new_bucket = (new_bucket + 1) & new_mask;
+						}
+						table[new_bucket] = i;
+					}
+				}
+			}
+
+			parent = node_idx;
+			if (segment_end == equals) {
+				break;
+			}
+			segment_start = segment_end + 1;
+		}
+
+		const uint32_t value_length = line_length - equals - 1;
+		parsed_nodes[parent].value_offset = arena.size();
+		parsed_nodes[parent].value_length = value_length;
+		arena.resize(arena.size() + value_length);
+		memcpy(arena.ptr() + parsed_nodes[parent].value_offset, line + equals + 1, value_length);
+	}
+
+	Header blob_header = {};
+	blob_header.magic = INDEX_MAGIC;
+	blob_header.version = INDEX_VERSION;
+	blob_header.source_hash = p_source_hash;
+	blob_header.node_count = parsed_nodes.size();
+	blob_header.bucket_count = table.size();
+	blob_header.child_count = child_count;
+	blob_header.string_size = arena.size();
+
+	blob.resize(sizeof(Header) + parsed_nodes.size() * sizeof(Node) + (table.size() + child_count) * sizeof(uint32_t) + arena.size());
+	uint8_t *dst = blob.ptrw();
+	memcpy(dst, &blob_header, sizeof(Header));
+	Node *blob_nodes = (Node *)(dst + sizeof(Header));
+	uint32_t *blob_buckets = (uint32_t *)(blob_nodes + parsed_nodes.size());
+	uint32_t *blob_children = blob_buckets + table.size();
+
+	uint32_t children_written = 0;
+	for (uint32_t i = 0; i < parsed_nodes.size(); i++) {
+		parsed_nodes[i].children_start = children_written;
+		for (uint32_t child = first_child[i]; child != EMPTY_BUCKET; child = next_sibling[child]) {
+			blob_children[children_written++] = child;
+		}
+	}
+	memcpy(blob_nodes, parsed_nodes.ptr(), parsed_nodes.size() * sizeof(Node));
+	memcpy(blob_buckets, table.ptr(), table.size() * sizeof(uint32_t));
+	memcpy(blob_children + child_count, arena.ptr(), arena.size());
+
+	_bind_blob();
+}
+
+void KVTable::parse(const String &p_text) {
+	CharString text = p_text.utf8();
+	parse_utf8((const uint8_t *)text.get_data(), text.length());
+}
+
+void KVTable::parse_utf8(const uint8_t *p_data, uint64_t p_length) {
+	_parse(p_data, p_length, hash_source(p_data, p_length));
+}
+
+const PackedByteArray &KVTable::get_index_data() const {
+	return blob;
+}
+
+Error KVTable::set_index_data(const PackedByteArray &p_data) {
+	blob = p_data;
+	if (!_bind_blob()) {
+		blob.clear();
+		return ERR_FILE_CORRUPT;
+	}
+	return OK;
+}
+
+Error KVTable::save_index(const String &p_path) const {
+	ERR_FAIL_NULL_V_MSG(header, ERR_UNCONFIGURED, "Nothing was parsed.");
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, vformat("Couldn't open %s for writing.", p_path));
+	file->store_buffer(blob);
+	return OK;
+}
+
+Error KVTable::load_index(const String &p_path, uint32_t p_source_hash) {
+	if (!FileAccess::exists(p_path)) {
+		return ERR_FILE_NOT_FOUND;
+	}
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ, &err);
+	if (err != OK) {
+		return err;
+	}
+	Header file_header = {};
+	if (file->get_buffer((uint8_t *)&file_header, sizeof(Header)) != sizeof(Header) || file_header.magic != INDEX_MAGIC || file_header.version != INDEX_VERSION || file_header.source_hash != p_source_hash) {
+		return ERR_INVALID_DATA;
+	}
+	file->seek(0);
+	return set_index_data(file->get_buffer(file->get_length()));
+}
+
+void KVTable::parse_utf8_cached(const uint8_t *p_data, uint64_t p_length, const String &p_index_path) {
+	const uint32_t source_hash = hash_source(p_data, p_length);
+	if (load_index(p_index_path, source_hash) == OK) {
+		return;
+	}
+	_parse(p_data, p_length, source_hash);
+	Error err = save_index(p_index_path);
+	ERR_FAIL_COND_MSG(err != OK, vformat("Couldn't save KV table index to %s.", p_index_path));
+}
+
+uint32_t KVTable::_find(uint32_t p_hash, uint32_t p_parent, const String &p_suffix) const {
+	if (!header) {
+		return EMPTY_BUCKET;
+	}
+	const uint32_t prefix_length = p_parent != EMPTY_BUCKET ? nodes[p_parent].path_length + 1 : 0;
+	const uint32_t mask = header->bucket_count - 1;
+	uint32_t bucket = hash_fmix32(p_hash) & mask;
+	while (buckets[bucket] != EMPTY_BUCKET) {
+		const Node &candidate = nodes[buckets[bucket]];
+		if (candidate.path_hash == p_hash && candidate.path_length >= prefix_length) {
+			const uint8_t *path = strings + candidate.path_offset;
+			bool prefix_matches = p_parent == EMPTY_BUCKET || (memcmp(path, strings + nodes[p_parent].path_offset, prefix_length - 1) == 0 && path[prefix_length - 1] == '.');
+			if (prefix_matches && _equals_utf8(path + prefix_length, candidate.path_length - prefix_length, p_suffix)) {
+				return buckets[bucket];
+			}
+		}
+		bucket = (bucket + 1) & mask;
+	}
+	return EMPTY_BUCKET;
+}
+
+uint32_t KVTable::_find_path(const String &p_path) const {
+	return _find(_hash_utf8(p_path, PATH_HASH_SEED), EMPTY_BUCKET, p_path);
+}
+
+uint32_t KVTable::_find_child_key(const StringName &p_path, int p_child, const StringName &p_key) const {
+	uint32_t i = _find_path(p_path);
+	ERR_FAIL_COND_V(i == EMPTY_BUCKET, EMPTY_BUCKET);
+	ERR_FAIL_INDEX_V(p_child, (int)nodes[i].children_count, EMPTY_BUCKET);
+
+	uint32_t child = children[nodes[i].children_start + p_child];
+	const uint8_t dot = '.';
+	uint32_t hash = hash_djb2_buffer(&dot, 1, nodes[child].path_hash);
+	return _find(_hash_utf8(p_key, hash), child, p_key);
+}
+
+String KVTable::_get_string(uint32_t p_offset, uint32_t p_length) const {
+	return String::utf8((const char *)strings + p_offset, p_length);
+}
+
+int KVTable::get_children_count(const StringName &p_path) const {
+	uint32_t i = _find_path(p_path);
+	ERR_FAIL_COND_V(i == EMPTY_BUCKET, 0);
+	return nodes[i].children_count;
+}
+
+bool KVTable::has_key(const StringName &p_path) const {
+	return _find_path(p_path) != EMPTY_BUCKET;
+}
+
+StringName KVTable::child_get_path(const StringName &p_path, int p_child, const StringName &p_key) const {
+	uint32_t i = _find_child_key(p_path, p_child, p_key);
+	if (i == EMPTY_BUCKET) {
+		return "";
+	}
+	return StringName(_get_string(nodes[i].path_offset, nodes[i].path_length));
+}
+
+bool KVTable::child_has_key(const StringName &p_path, int p_child, const StringName &p_key) const {
+	return _find_child_key(p_path, p_child, p_key) != EMPTY_BUCKET;
+}
+
+String KVTable::child_get_value(const StringName &p_path, int p_child, const StringName &p_key) const {
+	uint32_t i = _find_child_key(p_path, p_child, p_key);
+	if (i == EMPTY_BUCKET) {
+		return "";
+	}
+	return _get_string(nodes[i].value_offset, nodes[i].value_length);
+}
+
+String KVTable::get_value(const StringName &p_path) const {
+	uint32_t i = _find_path(p_path);
+	ERR_FAIL_COND_V_MSG(i == EMPTY_BUCKET, "", vformat("Key %s not found", p_path));
+	ERR_FAIL_COND_V(nodes[i].children_count != 0, "");
+	return _get_string(nodes[i].value_offset, nodes[i].value_length);
+}
@@ -1,140 +1,83 @@
-
 #ifndef KV_TABLE_H
 #define KV_TABLE_H
 
 #include "core/error/error_macros.h"
 #include "core/string/ustring.h"
-#include "core/templates/hash_map.h"
 #include "core/templates/local_vector.h"
 #include "core/variant/variant.h"
 
+// Reader for the dotted key=value text tables (module_tbl, chritm_prop...).
+// Everything lives in a single blob: a node array, an open addressed table keyed by the hash of the
+// full path, a child index list and a string arena with every path and value. The blob is also the
+// on-disk index format, so loading a saved index is one read with nothing to rebuild.
 class KVTable {
-	struct KVTableNode {
-		String value;
-		StringName path;
-		StringName name;
-		Vector<StringName> children;
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t source_hash;
+		uint32_t node_count;
+		uint32_t bucket_count;
+		uint32_t child_count;
+		uint32_t string_size;
+		uint32_t reserved;
+	};
+	struct Node {
+		uint32_t path_hash;
+		// Full dotted path in the arena, the name is its last segment
+		uint32_t path_offset;
+		uint32_t path_length;
+		uint32_t name_offset;
+		uint32_t value_offset;
+		uint32_t value_length;
+		uint32_t children_start;
+		uint32_t children_count;
 	};
-	LocalVector<KVTableNode> nodes;
-	HashMap<StringName, int> key_values;
-
-public:
-	void parse(String p_text) {
-		PackedStringArray lines = p_text.split("\n");
-		for (const String &line : lines) {
-			const String line_stripped = line.strip_edges();
-			if (line_stripped.begins_with("#")) {
-				continue;
-			}
-			PackedStringArray parts = line_stripped.split("=");
-			if (parts.size() == 2) {
-				PackedStringArray property_parts = parts[0].split(".");
-				String property_accumulator;
-				KVTableNode *table_node = nullptr;
-				for (const String &property_part : property_parts) {
-					if (property_accumulator.is_empty()) {
-						property_accumulator += property_part;
-					} else {
-						property_accumulator += "." + property_part;
-					}
-					StringName property_accum_name = StringName(property_accumulator);
-					HashMap<StringName, int>::Iterator it = key_values.find(property_accum_name);
-					if (it == key_values.end()) {
-						// No existing node in this path, create it
-						KVTableNode node{
-							.path = property_accum_name,
-							.name = StringName(property_part),
-						};
-						if (table_node) {
-							// Add this node to parent
-							StringName parent_path = table_node->path;
-							nodes.push_back(node);
-							nodes[key_values[parent_path]].children.push_back(property_accum_name);
-						} else {
-							// Node is a root node, just add it
-							nodes.push_back(node);
-						}
-						key_values.insert(property_accum_name, nodes.size() - 1);
-						table_node = &nodes[nodes.size() - 1];
-					} else {
-						// Existing node in this path, store it and continue moving forward
-						table_node = &nodes[it->value];
-					}
-				}
-				if (table_node) {
-					table_node->value = parts[1];
-				}
-			}
-		}
-	}
-	int get_children_count(const StringName &p_path) const {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		Vector<const KVTableNode *> children;
-		ERR_FAIL_COND_V(it == key_values.end(), 0);
-		int i = it->value;
-		return nodes[i].children.size();
-	}
 
-	bool has_key(const StringName &p_path) const {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		return it != key_values.end();
-	}
+	static const uint32_t INDEX_MAGIC = 0x4954564B; // KVTI
+	static const uint32_t INDEX_VERSION = 1;
+	static const uint32_t EMPTY_BUCKET = UINT32_MAX;
 
-	StringName child_get_path(const StringName &p_path, int p_child, const StringName &p_key) const {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		ERR_FAIL_COND_V(it == key_values.end(), "");
-		int i = it->value;
-		ERR_FAIL_INDEX_V(p_child, nodes[i].children.size(), "");
+	PackedByteArray blob;
+	// Views into blob
+	const Header *header = nullptr;
+	const Node *nodes = nullptr;
+	const uint32_t *buckets = nullptr;
+	const uint32_t *children = nullptr;
+	const uint8_t *strings = nullptr;
 
-		StringName child_path = nodes[i].children[p_child];
-		int child_i = key_values[child_path];
-		for (StringName child : nodes[child_i].children) {
-			if (nodes[key_values[child]].name == p_key) {
-				return nodes[key_values[child]].path;
-			}
-		}
-		return "";
-	}
+	static uint32_t _hash_utf8(const String &p_string, uint32_t p_hash);
+	static bool _equals_utf8(const uint8_t *p_bytes, uint32_t p_length, const String &p_string);
 
-	bool child_has_key(const StringName &p_path, int p_child, const StringName &p_key) const {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		ERR_FAIL_COND_V(it == key_values.end(), false);
-		int i = it->value;
-		ERR_FAIL_INDEX_V(p_child, nodes[i].children.size(), false);
+	bool _bind_blob();
+	void _parse(const uint8_t *p_data, uint64_t p_length, uint32_t p_source_hash);
+	// Finds the node whose path is p_suffix, or the path of p_parent followed by a dot and p_suffix
+	uint32_t _find(uint32_t p_hash, uint32_t p_parent, const String &p_suffix) const;
+	uint32_t _find_path(const String &p_path) const;
+	uint32_t _find_child_key(const StringName &p_path, int p_child, const StringName &p_key) const;
+	String _get_string(uint32_t p_offset, uint32_t p_length) const;
 
-		StringName child_path = nodes[i].children[p_child];
-		int child_i = key_values[child_path];
-		for (StringName child : nodes[child_i].children) {
-			if (nodes[key_values[child]].name == p_key) {
-				return true;
-			}
-		}
-		return false;
-	}
+public:
+	// Hash stored in saved indices to tell whether they are still up to date with their source text
+	static uint32_t hash_source(const uint8_t *p_data, uint64_t p_length);
 
-	String child_get_value(const StringName &p_path, int p_child, const StringName &p_key) {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		ERR_FAIL_COND_V(it == key_values.end(), "");
-		int i = it->value;
-		ERR_FAIL_INDEX_V(p_child, nodes[i].children.size(), "");
+	void parse(const String &p_text);
+	// Single pass over the raw UTF-8 text, nothing is allocated per line
+	void parse_utf8(const uint8_t *p_data, uint64_t p_length);
 
-		StringName child_path = nodes[i].children[p_child];
-		int child_i = key_values[child_path];
-		for (StringName child : nodes[child_i].children) {
-			if (nodes[key_values[child]].name == p_key) {
-				return nodes[key_values[child]].value;
-			}
-		}
-		return "";
-	}
+	const PackedByteArray &get_index_data() const;
+	Error set_index_data(const PackedByteArray &p_data);
+	Error save_index(const String &p_path) const;
+	// Fails with ERR_INVALID_DATA without printing anything when the index was made from different text
+	Error load_index(const String &p_path, uint32_t p_source_hash);
+	// Loads the index at p_index_path if it matches p_data, otherwise parses and saves a new one
+	void parse_utf8_cached(const uint8_t *p_data, uint64_t p_length, const String &p_index_path);
 
-	String get_value(const StringName &p_path) const {
-		HashMap<StringName, int>::ConstIterator it = key_values.find(p_path);
-		ERR_FAIL_COND_V_MSG(it == key_values.end(), "", vformat("Key %s not found", p_path));
-		int i = it->value;
-		ERR_FAIL_COND_V(nodes[i].children.size() != 0, "");
-		return nodes[i].value;
-	}
+	int get_children_count(const StringName &p_path) const;
+	bool has_key(const StringName &p_path) const;
+	StringName child_get_path(const StringName &p_path, int p_child, const StringName &p_key) const;
+	bool child_has_key(const StringName &p_path, int p_child, const StringName &p_key) const;
+	String child_get_value(const StringName &p_path, int p_child, const StringName &p_key) const;
+	String get_value(const StringName &p_path) const;
 };
 
 #endif // KV_TABLE_H
@@ -0,0 +1,285 @@
+#include "motion.h"
+#include "core/templates/hash_map.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIVA_MOTION_SSE2
+#endif
+
+// Motions are authored at 60 frames per second
+static const float DIVA_MOTION_FPS = 60.0f;
+
+void DIVAMotion::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("read_classic", "stream"), &DIVAMotion::read_classic);
+	ClassDB::bind_method(D_METHOD("get_frame_count"), &DIVAMotion::get_frame_count);
+	ClassDB::bind_method(D_METHOD("get_key_set_count"), &DIVAMotion::get_key_set_count);
+	ClassDB::bind_method(D_METHOD("sample", "frame"), &DIVAMotion::sample);
+	ClassDB::bind_method(D_METHOD("bake_animation", "skeleton", "motion_bone_names", "skeleton_path"), &DIVAMotion::bake_animation);
+	ClassDB::bind_method(D_METHOD("bake_animation_async", "skeleton", "motion_bone_names", "skeleton_path"), &DIVAMotion::bake_animation_async);
+	ADD_SIGNAL(MethodInfo("animation_baked", PropertyInfo(Variant::OBJECT, "animation", PROPERTY_HINT_RESOURCE_TYPE, "Animation")));
+}
+
+int DIVAMotion::get_frame_count() const {
+	return data.frame_count;
+}
+
+int DIVAMotion::get_key_set_count() const {
+	return data.key_sets.size();
+}
+
+void DIVAMotion::_sample(float p_frame, SampleState &r_state) const {
+	const uint32_t key_set_count = data.key_sets.size();
+	r_state.cursors.resize(key_set_count);
+	r_state.t.resize(key_set_count);
+	r_state.p0.resize(key_set_count);
+	r_state.p1.resize(key_set_count);
+	r_state.m0.resize(key_set_count);
+	r_state.m1.resize(key_set_count);
+	r_state.values.resize(key_set_count);
+
+	// Find the segment of every key set, anything that isn't between two keys becomes a flat segment
+	for (uint32_t i = 0; i < key_set_count; i++) {
+		const key_set_data &ks = data.key_sets[i];
+		float &t = r_state.t[i];
+		float &p0 = r_state.p0[i];
+		float &p1 = r_state.p1[i];
+		float &m0 = r_state.m0[i];
+		float &m1 = r_state.m1[i];
+		t = 0.0f;
+		m0 = 0.0f;
+		m1 = 0.0f;
+
+		if (ks.type == MOT_KEY_SET_NONE || ks.values.size() == 0) {
+			p0 = p1 = 0.0f;
+			continue;
+		}
+		if (ks.type == MOT_KEY_SET_STATIC || ks.keys_count == 1) {
+			p0 = p1 = ks.values[0];
+			continue;
+		}
+
+		const uint16_t *frames = ks.frames.ptr();
+		const uint32_t keys_count = ks.keys_count;
+		const uint32_t stride = ks.type == MOT_KEY_SET_HERMITE_TANGENT ? 2 : 1;
+		if (p_frame <= frames[0]) {
+			p0 = p1 = ks.values[0];
+			continue;
+		}
+		if (p_frame >= frames[keys_count - 1]) {
+			p0 = p1 = ks.values[(keys_count - 1) * stride];
+			continue;
+		}
+
+		uint32_t key = MIN(r_state.cursors[i], keys_count - 2);
+		if (frames[key] > p_frame) {
+			// Went back in time, find the segment from scratch
+			uint32_t low = 0;
+			uint32_t high = keys_count - 1;
+			while (high - low > 1) {
+				uint32_t middle = (low + high) / 2;
+				if (frames[middle] <= p_frame) {
+					low = middle;
+				} else {
+					high = middle;
+				}
+			}
+			key = low;
+		} else {
+			while (frames[key + 1] <= p_frame) {
+				key++;
+			}
+		}
+		r_state.cursors[i] = key;
+
+		const float segment_length = frames[key + 1] - frames[key];
+		t = (p_frame - frames[key]) / segment_length;
+		p0 = ks.values[key * stride];
+		p1 = ks.values[(key + 1) * stride];
+		if (stride == 2) {
+			m0 = ks.values[key * stride + 1] * segment_length;
+			m1 = ks.values[(key + 1) * stride + 1] * segment_length;
+		}
+	}
+
+	// Cubic Hermite for everything at once
+	const float *t = r_state.t.ptr();
+	const float *p0 = r_state.p0.ptr();
+	const float *p1 = r_state.p1.ptr();
+	const float *m0 = r_state.m0.ptr();
+	const float *m1 = r_state.m1.ptr();
+	float *values = r_state.values.ptr();
+	uint32_t i = 0;
+#ifdef DIVA_MOTION_SSE2
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	for (; i + 4 <= key_set_count; i += 4) {
+		__m128 vt = _mm_loadu_ps(t + i);
+		__m128 vt2 = _mm_mul_ps(vt, vt);
+		__m128 vt3 = _mm_mul_ps(vt2, vt);
+		__m128 h01 = _mm_sub_ps(_mm_mul_ps(three, vt2), _mm_mul_ps(two, vt3));
+		__m128 h00 = _mm_sub_ps(one, h01);
+		__m128 h11 = _mm_sub_ps(vt3, vt2);
+		__m128 h10 = _mm_add_ps(_mm_sub_ps(h11, vt2), vt);
+		__m128 result = _mm_mul_ps(h00, _mm_loadu_ps(p0 + i));
+		result = _mm_add_ps(result, _mm_mul_ps(h10, _mm_loadu_ps(m0 + i)));
+		result = _mm_add_ps(result, _mm_mul_ps(h01, _mm_loadu_ps(p1 + i)));
+		result = _mm_add_ps(result, _mm_mul_ps(h11, _mm_loadu_ps(m1 + i)));
+		_mm_storeu_ps(values + i, result);
+	}
+#endif
+	for (; i < key_set_count; i++) {
+		const float t2 = t[i] * t[i];
+		const float t3 = t2 * t[i];
+		const float h01 = 3.0f * t2 - 2.0f * t3;
+		const float h00 = 1.0f - h01;
+		const float h11 = t3 - t2;
+		const float h10 = h11 - t2 + t[i];
+		values[i] = h00 * p0[i] + h10 * m0[i] + h01 * p1[i] + h11 * m1[i];
+	}
+}
+
+// r_values must hold get_key_set_count() floats
+void DIVAMotion::sample_into(float p_frame, float *r_values) {
+	_sample(p_frame, sample_state);
+	memcpy(r_values, sample_state.values.ptr(), sample_state.values.size() * sizeof(float));
+}
+
+PackedFloat32Array DIVAMotion::sample(float p_frame) {
+	PackedFloat32Array values;
+	values.resize(data.key_sets.size());
+	sample_into(p_frame, values.ptrw());
+	return values;
+}
+
+Ref<Animation> DIVAMotion::bake_animation(const Ref<DIVASkeleton> &p_skeleton, const PackedStringArray &p_motion_bone_names, const NodePath &p_skeleton_path) const {
+	ERR_FAIL_COND_V(p_skeleton.is_null(), Ref<Animation>());
+
+	HashMap<String, uint32_t> skeleton_bones;
+	for (uint32_t i = 0; i < p_skeleton->bones.size(); i++) {
+		skeleton_bones.insert(p_skeleton->bones[i].name, i);
+	}
+
+	// Work out which key sets drive which bone, each bone takes a fixed number of them by type
+	struct BoneBinding {
+		String name;
+		int position_key_set = -1;
+		int rotation_key_set = -1;
+		int position_track = -1;
+		int rotation_track = -1;
+	};
+	LocalVector<BoneBinding> bindings;
+	uint32_t key_set = 0;
+	for (uint32_t i = 0; i < data.bone_info.size() && key_set < data.key_sets.size(); i++) {
+		const uint16_t motion_bone = data.bone_info[i].index;
+		ERR_FAIL_INDEX_V_MSG(motion_bone, p_motion_bone_names.size(), Ref<Animation>(), "Motion references a bone missing from the motion bone names.");
+		HashMap<String, uint32_t>::Iterator it = skeleton_bones.find(p_motion_bone_names[motion_bone]);
+		ERR_FAIL_COND_V_MSG(!it, Ref<Animation>(), vformat("Motion bone %s isn't part of skeleton %s.", p_motion_bone_names[motion_bone], p_skeleton->name));
+
+		BoneBinding binding;
+		binding.name = it->key;
+		switch (p_skeleton->bones[it->value].type) {
+			case DIVASkeleton::BONE_DATABASE_BONE_ROTATION: {
+				binding.rotation_key_set = key_set;
+				key_set += 3;
+			} break;
+			case DIVASkeleton::BONE_DATABASE_BONE_TYPE_1:
+			case DIVASkeleton::BONE_DATABASE_BONE_POSITION: {
+				binding.position_key_set = key_set;
+				key_set += 3;
+			} break;
+			case DIVASkeleton::BONE_DATABASE_BONE_POSITION_ROTATION: {
+				binding.position_key_set = key_set;
+				binding.rotation_key_set = key_set + 3;
+				key_set += 6;
+			} break;
+			case DIVASkeleton::BONE_DATABASE_BONE_HEAD_IK_ROTATION: {
+				// IK bones carry targets rather than a local transform, they need solving at runtime
+				key_set += 6;
+				continue;
+			}
+			case DIVASkeleton::BONE_DATABASE_BONE_ARM_IK_ROTATION:
+			case DIVASkeleton::BONE_DATABASE_BONE_LEGS_IK_ROTATION: {
+				// Same as above, with the pole rotation on top of the target
+				key_set += 9;
+				continue;
+			}
+			default: {
+				ERR_FAIL_V_MSG(Ref<Animation>(), vformat("Bone %s has an unknown bone type.", it->key));
+			}
+		}
+		if (key_set > data.key_sets.size()) {
+			break;
+		}
+		bindings.push_back(binding);
+	}
+
+	Ref<Animation> animation;
+	animation.instantiate();
+	const String skeleton_path = p_skeleton_path;
+	for (BoneBinding &binding : bindings) {
+		NodePath track_path = NodePath(skeleton_path + ":" + binding.name);
+		if (binding.position_key_set != -1) {
+			binding.position_track = animation->add_track(Animation::TYPE_POSITION_3D);
+			animation->track_set_path(binding.position_track, track_path);
+		}
+		if (binding.rotation_key_set != -1) {
+			binding.rotation_track = animation->add_track(Animation::TYPE_ROTATION_3D);
+			animation->track_set_path(binding.rotation_track, track_path);
+		}
+	}
+
+	// One sample covers every key set of the frame, the state is local so this can run off the main thread
+	SampleState state;
+	for (uint32_t frame = 0; frame < data.frame_count; frame++) {
+		_sample(frame, state);
+		const float *values = state.values.ptr();
+		const double time = frame / DIVA_MOTION_FPS;
+		for (const BoneBinding &binding : bindings) {
+			if (binding.position_track != -1) {
+				const float *position = values + binding.position_key_set;
+				animation->position_track_insert_key(binding.position_track, time, Vector3(position[0], position[1], position[2]));
+			}
+			if (binding.rotation_track != -1) {
+				const float *rotation = values + binding.rotation_key_set;
+				Basis basis = Basis::from_euler(Vector3(rotation[0], rotation[1], rotation[2]), EulerOrder::ZYX);
+				animation->rotation_track_insert_key(binding.rotation_track, time, basis.get_rotation_quaternion());
+			}
+		}
+	}
+
+	animation->set_length(MAX(int(data.frame_count) - 1, 0) / DIVA_MOTION_FPS);
+	animation->set_step(1.0f / DIVA_MOTION_FPS);
+	animation->compress(8192, DIVA_MOTION_FPS);
+	return animation;
+}
+
+void DIVAMotion::_bake_task(void *p_userdata) {
+	DIVAMotion *motion = (DIVAMotion *)p_userdata;
+	BakeTask &task = motion->bake_task;
+	task.animation = motion->bake_animation(task.skeleton, task.motion_bone_names, task.skeleton_path);
+	callable_mp(motion, &DIVAMotion::_bake_task_done).call_deferred();
+}
+
+void DIVAMotion::_bake_task_done() {
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(bake_task_id);
+	bake_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	Ref<Animation> animation = bake_task.animation;
+	bake_task = BakeTask();
+	emit_signal(SNAME("animation_baked"), animation);
+	// Might free this motion, nothing may come after this
+	bake_task_keep_alive.unref();
+}
+
+// Bakes on the worker thread pool, animation_baked is emitted on the main thread with the result (null on failure).
+// read_classic fails until then.
+Error DIVAMotion::bake_animation_async(const Ref<DIVASkeleton> &p_skeleton, const PackedStringArray &p_motion_bone_names, const NodePath &p_skeleton_path) {
+	ERR_FAIL_COND_V_MSG(bake_task_id != WorkerThreadPool::INVALID_TASK_ID, ERR_BUSY, "This motion is already being baked.");
+	ERR_FAIL_COND_V(p_skeleton.is_null(), ERR_INVALID_PARAMETER);
+	bake_task.skeleton = p_skeleton;
+	bake_task.motion_bone_names = p_motion_bone_names;
+	bake_task.skeleton_path = p_skeleton_path;
+	bake_task_keep_alive = Ref<RefCounted>(this);
+	bake_task_id = WorkerThreadPool::get_singleton()->add_native_task(&DIVAMotion::_bake_task, this, false, "DIVA motion bake");
+	return OK;
+}
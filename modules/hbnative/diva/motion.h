@@ -1,9 +1,16 @@
 #ifndef MOTION_H
 #define MOTION_H
 
+#include "bone_db.h"
 #include "core/io/stream_peer.h"
+#include "core/object/ref_counted.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/local_vector.h"
+#include "scene/resources/animation.h"
+
+class DIVAMotion : public RefCounted {
+	GDCLASS(DIVAMotion, RefCounted);
 
-class DIVAMotion {
 	enum mot_key_set_type {
 		MOT_KEY_SET_NONE = 0x00,
 		MOT_KEY_SET_STATIC = 0x01,
@@ -50,6 +57,37 @@ class DIVAMotion {
 		LocalVector<key_set_data> key_sets;
 	};
 
+	// Scratch for evaluating every key set at one frame, laid out per key set so the Hermite
+	// evaluation runs over plain arrays. The cursors remember the last segment of each key set,
+	// sampling forward in time only ever moves them a key or two.
+	struct SampleState {
+		LocalVector<uint32_t> cursors;
+		LocalVector<float> t;
+		LocalVector<float> p0;
+		LocalVector<float> p1;
+		LocalVector<float> m0;
+		LocalVector<float> m1;
+		LocalVector<float> values;
+	};
+
+	struct BakeTask {
+		Ref<DIVASkeleton> skeleton;
+		PackedStringArray motion_bone_names;
+		NodePath skeleton_path;
+		Ref<Animation> animation;
+	};
+
+	motion_data data;
+	SampleState sample_state;
+
+	WorkerThreadPool::TaskID bake_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	BakeTask bake_task;
+	Ref<RefCounted> bake_task_keep_alive;
+
+	void _sample(float p_frame, SampleState &r_state) const;
+	static void _bake_task(void *p_userdata);
+	void _bake_task_done();
+
 	static void align_read(Ref<StreamPeerBuffer> &p_stream, int align) {
 		int64_t position = p_stream->get_position();
 		size_t temp_align = align - position % align;
@@ -58,7 +96,13 @@ class DIVAMotion {
 		}
 	}
 
+protected:
+	static void _bind_methods();
+
+public:
 	void read_classic(Ref<StreamPeerBuffer> p_stream) {
+		// The bake task reads data without a lock
+		ERR_FAIL_COND_MSG(bake_task_id != WorkerThreadPool::INVALID_TASK_ID, "Can't read into a motion while it's being baked.");
 		motion_header_classic header{
 			.key_set_info_offset = p_stream->get_u32(),
 			.key_set_types_offset = p_stream->get_u32(),
@@ -68,7 +112,7 @@ class DIVAMotion {
 
 		p_stream->seek(header.key_set_info_offset);
 
-		motion_data data;
+		data = motion_data();
 		data.info = p_stream->get_u16();
 		data.frame_count = p_stream->get_u16();
 
@@ -81,6 +125,7 @@ class DIVAMotion {
 			} while (p_stream->get_u16() != 0 && p_stream->get_position() < p_stream->get_size());
 
 			data.bone_info.resize(bone_info_count);
+			data.bone_info_count = bone_info_count;
 
 			p_stream->seek(header.bone_info_offset);
 
@@ -91,11 +136,11 @@ class DIVAMotion {
 		}
 
 		uint32_t key_set_count = data.key_set_count;
+		data.key_sets.resize(key_set_count);
 		key_set_data *key_set_arr = data.key_sets.ptr();
 
 		// Key set type
 		{
-			data.key_sets.resize(key_set_count);
 
 			p_stream->seek(header.key_set_types_offset);
 
@@ -142,6 +187,15 @@ class DIVAMotion {
 			}
 		}
 	}
+
+	int get_frame_count() const;
+	int get_key_set_count() const;
+
+	void sample_into(float p_frame, float *r_values);
+	PackedFloat32Array sample(float p_frame);
+
+	Ref<Animation> bake_animation(const Ref<DIVASkeleton> &p_skeleton, const PackedStringArray &p_motion_bone_names, const NodePath &p_skeleton_path) const;
+	Error bake_animation_async(const Ref<DIVASkeleton> &p_skeleton, const PackedStringArray &p_motion_bone_names, const NodePath &p_skeleton_path);
 };
 
 #endif // MOTION_H
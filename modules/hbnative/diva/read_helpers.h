@@ -4,6 +4,11 @@
 #include "core/io/stream_peer.h"
 #include <stack>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIVA_READ_HELPERS_SSE2
+#endif
+
 namespace DIVAReadHelpers {
 struct OffsetQueue {
 	Ref<StreamPeerBuffer> spb;
@@ -34,6 +39,98 @@ static String read_null_terminated_string(int p_string_pos, OffsetQueue &p_queue
 	p_queue.position_pop();
 	return out;
 }
+
+// Read only view over a whole loaded file. Reads take absolute offsets, so there is no cursor to share
+// and any number of threads can read from the same span. Arrays are bounds checked once as a whole
+// instead of once per value.
+struct Span {
+	const uint8_t *data = nullptr;
+	uint64_t size = 0;
+
+	bool has(uint64_t p_offset, uint64_t p_length) const {
+		return p_offset <= size && p_length <= size - p_offset;
+	}
+
+	// Returns nullptr when the range doesn't fit in the file
+	const uint8_t *ptr(uint64_t p_offset, uint64_t p_length) const {
+		ERR_FAIL_COND_V_MSG(!has(p_offset, p_length), nullptr, vformat("Read of %d bytes at offset %d is outside of the file.", p_length, p_offset));
+		return data + p_offset;
+	}
+
+	bool copy(uint64_t p_offset, void *r_dst, uint64_t p_length) const {
+		const uint8_t *src = ptr(p_offset, p_length);
+		if (!src) {
+			return false;
+		}
+		memcpy(r_dst, src, p_length);
+		return true;
+	}
+
+	template <typename T>
+	T get(uint64_t p_offset) const {
+		T value = {};
+		copy(p_offset, &value, sizeof(T));
+		return value;
+	}
+};
+
+// Cursor over a span for walking through consecutive header fields
+struct SpanReader {
+	const Span &span;
+	uint64_t position = 0;
+
+	uint32_t get_u32() {
+		uint32_t value = span.get<uint32_t>(position);
+		position += sizeof(uint32_t);
+		return value;
+	}
+	float get_float() {
+		float value = span.get<float>(position);
+		position += sizeof(float);
+		return value;
+	}
+	void get_data(void *r_dst, uint64_t p_length) {
+		span.copy(position, r_dst, p_length);
+		position += p_length;
+	}
+	void skip(uint64_t p_length) {
+		position += p_length;
+	}
+};
+
+// Widens 8 bit indices, optionally turning the 0xFF strip restart into -1
+static void widen_indices_u8(const uint8_t *p_src, int32_t *r_dst, uint32_t p_count, bool p_restart) {
+	if (p_restart) {
+		for (uint32_t i = 0; i < p_count; i++) {
+			r_dst[i] = p_src[i] == 0xFF ? -1 : p_src[i];
+		}
+	} else {
+		for (uint32_t i = 0; i < p_count; i++) {
+			r_dst[i] = p_src[i];
+		}
+	}
+}
+
+// Widens 16 bit indices, optionally turning the 0xFFFF strip restart into -1. The source doesn't need to be aligned.
+static void widen_indices_u16(const uint8_t *p_src, int32_t *r_dst, uint32_t p_count, bool p_restart) {
+	uint32_t i = 0;
+#ifdef DIVA_READ_HELPERS_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i restart = _mm_set1_epi16((short)0xFFFF);
+	for (; i + 8 <= p_count; i += 8) {
+		__m128i indices = _mm_loadu_si128((const __m128i *)(p_src + i * sizeof(uint16_t)));
+		// Interleaving with all ones fills the high half of restart indices, giving 0xFFFFFFFF
+		__m128i high = p_restart ? _mm_cmpeq_epi16(indices, restart) : zero;
+		_mm_storeu_si128((__m128i *)(r_dst + i), _mm_unpacklo_epi16(indices, high));
+		_mm_storeu_si128((__m128i *)(r_dst + i + 4), _mm_unpackhi_epi16(indices, high));
+	}
+#endif
+	for (; i < p_count; i++) {
+		uint16_t index;
+		memcpy(&index, p_src + i * sizeof(uint16_t), sizeof(uint16_t));
+		r_dst[i] = (p_restart && index == 0xFFFF) ? -1 : index;
+	}
+}
 }; //namespace DIVAReadHelpers
 
 #endif // READ_HELPERS_H
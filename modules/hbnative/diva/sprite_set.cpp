@@ -0,0 +1,432 @@
+#include "sprite_set.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIVA_SPRITE_SET_SSE2
+#endif
+
+const uint8_t *DivaTXP::_get_mipmap_data(const DIVAMipmap &p_mipmap) const {
+	DIVAReadHelpers::Span span = { data.ptr(), (uint64_t)data.size() };
+	return span.ptr(p_mipmap.data_offset, p_mipmap.data_size);
+}
+
+// Sprites store colour as a full size luma + alpha BC5 level followed by a half size chroma one,
+// laid out as if they were a two level mipmap chain
+bool DivaTXP::_is_ycbcr(const DIVATexture &p_texture) {
+	return p_texture.array_size == 1 && p_texture.mipmap_count == 2 && p_texture.mipmaps[0].format == DIVA_BC5 && p_texture.mipmaps[1].format == DIVA_BC5;
+}
+
+void DivaTXP::convert_rgb5(const uint8_t *p_src, uint8_t *r_dst, uint32_t p_pixel_count) {
+	uint32_t i = 0;
+#ifdef DIVA_SPRITE_SET_SSE2
+	const __m128i mask_5 = _mm_set1_epi16(0x1F);
+	const __m128i mask_6 = _mm_set1_epi16(0x3F);
+	const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+	for (; i + 8 <= p_pixel_count; i += 8) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(p_src + i * 2));
+		__m128i r = _mm_srli_epi16(pixels, 11);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask_6);
+		__m128i b = _mm_and_si128(pixels, mask_5);
+		// Replicate the top bits into the bottom ones so 31 and 63 become 255
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		__m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+		__m128i ba = _mm_or_si128(b, alpha);
+		_mm_storeu_si128((__m128i *)(r_dst + i * 4), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128((__m128i *)(r_dst + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+	}
+#endif
+	for (; i < p_pixel_count; i++) {
+		uint16_t pixel = p_src[i * 2] | (p_src[i * 2 + 1] << 8);
+		uint8_t r = pixel >> 11;
+		uint8_t g = (pixel >> 5) & 0x3F;
+		uint8_t b = pixel & 0x1F;
+		r_dst[i * 4 + 0] = (r << 3) | (r >> 2);
+		r_dst[i * 4 + 1] = (g << 2) | (g >> 4);
+		r_dst[i * 4 + 2] = (b << 3) | (b >> 2);
+		r_dst[i * 4 + 3] = 0xFF;
+	}
+}
+
+void DivaTXP::convert_rgb5a1(const uint8_t *p_src, uint8_t *r_dst, uint32_t p_pixel_count) {
+	uint32_t i = 0;
+#ifdef DIVA_SPRITE_SET_SSE2
+	const __m128i mask_5 = _mm_set1_epi16(0x1F);
+	const __m128i one = _mm_set1_epi16(1);
+	for (; i + 8 <= p_pixel_count; i += 8) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(p_src + i * 2));
+		__m128i r = _mm_srli_epi16(pixels, 11);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 6), mask_5);
+		__m128i b = _mm_and_si128(_mm_srli_epi16(pixels, 1), mask_5);
+		// All ones in the high byte when the alpha bit is set
+		__m128i a = _mm_slli_epi16(_mm_cmpeq_epi16(_mm_and_si128(pixels, one), one), 8);
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		__m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+		__m128i ba = _mm_or_si128(b, a);
+		_mm_storeu_si128((__m128i *)(r_dst + i * 4), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128((__m128i *)(r_dst + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+	}
+#endif
+	for (; i < p_pixel_count; i++) {
+		uint16_t pixel = p_src[i * 2] | (p_src[i * 2 + 1] << 8);
+		uint8_t r = pixel >> 11;
+		uint8_t g = (pixel >> 6) & 0x1F;
+		uint8_t b = (pixel >> 1) & 0x1F;
+		r_dst[i * 4 + 0] = (r << 3) | (r >> 2);
+		r_dst[i * 4 + 1] = (g << 3) | (g >> 2);
+		r_dst[i * 4 + 2] = (b << 3) | (b >> 2);
+		r_dst[i * 4 + 3] = (pixel & 1) ? 0xFF : 0x00;
+	}
+}
+
+static void decode_bc4_block(const uint8_t *p_block, uint8_t *r_values) {
+	uint8_t palette[8];
+	palette[0] = p_block[0];
+	palette[1] = p_block[1];
+	if (palette[0] > palette[1]) {
+		for (int i = 1; i < 7; i++) {
+			palette[i + 1] = ((7 - i) * palette[0] + i * palette[1] + 3) / 7;
+		}
+	} else {
+		for (int i = 1; i < 5; i++) {
+			palette[i + 1] = ((5 - i) * palette[0] + i * palette[1] + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++) {
+		indices |= uint64_t(p_block[2 + i]) << (8 * i);
+	}
+	for (int i = 0; i < 16; i++) {
+		r_values[i] = palette[(indices >> (3 * i)) & 0x7];
+	}
+}
+
+void DivaTXP::decode_bc5(const uint8_t *p_src, uint8_t *r_dst, Size2i p_size) {
+	const int blocks_x = (p_size.x + 3) / 4;
+	const int blocks_y = (p_size.y + 3) / 4;
+	uint8_t red[16];
+	uint8_t green[16];
+	for (int block_y = 0; block_y < blocks_y; block_y++) {
+		for (int block_x = 0; block_x < blocks_x; block_x++) {
+			const uint8_t *block = p_src + (block_y * blocks_x + block_x) * 16;
+			decode_bc4_block(block, red);
+			decode_bc4_block(block + 8, green);
+			const int width = MIN(4, p_size.x - block_x * 4);
+			const int height = MIN(4, p_size.y - block_y * 4);
+			for (int y = 0; y < height; y++) {
+				uint8_t *row = r_dst + ((block_y * 4 + y) * p_size.x + block_x * 4) * 2;
+				for (int x = 0; x < width; x++) {
+					row[x * 2 + 0] = red[y * 4 + x];
+					row[x * 2 + 1] = green[y * 4 + x];
+				}
+			}
+		}
+	}
+}
+
+static uint32_t get_bc5_size(Size2i p_size) {
+	return ((p_size.x + 3) / 4) * ((p_size.y + 3) / 4) * 16;
+}
+
+static uint8_t ycbcr_channel_to_byte(float p_value) {
+	return uint8_t(CLAMP(p_value, 0.0f, 255.0f) + 0.5f);
+}
+
+// BT.709 full range, same matrix the game's sprite shader uses
+Ref<Image> DivaTXP::_decode_ycbcr(const DIVATexture &p_texture) const {
+	const DIVAMipmap &luma = p_texture.mipmaps[0];
+	const DIVAMipmap &chroma = p_texture.mipmaps[1];
+	const Size2i size = luma.size;
+	const Size2i chroma_size = chroma.size;
+	ERR_FAIL_COND_V(size.x <= 0 || size.y <= 0 || chroma_size.x <= 0 || chroma_size.y <= 0, Ref<Image>());
+	ERR_FAIL_COND_V_MSG(luma.data_size < get_bc5_size(size) || chroma.data_size < get_bc5_size(chroma_size), Ref<Image>(), "YCbCr texture data is too small.");
+
+	const uint8_t *luma_src = _get_mipmap_data(luma);
+	const uint8_t *chroma_src = _get_mipmap_data(chroma);
+	ERR_FAIL_NULL_V(luma_src, Ref<Image>());
+	ERR_FAIL_NULL_V(chroma_src, Ref<Image>());
+
+	LocalVector<uint8_t> luma_alpha;
+	luma_alpha.resize(size.x * size.y * 2);
+	decode_bc5(luma_src, luma_alpha.ptr(), size);
+	LocalVector<uint8_t> cb_cr;
+	cb_cr.resize(chroma_size.x * chroma_size.y * 2);
+	decode_bc5(chroma_src, cb_cr.ptr(), chroma_size);
+
+	Vector<uint8_t> image_data;
+	image_data.resize(size.x * size.y * 4);
+	uint8_t *dst = image_data.ptrw();
+
+	for (int y = 0; y < size.y; y++) {
+		const uint8_t *ya_row = luma_alpha.ptr() + y * size.x * 2;
+		const uint8_t *c_row = cb_cr.ptr() + MIN(y / 2, chroma_size.y - 1) * chroma_size.x * 2;
+		uint8_t *dst_row = dst + y * size.x * 4;
+		int x = 0;
+#ifdef DIVA_SPRITE_SET_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 max = _mm_set1_ps(255.0f);
+		for (; x + 4 <= size.x; x += 4) {
+			// Two pixels share each chroma sample
+			const uint8_t *c0 = c_row + MIN(x / 2, chroma_size.x - 1) * 2;
+			const uint8_t *c1 = c_row + MIN(x / 2 + 1, chroma_size.x - 1) * 2;
+			const uint8_t *ya = ya_row + x * 2;
+			__m128 luma_v = _mm_set_ps(ya[6], ya[4], ya[2], ya[0]);
+			__m128 cb = _mm_set_ps(c1[0], c1[0], c0[0], c0[0]);
+			__m128 cr = _mm_set_ps(c1[1], c1[1], c0[1], c0[1]);
+			__m128 r = _mm_add_ps(_mm_add_ps(luma_v, _mm_mul_ps(cr, _mm_set1_ps(1.5748f))), _mm_set1_ps(-0.7874f * 255.0f));
+			__m128 g = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(luma_v, _mm_mul_ps(cb, _mm_set1_ps(0.1873f))), _mm_mul_ps(cr, _mm_set1_ps(0.4681f))), _mm_set1_ps(0.3277f * 255.0f));
+			__m128 b = _mm_add_ps(_mm_add_ps(luma_v, _mm_mul_ps(cb, _mm_set1_ps(1.8556f))), _mm_set1_ps(-0.9278f * 255.0f));
+			__m128i r_i = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, zero), max));
+			__m128i g_i = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(g, zero), max));
+			__m128i b_i = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, zero), max));
+			__m128i a_i = _mm_set_epi32(ya[7], ya[5], ya[3], ya[1]);
+			__m128i rgba = _mm_or_si128(_mm_or_si128(r_i, _mm_slli_epi32(g_i, 8)), _mm_or_si128(_mm_slli_epi32(b_i, 16), _mm_slli_epi32(a_i, 24)));
+			_mm_storeu_si128((__m128i *)(dst_row + x * 4), rgba);
+		}
+#endif
+		for (; x < size.x; x++) {
+			const uint8_t *c = c_row + MIN(x / 2, chroma_size.x - 1) * 2;
+			const float luma_v = ya_row[x * 2];
+			dst_row[x * 4 + 0] = ycbcr_channel_to_byte(luma_v + 1.5748f * c[1] - 0.7874f * 255.0f);
+			dst_row[x * 4 + 1] = ycbcr_channel_to_byte(luma_v - 0.1873f * c[0] - 0.4681f * c[1] + 0.3277f * 255.0f);
+			dst_row[x * 4 + 2] = ycbcr_channel_to_byte(luma_v + 1.8556f * c[0] - 0.9278f * 255.0f);
+			dst_row[x * 4 + 3] = ya_row[x * 2 + 1];
+		}
+	}
+
+	return Image::create_from_data(size.x, size.y, false, Image::FORMAT_RGBA8, image_data);
+}
+
+// Writes one mipmap into its final place in an image, converting it if Godot has no matching format
+bool DivaTXP::_decode_mipmap_into(const DIVAMipmap &p_mipmap, const uint8_t *p_src, uint8_t *r_dst, int64_t p_dst_size) {
+	const uint32_t pixel_count = p_mipmap.size.x * p_mipmap.size.y;
+	switch (p_mipmap.format) {
+		case DIVA_RGB5:
+		case DIVA_RGB5A1: {
+			ERR_FAIL_COND_V_MSG(p_mipmap.data_size < pixel_count * 2 || p_dst_size < pixel_count * 4, false, "Mipmap data is too small.");
+			if (p_mipmap.format == DIVA_RGB5) {
+				convert_rgb5(p_src, r_dst, pixel_count);
+			} else {
+				convert_rgb5a1(p_src, r_dst, pixel_count);
+			}
+		} break;
+		default: {
+			// Everything else, BC included, is already in a format the GPU takes
+			ERR_FAIL_COND_V_MSG(p_mipmap.data_size < p_dst_size, false, "Mipmap data is too small.");
+			memcpy(r_dst, p_src, p_dst_size);
+		} break;
+	}
+	return true;
+}
+
+int DivaTXP::get_texture_count() const {
+	return textures.size();
+}
+
+Vector<Ref<Image>> DivaTXP::get_texture_mipmaps(int p_idx) const {
+	ERR_FAIL_INDEX_V(p_idx, (int)textures.size(), Vector<Ref<Image>>());
+	Vector<Ref<Image>> mipmaps;
+	for (const DIVAMipmap &mipmap : textures[p_idx].mipmaps) {
+		Image::Format godot_format = diva_to_godot_format(mipmap.format);
+		ERR_CONTINUE(godot_format == Image::FORMAT_MAX);
+		const uint8_t *src = _get_mipmap_data(mipmap);
+		ERR_CONTINUE(!src);
+		Vector<uint8_t> mipmap_data;
+		mipmap_data.resize(Image::get_image_data_size(mipmap.size.x, mipmap.size.y, godot_format, false));
+		ERR_CONTINUE(!_decode_mipmap_into(mipmap, src, mipmap_data.ptrw(), mipmap_data.size()));
+		mipmaps.push_back(Image::create_from_data(mipmap.size.x, mipmap.size.y, false, godot_format, mipmap_data));
+	}
+	return mipmaps;
+}
+
+Ref<Image> DivaTXP::decode_texture(int p_idx) const {
+	ERR_FAIL_INDEX_V(p_idx, (int)textures.size(), Ref<Image>());
+	const DIVATexture &texture = textures[p_idx];
+	ERR_FAIL_COND_V(texture.mipmaps.is_empty(), Ref<Image>());
+
+	if (_is_ycbcr(texture)) {
+		return _decode_ycbcr(texture);
+	}
+
+	// Cube maps and arrays only get their first element
+	const DIVAMipmap &base = texture.mipmaps[0];
+	const Size2i size = base.size;
+	const Image::Format format = diva_to_godot_format(base.format);
+	ERR_FAIL_COND_V_MSG(format == Image::FORMAT_MAX, Ref<Image>(), vformat("Unsupported texture format %s.", diva_texture_format_to_str(base.format)));
+	ERR_FAIL_COND_V(size.x <= 0 || size.y <= 0, Ref<Image>());
+
+	// Images take either the whole mipmap chain or nothing
+	bool use_mipmaps = texture.mipmap_count > 1 && int(texture.mipmap_count) == Image::get_image_required_mipmaps(size.x, size.y, format) + 1;
+	for (uint32_t i = 1; use_mipmaps && i < texture.mipmap_count; i++) {
+		const DIVAMipmap &mipmap = texture.mipmaps[i];
+		use_mipmaps = mipmap.format == base.format && mipmap.size == Image::get_image_mipmap_size(size.x, size.y, format, i);
+	}
+	const int level_count = use_mipmaps ? texture.mipmap_count : 1;
+
+	// Every level is decoded straight into the image's own buffer
+	Vector<uint8_t> image_data;
+	image_data.resize(Image::get_image_data_size(size.x, size.y, format, use_mipmaps));
+	uint8_t *dst = image_data.ptrw();
+	for (int i = 0; i < level_count; i++) {
+		const DIVAMipmap &mipmap = texture.mipmaps[i];
+		const int64_t offset = Image::get_image_mipmap_offset(size.x, size.y, format, i);
+		const int64_t end = i + 1 < level_count ? Image::get_image_mipmap_offset(size.x, size.y, format, i + 1) : image_data.size();
+		const uint8_t *src = _get_mipmap_data(mipmap);
+		ERR_FAIL_NULL_V(src, Ref<Image>());
+		ERR_FAIL_COND_V(!_decode_mipmap_into(mipmap, src, dst + offset, end - offset), Ref<Image>());
+	}
+
+	return Image::create_from_data(size.x, size.y, use_mipmaps, format, image_data);
+}
+
+Ref<ImageTexture> DivaTXP::create_texture(int p_idx) const {
+	Ref<Image> image = decode_texture(p_idx);
+	ERR_FAIL_COND_V(image.is_null(), Ref<ImageTexture>());
+	return ImageTexture::create_from_image(image);
+}
+
+void DivaTXP::read_classic(Ref<StreamPeerBuffer> p_spb) {
+	// Mipmaps point into this instead of getting their own copy
+	data = p_spb->get_data_array();
+	DIVAReadHelpers::Span span = { data.ptr(), (uint64_t)data.size() };
+
+	uint32_t set_start = p_spb->get_position();
+	uint32_t signature = p_spb->get_u32();
+	ERR_FAIL_COND_MSG(signature != 0x03505854, "Texture set signature was wrong");
+
+	DIVAReadHelpers::OffsetQueue queue{
+		.spb = p_spb
+	};
+
+	uint32_t texture_count = p_spb->get_u32();
+
+	textures.reserve(texture_count);
+
+	// Not sure why but we have to skip 4 bytes here
+	// Both MML and ReDIVA skip it, MML calls it "texture count with rubbish"
+	p_spb->get_u32();
+	for (uint32_t i = 0; i < texture_count; i++) {
+		uint32_t texture_start = set_start + p_spb->get_u32();
+		queue.position_push(texture_start);
+
+		uint32_t txp_signature = p_spb->get_u32();
+		if (txp_signature != 0x04505854 && txp_signature != 0x05505854) {
+			queue.position_pop();
+			continue;
+		}
+
+		uint32_t subtex_count = p_spb->get_u32();
+		uint32_t tex_info = p_spb->get_u32();
+
+		DIVATexture tex = {
+			.cube_map = txp_signature == 0x05505854,
+			.array_size = (tex_info >> 8) & 0xFF,
+			.mipmap_count = tex_info & 0xFF
+		};
+
+		if (tex.array_size == 1 && tex.mipmap_count != subtex_count) {
+			tex.mipmap_count = subtex_count & 0xFF;
+		}
+
+		tex.mipmaps.resize(tex.array_size * tex.mipmap_count);
+
+		for (uint32_t arr_i = 0; arr_i < tex.array_size; arr_i++) {
+			for (uint32_t mipmap_i = 0; mipmap_i < tex.mipmap_count; mipmap_i++) {
+				uint32_t mipmap_offset = p_spb->get_u32();
+				queue.position_push(texture_start + mipmap_offset);
+
+				uint32_t subtex_signature = p_spb->get_u32(); // Mipmap signature
+
+				ERR_FAIL_COND_MSG(subtex_signature != 0x02505854, "Subtexture signature was incorrect");
+
+				DIVAMipmap mipmap = {
+					.size = Size2i(p_spb->get_u32(), p_spb->get_u32()),
+					.format = (DIVATextureFormat)p_spb->get_u32(),
+					.id = p_spb->get_u32()
+				};
+
+				mipmap.data_size = p_spb->get_u32();
+				mipmap.data_offset = p_spb->get_position();
+				ERR_FAIL_COND_MSG(!span.has(mipmap.data_offset, mipmap.data_size), "Mipmap data is outside of the file");
+
+				tex.mipmaps[arr_i * tex.mipmap_count + mipmap_i] = mipmap;
+
+				queue.position_pop();
+			}
+		}
+
+		textures.push_back(tex);
+
+		queue.position_pop();
+	}
+}
+
+void DIVASpriteSet::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("read_classic", "stream"), &DIVASpriteSet::read_classic);
+	ClassDB::bind_method(D_METHOD("load_textures_async"), &DIVASpriteSet::load_textures_async);
+	ClassDB::bind_method(D_METHOD("is_loading_textures"), &DIVASpriteSet::is_loading_textures);
+	ClassDB::bind_method(D_METHOD("get_texture_count"), &DIVASpriteSet::get_texture_count);
+	ClassDB::bind_method(D_METHOD("get_texture", "idx"), &DIVASpriteSet::get_texture);
+	ADD_SIGNAL(MethodInfo("textures_loaded"));
+}
+
+void DIVASpriteSet::_load_texture_task(void *p_userdata, uint32_t p_idx) {
+	DIVASpriteSet *sprite_set = (DIVASpriteSet *)p_userdata;
+	// Texture creation is thread safe on the RenderingServer, so the upload happens here too
+	sprite_set->textures[p_idx] = sprite_set->loading_texture_set->create_texture(p_idx);
+	if (sprite_set->pending_texture_count.decrement() == 0) {
+		callable_mp(sprite_set, &DIVASpriteSet::_textures_loaded).call_deferred();
+	}
+}
+
+void DIVASpriteSet::_textures_loaded() {
+	if (texture_group_id != -1) {
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(texture_group_id);
+		texture_group_id = -1;
+	}
+	loading_texture_set.unref();
+	emit_signal(SNAME("textures_loaded"));
+	// Might free this sprite set, nothing may come after this
+	texture_load_keep_alive.unref();
+}
+
+// One worker task per texture, textures_loaded is emitted on the main thread once all of them are done.
+// Textures that failed to decode are left null.
+Error DIVASpriteSet::load_textures_async() {
+	ERR_FAIL_COND_V_MSG(texture_load_keep_alive.is_valid(), ERR_BUSY, "Textures are already being loaded.");
+	ERR_FAIL_COND_V_MSG(set_data.texture_set.is_null(), ERR_UNCONFIGURED, "No texture set was read.");
+
+	const int texture_count = set_data.texture_set->get_texture_count();
+	textures.clear();
+	textures.resize(texture_count);
+	loading_texture_set = set_data.texture_set;
+	texture_load_keep_alive = Ref<RefCounted>(this);
+
+	if (texture_count == 0) {
+		callable_mp(this, &DIVASpriteSet::_textures_loaded).call_deferred();
+		return OK;
+	}
+
+	pending_texture_count.set(texture_count);
+	texture_group_id = WorkerThreadPool::get_singleton()->add_native_group_task(&DIVASpriteSet::_load_texture_task, this, texture_count, -1, false, "DIVA sprite set textures");
+	return OK;
+}
+
+bool DIVASpriteSet::is_loading_textures() const {
+	return texture_load_keep_alive.is_valid();
+}
+
+int DIVASpriteSet::get_texture_count() const {
+	return textures.size();
+}
+
+Ref<ImageTexture> DIVASpriteSet::get_texture(int p_idx) const {
+	ERR_FAIL_COND_V_MSG(is_loading_textures(), Ref<ImageTexture>(), "Textures are still loading.");
+	ERR_FAIL_INDEX_V(p_idx, (int)textures.size(), Ref<ImageTexture>());
+	return textures[p_idx];
+}
@@ -4,6 +4,8 @@
 #include "core/error/error_macros.h"
 #include "core/io/json.h"
 #include "core/io/stream_peer.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/safe_refcount.h"
 #include "read_helpers.h"
 #include "scene/resources/image_texture.h"
 #include "scene/resources/texture.h"
@@ -78,7 +80,9 @@ class DivaTXP : public RefCounted {
 		Size2i size;
 		DIVATextureFormat format;
 		uint32_t id;
-		LocalVector<uint8_t> data;
+		// Pixels stay in the file buffer until they are decoded straight into an image
+		uint64_t data_offset;
+		uint32_t data_size;
 	};
 	struct DIVATexture {
 		bool cube_map;
@@ -87,6 +91,13 @@ class DivaTXP : public RefCounted {
 		LocalVector<DIVAMipmap> mipmaps;
 	};
 	LocalVector<DIVATexture> textures;
+	// The whole file the set was read from, shared with the stream rather than copied
+	PackedByteArray data;
+
+	const uint8_t *_get_mipmap_data(const DIVAMipmap &p_mipmap) const;
+	static bool _is_ycbcr(const DIVATexture &p_texture);
+	static bool _decode_mipmap_into(const DIVAMipmap &p_mipmap, const uint8_t *p_src, uint8_t *r_dst, int64_t p_dst_size);
+	Ref<Image> _decode_ycbcr(const DIVATexture &p_texture) const;
 
 public:
 	static Image::Format diva_to_godot_format(DIVATextureFormat p_tex_format) {
@@ -101,12 +112,12 @@ public:
 				return Image::FORMAT_RGBA8;
 			} break;
 			case DIVA_RGB5: {
-				// Unsupported
-				return Image::FORMAT_MAX;
+				// Expanded on load, see convert_rgb5
+				return Image::FORMAT_RGBA8;
 			} break;
 			case DIVA_RGB5A1: {
-				// Unsupported
-				return Image::FORMAT_MAX;
+				// Expanded on load, see convert_rgb5a1
+				return Image::FORMAT_RGBA8;
 			} break;
 			case DIVA_RGBA4: {
 				return Image::FORMAT_RGBA4444;
@@ -189,91 +200,22 @@ public:
 		return 0;
 	}*/
 
-	Vector<Ref<Image>> get_texture_mipmaps(int p_idx) const {
-		ERR_FAIL_INDEX_V(p_idx, textures.size(), Vector<Ref<Image>>());
-		Vector<Ref<Image>> mipmaps;
-		for (int i = 0; i < textures[p_idx].mipmaps.size(); i++) {
-			Image::Format godot_format = diva_to_godot_format(textures[p_idx].mipmaps[i].format);
-			const Vector<uint8_t> mipmap_data = textures[p_idx].mipmaps[i].data;
-			Size2i mipmap_size = textures[p_idx].mipmaps[i].size;
-			Ref<Image> img = Image::create_from_data(mipmap_size.x, mipmap_size.y, false, godot_format, mipmap_data);
-			mipmaps.push_back(img);
-		}
-		return mipmaps;
-	}
-
-	void read_classic(Ref<StreamPeerBuffer> p_spb) {
-		uint32_t set_start = p_spb->get_position();
-		uint32_t signature = p_spb->get_u32();
-		ERR_FAIL_COND_MSG(signature != 0x03505854, "Texture set signature was wrong");
-
-		DIVAReadHelpers::OffsetQueue queue{
-			.spb = p_spb
-		};
-
-		uint32_t texture_count = p_spb->get_u32();
-
-		textures.reserve(texture_count);
-
-		// Not sure why but we have to skip 4 bytes here
-		// Both MML and ReDIVA skip it, MML calls it "texture count with rubbish"
-		p_spb->get_u32();
-		for (uint32_t i = 0; i < texture_count; i++) {
-			uint32_t texture_start = set_start + p_spb->get_u32();
-			queue.position_push(texture_start);
-
-			uint32_t txp_signature = p_spb->get_u32();
-			if (txp_signature != 0x04505854 && txp_signature != 0x05505854) {
-				continue;
-			}
+	// 16 bit pixels to RGBA8, using the same bit layouts the game uploads them with
+	// (GL_UNSIGNED_SHORT_5_6_5 and GL_UNSIGNED_SHORT_5_5_5_1)
+	static void convert_rgb5(const uint8_t *p_src, uint8_t *r_dst, uint32_t p_pixel_count);
+	static void convert_rgb5a1(const uint8_t *p_src, uint8_t *r_dst, uint32_t p_pixel_count);
+	// Decodes BC5 blocks to RG8, clipping the blocks that hang over the edges
+	static void decode_bc5(const uint8_t *p_src, uint8_t *r_dst, Size2i p_size);
 
-			uint32_t subtex_count = p_spb->get_u32();
-			uint32_t tex_info = p_spb->get_u32();
+	int get_texture_count() const;
+	// Every mipmap on its own, BC data is left compressed
+	Vector<Ref<Image>> get_texture_mipmaps(int p_idx) const;
+	// A single image with the mipmap chain when the file has a complete one, YCbCr textures
+	// come out as RGBA8. Only reads from the set, so it is safe to call from several threads at once.
+	Ref<Image> decode_texture(int p_idx) const;
+	Ref<ImageTexture> create_texture(int p_idx) const;
 
-			DIVATexture tex = {
-				.cube_map = signature == 0x05505854,
-				.array_size = (tex_info >> 8) & 0xFF,
-				.mipmap_count = tex_info & 0xFF
-			};
-
-			if (tex.array_size == 1 && tex.mipmap_count != subtex_count) {
-				tex.mipmap_count = subtex_count & 0xFF;
-			}
-
-			tex.mipmaps.resize(tex.array_size * tex.mipmap_count);
-
-			for (uint32_t arr_i = 0; arr_i < tex.array_size; arr_i++) {
-				for (uint32_t mipmap_i = 0; mipmap_i < tex.mipmap_count; mipmap_i++) {
-					uint32_t mipmap_offset = p_spb->get_u32();
-					queue.position_push(texture_start + mipmap_offset);
-
-					uint32_t subtex_signature = p_spb->get_u32(); // Mipmap signature
-
-					ERR_FAIL_COND_MSG(subtex_signature != 0x02505854, "Subtexture signature was incorrect");
-
-					DIVAMipmap mipmap = {
-						.size = Size2i(p_spb->get_u32(), p_spb->get_u32()),
-						.format = (DIVATextureFormat)p_spb->get_u32(),
-						.id = p_spb->get_u32()
-					};
-
-					uint32_t data_size = p_spb->get_u32();
-
-					mipmap.data.resize(data_size);
-
-					p_spb->get_data(mipmap.data.ptr(), mipmap.data.size());
-
-					tex.mipmaps[arr_i * tex.mipmap_count + mipmap_i] = mipmap;
-
-					queue.position_pop();
-				}
-			}
-
-			textures.push_back(tex);
-
-			queue.position_pop();
-		}
-	}
+	void read_classic(Ref<StreamPeerBuffer> p_spb);
 
 	void dump_json(String p_path) {
 		Array textures_out;
@@ -324,8 +266,23 @@ class DIVASpriteSet : public RefCounted {
 	SpriteSetData set_data;
 	Ref<StreamPeerBuffer> spb;
 
+	LocalVector<Ref<ImageTexture>> textures;
+	WorkerThreadPool::GroupID texture_group_id = -1;
+	SafeNumeric<uint32_t> pending_texture_count;
+	// The set the workers decode from, held on its own so it outlives whatever happens to set_data
+	Ref<DivaTXP> loading_texture_set;
+	// Keeps us alive until the textures are handed out on the main thread
+	Ref<RefCounted> texture_load_keep_alive;
+
+	static void _load_texture_task(void *p_userdata, uint32_t p_idx);
+	void _textures_loaded();
+
+protected:
+	static void _bind_methods();
+
 public:
 	void read_classic(Ref<StreamPeerBuffer> p_spb) {
+		ERR_FAIL_COND_MSG(is_loading_textures(), "Can't read into a sprite set while its textures are loading.");
 		spb = p_spb;
 
 		DIVAReadHelpers::OffsetQueue queue{
@@ -373,6 +330,12 @@ public:
 	Ref<DivaTXP> get_texture_set() const {
 		return set_data.texture_set;
 	}
+
+	// Decodes and uploads every texture on the worker pool, emits textures_loaded when they are ready
+	Error load_textures_async();
+	bool is_loading_textures() const;
+	int get_texture_count() const;
+	Ref<ImageTexture> get_texture(int p_idx) const;
 };
 
 #endif // SPRITE_SET_H
@@ -55,6 +55,11 @@
 #ifndef EASING_EQUATIONS_H
 #define EASING_EQUATIONS_H
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EASING_BATCH_SSE2
+#endif
+
 namespace linear {
 static real_t in(real_t t, real_t b, real_t c, real_t d) {
 	return c * t / d + b;
@@ -402,4 +407,112 @@ static real_t out_in(real_t t, real_t b, real_t c, real_t d) {
 }
 }; // namespace back
 
+// Batch evaluation of one transition/ease pair over many time values, b + c * f(t / d) for each t.
+// Every curve gets its own instantiation of the loop so the equation is inlined rather than called
+// through a pointer per value. The polynomial family is rewritten over the normalized time and
+// evaluated four values at a time with SSE2, the rest use the scalar equations above.
+namespace batch {
+typedef void (*batch_interpolater)(const float *p_times, float *r_values, int p_count, float b, float c, float d);
+
+enum Shape {
+	SHAPE_IN,
+	SHAPE_OUT,
+	SHAPE_IN_OUT,
+	SHAPE_OUT_IN,
+};
+
+template <real_t (*m_equation)(real_t, real_t, real_t, real_t)>
+static void scalar(const float *p_times, float *r_values, int p_count, float b, float c, float d) {
+	for (int i = 0; i < p_count; i++) {
+		r_values[i] = m_equation(p_times[i], b, c, d);
+	}
+}
+
+template <int m_power>
+static _FORCE_INLINE_ float power(float u) {
+	float r = u;
+	for (int i = 1; i < m_power; i++) {
+		r *= u;
+	}
+	return r;
+}
+
+// u^n in, 1 - (1 - u)^n out, the halves of both glued together for in_out and out_in
+template <int m_power, int m_shape>
+static _FORCE_INLINE_ float polynomial_normalized(float u) {
+	switch (m_shape) {
+		case SHAPE_IN:
+			return power<m_power>(u);
+		case SHAPE_OUT:
+			return 1.0f - power<m_power>(1.0f - u);
+		case SHAPE_IN_OUT: {
+			float s = u * 2.0f;
+			return s < 1.0f ? 0.5f * power<m_power>(s) : 1.0f - 0.5f * power<m_power>(2.0f - s);
+		}
+		default: {
+			float s = u * 2.0f;
+			return s < 1.0f ? 0.5f - 0.5f * power<m_power>(1.0f - s) : 0.5f + 0.5f * power<m_power>(s - 1.0f);
+		}
+	}
+}
+
+#ifdef EASING_BATCH_SSE2
+template <int m_power>
+static _FORCE_INLINE_ __m128 power_sse(__m128 u) {
+	__m128 r = u;
+	for (int i = 1; i < m_power; i++) {
+		r = _mm_mul_ps(r, u);
+	}
+	return r;
+}
+
+static _FORCE_INLINE_ __m128 select_sse(__m128 p_mask, __m128 p_a, __m128 p_b) {
+	return _mm_or_ps(_mm_and_ps(p_mask, p_a), _mm_andnot_ps(p_mask, p_b));
+}
+
+template <int m_power, int m_shape>
+static _FORCE_INLINE_ __m128 polynomial_normalized_sse(__m128 u) {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	switch (m_shape) {
+		case SHAPE_IN:
+			return power_sse<m_power>(u);
+		case SHAPE_OUT:
+			return _mm_sub_ps(one, power_sse<m_power>(_mm_sub_ps(one, u)));
+		case SHAPE_IN_OUT: {
+			__m128 s = _mm_mul_ps(u, two);
+			__m128 first = _mm_mul_ps(half, power_sse<m_power>(s));
+			__m128 second = _mm_sub_ps(one, _mm_mul_ps(half, power_sse<m_power>(_mm_sub_ps(two, s))));
+			return select_sse(_mm_cmplt_ps(s, one), first, second);
+		}
+		default: {
+			__m128 s = _mm_mul_ps(u, two);
+			__m128 first = _mm_sub_ps(half, _mm_mul_ps(half, power_sse<m_power>(_mm_sub_ps(one, s))));
+			__m128 second = _mm_add_ps(half, _mm_mul_ps(half, power_sse<m_power>(_mm_sub_ps(s, one))));
+			return select_sse(_mm_cmplt_ps(s, one), first, second);
+		}
+	}
+}
+#endif
+
+template <int m_power, int m_shape>
+static void polynomial(const float *p_times, float *r_values, int p_count, float b, float c, float d) {
+	const float inv_d = 1.0f / d;
+	int i = 0;
+#ifdef EASING_BATCH_SSE2
+	const __m128 vb = _mm_set1_ps(b);
+	const __m128 vc = _mm_set1_ps(c);
+	const __m128 vinv_d = _mm_set1_ps(inv_d);
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 u = _mm_mul_ps(_mm_loadu_ps(p_times + i), vinv_d);
+		_mm_storeu_ps(r_values + i, _mm_add_ps(vb, _mm_mul_ps(vc, polynomial_normalized_sse<m_power, m_shape>(u))));
+	}
+#endif
+	for (; i < p_count; i++) {
+		r_values[i] = b + c * polynomial_normalized<m_power, m_shape>(p_times[i] * inv_d);
+	}
+}
+}; // namespace batch
+
 #endif // EASING_EQUATIONS_H
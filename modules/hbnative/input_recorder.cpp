@@ -0,0 +1,694 @@
+#include "input_recorder.h"
+
+#include "core/input/input.h"
+#include "core/io/marshalls.h"
+#include "core/os/os.h"
+#include "core/templates/sort_array.h"
+#include "scene/main/scene_tree.h"
+
+HBInputRecorder *HBInputRecorder::active = nullptr;
+Ref<HBInputRecorder> HBInputRecorder::command_line_recorder;
+String HBInputRecorder::command_line_record_path;
+
+void HBInputRecorder::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("start_recording"), &HBInputRecorder::start_recording);
+	ClassDB::bind_method(D_METHOD("stop_recording"), &HBInputRecorder::stop_recording);
+	ClassDB::bind_method(D_METHOD("is_recording"), &HBInputRecorder::is_recording);
+	ClassDB::bind_method(D_METHOD("start_replay"), &HBInputRecorder::start_replay);
+	ClassDB::bind_method(D_METHOD("stop_replay"), &HBInputRecorder::stop_replay);
+	ClassDB::bind_method(D_METHOD("is_replaying"), &HBInputRecorder::is_replaying);
+	ClassDB::bind_method(D_METHOD("get_event_count"), &HBInputRecorder::get_event_count);
+	ClassDB::bind_method(D_METHOD("get_duration_usec"), &HBInputRecorder::get_duration_usec);
+	ClassDB::bind_method(D_METHOD("clear"), &HBInputRecorder::clear);
+	ClassDB::bind_method(D_METHOD("save", "path"), &HBInputRecorder::save);
+	ClassDB::bind_method(D_METHOD("load", "path"), &HBInputRecorder::load);
+	ClassDB::bind_method(D_METHOD("get_latency_report"), &HBInputRecorder::get_latency_report);
+	ClassDB::bind_method(D_METHOD("reset_latency_stats"), &HBInputRecorder::reset_latency_stats);
+	ADD_SIGNAL(MethodInfo("replay_finished"));
+}
+
+void HBInputRecorder::_event_monitor(void *p_userdata, const Ref<InputEvent> &p_event, bool p_dispatched) {
+	static_cast<HBInputRecorder *>(p_userdata)->_on_event(p_event, p_dispatched);
+}
+
+void HBInputRecorder::_on_event(const Ref<InputEvent> &p_event, bool p_dispatched) {
+	const uint64_t now = OS::get_singleton()->get_ticks_usec();
+	const uint64_t timestamp = p_event->get_timestamp();
+	MutexLock lock(mutex);
+
+	if (p_dispatched) {
+		if (timestamp != UINT64_MAX && timestamp <= now && latencies_usec.size() < MAX_LATENCY_SAMPLES) {
+			latencies_usec.push_back(MIN(now - timestamp, (uint64_t)UINT32_MAX));
+		}
+		return;
+	}
+
+	if (!recording) {
+		return;
+	}
+	Record record;
+	record.arrival_usec = now - start_ticks_usec;
+	record.has_timestamp = timestamp != UINT64_MAX;
+	record.timestamp_usec = record.has_timestamp ? (int64_t)(timestamp - start_ticks_usec) : 0;
+	// The caller may keep changing its event, such as accumulated mouse motion
+	record.event = p_event->duplicate();
+	records.push_back(record);
+}
+
+Error HBInputRecorder::_activate() {
+	ERR_FAIL_NULL_V(Input::get_singleton(), ERR_UNCONFIGURED);
+	ERR_FAIL_COND_V_MSG(active != nullptr, ERR_BUSY, "Another input recorder is already recording or replaying.");
+	ERR_FAIL_COND_V_MSG(Input::get_singleton()->get_event_monitor_function() != nullptr, ERR_BUSY, "Something else is already monitoring input events.");
+	active = this;
+	Input::get_singleton()->set_event_monitor_function(&HBInputRecorder::_event_monitor, this);
+	return OK;
+}
+
+void HBInputRecorder::_deactivate() {
+	if (active != this) {
+		return;
+	}
+	Input::get_singleton()->set_event_monitor_function(nullptr, nullptr);
+	active = nullptr;
+}
+
+Error HBInputRecorder::start_recording() {
+	ERR_FAIL_COND_V(recording || replaying, ERR_BUSY);
+	Error err = _activate();
+	if (err != OK) {
+		return err;
+	}
+	MutexLock lock(mutex);
+	records.clear();
+	start_ticks_usec = OS::get_singleton()->get_ticks_usec();
+	recording = true;
+	return OK;
+}
+
+void HBInputRecorder::stop_recording() {
+	if (!recording) {
+		return;
+	}
+	_deactivate();
+	MutexLock lock(mutex);
+	recording = false;
+}
+
+bool HBInputRecorder::is_recording() const {
+	return recording;
+}
+
+Error HBInputRecorder::start_replay() {
+	ERR_FAIL_COND_V(recording || replaying, ERR_BUSY);
+	ERR_FAIL_NULL_V_MSG(SceneTree::get_singleton(), ERR_UNCONFIGURED, "Replaying input needs a SceneTree to run on.");
+	Error err = _activate();
+	if (err != OK) {
+		return err;
+	}
+	replay_next = 0;
+	start_ticks_usec = OS::get_singleton()->get_ticks_usec();
+	replaying = true;
+	replay_keep_alive = Ref<RefCounted>(this);
+	SceneTree::get_singleton()->connect(SNAME("process_frame"), callable_mp(this, &HBInputRecorder::_replay_step));
+	return OK;
+}
+
+void HBInputRecorder::_replay_step() {
+	const uint64_t now = OS::get_singleton()->get_ticks_usec();
+	const uint64_t elapsed = now - start_ticks_usec;
+
+	while (replay_next < records.size() && records[replay_next].arrival_usec <= elapsed) {
+		const Record &record = records[replay_next++];
+		// Fresh object every time, Input must not get the same event twice in a frame
+		Ref<InputEvent> event = record.event->duplicate();
+		if (record.has_timestamp) {
+			event->set_timestamp(start_ticks_usec + record.timestamp_usec);
+		}
+		Input::get_singleton()->parse_input_event(event);
+	}
+	// Display servers flush right after delivering their events, so do the same to dispatch them this frame
+	Input::get_singleton()->flush_buffered_events();
+
+	if (replay_next >= records.size()) {
+		_finish_replay();
+	}
+}
+
+void HBInputRecorder::_finish_replay() {
+	SceneTree::get_singleton()->disconnect(SNAME("process_frame"), callable_mp(this, &HBInputRecorder::_replay_step));
+	_deactivate();
+	replaying = false;
+
+	emit_signal(SNAME("replay_finished"));
+	if (quit_after_replay) {
+		SceneTree::get_singleton()->quit();
+	}
+	// Might be the last reference
+	replay_keep_alive.unref();
+}
+
+void HBInputRecorder::stop_replay() {
+	if (replaying) {
+		_finish_replay();
+	}
+}
+
+bool HBInputRecorder::is_replaying() const {
+	return replaying;
+}
+
+int HBInputRecorder::get_event_count() const {
+	MutexLock lock(mutex);
+	return records.size();
+}
+
+uint64_t HBInputRecorder::get_duration_usec() const {
+	MutexLock lock(mutex);
+	return records.is_empty() ? 0 : records[records.size() - 1].arrival_usec;
+}
+
+void HBInputRecorder::clear() {
+	ERR_FAIL_COND(recording || replaying);
+	MutexLock lock(mutex);
+	records.clear();
+}
+
+void HBInputRecorder::_store_event(Ref<FileAccess> p_file, const Ref<InputEvent> &p_event) {
+	RecordType type = RECORD_PROPERTIES;
+	if (Object::cast_to<InputEventKey>(*p_event)) {
+		type = RECORD_KEY;
+	} else if (Object::cast_to<InputEventJoypadButton>(*p_event)) {
+		type = RECORD_JOYPAD_BUTTON;
+	} else if (Object::cast_to<InputEventJoypadMotion>(*p_event)) {
+		type = RECORD_JOYPAD_MOTION;
+	} else if (Object::cast_to<InputEventMouseButton>(*p_event)) {
+		type = RECORD_MOUSE_BUTTON;
+	} else if (Object::cast_to<InputEventAction>(*p_event)) {
+		type = RECORD_ACTION;
+	} else if (Object::cast_to<InputEventMouseMotion>(*p_event)) {
+		type = RECORD_MOUSE_MOTION;
+	} else if (Object::cast_to<InputEventScreenTouch>(*p_event)) {
+		type = RECORD_SCREEN_TOUCH;
+	} else if (Object::cast_to<InputEventScreenDrag>(*p_event)) {
+		type = RECORD_SCREEN_DRAG;
+	} else if (Object::cast_to<InputEventMagnifyGesture>(*p_event)) {
+		type = RECORD_MAGNIFY_GESTURE;
+	} else if (Object::cast_to<InputEventPanGesture>(*p_event)) {
+		type = RECORD_PAN_GESTURE;
+	} else if (Object::cast_to<InputEventMIDI>(*p_event)) {
+		type = RECORD_MIDI;
+	}
+	p_file->store_8(type);
+
+	if (type == RECORD_PROPERTIES) {
+		// Only plain values, objects (the script included) are left out so loading never has to create one
+		List<PropertyInfo> properties;
+		p_event->get_property_list(&properties);
+		LocalVector<const PropertyInfo *> stored;
+		for (const PropertyInfo &property : properties) {
+			if ((property.usage & PROPERTY_USAGE_STORAGE) && property.type != Variant::OBJECT) {
+				stored.push_back(&property);
+			}
+		}
+		p_file->store_pascal_string(p_event->get_class());
+		p_file->store_32(stored.size());
+		for (const PropertyInfo *property : stored) {
+			p_file->store_pascal_string(property->name);
+			p_file->store_var(p_event->get(property->name), false);
+		}
+		return;
+	}
+
+	// Every other record starts with what its base classes have
+	p_file->store_32(p_event->get_device());
+	Ref<InputEventFromWindow> from_window = p_event;
+	if (from_window.is_valid()) {
+		p_file->store_64(from_window->get_window_id());
+	}
+	Ref<InputEventWithModifiers> with_modifiers = p_event;
+	if (with_modifiers.is_valid()) {
+		p_file->store_8(with_modifiers->is_shift_pressed() | with_modifiers->is_alt_pressed() << 1 | with_modifiers->is_ctrl_pressed() << 2 | with_modifiers->is_meta_pressed() << 3 | with_modifiers->is_command_or_control_autoremap() << 4);
+	}
+	Ref<InputEventMouse> mouse = p_event;
+	if (mouse.is_valid()) {
+		p_file->store_32((uint32_t)mouse->get_button_mask());
+		_store_vector2(p_file, mouse->get_position());
+		_store_vector2(p_file, mouse->get_global_position());
+	}
+
+	switch (type) {
+		case RECORD_KEY: {
+			Ref<InputEventKey> key = p_event;
+			p_file->store_32((uint32_t)key->get_keycode());
+			p_file->store_32((uint32_t)key->get_physical_keycode());
+			p_file->store_32((uint32_t)key->get_key_label());
+			p_file->store_32(key->get_unicode());
+			p_file->store_8((uint8_t)key->get_location());
+			p_file->store_8(key->is_pressed() | key->is_echo() << 1);
+		} break;
+		case RECORD_JOYPAD_BUTTON: {
+			Ref<InputEventJoypadButton> joypad_button = p_event;
+			p_file->store_8((uint8_t)joypad_button->get_button_index());
+			p_file->store_8(joypad_button->is_pressed());
+			p_file->store_float(joypad_button->get_pressure());
+		} break;
+		case RECORD_JOYPAD_MOTION: {
+			Ref<InputEventJoypadMotion> joypad_motion = p_event;
+			p_file->store_8((uint8_t)joypad_motion->get_axis());
+			p_file->store_float(joypad_motion->get_axis_value());
+		} break;
+		case RECORD_MOUSE_BUTTON: {
+			Ref<InputEventMouseButton> mouse_button = p_event;
+			p_file->store_float(mouse_button->get_factor());
+			p_file->store_8((uint8_t)mouse_button->get_button_index());
+			p_file->store_8(mouse_button->is_pressed() | mouse_button->is_double_click() << 1 | mouse_button->is_canceled() << 2);
+		} break;
+		case RECORD_ACTION: {
+			Ref<InputEventAction> action = p_event;
+			p_file->store_pascal_string(action->get_action());
+			p_file->store_8(action->is_pressed());
+			p_file->store_float(action->get_strength());
+			p_file->store_32(action->get_event_index());
+		} break;
+		case RECORD_MOUSE_MOTION: {
+			Ref<InputEventMouseMotion> mouse_motion = p_event;
+			_store_vector2(p_file, mouse_motion->get_tilt());
+			p_file->store_float(mouse_motion->get_pressure());
+			p_file->store_8(mouse_motion->get_pen_inverted());
+			_store_vector2(p_file, mouse_motion->get_relative());
+			_store_vector2(p_file, mouse_motion->get_relative_screen_position());
+			_store_vector2(p_file, mouse_motion->get_velocity());
+			_store_vector2(p_file, mouse_motion->get_screen_velocity());
+		} break;
+		case RECORD_SCREEN_TOUCH: {
+			Ref<InputEventScreenTouch> screen_touch = p_event;
+			p_file->store_32(screen_touch->get_index());
+			_store_vector2(p_file, screen_touch->get_position());
+			p_file->store_8(screen_touch->is_pressed() | screen_touch->is_canceled() << 1 | screen_touch->is_double_tap() << 2);
+		} break;
+		case RECORD_SCREEN_DRAG: {
+			Ref<InputEventScreenDrag> screen_drag = p_event;
+			p_file->store_32(screen_drag->get_index());
+			_store_vector2(p_file, screen_drag->get_tilt());
+			p_file->store_float(screen_drag->get_pressure());
+			p_file->store_8(screen_drag->get_pen_inverted());
+			_store_vector2(p_file, screen_drag->get_position());
+			_store_vector2(p_file, screen_drag->get_relative());
+			_store_vector2(p_file, screen_drag->get_relative_screen_position());
+			_store_vector2(p_file, screen_drag->get_velocity());
+			_store_vector2(p_file, screen_drag->get_screen_velocity());
+		} break;
+		case RECORD_MAGNIFY_GESTURE: {
+			Ref<InputEventMagnifyGesture> magnify_gesture = p_event;
+			_store_vector2(p_file, magnify_gesture->get_position());
+			p_file->store_float(magnify_gesture->get_factor());
+		} break;
+		case RECORD_PAN_GESTURE: {
+			Ref<InputEventPanGesture> pan_gesture = p_event;
+			_store_vector2(p_file, pan_gesture->get_position());
+			_store_vector2(p_file, pan_gesture->get_delta());
+		} break;
+		case RECORD_MIDI: {
+			Ref<InputEventMIDI> midi = p_event;
+			p_file->store_32(midi->get_channel());
+			p_file->store_32((uint32_t)midi->get_message());
+			p_file->store_32(midi->get_pitch());
+			p_file->store_32(midi->get_velocity());
+			p_file->store_32(midi->get_instrument());
+			p_file->store_32(midi->get_pressure());
+			p_file->store_32(midi->get_controller_number());
+			p_file->store_32(midi->get_controller_value());
+		} break;
+		case RECORD_PROPERTIES: {
+		} break;
+	}
+}
+
+void HBInputRecorder::_store_vector2(Ref<FileAccess> p_file, const Vector2 &p_vector) {
+	p_file->store_float(p_vector.x);
+	p_file->store_float(p_vector.y);
+}
+
+Vector2 HBInputRecorder::_load_vector2(Ref<FileAccess> p_file) {
+	Vector2 vector;
+	vector.x = p_file->get_float();
+	vector.y = p_file->get_float();
+	return vector;
+}
+
+// FileAccess::get_pascal_string and get_var trust the stored length, these check it against what's left of the file
+bool HBInputRecorder::_load_string(Ref<FileAccess> p_file, String &r_string) {
+	const uint32_t length = p_file->get_32();
+	if (p_file->eof_reached() || length > p_file->get_length() - p_file->get_position()) {
+		return false;
+	}
+	CharString utf8;
+	utf8.resize(length + 1);
+	p_file->get_buffer((uint8_t *)utf8.ptrw(), length);
+	utf8[length] = 0;
+	r_string.parse_utf8(utf8.get_data());
+	return true;
+}
+
+bool HBInputRecorder::_load_value(Ref<FileAccess> p_file, Variant &r_value) {
+	const uint32_t length = p_file->get_32();
+	if (p_file->eof_reached() || length > p_file->get_length() - p_file->get_position()) {
+		return false;
+	}
+	const Vector<uint8_t> buffer = p_file->get_buffer(length);
+	// No objects, not even as IDs
+	return decode_variant(r_value, buffer.ptr(), buffer.size(), nullptr, false) == OK && r_value.get_type() != Variant::OBJECT;
+}
+
+Ref<InputEvent> HBInputRecorder::_load_event(Ref<FileAccess> p_file) {
+	const uint8_t type = p_file->get_8();
+
+	if (type == RECORD_PROPERTIES) {
+		String class_name;
+		if (!_load_string(p_file, class_name)) {
+			return Ref<InputEvent>();
+		}
+		// Checked before anything gets created, script classes aren't in ClassDB so they can't get through either
+		if (!ClassDB::class_exists(class_name) || !ClassDB::is_parent_class(class_name, SNAME("InputEvent")) || !ClassDB::can_instantiate(class_name)) {
+			return Ref<InputEvent>();
+		}
+		const uint32_t property_count = p_file->get_32();
+		Ref<InputEvent> event = Object::cast_to<InputEvent>(ClassDB::instantiate(class_name));
+		ERR_FAIL_COND_V(event.is_null(), Ref<InputEvent>());
+		for (uint32_t i = 0; i < property_count; i++) {
+			String name;
+			Variant value;
+			if (!_load_string(p_file, name) || !_load_value(p_file, value)) {
+				return Ref<InputEvent>();
+			}
+			event->set(name, value);
+		}
+		return event;
+	}
+
+	Ref<InputEvent> event;
+	switch (type) {
+		case RECORD_KEY: {
+			event = Ref<InputEventKey>(memnew(InputEventKey));
+		} break;
+		case RECORD_JOYPAD_BUTTON: {
+			event = Ref<InputEventJoypadButton>(memnew(InputEventJoypadButton));
+		} break;
+		case RECORD_JOYPAD_MOTION: {
+			event = Ref<InputEventJoypadMotion>(memnew(InputEventJoypadMotion));
+		} break;
+		case RECORD_MOUSE_BUTTON: {
+			event = Ref<InputEventMouseButton>(memnew(InputEventMouseButton));
+		} break;
+		case RECORD_ACTION: {
+			event = Ref<InputEventAction>(memnew(InputEventAction));
+		} break;
+		case RECORD_MOUSE_MOTION: {
+			event = Ref<InputEventMouseMotion>(memnew(InputEventMouseMotion));
+		} break;
+		case RECORD_SCREEN_TOUCH: {
+			event = Ref<InputEventScreenTouch>(memnew(InputEventScreenTouch));
+		} break;
+		case RECORD_SCREEN_DRAG: {
+			event = Ref<InputEventScreenDrag>(memnew(InputEventScreenDrag));
+		} break;
+		case RECORD_MAGNIFY_GESTURE: {
+			event = Ref<InputEventMagnifyGesture>(memnew(InputEventMagnifyGesture));
+		} break;
+		case RECORD_PAN_GESTURE: {
+			event = Ref<InputEventPanGesture>(memnew(InputEventPanGesture));
+		} break;
+		case RECORD_MIDI: {
+			event = Ref<InputEventMIDI>(memnew(InputEventMIDI));
+		} break;
+		default: {
+			return Ref<InputEvent>();
+		}
+	}
+
+	event->set_device((int32_t)p_file->get_32());
+	Ref<InputEventFromWindow> from_window = event;
+	if (from_window.is_valid()) {
+		from_window->set_window_id(p_file->get_64());
+	}
+	Ref<InputEventWithModifiers> with_modifiers = event;
+	if (with_modifiers.is_valid()) {
+		const uint8_t modifiers = p_file->get_8();
+		with_modifiers->set_shift_pressed(modifiers & 1);
+		with_modifiers->set_alt_pressed(modifiers & 2);
+		with_modifiers->set_ctrl_pressed(modifiers & 4);
+		with_modifiers->set_meta_pressed(modifiers & 8);
+		with_modifiers->set_command_or_control_autoremap(modifiers & 16);
+	}
+	Ref<InputEventMouse> mouse = event;
+	if (mouse.is_valid()) {
+		mouse->set_button_mask(BitField<MouseButtonMask>(p_file->get_32()));
+		mouse->set_position(_load_vector2(p_file));
+		mouse->set_global_position(_load_vector2(p_file));
+	}
+
+	switch (type) {
+		case RECORD_KEY: {
+			Ref<InputEventKey> key = event;
+			key->set_keycode((Key)p_file->get_32());
+			key->set_physical_keycode((Key)p_file->get_32());
+			key->set_key_label((Key)p_file->get_32());
+			key->set_unicode(p_file->get_32());
+			key->set_location((KeyLocation)p_file->get_8());
+			const uint8_t flags = p_file->get_8();
+			key->set_pressed(flags & 1);
+			key->set_echo(flags & 2);
+		} break;
+		case RECORD_JOYPAD_BUTTON: {
+			Ref<InputEventJoypadButton> joypad_button = event;
+			joypad_button->set_button_index((JoyButton)p_file->get_8());
+			joypad_button->set_pressed(p_file->get_8());
+			joypad_button->set_pressure(p_file->get_float());
+		} break;
+		case RECORD_JOYPAD_MOTION: {
+			Ref<InputEventJoypadMotion> joypad_motion = event;
+			joypad_motion->set_axis((JoyAxis)p_file->get_8());
+			joypad_motion->set_axis_value(p_file->get_float());
+		} break;
+		case RECORD_MOUSE_BUTTON: {
+			Ref<InputEventMouseButton> mouse_button = event;
+			mouse_button->set_factor(p_file->get_float());
+			mouse_button->set_button_index((MouseButton)p_file->get_8());
+			const uint8_t flags = p_file->get_8();
+			mouse_button->set_pressed(flags & 1);
+			mouse_button->set_double_click(flags & 2);
+			mouse_button->set_canceled(flags & 4);
+		} break;
+		case RECORD_ACTION: {
+			Ref<InputEventAction> action = event;
+			String name;
+			if (!_load_string(p_file, name)) {
+				return Ref<InputEvent>();
+			}
+			action->set_action(name);
+			action->set_pressed(p_file->get_8());
+			action->set_strength(p_file->get_float());
+			action->set_event_index((int32_t)p_file->get_32());
+		} break;
+		case RECORD_MOUSE_MOTION: {
+			Ref<InputEventMouseMotion> mouse_motion = event;
+			mouse_motion->set_tilt(_load_vector2(p_file));
+			mouse_motion->set_pressure(p_file->get_float());
+			mouse_motion->set_pen_inverted(p_file->get_8());
+			mouse_motion->set_relative(_load_vector2(p_file));
+			mouse_motion->set_relative_screen_position(_load_vector2(p_file));
+			mouse_motion->set_velocity(_load_vector2(p_file));
+			mouse_motion->set_screen_velocity(_load_vector2(p_file));
+		} break;
+		case RECORD_SCREEN_TOUCH: {
+			Ref<InputEventScreenTouch> screen_touch = event;
+			screen_touch->set_index((int32_t)p_file->get_32());
+			screen_touch->set_position(_load_vector2(p_file));
+			const uint8_t flags = p_file->get_8();
+			screen_touch->set_pressed(flags & 1);
+			screen_touch->set_canceled(flags & 2);
+			screen_touch->set_double_tap(flags & 4);
+		} break;
+		case RECORD_SCREEN_DRAG: {
+			Ref<InputEventScreenDrag> screen_drag = event;
+			screen_drag->set_index((int32_t)p_file->get_32());
+			screen_drag->set_tilt(_load_vector2(p_file));
+			screen_drag->set_pressure(p_file->get_float());
+			screen_drag->set_pen_inverted(p_file->get_8());
+			screen_drag->set_position(_load_vector2(p_file));
+			screen_drag->set_relative(_load_vector2(p_file));
+			screen_drag->set_relative_screen_position(_load_vector2(p_file));
+			screen_drag->set_velocity(_load_vector2(p_file));
+			screen_drag->set_screen_velocity(_load_vector2(p_file));
+		} break;
+		case RECORD_MAGNIFY_GESTURE: {
+			Ref<InputEventMagnifyGesture> magnify_gesture = event;
+			magnify_gesture->set_position(_load_vector2(p_file));
+			magnify_gesture->set_factor(p_file->get_float());
+		} break;
+		case RECORD_PAN_GESTURE: {
+			Ref<InputEventPanGesture> pan_gesture = event;
+			pan_gesture->set_position(_load_vector2(p_file));
+			pan_gesture->set_delta(_load_vector2(p_file));
+		} break;
+		case RECORD_MIDI: {
+			Ref<InputEventMIDI> midi = event;
+			midi->set_channel((int32_t)p_file->get_32());
+			midi->set_message((MIDIMessage)p_file->get_32());
+			midi->set_pitch((int32_t)p_file->get_32());
+			midi->set_velocity((int32_t)p_file->get_32());
+			midi->set_instrument((int32_t)p_file->get_32());
+			midi->set_pressure((int32_t)p_file->get_32());
+			midi->set_controller_number((int32_t)p_file->get_32());
+			midi->set_controller_value((int32_t)p_file->get_32());
+		} break;
+	}
+	return event;
+}
+
+Error HBInputRecorder::save(const String &p_path) const {
+	ERR_FAIL_COND_V(recording, ERR_BUSY);
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, vformat("Couldn't open %s for writing.", p_path));
+
+	MutexLock lock(mutex);
+	file->store_32(RECORDING_MAGIC);
+	file->store_32(RECORDING_VERSION);
+	file->store_32(records.size());
+	for (const Record &record : records) {
+		file->store_64(record.arrival_usec);
+		file->store_8(record.has_timestamp);
+		if (record.has_timestamp) {
+			file->store_64(record.timestamp_usec);
+		}
+		_store_event(file, record.event);
+	}
+	return OK;
+}
+
+Error HBInputRecorder::load(const String &p_path) {
+	ERR_FAIL_COND_V(recording || replaying, ERR_BUSY);
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, vformat("Couldn't open %s.", p_path));
+	ERR_FAIL_COND_V_MSG(file->get_32() != RECORDING_MAGIC || file->get_32() != RECORDING_VERSION, ERR_FILE_UNRECOGNIZED, vformat("%s is not an input recording.", p_path));
+
+	const uint32_t count = file->get_32();
+	// A corrupt count shouldn't get to reserve gigabytes
+	ERR_FAIL_COND_V_MSG(file->eof_reached() || count > (file->get_length() - file->get_position()) / MIN_RECORD_SIZE, ERR_FILE_CORRUPT, vformat("Input recording %s is corrupt.", p_path));
+	LocalVector<Record> loaded;
+	loaded.reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		Record record;
+		record.arrival_usec = file->get_64();
+		record.has_timestamp = file->get_8();
+		if (record.has_timestamp) {
+			record.timestamp_usec = file->get_64();
+		}
+		record.event = _load_event(file);
+		ERR_FAIL_COND_V_MSG(record.event.is_null() || file->eof_reached(), ERR_FILE_CORRUPT, vformat("Input recording %s is corrupt.", p_path));
+		ERR_FAIL_COND_V_MSG(!loaded.is_empty() && record.arrival_usec < loaded[loaded.size() - 1].arrival_usec, ERR_FILE_CORRUPT, vformat("Input recording %s is corrupt.", p_path));
+		loaded.push_back(record);
+	}
+
+	MutexLock lock(mutex);
+	records = loaded;
+	return OK;
+}
+
+Dictionary HBInputRecorder::get_latency_report() const {
+	LocalVector<uint32_t> sorted;
+	{
+		MutexLock lock(mutex);
+		sorted = latencies_usec;
+	}
+	Dictionary report;
+	report["count"] = sorted.size();
+	if (sorted.is_empty()) {
+		return report;
+	}
+	SortArray<uint32_t> sorter;
+	sorter.sort(sorted.ptr(), sorted.size());
+
+	// Nearest rank
+	const uint32_t count = sorted.size();
+	report["min"] = sorted[0];
+	report["p50"] = sorted[(count - 1) * 50 / 100];
+	report["p90"] = sorted[(count - 1) * 90 / 100];
+	report["p99"] = sorted[(count - 1) * 99 / 100];
+	report["max"] = sorted[count - 1];
+	return report;
+}
+
+void HBInputRecorder::reset_latency_stats() {
+	MutexLock lock(mutex);
+	latencies_usec.clear();
+}
+
+void HBInputRecorder::_start_from_command_line(const String &p_replay_path, bool p_quit) {
+	if (!SceneTree::get_singleton()) {
+		// The main loop isn't there yet this early in startup
+		callable_mp_static(&HBInputRecorder::_start_from_command_line).call_deferred(p_replay_path, p_quit);
+		return;
+	}
+	Ref<HBInputRecorder> recorder;
+	recorder.instantiate();
+	Error err = recorder->load(p_replay_path);
+	ERR_FAIL_COND_MSG(err != OK, vformat("Couldn't load input recording %s.", p_replay_path));
+	recorder->quit_after_replay = p_quit;
+	recorder->connect(SNAME("replay_finished"), callable_mp(recorder.ptr(), &HBInputRecorder::_print_latency_report));
+	print_line(vformat("Replaying %d input events from %s.", recorder->get_event_count(), p_replay_path));
+	err = recorder->start_replay();
+	ERR_FAIL_COND_MSG(err != OK, "Couldn't start the input replay.");
+}
+
+void HBInputRecorder::_print_latency_report() {
+	Dictionary report = get_latency_report();
+	if ((int)report["count"] == 0) {
+		print_line("Input replay finished, no timestamped events were dispatched.");
+		return;
+	}
+	print_line(vformat("Input replay finished, timestamp to dispatch latency of %d events (usec): min %d, p50 %d, p90 %d, p99 %d, max %d.",
+			report["count"], report["min"], report["p50"], report["p90"], report["p99"], report["max"]));
+}
+
+void HBInputRecorder::initialize_command_line() {
+	String replay_path;
+	bool quit = false;
+	List<String> args = OS::get_singleton()->get_cmdline_args();
+	for (List<String>::Element *E = args.front(); E; E = E->next()) {
+		if (E->get() == "--hb-input-record" && E->next()) {
+			command_line_record_path = E->next()->get();
+		} else if (E->get() == "--hb-input-replay" && E->next()) {
+			replay_path = E->next()->get();
+		} else if (E->get() == "--hb-input-replay-quit") {
+			quit = true;
+		}
+	}
+
+	if (!command_line_record_path.is_empty()) {
+		command_line_recorder.instantiate();
+		if (command_line_recorder->start_recording() != OK) {
+			command_line_recorder.unref();
+		}
+	}
+	if (!replay_path.is_empty()) {
+		callable_mp_static(&HBInputRecorder::_start_from_command_line).call_deferred(replay_path, quit);
+	}
+}
+
+void HBInputRecorder::finalize_command_line() {
+	if (command_line_recorder.is_null()) {
+		return;
+	}
+	command_line_recorder->stop_recording();
+	if (command_line_recorder->save(command_line_record_path) == OK) {
+		print_line(vformat("Saved %d input events to %s.", command_line_recorder->get_event_count(), command_line_record_path));
+	}
+	command_line_recorder.unref();
+}
+
+HBInputRecorder::~HBInputRecorder() {
+	_deactivate();
+}
@@ -0,0 +1,116 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include "core/input/input_event.h"
+#include "core/io/file_access.h"
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+
+// Records every event Input::parse_input_event sees along with when it arrived, and replays them through the same
+// path with the original timings. While recording or replaying it also measures how long timestamped events take
+// from their timestamp to being dispatched.
+// Can be driven from the command line with --hb-input-record <file> and --hb-input-replay <file>, adding
+// --hb-input-replay-quit quits once the replay is done after printing the latency report.
+class HBInputRecorder : public RefCounted {
+	GDCLASS(HBInputRecorder, RefCounted);
+
+	static const uint32_t RECORDING_MAGIC = 0x52494248; // HBIR
+	static const uint32_t RECORDING_VERSION = 2;
+	// Arrival time, timestamp flag and record type, every record takes at least this much
+	static const uint32_t MIN_RECORD_SIZE = 10;
+	// Latencies past this many events are dropped, so long sessions don't grow forever
+	static const uint32_t MAX_LATENCY_SAMPLES = 1 << 20;
+
+public:
+	// Stored before every event in recordings, so values must never change
+	enum RecordType {
+		RECORD_KEY,
+		RECORD_JOYPAD_BUTTON,
+		RECORD_JOYPAD_MOTION,
+		RECORD_MOUSE_BUTTON,
+		RECORD_ACTION,
+		RECORD_MOUSE_MOTION,
+		RECORD_SCREEN_TOUCH,
+		RECORD_SCREEN_DRAG,
+		RECORD_MAGNIFY_GESTURE,
+		RECORD_PAN_GESTURE,
+		RECORD_MIDI,
+		// Anything else, as its class name and the values of its stored properties. Loading only creates
+		// classes deriving from InputEvent and never any object held in a property.
+		RECORD_PROPERTIES,
+	};
+
+private:
+	struct Record {
+		// Since the recording started
+		uint64_t arrival_usec = 0;
+		bool has_timestamp = false;
+		// Event timestamp relative to the start, input backends may stamp events from before it
+		int64_t timestamp_usec = 0;
+		Ref<InputEvent> event;
+	};
+
+	LocalVector<Record> records;
+	LocalVector<uint32_t> latencies_usec;
+	mutable Mutex mutex;
+
+	bool recording = false;
+	bool replaying = false;
+	uint64_t start_ticks_usec = 0;
+	uint32_t replay_next = 0;
+	bool quit_after_replay = false;
+	Ref<RefCounted> replay_keep_alive;
+
+	static HBInputRecorder *active;
+	static Ref<HBInputRecorder> command_line_recorder;
+	static String command_line_record_path;
+
+	static void _event_monitor(void *p_userdata, const Ref<InputEvent> &p_event, bool p_dispatched);
+	void _on_event(const Ref<InputEvent> &p_event, bool p_dispatched);
+	Error _activate();
+	void _deactivate();
+	void _replay_step();
+	void _finish_replay();
+
+	static void _store_event(Ref<FileAccess> p_file, const Ref<InputEvent> &p_event);
+	static Ref<InputEvent> _load_event(Ref<FileAccess> p_file);
+	static void _store_vector2(Ref<FileAccess> p_file, const Vector2 &p_vector);
+	static Vector2 _load_vector2(Ref<FileAccess> p_file);
+	static bool _load_string(Ref<FileAccess> p_file, String &r_string);
+	static bool _load_value(Ref<FileAccess> p_file, Variant &r_value);
+	static void _start_from_command_line(const String &p_replay_path, bool p_quit);
+	void _print_latency_report();
+
+protected:
+	static void _bind_methods();
+
+public:
+	Error start_recording();
+	void stop_recording();
+	bool is_recording() const;
+
+	// Replays from the main thread once per process frame, like display servers deliver events.
+	// Timestamps are moved to the replay's timeline keeping their distance from when the event arrived.
+	Error start_replay();
+	void stop_replay();
+	bool is_replaying() const;
+
+	int get_event_count() const;
+	uint64_t get_duration_usec() const;
+	void clear();
+
+	Error save(const String &p_path) const;
+	Error load(const String &p_path);
+
+	// Timestamp to dispatch latency in microseconds, as count, min, p50, p90, p99 and max
+	Dictionary get_latency_report() const;
+	void reset_latency_stats();
+
+	static void initialize_command_line();
+	static void finalize_command_line();
+
+	~HBInputRecorder();
+};
+
+#endif // INPUT_RECORDER_H
@@ -1,33 +1,197 @@
 #include "interval_tree.h"
+#include "core/templates/sort_array.h"
 
 void HBIntervalTree::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("insert", "low", "high", "value"), &HBIntervalTree::insert);
 	ClassDB::bind_method(D_METHOD("erase", "low", "high", "value"), &HBIntervalTree::erase);
 	ClassDB::bind_method(D_METHOD("query_point", "query_point"), &HBIntervalTree::query_point);
+	ClassDB::bind_method(D_METHOD("query_point_ids", "query_point"), &HBIntervalTree::_query_point_ids_bind);
+	ClassDB::bind_method(D_METHOD("query_range_ids", "low", "high"), &HBIntervalTree::_query_range_ids_bind);
+	ClassDB::bind_method(D_METHOD("query_sweep", "sorted_points"), &HBIntervalTree::_query_sweep_bind);
+	ClassDB::bind_method(D_METHOD("get_interval_count"), &HBIntervalTree::get_interval_count);
 	ClassDB::bind_method(D_METHOD("clear"), &HBIntervalTree::clear);
 }
 
+struct FlatIntervalSort {
+	_FORCE_INLINE_ bool operator()(const Intervals::Interval<int64_t, ObjectID> &p_a, const Intervals::Interval<int64_t, ObjectID> &p_b) const {
+		if (p_a.low != p_b.low) {
+			return p_a.low < p_b.low;
+		}
+		if (p_a.high != p_b.high) {
+			return p_a.high < p_b.high;
+		}
+		return p_a.value < p_b.value;
+	}
+};
+
+int64_t HBIntervalTree::_build_max_highs(uint32_t p_begin, uint32_t p_end) const {
+	if (p_begin >= p_end) {
+		return INT64_MIN;
+	}
+	const uint32_t mid = p_begin + (p_end - p_begin) / 2;
+	int64_t max_high = MAX(flat.highs[mid], MAX(_build_max_highs(p_begin, mid), _build_max_highs(mid + 1, p_end)));
+	flat.max_highs[mid] = max_high;
+	return max_high;
+}
+
+void HBIntervalTree::_update_flat() const {
+	if (!flat_dirty.is_set()) {
+		return;
+	}
+	MutexLock lock(flat_mutex);
+	if (!flat_dirty.is_set()) {
+		// Another query got here first
+		return;
+	}
+
+	IntervalTree::Intervals intervals = tree.intervals();
+	SortArray<IntervalTree::Interval, FlatIntervalSort> sorter;
+	sorter.sort(intervals.data(), intervals.size());
+
+	const uint32_t count = intervals.size();
+	flat.lows.resize(count);
+	flat.highs.resize(count);
+	flat.max_highs.resize(count);
+	flat.ids.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		flat.lows[i] = intervals[i].low;
+		flat.highs[i] = intervals[i].high;
+		flat.ids[i] = (int64_t)(uint64_t)intervals[i].value;
+	}
+	_build_max_highs(0, count);
+	// Cleared last, queries that see it clear skip the lock and read flat straight away
+	flat_dirty.clear();
+}
+
+void HBIntervalTree::_query_range(uint32_t p_begin, uint32_t p_end, int64_t p_low, int64_t p_high, LocalVector<int64_t> &r_ids) const {
+	if (p_begin >= p_end) {
+		return;
+	}
+	const uint32_t mid = p_begin + (p_end - p_begin) / 2;
+	if (flat.max_highs[mid] < p_low) {
+		// Everything in this subtree ends before the range
+		return;
+	}
+	_query_range(p_begin, mid, p_low, p_high, r_ids);
+	if (flat.lows[mid] > p_high) {
+		// This and everything to the right starts after the range
+		return;
+	}
+	if (flat.highs[mid] >= p_low) {
+		r_ids.push_back(flat.ids[mid]);
+	}
+	_query_range(mid + 1, p_end, p_low, p_high, r_ids);
+}
+
 void HBIntervalTree::insert(int64_t p_low, int64_t p_high, ObjectID p_value) {
 	IntervalTree::Interval interval{ p_low, p_high, p_value };
 	ERR_FAIL_COND(!tree.insert(interval));
+	flat_dirty.set();
 }
 
 void HBIntervalTree::erase(int64_t p_low, int64_t p_high, ObjectID p_value) {
 	IntervalTree::Interval interval{ p_low, p_high, p_value };
 	ERR_FAIL_COND(!tree.remove(interval));
+	flat_dirty.set();
 }
 
 TypedArray<Object> HBIntervalTree::query_point(int64_t p_point) const {
-	IntervalTree::Intervals intervals = tree.findIntervalsContainPoint(p_point);
+	LocalVector<int64_t> ids;
+	query_range_ids(p_point, p_point, ids);
 	TypedArray<Object> intervals_out;
-	intervals_out.resize(intervals.size());
+	intervals_out.resize(ids.size());
 
-	for (int i = 0; i < (int)intervals.size(); i++) {
-		intervals_out[i] = ObjectDB::get_instance(intervals[i].value);
+	for (uint32_t i = 0; i < ids.size(); i++) {
+		intervals_out[i] = ObjectDB::get_instance(ObjectID(ids[i]));
 	}
 	return intervals_out;
 }
 
 void HBIntervalTree::clear() {
 	tree.clear();
+	flat_dirty.set();
+}
+
+int HBIntervalTree::get_interval_count() const {
+	return tree.size();
+}
+
+void HBIntervalTree::query_range_ids(int64_t p_low, int64_t p_high, LocalVector<int64_t> &r_ids) const {
+	r_ids.clear();
+	ERR_FAIL_COND_MSG(p_low > p_high, "Query range low must not be greater than high.");
+	_update_flat();
+	_query_range(0, flat.lows.size(), p_low, p_high, r_ids);
+}
+
+void HBIntervalTree::query_sweep(const int64_t *p_points, uint32_t p_point_count, LocalVector<int64_t> &r_ids, LocalVector<uint32_t> &r_offsets) const {
+	r_ids.clear();
+	r_offsets.clear();
+	r_offsets.push_back(0);
+	_update_flat();
+
+	// Intervals that started at or before the current point and haven't been seen ending yet, in order of their low.
+	// Per thread scratch, so sweeps neither allocate every call nor share state between threads.
+	static thread_local LocalVector<uint32_t> sweep_active;
+	sweep_active.clear();
+	uint32_t next = 0;
+	for (uint32_t i = 0; i < p_point_count; i++) {
+		const int64_t point = p_points[i];
+		if (i > 0 && point < p_points[i - 1]) {
+			ERR_PRINT("Sweep points must be sorted in ascending order.");
+			r_ids.clear();
+			r_offsets.clear();
+			return;
+		}
+
+		while (next < flat.lows.size() && flat.lows[next] <= point) {
+			sweep_active.push_back(next++);
+		}
+
+		// Points only move forward, so intervals that ended before this one are gone for good
+		uint32_t active_count = 0;
+		for (uint32_t j = 0; j < sweep_active.size(); j++) {
+			const uint32_t interval = sweep_active[j];
+			if (flat.highs[interval] >= point) {
+				sweep_active[active_count++] = interval;
+				r_ids.push_back(flat.ids[interval]);
+			}
+		}
+		sweep_active.resize(active_count);
+		r_offsets.push_back(r_ids.size());
+	}
+}
+
+PackedInt64Array HBIntervalTree::_query_point_ids_bind(int64_t p_point) const {
+	return _query_range_ids_bind(p_point, p_point);
+}
+
+PackedInt64Array HBIntervalTree::_query_range_ids_bind(int64_t p_low, int64_t p_high) const {
+	LocalVector<int64_t> ids;
+	query_range_ids(p_low, p_high, ids);
+	PackedInt64Array out;
+	out.resize(ids.size());
+	memcpy(out.ptrw(), ids.ptr(), ids.size() * sizeof(int64_t));
+	return out;
+}
+
+// Returns [ids, offsets] as a PackedInt64Array and a PackedInt32Array, see query_sweep
+Array HBIntervalTree::_query_sweep_bind(const PackedInt64Array &p_points) const {
+	LocalVector<int64_t> ids;
+	LocalVector<uint32_t> offsets;
+	query_sweep(p_points.ptr(), p_points.size(), ids, offsets);
+
+	PackedInt64Array ids_out;
+	ids_out.resize(ids.size());
+	memcpy(ids_out.ptrw(), ids.ptr(), ids.size() * sizeof(int64_t));
+	PackedInt32Array offsets_out;
+	offsets_out.resize(offsets.size());
+	int32_t *offsets_w = offsets_out.ptrw();
+	for (uint32_t i = 0; i < offsets.size(); i++) {
+		offsets_w[i] = offsets[i];
+	}
+
+	Array out;
+	out.push_back(ids_out);
+	out.push_back(offsets_out);
+	return out;
 }
@@ -2,6 +2,9 @@
 #define INTERVAL_TREE_GD_H
 
 #include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+#include "core/templates/safe_refcount.h"
 #include "core/variant/typed_array.h"
 #include "thirdparty/intervaltree.h"
 
@@ -11,6 +14,29 @@ class HBIntervalTree : public RefCounted {
 	typedef Intervals::IntervalTree<int64_t, ObjectID> IntervalTree;
 	IntervalTree tree;
 
+	// Queries run on a flat copy of the tree, rebuilt on the first query after a change. Intervals are sorted by
+	// low and laid out as an implicit balanced tree (the middle of every range is its root), max_highs holds the
+	// highest high of each of those subtrees.
+	// The rebuild is done under flat_mutex, so queries may run from several threads at once. Modifying the tree
+	// while it's being queried isn't safe.
+	struct FlatIntervals {
+		LocalVector<int64_t> lows;
+		LocalVector<int64_t> highs;
+		LocalVector<int64_t> max_highs;
+		LocalVector<int64_t> ids;
+	};
+	mutable FlatIntervals flat;
+	mutable SafeFlag flat_dirty;
+	mutable BinaryMutex flat_mutex;
+
+	void _update_flat() const;
+	int64_t _build_max_highs(uint32_t p_begin, uint32_t p_end) const;
+	void _query_range(uint32_t p_begin, uint32_t p_end, int64_t p_low, int64_t p_high, LocalVector<int64_t> &r_ids) const;
+
+	PackedInt64Array _query_point_ids_bind(int64_t p_point) const;
+	PackedInt64Array _query_range_ids_bind(int64_t p_low, int64_t p_high) const;
+	Array _query_sweep_bind(const PackedInt64Array &p_points) const;
+
 protected:
 	static void _bind_methods();
 
@@ -19,6 +45,15 @@ public:
 	void erase(int64_t p_low, int64_t p_high, ObjectID p_value);
 	TypedArray<Object> query_point(int64_t p_point) const;
 	void clear();
+	int get_interval_count() const;
+
+	// The ids of every interval overlapping [p_low, p_high] (ends included), in order of their low end.
+	// r_ids is cleared first and keeps its capacity, so reusing it across calls doesn't allocate.
+	void query_range_ids(int64_t p_low, int64_t p_high, LocalVector<int64_t> &r_ids) const;
+	// Stabbing query for every point in p_points, which must be sorted in ascending order. The hits for point i
+	// are r_ids[r_offsets[i]] to r_ids[r_offsets[i + 1] - 1], r_offsets has one more element than there are points.
+	// Walks the intervals once for the whole batch instead of once per point.
+	void query_sweep(const int64_t *p_points, uint32_t p_point_count, LocalVector<int64_t> &r_ids, LocalVector<uint32_t> &r_offsets) const;
 };
 
 #endif // INTERVAL_TREE_GD_H
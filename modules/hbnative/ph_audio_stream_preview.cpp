@@ -29,17 +29,114 @@
 /*************************************************************************/
 
 #include "ph_audio_stream_preview.h"
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
+#include "scene/resources/audio_stream_wav.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PH_AUDIO_STREAM_PREVIEW_SSE2
+#endif
+
+// Level 0 buckets are made of this many mixed frames
+static const int PREVIEW_BUCKET_FRAMES = 20;
+// Queries go up the levels while the range still covers at least this many buckets
+static const uint32_t PREVIEW_MIN_QUERY_BUCKETS = 8;
+
+// Native decoding splits streams into segments of at least this length, one per worker
+static const float PREVIEW_MIN_SEGMENT_SECONDS = 10.0f;
+static const int PREVIEW_DECODE_CHUNK_FRAMES = 4096;
+// preview_updated is emitted at most this often while a preview is generating
+static const uint64_t PREVIEW_PROGRESS_INTERVAL_USEC = 100000;
+
+static const uint32_t PREVIEW_CACHE_MAGIC = 0x50574850; // PHWP
+static const uint32_t PREVIEW_CACHE_VERSION = 2;
 
 /////////////////////
 
-float PHAudioStreamPreview::get_length() const {
-	return length;
+void PHAudioStreamPreview::_allocate(uint32_t p_bucket_count) {
+	levels.clear();
+	uint32_t bucket_count = p_bucket_count;
+	while (true) {
+		Level level;
+		level.mins.resize(bucket_count);
+		level.maxs.resize(bucket_count);
+		level.means.resize(bucket_count);
+		level.mean_squares.resize(bucket_count);
+		for (uint32_t i = 0; i < bucket_count; i++) {
+			level.mins[i] = 127;
+			level.maxs[i] = 127;
+			level.means[i] = 127.0f;
+			level.mean_squares[i] = 127.0f * 127.0f;
+		}
+		levels.push_back(level);
+		if (bucket_count <= 1) {
+			break;
+		}
+		bucket_count = (bucket_count + 1) / 2;
+	}
+}
+
+void PHAudioStreamPreview::_set_bucket(uint32_t p_bucket, uint8_t p_min, uint8_t p_max) {
+	Level &base = levels[0];
+	base.mins[p_bucket] = p_min;
+	base.maxs[p_bucket] = p_max;
+	base.means[p_bucket] = p_max;
+	base.mean_squares[p_bucket] = float(p_max) * float(p_max);
 }
-float PHAudioStreamPreview::get_max(float p_time, float p_time_next) const {
-	if (length == 0)
-		return 0;
 
-	int max = preview.size() / 2;
+void PHAudioStreamPreview::_update_levels(uint32_t p_from, uint32_t p_to, uint32_t p_max_level) {
+	for (uint32_t level_idx = 1; level_idx < levels.size() && level_idx <= p_max_level && p_from < p_to; level_idx++) {
+		const Level &child = levels[level_idx - 1];
+		Level &parent = levels[level_idx];
+		p_from /= 2;
+		p_to = MIN((p_to + 1) / 2, parent.mins.size());
+
+		uint32_t i = p_from;
+#ifdef PH_AUDIO_STREAM_PREVIEW_SSE2
+		const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+		const __m128 half = _mm_set1_ps(0.5f);
+		// 8 parents from 16 children at a time, as long as all of the children exist
+		for (; i + 8 <= p_to && i * 2 + 16 <= child.mins.size(); i += 8) {
+			__m128i mins = _mm_loadu_si128((const __m128i *)(child.mins.ptr() + i * 2));
+			__m128i maxs = _mm_loadu_si128((const __m128i *)(child.maxs.ptr() + i * 2));
+			// Each 16 bit lane holds a pair of children, compare the low byte against the high one
+			mins = _mm_and_si128(_mm_min_epu8(mins, _mm_srli_epi16(mins, 8)), low_bytes);
+			maxs = _mm_and_si128(_mm_max_epu8(maxs, _mm_srli_epi16(maxs, 8)), low_bytes);
+			_mm_storel_epi64((__m128i *)(parent.mins.ptr() + i), _mm_packus_epi16(mins, mins));
+			_mm_storel_epi64((__m128i *)(parent.maxs.ptr() + i), _mm_packus_epi16(maxs, maxs));
+
+			for (int j = 0; j < 2; j++) {
+				const float *means = child.means.ptr() + i * 2 + j * 8;
+				const float *mean_squares = child.mean_squares.ptr() + i * 2 + j * 8;
+				__m128 a = _mm_loadu_ps(means);
+				__m128 b = _mm_loadu_ps(means + 4);
+				__m128 mean = _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), half);
+				_mm_storeu_ps(parent.means.ptr() + i + j * 4, mean);
+				a = _mm_loadu_ps(mean_squares);
+				b = _mm_loadu_ps(mean_squares + 4);
+				__m128 mean_square = _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), half);
+				_mm_storeu_ps(parent.mean_squares.ptr() + i + j * 4, mean_square);
+			}
+		}
+#endif
+		for (; i < p_to; i++) {
+			const uint32_t first = i * 2;
+			// The last parent might only have one child
+			const uint32_t second = MIN(first + 1, child.mins.size() - 1);
+			parent.mins[i] = MIN(child.mins[first], child.mins[second]);
+			parent.maxs[i] = MAX(child.maxs[first], child.maxs[second]);
+			parent.means[i] = (child.means[first] + child.means[second]) * 0.5f;
+			parent.mean_squares[i] = (child.mean_squares[first] + child.mean_squares[second]) * 0.5f;
+		}
+	}
+}
+
+// Picks the highest level where the range still spans a few buckets, so every query reads a bounded number of
+// them no matter how long the range is. The buckets at the ends may stick out of the range by a bit.
+void PHAudioStreamPreview::_get_buckets(float p_time, float p_time_next, uint32_t &r_level, uint32_t &r_from, uint32_t &r_to) const {
+	int max = levels[0].mins.size();
 	int time_from = p_time / length * max;
 	int time_to = p_time_next / length * max;
 	time_from = CLAMP(time_from, 0, max - 1);
@@ -49,98 +146,146 @@ float PHAudioStreamPreview::get_max(float p_time, float p_time_next) const {
 		time_to = time_from + 1;
 	}
 
-	uint8_t vmax = 0;
+	uint32_t level = 0;
+	const uint32_t span = time_to - time_from;
+	while (level + 1 < levels.size() && (span >> (level + 1)) >= PREVIEW_MIN_QUERY_BUCKETS) {
+		level++;
+	}
+	r_level = level;
+	r_from = uint32_t(time_from) >> level;
+	r_to = ((uint32_t(time_to) - 1) >> level) + 1;
+}
 
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2 + 1];
-		if (i == 0 || v > vmax) {
-			vmax = v;
-		}
+float PHAudioStreamPreview::get_length() const {
+	return length;
+}
+
+float PHAudioStreamPreview::get_max(float p_time, float p_time_next) const {
+	if (length == 0 || levels.is_empty())
+		return 0;
+
+	uint32_t level, from, to;
+	_get_buckets(p_time, p_time_next, level, from, to);
+
+	const uint8_t *maxs = levels[level].maxs.ptr();
+	uint8_t vmax = 0;
+	for (uint32_t i = from; i < to; i++) {
+		vmax = MAX(vmax, maxs[i]);
 	}
 
 	return (vmax / 255.0) * 2.0 - 1.0;
 }
 
 float PHAudioStreamPreview::get_avg(float p_time, float p_time_next) const {
-	if (length == 0)
+	if (length == 0 || levels.is_empty())
 		return 0;
 
-	int max = preview.size() / 2;
-	int time_from = p_time / length * max;
-	int time_to = p_time_next / length * max;
-	time_from = CLAMP(time_from, 0, max - 1);
-	time_to = CLAMP(time_to, 0, max - 1);
-
-	if (time_to <= time_from) {
-		time_to = time_from + 1;
-	}
+	uint32_t level, from, to;
+	_get_buckets(p_time, p_time_next, level, from, to);
 
-	int64_t total = 0;
-	int64_t count = 0;
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2 + 1];
-		total += v;
-		count++;
+	const float *means = levels[level].means.ptr();
+	float total = 0;
+	for (uint32_t i = from; i < to; i++) {
+		total += means[i];
 	}
 
-	float avg = total / count;
+	float avg = total / (to - from);
 
 	return (avg / 255.0) * 2.0 - 1.0;
 }
 
 float PHAudioStreamPreview::get_rms(float p_time, float p_time_next) const {
-	if (length == 0)
+	if (length == 0 || levels.is_empty())
 		return 0;
 
-	int max = preview.size() / 2;
-	int time_from = p_time / length * max;
-	int time_to = p_time_next / length * max;
-	time_from = CLAMP(time_from, 0, max - 1);
-	time_to = CLAMP(time_to, 0, max - 1);
-
-	if (time_to <= time_from) {
-		time_to = time_from + 1;
-	}
+	uint32_t level, from, to;
+	_get_buckets(p_time, p_time_next, level, from, to);
 
+	const float *mean_squares = levels[level].mean_squares.ptr();
 	float total = 0;
-	int64_t count = 0;
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2 + 1];
-		total += v * v;
-		count++;
+	for (uint32_t i = from; i < to; i++) {
+		total += mean_squares[i];
 	}
 
-	float mean = total / count;
+	float mean = total / (to - from);
 
 	return (Math::sqrt(mean) / 255.0) * 2.0 - 1.0;
 }
 
 float PHAudioStreamPreview::get_min(float p_time, float p_time_next) const {
-	if (length == 0)
+	if (length == 0 || levels.is_empty())
 		return 0;
 
-	int max = preview.size() / 2;
-	int time_from = p_time / length * max;
-	int time_to = p_time_next / length * max;
-	time_from = CLAMP(time_from, 0, max - 1);
-	time_to = CLAMP(time_to, 0, max - 1);
-
-	if (time_to <= time_from) {
-		time_to = time_from + 1;
-	}
+	uint32_t level, from, to;
+	_get_buckets(p_time, p_time_next, level, from, to);
 
+	const uint8_t *mins = levels[level].mins.ptr();
 	uint8_t vmin = 255;
-
-	for (int i = time_from; i < time_to; i++) {
-		uint8_t v = preview[i * 2];
-		if (i == 0 || v < vmin) {
-			vmin = v;
-		}
+	for (uint32_t i = from; i < to; i++) {
+		vmin = MIN(vmin, mins[i]);
 	}
 
 	return (vmin / 255.0) * 2.0 - 1.0;
 }
 
+int PHAudioStreamPreview::get_level_count() const {
+	return levels.size();
+}
+
+// Only the base level is stored, the rest is quick to rebuild. The key goes in the header so a file whose name
+// matches but was made from other data is never taken for the stream's preview.
+Error PHAudioStreamPreview::_save(const String &p_path, const CacheKey &p_key) const {
+	ERR_FAIL_COND_V(levels.is_empty(), ERR_UNCONFIGURED);
+	Error err = DirAccess::make_dir_recursive_absolute(p_path.get_base_dir());
+	ERR_FAIL_COND_V_MSG(err != OK && err != ERR_ALREADY_EXISTS, err, vformat("Couldn't create the preview cache directory for %s.", p_path));
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(err != OK, err, vformat("Couldn't open %s for writing.", p_path));
+	file->store_32(PREVIEW_CACHE_MAGIC);
+	file->store_32(PREVIEW_CACHE_VERSION);
+	file->store_64(p_key.source_length);
+	file->store_buffer(p_key.digest, sizeof(p_key.digest));
+	file->store_float(length);
+	file->store_32(levels[0].mins.size());
+	file->store_buffer(levels[0].mins.ptr(), levels[0].mins.size());
+	file->store_buffer(levels[0].maxs.ptr(), levels[0].maxs.size());
+	return OK;
+}
+
+Error PHAudioStreamPreview::_load(const String &p_path, const CacheKey &p_key) {
+	if (!FileAccess::exists(p_path)) {
+		return ERR_FILE_NOT_FOUND;
+	}
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ, &err);
+	if (err != OK) {
+		return err;
+	}
+	if (file->get_32() != PREVIEW_CACHE_MAGIC || file->get_32() != PREVIEW_CACHE_VERSION) {
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	CacheKey file_key;
+	file_key.source_length = file->get_64();
+	if (file->get_buffer(file_key.digest, sizeof(file_key.digest)) != sizeof(file_key.digest) || file_key.source_length != p_key.source_length || memcmp(file_key.digest, p_key.digest, sizeof(file_key.digest)) != 0) {
+		// Made from different data, it gets overwritten once the new preview is done
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	const float file_length = file->get_float();
+	const uint32_t bucket_count = file->get_32();
+	ERR_FAIL_COND_V_MSG(bucket_count == 0 || file->get_length() != file->get_position() + bucket_count * 2ull, ERR_FILE_CORRUPT, vformat("Preview cache %s is corrupt.", p_path));
+
+	length = file_length;
+	_allocate(bucket_count);
+	Level &base = levels[0];
+	file->get_buffer(base.mins.ptr(), bucket_count);
+	file->get_buffer(base.maxs.ptr(), bucket_count);
+	for (uint32_t i = 0; i < bucket_count; i++) {
+		base.means[i] = base.maxs[i];
+		base.mean_squares[i] = float(base.maxs[i]) * float(base.maxs[i]);
+	}
+	_update_levels(0, bucket_count);
+	return OK;
+}
+
 PHAudioStreamPreview::PHAudioStreamPreview() {
 	length = 0;
 }
@@ -151,6 +296,7 @@ void PHAudioStreamPreview::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_avg", "time", "time_next"), &PHAudioStreamPreview::get_avg);
 	ClassDB::bind_method(D_METHOD("get_rms", "time", "time_next"), &PHAudioStreamPreview::get_rms);
 	ClassDB::bind_method(D_METHOD("get_min", "time", "time_next"), &PHAudioStreamPreview::get_min);
+	ClassDB::bind_method(D_METHOD("get_level_count"), &PHAudioStreamPreview::get_level_count);
 }
 
 ////
@@ -159,8 +305,42 @@ void PHAudioStreamPreviewGenerator::_update_emit(ObjectID p_id) {
 	emit_signal("preview_updated", p_id);
 }
 
+static void frames_min_max(const AudioFrame *p_frames, int p_count, float &r_min, float &r_max) {
+	// Both channels go into the same min and max, so the frames can be read as a flat float array
+	const float *samples = (const float *)p_frames;
+	const int sample_count = p_count * 2;
+	int i = 0;
+	float min = 1000;
+	float max = -1000;
+#ifdef PH_AUDIO_STREAM_PREVIEW_SSE2
+	if (sample_count >= 4) {
+		__m128 vmin = _mm_set1_ps(min);
+		__m128 vmax = _mm_set1_ps(max);
+		for (; i + 4 <= sample_count; i += 4) {
+			__m128 v = _mm_loadu_ps(samples + i);
+			vmin = _mm_min_ps(vmin, v);
+			vmax = _mm_max_ps(vmax, v);
+		}
+		vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+		vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+		vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+		vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+		min = _mm_cvtss_f32(vmin);
+		max = _mm_cvtss_f32(vmax);
+	}
+#endif
+	for (; i < sample_count; i++) {
+		min = MIN(min, samples[i]);
+		max = MAX(max, samples[i]);
+	}
+	r_min = min;
+	r_max = max;
+}
+
 void PHAudioStreamPreviewGenerator::_preview_thread(void *p_preview) {
 	Preview *preview = (Preview *)p_preview;
+	PHAudioStreamPreview *stream_preview = preview->preview.ptr();
+	const int bucket_count = stream_preview->levels[0].mins.size();
 
 	float muxbuff_chunk_s = 0.25;
 
@@ -169,22 +349,22 @@ void PHAudioStreamPreviewGenerator::_preview_thread(void *p_preview) {
 	Vector<AudioFrame> mix_chunk;
 	mix_chunk.resize(mixbuff_chunk_frames);
 
-	int frames_total = AudioServer::get_singleton()->get_mix_rate() * preview->preview->length;
+	int frames_total = AudioServer::get_singleton()->get_mix_rate() * stream_preview->length;
 	int frames_todo = frames_total;
 
 	preview->playback->start();
 
 	while (frames_todo) {
-		int ofs_write = uint64_t(frames_total - frames_todo) * uint64_t(preview->preview->preview.size() / 2) / uint64_t(frames_total);
+		int ofs_write = uint64_t(frames_total - frames_todo) * uint64_t(bucket_count) / uint64_t(frames_total);
 		int to_read = MIN(frames_todo, mixbuff_chunk_frames);
-		int to_write = uint64_t(to_read) * uint64_t(preview->preview->preview.size() / 2) / uint64_t(frames_total);
-		to_write = MIN(to_write, (preview->preview->preview.size() / 2) - ofs_write);
+		int to_write = uint64_t(to_read) * uint64_t(bucket_count) / uint64_t(frames_total);
+		to_write = MIN(to_write, bucket_count - ofs_write);
 
 		preview->playback->mix(mix_chunk.ptrw(), 1.0, to_read);
 
 		for (int i = 0; i < to_write; i++) {
-			float max = -1000;
-			float min = 1000;
+			float max;
+			float min;
 			int from = uint64_t(i) * to_read / to_write;
 			int to = (uint64_t(i) + 1) * to_read / to_write;
 			to = MIN(to, to_read);
@@ -193,28 +373,267 @@ void PHAudioStreamPreviewGenerator::_preview_thread(void *p_preview) {
 				to = from + 1;
 			}
 
-			for (int j = from; j < to; j++) {
-				max = MAX(max, mix_chunk[j].l);
-				max = MAX(max, mix_chunk[j].r);
-
-				min = MIN(min, mix_chunk[j].l);
-				min = MIN(min, mix_chunk[j].r);
-			}
+			frames_min_max(mix_chunk.ptr() + from, to - from, min, max);
 
 			uint8_t pfrom = CLAMP((min * 0.5 + 0.5) * 255, 0, 255);
 			uint8_t pto = CLAMP((max * 0.5 + 0.5) * 255, 0, 255);
 
-			preview->preview->preview.write[(ofs_write + i) * 2 + 0] = pfrom;
-			preview->preview->preview.write[(ofs_write + i) * 2 + 1] = pto;
+			stream_preview->_set_bucket(ofs_write + i, pfrom, pto);
 		}
+		stream_preview->_update_levels(ofs_write, ofs_write + to_write);
 
 		frames_todo -= to_read;
-		singleton->call_deferred(SNAME("_update_emit"), preview->id);
+		_notify_progress(preview);
 	}
 
 	preview->playback->stop();
 
+	if (!preview->cache_path.is_empty()) {
+		stream_preview->_save(preview->cache_path, preview->cache_key);
+	}
+
 	preview->generating.clear();
+	singleton->call_deferred(SNAME("_update_emit"), preview->id);
+}
+
+// Only the thread that moves the deadline forward gets to emit, the rest skip it
+void PHAudioStreamPreviewGenerator::_notify_progress(Preview *p_preview) {
+	const uint64_t now = OS::get_singleton()->get_ticks_usec();
+	if (now < p_preview->next_progress_usec.get()) {
+		return;
+	}
+	const uint64_t next = now + PREVIEW_PROGRESS_INTERVAL_USEC;
+	if (p_preview->next_progress_usec.exchange_if_greater(next) == next) {
+		singleton->call_deferred(SNAME("_update_emit"), p_preview->id);
+	}
+}
+
+int PHAudioStreamPreviewGenerator::_decode_native(Preview *p_preview, AudioStreamPlayback *p_playback, AudioFrame *r_frames, int p_frames) {
+	switch (p_preview->decode_mode) {
+		case Preview::DECODE_NATIVE_RESAMPLED: {
+			return static_cast<AudioStreamPlaybackResampled *>(p_playback)->mix_native(r_frames, p_frames);
+		} break;
+		case Preview::DECODE_NATIVE_WAV: {
+			// A rate scale that cancels out the mix rate makes the playback step one source frame at a time
+			const float rate_scale = AudioServer::get_singleton()->get_mix_rate() / (p_preview->native_rate * AudioServer::get_singleton()->get_playback_speed_scale());
+			return p_playback->mix(r_frames, rate_scale, p_frames);
+		} break;
+		default: {
+		} break;
+	}
+	return 0;
+}
+
+void PHAudioStreamPreviewGenerator::_preview_segment_task(void *p_preview, uint32_t p_segment) {
+	Preview *preview = (Preview *)p_preview;
+	PHAudioStreamPreview *stream_preview = preview->preview.ptr();
+	Preview::Segment &segment = preview->segments[p_segment];
+	const uint64_t bucket_count = stream_preview->levels[0].mins.size();
+	const uint64_t frames_total = MAX(uint64_t(preview->native_rate * stream_preview->length), (uint64_t)1);
+
+	uint64_t frame = segment.bucket_from * frames_total / bucket_count;
+	const uint64_t segment_end = segment.bucket_to * frames_total / bucket_count;
+	segment.playback->start(double(frame) / preview->native_rate);
+
+	LocalVector<AudioFrame> chunk;
+	chunk.resize(PREVIEW_DECODE_CHUNK_FRAMES);
+
+	uint32_t bucket = segment.bucket_from;
+	uint32_t levels_updated_until = bucket;
+	uint64_t bucket_end = (bucket + 1) * frames_total / bucket_count;
+	float bucket_min = 1000;
+	float bucket_max = -1000;
+	bool stream_ended = false;
+
+	auto write_bucket = [&]() {
+		if (bucket_min > bucket_max) {
+			// Bucket without any frames in it
+			bucket_min = 0;
+			bucket_max = 0;
+		}
+		uint8_t pfrom = CLAMP((bucket_min * 0.5 + 0.5) * 255, 0, 255);
+		uint8_t pto = CLAMP((bucket_max * 0.5 + 0.5) * 255, 0, 255);
+		stream_preview->_set_bucket(bucket, pfrom, pto);
+		bucket++;
+		bucket_end = (bucket + 1) * frames_total / bucket_count;
+		bucket_min = 1000;
+		bucket_max = -1000;
+	};
+
+	while (frame < segment_end && bucket < segment.bucket_to) {
+		const int to_read = MIN((uint64_t)PREVIEW_DECODE_CHUNK_FRAMES, segment_end - frame);
+		int read = stream_ended ? 0 : _decode_native(preview, segment.playback.ptr(), chunk.ptr(), to_read);
+		if (read < to_read) {
+			// Anything past the end of the stream is silence
+			for (int i = MAX(read, 0); i < to_read; i++) {
+				chunk[i] = AudioFrame(0, 0);
+			}
+			stream_ended = true;
+		}
+
+		int position = 0;
+		while (position < to_read && bucket < segment.bucket_to) {
+			const int span = MIN(uint64_t(to_read - position), bucket_end - (frame + position));
+			if (span > 0) {
+				float min, max;
+				frames_min_max(chunk.ptr() + position, span, min, max);
+				bucket_min = MIN(bucket_min, min);
+				bucket_max = MAX(bucket_max, max);
+				position += span;
+			}
+			if (frame + position >= bucket_end) {
+				write_bucket();
+			}
+		}
+		frame += to_read;
+
+		stream_preview->_update_levels(levels_updated_until, bucket, preview->segment_max_level);
+		levels_updated_until = bucket;
+		_notify_progress(preview);
+	}
+
+	while (bucket < segment.bucket_to) {
+		write_bucket();
+	}
+	stream_preview->_update_levels(levels_updated_until, bucket, preview->segment_max_level);
+	segment.playback->stop();
+
+	if (preview->segments_left.decrement() == 0) {
+		// The levels above segment_max_level have buckets shared by several segments, they're only built once all are done
+		stream_preview->_update_levels(0, bucket_count);
+		if (!preview->cache_path.is_empty()) {
+			stream_preview->_save(preview->cache_path, preview->cache_key);
+		}
+		preview->generating.clear();
+		singleton->call_deferred(SNAME("_update_emit"), preview->id);
+	}
+}
+
+// The encoded audio, so cached previews follow the data rather than the file name.
+// Streams that don't expose their data this way aren't cached.
+Variant PHAudioStreamPreviewGenerator::_get_stream_data(const Ref<AudioStream> &p_stream) {
+	// AudioStreamWAV and AudioStreamMP3
+	Variant data = p_stream->get("data");
+	if (data.get_type() == Variant::NIL) {
+		// AudioStreamOggVorbis, pages of packets
+		Ref<Resource> packet_sequence = p_stream->get("packet_sequence");
+		if (packet_sequence.is_valid()) {
+			data = packet_sequence->get("packet_data");
+		}
+	}
+	return data;
+}
+
+void PHAudioStreamPreviewGenerator::_hash_stream_data(const Variant &p_data, CryptoCore::SHA256Context &r_context, uint64_t &r_length) {
+	if (p_data.get_type() == Variant::PACKED_BYTE_ARRAY) {
+		const PackedByteArray bytes = p_data;
+		r_context.update(bytes.ptr(), bytes.size());
+		r_length += bytes.size();
+		// Keeps packet boundaries part of the hash
+		const uint32_t size = bytes.size();
+		r_context.update((const uint8_t *)&size, sizeof(size));
+	} else if (p_data.get_type() == Variant::ARRAY) {
+		const Array array = p_data;
+		for (int i = 0; i < array.size(); i++) {
+			_hash_stream_data(array[i], r_context, r_length);
+		}
+	}
+}
+
+// Hashes the stream data on the worker pool, then either loads the cached preview or starts generating it
+void PHAudioStreamPreviewGenerator::_cache_task(void *p_preview) {
+	Preview *preview = (Preview *)p_preview;
+
+	CryptoCore::SHA256Context context;
+	context.start();
+	uint64_t source_length = 0;
+	_hash_stream_data(preview->cache_source, context, source_length);
+	// The same bytes decode differently depending on the stream type
+	const CharString class_name = String(preview->base_stream->get_class_name()).utf8();
+	context.update((const uint8_t *)class_name.get_data(), class_name.length());
+	context.finish(preview->cache_key.digest);
+	preview->cache_key.source_length = source_length;
+	preview->cache_source = Variant();
+
+	// cache_path holds the directory until now
+	preview->cache_path = preview->cache_path.path_join(String::hex_encode_buffer(preview->cache_key.digest, sizeof(preview->cache_key.digest)) + ".phwp");
+
+	Ref<PHAudioStreamPreview> cached;
+	cached.instantiate();
+	if (cached->_load(preview->cache_path, preview->cache_key) == OK) {
+		// The preview may be read on the main thread right now, so it's swapped in there
+		preview->cached_preview = cached;
+		callable_mp(singleton, &PHAudioStreamPreviewGenerator::_cache_loaded).call_deferred(preview->id);
+		return;
+	}
+	_start_generation(preview);
+}
+
+void PHAudioStreamPreviewGenerator::_cache_loaded(ObjectID p_id) {
+	RBMap<ObjectID, Preview>::Element *E = previews.find(p_id);
+	ERR_FAIL_NULL(E);
+	Preview &preview = E->value();
+	preview.preview->levels = preview.cached_preview->levels;
+	preview.preview->length = preview.cached_preview->length;
+	preview.cached_preview.unref();
+	preview.generating.clear();
+	_update_emit(p_id);
+}
+
+// Runs on the main thread, or on the worker pool after a cache miss
+void PHAudioStreamPreviewGenerator::_start_generation(Preview *p_preview) {
+	if (p_preview->playback.is_null()) {
+		return;
+	}
+
+	const uint32_t bucket_count = p_preview->preview->levels[0].mins.size();
+	const float len_s = p_preview->preview->length;
+
+	// Streams of known length that can be decoded at their own rate skip the mixer and get split across the worker pool
+	if (p_preview->base_stream->get_length() > 0) {
+		Ref<AudioStreamWAV> wav = p_preview->base_stream;
+		AudioStreamPlaybackResampled *resampled = Object::cast_to<AudioStreamPlaybackResampled>(p_preview->playback.ptr());
+		if (resampled) {
+			p_preview->decode_mode = Preview::DECODE_NATIVE_RESAMPLED;
+			p_preview->native_rate = resampled->get_native_sampling_rate();
+		} else if (wav.is_valid()) {
+			p_preview->decode_mode = Preview::DECODE_NATIVE_WAV;
+			p_preview->native_rate = wav->get_mix_rate();
+		}
+		if (p_preview->native_rate <= 0) {
+			p_preview->decode_mode = Preview::DECODE_MIX;
+		}
+	}
+
+	if (p_preview->decode_mode == Preview::DECODE_MIX) {
+		p_preview->thread = memnew(Thread);
+		p_preview->thread->start(_preview_thread, p_preview);
+		return;
+	}
+
+	uint32_t segment_count = CLAMP(uint32_t(len_s / PREVIEW_MIN_SEGMENT_SECONDS), 1u, (uint32_t)WorkerThreadPool::get_singleton()->get_thread_count());
+	segment_count = MIN(segment_count, bucket_count);
+
+	// Segments start on a multiple of 2^segment_max_level base buckets, so every bucket up to that level belongs to
+	// a single segment and the tasks never write the same one. It's the highest level that still fits a stride into
+	// every segment.
+	const uint32_t level_count = p_preview->preview->levels.size();
+	uint32_t segment_max_level = 0;
+	while (segment_max_level + 1 < level_count && (bucket_count >> (segment_max_level + 1)) >= segment_count) {
+		segment_max_level++;
+	}
+	p_preview->segment_max_level = segment_max_level;
+	const uint32_t stride_mask = ~((1u << segment_max_level) - 1);
+
+	p_preview->segments.resize(segment_count);
+	for (uint32_t i = 0; i < segment_count; i++) {
+		Preview::Segment &segment = p_preview->segments[i];
+		segment.playback = i == 0 ? p_preview->playback : p_preview->base_stream->instantiate_playback();
+		segment.bucket_from = uint32_t(uint64_t(i) * bucket_count / segment_count) & stride_mask;
+		segment.bucket_to = i + 1 == segment_count ? bucket_count : uint32_t(uint64_t(i + 1) * bucket_count / segment_count) & stride_mask;
+	}
+	p_preview->segments_left.set(segment_count);
+	p_preview->group_id = WorkerThreadPool::get_singleton()->add_native_group_task(&PHAudioStreamPreviewGenerator::_preview_segment_task, p_preview, segment_count, -1, false, "Audio stream preview");
 }
 
 Ref<PHAudioStreamPreview> PHAudioStreamPreviewGenerator::generate_preview(const Ref<AudioStream> &p_stream) {
@@ -233,6 +652,9 @@ Ref<PHAudioStreamPreview> PHAudioStreamPreviewGenerator::generate_preview(const
 	preview->playback = preview->base_stream->instantiate_playback();
 	preview->generating.set();
 	preview->id = p_stream->get_instance_id();
+	preview->thread = nullptr;
+
+	preview->preview.instantiate();
 
 	float len_s = preview->base_stream->get_length();
 	if (len_s == 0) {
@@ -241,31 +663,39 @@ Ref<PHAudioStreamPreview> PHAudioStreamPreviewGenerator::generate_preview(const
 
 	int frames = AudioServer::get_singleton()->get_mix_rate() * len_s;
 
-	Vector<uint8_t> maxmin;
-	int pw = frames / 20;
-	maxmin.resize(pw * 2);
-	{
-		uint8_t *ptr = maxmin.ptrw();
-		for (int i = 0; i < pw * 2; i++) {
-			ptr[i] = 127;
-		}
-	}
-
-	preview->preview.instantiate();
-	preview->preview->preview = maxmin;
+	const uint32_t bucket_count = MAX(frames / PREVIEW_BUCKET_FRAMES, 1);
+	preview->preview->_allocate(bucket_count);
 	preview->preview->length = len_s;
 
-	if (preview->playback.is_valid()) {
-		preview->thread = memnew(Thread);
-		preview->thread->start(_preview_thread, preview);
+	if (!cache_directory.is_empty()) {
+		preview->cache_source = _get_stream_data(p_stream);
+		if (preview->cache_source.get_type() != Variant::NIL) {
+			// Hashing a whole song takes a while, the worker looks the preview up and starts generating it on a miss
+			preview->cache_path = cache_directory;
+			preview->cache_task_id = WorkerThreadPool::get_singleton()->add_native_task(&PHAudioStreamPreviewGenerator::_cache_task, preview, false, "Audio stream preview cache");
+			return preview->preview;
+		}
 	}
 
+	_start_generation(preview);
 	return preview->preview;
 }
 
+void PHAudioStreamPreviewGenerator::set_cache_directory(const String &p_directory) {
+	cache_directory = p_directory;
+}
+
+String PHAudioStreamPreviewGenerator::get_cache_directory() const {
+	return cache_directory;
+}
+
 void PHAudioStreamPreviewGenerator::_bind_methods() {
 	ClassDB::bind_method("_update_emit", &PHAudioStreamPreviewGenerator::_update_emit);
 	ClassDB::bind_method(D_METHOD("generate_preview", "stream"), &PHAudioStreamPreviewGenerator::generate_preview);
+	ClassDB::bind_method(D_METHOD("set_cache_directory", "directory"), &PHAudioStreamPreviewGenerator::set_cache_directory);
+	ClassDB::bind_method(D_METHOD("get_cache_directory"), &PHAudioStreamPreviewGenerator::get_cache_directory);
+
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "cache_directory", PROPERTY_HINT_DIR), "set_cache_directory", "get_cache_directory");
 
 	ADD_SIGNAL(MethodInfo("preview_updated", PropertyInfo(Variant::INT, "obj_id")));
 }
@@ -282,6 +712,15 @@ void PHAudioStreamPreviewGenerator::_notification(int p_what) {
 					memdelete(E.value.thread);
 					E.value.thread = NULL;
 				}
+				if (E.value.cache_task_id != WorkerThreadPool::INVALID_TASK_ID) {
+					WorkerThreadPool::get_singleton()->wait_for_task_completion(E.value.cache_task_id);
+					E.value.cache_task_id = WorkerThreadPool::INVALID_TASK_ID;
+				}
+				if (E.value.group_id != -1) {
+					WorkerThreadPool::get_singleton()->wait_for_group_task_completion(E.value.group_id);
+					E.value.group_id = -1;
+					E.value.segments.clear();
+				}
 				if (!ObjectDB::get_instance(E.key)) { //no longer in use, get rid of preview
 					to_erase.push_back(E.key);
 				}
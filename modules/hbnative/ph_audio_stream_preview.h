@@ -31,19 +31,48 @@
 #ifndef PH_AUDIO_STREAM_PREVIEW_H
 #define PH_AUDIO_STREAM_PREVIEW_H
 
+#include "core/crypto/crypto_core.h"
 #include "core/object/ref_counted.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/os/thread.h"
+#include "core/templates/safe_refcount.h"
+#include "core/templates/local_vector.h"
 #include "scene/main/node.h"
 #include "servers/audio/audio_stream.h"
 
 class PHAudioStreamPreview : public RefCounted {
 	GDCLASS(PHAudioStreamPreview, RefCounted);
 	friend class AudioStream;
-	Vector<uint8_t> preview;
+
+	// Level 0 has one bucket per 20 mixed frames, every level above merges pairs of buckets from the one below,
+	// so any time range can be answered from a handful of buckets at the right level.
+	// Min and max are bytes like the original preview, mean and mean square are of the max byte.
+	struct Level {
+		LocalVector<uint8_t> mins;
+		LocalVector<uint8_t> maxs;
+		LocalVector<float> means;
+		LocalVector<float> mean_squares;
+	};
+	LocalVector<Level> levels;
 	float length;
 
 	friend class PHAudioStreamPreviewGenerator;
 
+	// Identifies the stream data a cached preview was made from
+	struct CacheKey {
+		uint64_t source_length = 0;
+		uint8_t digest[32] = {};
+	};
+
+	void _allocate(uint32_t p_bucket_count);
+	void _set_bucket(uint32_t p_bucket, uint8_t p_min, uint8_t p_max);
+	// Rebuilds the levels above the base one for base buckets [p_from, p_to), up to and including p_max_level
+	void _update_levels(uint32_t p_from, uint32_t p_to, uint32_t p_max_level = UINT32_MAX);
+	void _get_buckets(float p_time, float p_time_next, uint32_t &r_level, uint32_t &r_from, uint32_t &r_to) const;
+
+	Error _save(const String &p_path, const CacheKey &p_key) const;
+	Error _load(const String &p_path, const CacheKey &p_key);
+
 protected:
 	static void _bind_methods();
 
@@ -53,6 +82,7 @@ public:
 	float get_min(float p_time, float p_time_next) const;
 	float get_avg(float p_time, float p_time_next) const;
 	float get_rms(float p_time, float p_time_next) const;
+	int get_level_count() const;
 
 	PHAudioStreamPreview();
 };
@@ -63,38 +93,100 @@ class PHAudioStreamPreviewGenerator : public Node {
 	static PHAudioStreamPreviewGenerator *singleton;
 
 	struct Preview {
+		enum DecodeMode {
+			// Mixed through AudioStreamPlayback::mix at the AudioServer rate on a single thread
+			DECODE_MIX,
+			// Decoded at the stream's own rate, split into segments that run on the worker pool
+			DECODE_NATIVE_RESAMPLED,
+			DECODE_NATIVE_WAV,
+		};
+		struct Segment {
+			Ref<AudioStreamPlayback> playback;
+			uint32_t bucket_from = 0;
+			uint32_t bucket_to = 0;
+		};
+
 		Ref<PHAudioStreamPreview> preview;
 		Ref<AudioStream> base_stream;
 		Ref<AudioStreamPlayback> playback;
 		SafeFlag generating;
 		ObjectID id;
 		Thread *thread;
+		// Encoded stream data, hashed on the worker pool to find the cached preview
+		Variant cache_source;
+		WorkerThreadPool::TaskID cache_task_id = WorkerThreadPool::INVALID_TASK_ID;
+		// Where the finished preview gets saved, empty when it can't be cached
+		String cache_path;
+		PHAudioStreamPreview::CacheKey cache_key;
+		// Filled by the cache task on a hit, moved into preview on the main thread
+		Ref<PHAudioStreamPreview> cached_preview;
+		DecodeMode decode_mode = DECODE_MIX;
+		float native_rate = 0;
+		LocalVector<Segment> segments;
+		// Segment tasks only build the levels up to this one, see _start_generation
+		uint32_t segment_max_level = 0;
+		WorkerThreadPool::GroupID group_id = -1;
+		SafeNumeric<uint32_t> segments_left;
+		SafeNumeric<uint64_t> next_progress_usec;
 
 		// Needed for the bookkeeping of the Map
 		Preview &operator=(const Preview &p_rhs) {
 			preview = p_rhs.preview;
 			base_stream = p_rhs.base_stream;
 			playback = p_rhs.playback;
-			generating.set_to(generating.is_set());
+			generating.set_to(p_rhs.generating.is_set());
 			id = p_rhs.id;
 			thread = p_rhs.thread;
+			cache_source = p_rhs.cache_source;
+			cache_task_id = p_rhs.cache_task_id;
+			cache_path = p_rhs.cache_path;
+			cache_key = p_rhs.cache_key;
+			cached_preview = p_rhs.cached_preview;
+			decode_mode = p_rhs.decode_mode;
+			native_rate = p_rhs.native_rate;
+			segments = p_rhs.segments;
+			segment_max_level = p_rhs.segment_max_level;
+			group_id = p_rhs.group_id;
+			segments_left.set(p_rhs.segments_left.get());
+			next_progress_usec.set(p_rhs.next_progress_usec.get());
 			return *this;
 		}
 		Preview(const Preview &p_rhs) {
 			preview = p_rhs.preview;
 			base_stream = p_rhs.base_stream;
 			playback = p_rhs.playback;
-			generating.set_to(generating.is_set());
+			generating.set_to(p_rhs.generating.is_set());
 			id = p_rhs.id;
 			thread = p_rhs.thread;
+			cache_source = p_rhs.cache_source;
+			cache_task_id = p_rhs.cache_task_id;
+			cache_path = p_rhs.cache_path;
+			cache_key = p_rhs.cache_key;
+			cached_preview = p_rhs.cached_preview;
+			decode_mode = p_rhs.decode_mode;
+			native_rate = p_rhs.native_rate;
+			segments = p_rhs.segments;
+			segment_max_level = p_rhs.segment_max_level;
+			group_id = p_rhs.group_id;
+			segments_left.set(p_rhs.segments_left.get());
+			next_progress_usec.set(p_rhs.next_progress_usec.get());
 		}
 		Preview() {
 		}
 	};
 
 	RBMap<ObjectID, Preview> previews;
+	String cache_directory = "user://waveform_previews";
 
 	static void _preview_thread(void *p_preview);
+	static void _cache_task(void *p_preview);
+	static void _start_generation(Preview *p_preview);
+	void _cache_loaded(ObjectID p_id);
+	static void _preview_segment_task(void *p_preview, uint32_t p_segment);
+	static int _decode_native(Preview *p_preview, AudioStreamPlayback *p_playback, AudioFrame *r_frames, int p_frames);
+	static void _notify_progress(Preview *p_preview);
+	static Variant _get_stream_data(const Ref<AudioStream> &p_stream);
+	static void _hash_stream_data(const Variant &p_data, CryptoCore::SHA256Context &r_context, uint64_t &r_length);
 
 	void _update_emit(ObjectID p_id);
 
@@ -107,6 +199,10 @@ public:
 
 	Ref<PHAudioStreamPreview> generate_preview(const Ref<AudioStream> &p_stream);
 
+	// Finished previews are saved here keyed by a SHA-256 of the stream data, empty disables caching
+	void set_cache_directory(const String &p_directory);
+	String get_cache_directory() const;
+
 	PHAudioStreamPreviewGenerator();
 };
 
@@ -6,8 +6,6 @@
 #include "core/variant/dictionary.h"
 #include "core/variant/typed_array.h"
 
-stbrp_node HBRectPack::packer_temp_storage[MAX_RECT_SIZE] = {};
-
 void HBRectPack::_bind_methods() {
 	ClassDB::bind_static_method("HBRectPack", D_METHOD("pack_rects", "rects", "starting_pack_size"), &HBRectPack::pack_rects);
 }
@@ -15,13 +13,21 @@ void HBRectPack::_bind_methods() {
 Dictionary HBRectPack::pack_rects(PackedVector2Array p_rects, Vector2i p_starting_pack_size) {
 	LocalVector<stbrp_rect> rects;
 	rects.resize(p_rects.size());
+	int64_t total_area = 0;
+	Vector2i largest_rect;
 	for (int i = 0; i < p_rects.size(); i++) {
 		rects[i].id = i;
 		Vector2i rect = p_rects[i];
 		rects[i].w = rect.x;
 		rects[i].h = rect.y;
+		total_area += int64_t(rect.x) * rect.y;
+		largest_rect = largest_rect.max(rect);
 	}
 
+	// Skyline packing wants as many nodes as the target is wide
+	LocalVector<stbrp_node> nodes;
+	nodes.resize(MAX_RECT_SIZE);
+
 	Vector2i pack_size = Vector2(
 			nearest_power_of_2_templated(p_starting_pack_size.x),
 			nearest_power_of_2_templated(p_starting_pack_size.y));
@@ -34,7 +40,12 @@ Dictionary HBRectPack::pack_rects(PackedVector2Array p_rects, Vector2i p_startin
 		int min_axis = pack_size.min_axis_index();
 		pack_size.coord[min_axis] <<= 1;
 
-		stbrp_init_target(&context, pack_size.x, pack_size.y, packer_temp_storage, MAX_RECT_SIZE);
+		// Sizes that can't possibly fit everything aren't worth a packing attempt
+		if (int64_t(pack_size.x) * pack_size.y < total_area || pack_size.x < largest_rect.x || pack_size.y < largest_rect.y) {
+			continue;
+		}
+
+		stbrp_init_target(&context, pack_size.x, pack_size.y, nodes.ptr(), nodes.size());
 		int result = stbrp_pack_rects(&context, rects.ptr(), rects.size());
 		if (result == 1) {
 			packed = true;
@@ -63,3 +74,156 @@ Dictionary HBRectPack::pack_rects(PackedVector2Array p_rects, Vector2i p_startin
 
 	return out;
 }
+
+void HBRectAtlas::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_page_size", "page_size"), &HBRectAtlas::set_page_size);
+	ClassDB::bind_method(D_METHOD("get_page_size"), &HBRectAtlas::get_page_size);
+	ClassDB::bind_method(D_METHOD("set_heuristic", "heuristic"), &HBRectAtlas::set_heuristic);
+	ClassDB::bind_method(D_METHOD("get_heuristic"), &HBRectAtlas::get_heuristic);
+	ClassDB::bind_method(D_METHOD("get_page_count"), &HBRectAtlas::get_page_count);
+	ClassDB::bind_method(D_METHOD("get_rect_count"), &HBRectAtlas::get_rect_count);
+	ClassDB::bind_method(D_METHOD("clear"), &HBRectAtlas::clear);
+	ClassDB::bind_method(D_METHOD("add_rects", "rects"), &HBRectAtlas::_add_rects_bind);
+
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2I, "page_size"), "set_page_size", "get_page_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "heuristic", PROPERTY_HINT_ENUM, "Bottom Left,Best Fit"), "set_heuristic", "get_heuristic");
+
+	BIND_ENUM_CONSTANT(HEURISTIC_BOTTOM_LEFT);
+	BIND_ENUM_CONSTANT(HEURISTIC_BEST_FIT);
+}
+
+HBRectAtlas::Page *HBRectAtlas::_create_page() {
+	Page *page = memnew(Page);
+	page->nodes.resize(page_size.x);
+	stbrp_init_target(&page->context, page_size.x, page_size.y, page->nodes.ptr(), page->nodes.size());
+	stbrp_setup_heuristic(&page->context, heuristic == HEURISTIC_BEST_FIT ? STBRP_HEURISTIC_Skyline_BF_sortHeight : STBRP_HEURISTIC_Skyline_BL_sortHeight);
+	pages.push_back(page);
+	return page;
+}
+
+void HBRectAtlas::_clear_pages() {
+	for (Page *page : pages) {
+		memdelete(page);
+	}
+	pages.clear();
+}
+
+void HBRectAtlas::set_page_size(const Size2i &p_page_size) {
+	MutexLock lock(mutex);
+	ERR_FAIL_COND_MSG(pages.size() > 0, "Page size can't change once rects were added, clear the atlas first.");
+	ERR_FAIL_COND(p_page_size.x <= 0 || p_page_size.y <= 0);
+	page_size = p_page_size;
+}
+
+Size2i HBRectAtlas::get_page_size() const {
+	MutexLock lock(mutex);
+	return page_size;
+}
+
+// Only affects where new rects go, already packed rects stay where they are
+void HBRectAtlas::set_heuristic(Heuristic p_heuristic) {
+	MutexLock lock(mutex);
+	heuristic = p_heuristic;
+	for (Page *page : pages) {
+		stbrp_setup_heuristic(&page->context, heuristic == HEURISTIC_BEST_FIT ? STBRP_HEURISTIC_Skyline_BF_sortHeight : STBRP_HEURISTIC_Skyline_BL_sortHeight);
+	}
+}
+
+HBRectAtlas::Heuristic HBRectAtlas::get_heuristic() const {
+	MutexLock lock(mutex);
+	return heuristic;
+}
+
+int HBRectAtlas::get_page_count() const {
+	MutexLock lock(mutex);
+	return pages.size();
+}
+
+int HBRectAtlas::get_rect_count() const {
+	MutexLock lock(mutex);
+	int rect_count = 0;
+	for (const Page *page : pages) {
+		rect_count += page->rect_count;
+	}
+	return rect_count;
+}
+
+void HBRectAtlas::clear() {
+	MutexLock lock(mutex);
+	_clear_pages();
+}
+
+Error HBRectAtlas::add_rects(const Size2i *p_sizes, uint32_t p_count, Vector2i *r_positions, int32_t *r_pages) {
+	MutexLock lock(mutex);
+	Error err = OK;
+
+	pending_rects.clear();
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_positions[i] = Vector2i();
+		r_pages[i] = -1;
+		if (p_sizes[i].x > page_size.x || p_sizes[i].y > page_size.y || p_sizes[i].x < 0 || p_sizes[i].y < 0) {
+			err = ERR_PARAMETER_RANGE_ERROR;
+			continue;
+		}
+		stbrp_rect rect = {};
+		rect.id = i;
+		rect.w = p_sizes[i].x;
+		rect.h = p_sizes[i].y;
+		pending_rects.push_back(rect);
+	}
+
+	// Fill the existing pages first, whatever is left over spills into the next one.
+	// stb sorts each batch by height before packing it.
+	for (uint32_t page_idx = 0; pending_rects.size() > 0; page_idx++) {
+		const bool new_page = page_idx == pages.size();
+		Page *page = new_page ? _create_page() : pages[page_idx];
+		stbrp_pack_rects(&page->context, pending_rects.ptr(), pending_rects.size());
+
+		uint32_t remaining = 0;
+		for (uint32_t i = 0; i < pending_rects.size(); i++) {
+			const stbrp_rect &rect = pending_rects[i];
+			if (rect.was_packed) {
+				r_positions[rect.id] = Vector2i(rect.x, rect.y);
+				r_pages[rect.id] = page_idx;
+				page->rect_count++;
+			} else {
+				pending_rects[remaining++] = rect;
+			}
+		}
+		// Everything left fits a page on its own, so an empty page always takes at least one rect
+		ERR_FAIL_COND_V(new_page && remaining == pending_rects.size(), FAILED);
+		pending_rects.resize(remaining);
+	}
+
+	return err;
+}
+
+Dictionary HBRectAtlas::_add_rects_bind(const PackedVector2Array &p_sizes) {
+	LocalVector<Size2i> sizes;
+	sizes.resize(p_sizes.size());
+	for (int i = 0; i < p_sizes.size(); i++) {
+		sizes[i] = p_sizes[i];
+	}
+	LocalVector<Vector2i> positions;
+	positions.resize(sizes.size());
+	PackedInt32Array out_pages;
+	out_pages.resize(sizes.size());
+
+	Error err = add_rects(sizes.ptr(), sizes.size(), positions.ptr(), out_pages.ptrw());
+
+	TypedArray<Vector2i> out_points;
+	out_points.resize(positions.size());
+	for (uint32_t i = 0; i < positions.size(); i++) {
+		out_points[i] = positions[i];
+	}
+
+	Dictionary out;
+	out["result"] = err;
+	out["points"] = out_points;
+	out["pages"] = out_pages;
+	return out;
+}
+
+HBRectAtlas::~HBRectAtlas() {
+	_clear_pages();
+}
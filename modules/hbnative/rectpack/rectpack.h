@@ -3,6 +3,9 @@
 
 #include "core/math/rect2.h"
 #include "core/object/class_db.h"
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
 #include "core/variant/dictionary.h"
 #include "core/variant/typed_array.h"
 #include "thirdparty/misc/stb_rect_pack.h"
@@ -10,13 +13,66 @@
 class HBRectPack : public Object {
 	GDCLASS(HBRectPack, Object);
 	static constexpr int MAX_RECT_SIZE = 8192;
-	static stbrp_node packer_temp_storage[MAX_RECT_SIZE];
 
 protected:
 	static void _bind_methods();
 
 public:
+	// Safe to call from several threads at once, every call packs with its own storage
 	static Dictionary pack_rects(PackedVector2Array p_rects, Vector2i p_starting_pack_size);
 };
 
+// Atlas that rects can keep getting added to. Pages keep their packing state between calls, so adding
+// rects only packs the new ones, and rects that don't fit in any page open a new one.
+// All methods lock, so worker threads can add to the same atlas.
+class HBRectAtlas : public RefCounted {
+	GDCLASS(HBRectAtlas, RefCounted);
+
+public:
+	enum Heuristic {
+		HEURISTIC_BOTTOM_LEFT,
+		HEURISTIC_BEST_FIT,
+	};
+
+private:
+	struct Page {
+		// The context points into itself and into nodes, so pages never move once created
+		stbrp_context context;
+		LocalVector<stbrp_node> nodes;
+		uint32_t rect_count = 0;
+	};
+
+	LocalVector<Page *> pages;
+	Size2i page_size = Size2i(2048, 2048);
+	Heuristic heuristic = HEURISTIC_BOTTOM_LEFT;
+	// Rects still waiting for a page, reused between calls
+	LocalVector<stbrp_rect> pending_rects;
+	mutable Mutex mutex;
+
+	Page *_create_page();
+	void _clear_pages();
+	Dictionary _add_rects_bind(const PackedVector2Array &p_sizes);
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_page_size(const Size2i &p_page_size);
+	Size2i get_page_size() const;
+	void set_heuristic(Heuristic p_heuristic);
+	Heuristic get_heuristic() const;
+
+	int get_page_count() const;
+	int get_rect_count() const;
+	void clear();
+
+	// Writes where each rect ended up and on which page, rects bigger than a page get page -1 and make this
+	// return ERR_PARAMETER_RANGE_ERROR, the rest are still packed.
+	Error add_rects(const Size2i *p_sizes, uint32_t p_count, Vector2i *r_positions, int32_t *r_pages);
+
+	~HBRectAtlas();
+};
+
+VARIANT_ENUM_CAST(HBRectAtlas::Heuristic);
+
 #endif // RECTPACK_H
@@ -6,6 +6,9 @@
 #include "core/object/class_db.h"
 #include "diva/bone_db.h"
 #include "diva/diva_object.h"
+#include "diva/motion.h"
+#include "diva/sprite_set.h"
+#include "input_recorder.h"
 #include "interval_tree.h"
 #include "modules/hbnative/ph_blur_controls.h"
 #include "multi_spin_box.h"
@@ -80,15 +83,22 @@ void initialize_hbnative_module(ModuleInitializationLevel p_level) {
 	GDREGISTER_CLASS(DIVABoneDB);
 	GDREGISTER_CLASS(DIVASkeleton);
 	GDREGISTER_CLASS(DIVAObjectSet);
+	GDREGISTER_CLASS(DIVAMotion);
+	GDREGISTER_CLASS(DIVASpriteSet);
 	GDREGISTER_ABSTRACT_CLASS(HBRectPack);
+	GDREGISTER_CLASS(HBRectAtlas);
+	GDREGISTER_CLASS(HBInputRecorder);
 	Engine::get_singleton()->add_singleton(Engine::Singleton("PHAudioStreamPreviewGenerator", PHAudioStreamPreviewGenerator::get_singleton()));
 	Engine::get_singleton()->add_singleton(Engine::Singleton("PHNative", PHNative::get_singleton()));
+
+	HBInputRecorder::initialize_command_line();
 }
 
 void uninitialize_hbnative_module(ModuleInitializationLevel p_level) {
 	if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
 		return;
 	}
+	HBInputRecorder::finalize_command_line();
 	memdelete(preview_generator_ptr);
 	memdelete(ph_ptr);
 	HBStyleboxBlurDrawer::blur_material.unref();
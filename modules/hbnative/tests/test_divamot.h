@@ -47,7 +47,7 @@ TEST_SUITE("[DIVAMotion]") {
 		item_table.instantiate();
 
 		Ref<FileAccess> test_file = FileAccess::open("/home/eirexe/.local/share/Project Heartbeat/mikitm_tbl.txt", FileAccess::READ);
-		item_table->parse(test_file->get_as_utf8_string());
+		item_table->parse(test_file->get_buffer(test_file->get_length()), "user://mikitm_tbl.kvti");
 	}
 	TEST_CASE("[DIVAMotion] objectdb loading") {
 		Ref<DIVAObjectDB> object_db;
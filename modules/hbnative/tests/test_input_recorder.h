@@ -0,0 +1,258 @@
+#ifndef TEST_INPUT_RECORDER_H
+#define TEST_INPUT_RECORDER_H
+
+#include "../input_recorder.h"
+#include "core/input/input.h"
+#include "core/input/shortcut.h"
+#include "core/io/file_access.h"
+#include "core/os/os.h"
+#include "scene/main/scene_tree.h"
+#include "scene/main/window.h"
+#include "tests/test_macros.h"
+#include "tests/test_utils.h"
+
+namespace TestInputRecorder {
+
+static void _record_events(Ref<HBInputRecorder> &r_recorder) {
+	REQUIRE(r_recorder->start_recording() == OK);
+
+	Ref<InputEventKey> key;
+	key.instantiate();
+	key->set_keycode(Key::D);
+	key->set_physical_keycode(Key::D);
+	key->set_unicode('d');
+	key->set_pressed(true);
+	key->set_shift_pressed(true);
+	key->set_timestamp(OS::get_singleton()->get_ticks_usec());
+	Input::get_singleton()->parse_input_event(key);
+
+	Ref<InputEventJoypadButton> joypad_button;
+	joypad_button.instantiate();
+	joypad_button->set_device(1);
+	joypad_button->set_button_index(JoyButton::A);
+	joypad_button->set_pressed(true);
+	Input::get_singleton()->parse_input_event(joypad_button);
+
+	Ref<InputEventMouseMotion> mouse_motion;
+	mouse_motion.instantiate();
+	mouse_motion->set_position(Vector2(10, 20));
+	mouse_motion->set_relative(Vector2(-3, 4));
+	mouse_motion->set_velocity(Vector2(100, 50));
+	mouse_motion->set_pressure(0.5);
+	Input::get_singleton()->parse_input_event(mouse_motion);
+
+	Ref<InputEventScreenDrag> screen_drag;
+	screen_drag.instantiate();
+	screen_drag->set_index(2);
+	screen_drag->set_position(Vector2(64, 32));
+	screen_drag->set_relative(Vector2(1, -1));
+	Input::get_singleton()->parse_input_event(screen_drag);
+
+	Ref<InputEventMIDI> midi;
+	midi.instantiate();
+	midi->set_channel(3);
+	midi->set_message(MIDIMessage::NOTE_ON);
+	midi->set_pitch(60);
+	midi->set_velocity(100);
+	Input::get_singleton()->parse_input_event(midi);
+
+	// Goes through the property list, the shortcut it holds is an object so it's left out
+	Ref<InputEventShortcut> shortcut;
+	shortcut.instantiate();
+	shortcut->set_device(4);
+	shortcut->set_shortcut(memnew(Shortcut));
+	Input::get_singleton()->parse_input_event(shortcut);
+
+	r_recorder->stop_recording();
+}
+
+static Vector<uint8_t> _get_file(const String &p_path) {
+	return FileAccess::get_file_as_bytes(p_path);
+}
+
+static void _store_file(const String &p_path, const Vector<uint8_t> &p_data) {
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::WRITE);
+	REQUIRE(file.is_valid());
+	file->store_buffer(p_data.ptr(), p_data.size());
+}
+
+static LocalVector<Ref<InputEvent>> received_events;
+
+static void _on_window_input(const Ref<InputEvent> &p_event) {
+	received_events.push_back(p_event);
+}
+
+// The magic and version of a valid recording
+static Vector<uint8_t> _get_header() {
+	const String path = TestUtils::get_temp_path("test_input_recorder_empty.hbir");
+	Ref<HBInputRecorder> empty;
+	empty.instantiate();
+	REQUIRE(empty->save(path) == OK);
+	return _get_file(path).slice(0, 8);
+}
+
+TEST_SUITE("[HBInputRecorder]") {
+	TEST_CASE("[SceneTree][HBInputRecorder] Saved recordings load back the same") {
+		Ref<HBInputRecorder> recorder;
+		recorder.instantiate();
+		_record_events(recorder);
+		CHECK(recorder->get_event_count() == 6);
+
+		const String path = TestUtils::get_temp_path("test_input_recorder.hbir");
+		REQUIRE(recorder->save(path) == OK);
+
+		Ref<HBInputRecorder> loaded;
+		loaded.instantiate();
+		REQUIRE(loaded->load(path) == OK);
+		CHECK(loaded->get_event_count() == recorder->get_event_count());
+		CHECK(loaded->get_duration_usec() == recorder->get_duration_usec());
+
+		// Every stored field made it through loading if saving again gives the same bytes
+		const String resaved_path = TestUtils::get_temp_path("test_input_recorder_resaved.hbir");
+		REQUIRE(loaded->save(resaved_path) == OK);
+		CHECK(_get_file(resaved_path) == _get_file(path));
+	}
+
+	TEST_CASE("[SceneTree][HBInputRecorder] Truncated recordings are rejected") {
+		Ref<HBInputRecorder> recorder;
+		recorder.instantiate();
+		_record_events(recorder);
+		const String path = TestUtils::get_temp_path("test_input_recorder.hbir");
+		REQUIRE(recorder->save(path) == OK);
+		const Vector<uint8_t> data = _get_file(path);
+
+		Ref<HBInputRecorder> loaded;
+		loaded.instantiate();
+		REQUIRE(loaded->load(path) == OK);
+
+		const String truncated_path = TestUtils::get_temp_path("test_input_recorder_truncated.hbir");
+		_store_file(truncated_path, data.slice(0, data.size() - 3));
+		ERR_PRINT_OFF;
+		CHECK(loaded->load(truncated_path) == ERR_FILE_CORRUPT);
+		ERR_PRINT_ON;
+		// What was there before is kept
+		CHECK(loaded->get_event_count() == 6);
+	}
+
+	TEST_CASE("[SceneTree][HBInputRecorder] Replays dispatch events in order on the replay's timeline") {
+		const Key keys[] = { Key::A, Key::B, Key::C };
+		uint64_t timestamps[3];
+		Ref<HBInputRecorder> recorder;
+		recorder.instantiate();
+		REQUIRE(recorder->start_recording() == OK);
+		for (int i = 0; i < 3; i++) {
+			Ref<InputEventKey> key;
+			key.instantiate();
+			key->set_keycode(keys[i]);
+			key->set_pressed(true);
+			timestamps[i] = OS::get_singleton()->get_ticks_usec();
+			key->set_timestamp(timestamps[i]);
+			Input::get_singleton()->parse_input_event(key);
+			OS::get_singleton()->delay_usec(2000);
+		}
+		recorder->stop_recording();
+		// Dispatch what was recorded now, so only replayed events are seen below
+		Input::get_singleton()->flush_buffered_events();
+		REQUIRE(recorder->get_event_count() == 3);
+
+		Window *root = SceneTree::get_singleton()->get_root();
+		received_events.clear();
+		root->connect(SNAME("window_input"), callable_mp_static(&_on_window_input));
+		SIGNAL_WATCH(recorder.ptr(), "replay_finished");
+		const uint64_t replay_start = OS::get_singleton()->get_ticks_usec();
+		REQUIRE(recorder->start_replay() == OK);
+		for (int i = 0; i < 1000 && recorder->is_replaying(); i++) {
+			OS::get_singleton()->delay_usec(1000);
+			SceneTree::get_singleton()->process(0);
+		}
+		root->disconnect(SNAME("window_input"), callable_mp_static(&_on_window_input));
+		LocalVector<Ref<InputEvent>> events = received_events;
+		received_events.clear();
+		CHECK_FALSE(recorder->is_replaying());
+		Array empty_signal_args;
+		empty_signal_args.push_back(Array());
+		SIGNAL_CHECK("replay_finished", empty_signal_args);
+		SIGNAL_UNWATCH(recorder.ptr(), "replay_finished");
+
+		REQUIRE(events.size() == 3);
+		const uint64_t first_timestamp = events[0]->get_timestamp();
+		CHECK(first_timestamp >= replay_start);
+		CHECK(first_timestamp <= OS::get_singleton()->get_ticks_usec());
+		for (int i = 0; i < 3; i++) {
+			Ref<InputEventKey> key = events[i];
+			REQUIRE(key.is_valid());
+			CHECK(key->get_keycode() == keys[i]);
+			// Moved as a whole, the distance between events is kept
+			CHECK((uint64_t)key->get_timestamp() - first_timestamp == timestamps[i] - timestamps[0]);
+		}
+
+		const Dictionary report = recorder->get_latency_report();
+		CHECK((int)report["count"] == 3);
+		const char *keys_in_report[] = { "min", "p50", "p90", "p99", "max" };
+		for (const char *report_key : keys_in_report) {
+			CHECK(report.has(report_key));
+		}
+		CHECK((int)report["min"] <= (int)report["p50"]);
+		CHECK((int)report["p99"] <= (int)report["max"]);
+	}
+
+	TEST_CASE("[HBInputRecorder] Corrupt recordings are rejected") {
+		const Vector<uint8_t> header = _get_header();
+		const String path = TestUtils::get_temp_path("test_input_recorder_corrupt.hbir");
+		Ref<HBInputRecorder> loaded;
+		loaded.instantiate();
+
+		// An event count no file this size could hold
+		{
+			Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+			REQUIRE(file.is_valid());
+			file->store_buffer(header);
+			file->store_32(UINT32_MAX);
+			file->store_64(0);
+		}
+		ERR_PRINT_OFF;
+		CHECK(loaded->load(path) == ERR_FILE_CORRUPT);
+		ERR_PRINT_ON;
+
+		// Classes that aren't input events are never created
+		{
+			Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+			REQUIRE(file.is_valid());
+			file->store_buffer(header);
+			file->store_32(1);
+			file->store_64(0);
+			file->store_8(false);
+			file->store_8(HBInputRecorder::RECORD_PROPERTIES);
+			file->store_pascal_string("Node");
+			file->store_32(0);
+		}
+		ERR_PRINT_OFF;
+		CHECK(loaded->load(path) == ERR_FILE_CORRUPT);
+		ERR_PRINT_ON;
+
+		// Neither are objects stored in properties
+		{
+			Ref<Shortcut> shortcut;
+			shortcut.instantiate();
+			Ref<FileAccess> file = FileAccess::open(path, FileAccess::WRITE);
+			REQUIRE(file.is_valid());
+			file->store_buffer(header);
+			file->store_32(1);
+			file->store_64(0);
+			file->store_8(false);
+			file->store_8(HBInputRecorder::RECORD_PROPERTIES);
+			file->store_pascal_string("InputEventShortcut");
+			file->store_32(1);
+			file->store_pascal_string("shortcut");
+			file->store_var(shortcut, true);
+		}
+		ERR_PRINT_OFF;
+		CHECK(loaded->load(path) == ERR_FILE_CORRUPT);
+		ERR_PRINT_ON;
+		CHECK(loaded->get_event_count() == 0);
+	}
+}
+
+} // namespace TestInputRecorder
+
+#endif // TEST_INPUT_RECORDER_H
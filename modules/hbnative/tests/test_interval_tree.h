@@ -0,0 +1,178 @@
+#ifndef TEST_INTERVAL_TREE_H
+#define TEST_INTERVAL_TREE_H
+
+#include "../interval_tree.h"
+#include "core/math/random_number_generator.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/safe_refcount.h"
+#include "tests/test_macros.h"
+
+namespace TestIntervalTree {
+
+struct TestInterval {
+	int64_t low;
+	int64_t high;
+	int64_t id;
+};
+
+static void _fill_random(Ref<HBIntervalTree> &r_tree, LocalVector<TestInterval> &r_intervals, uint32_t p_count, uint64_t p_seed) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instantiate();
+	rng->set_seed(p_seed);
+	for (uint32_t i = 0; i < p_count; i++) {
+		TestInterval interval;
+		interval.low = rng->randi_range(-1000, 1000);
+		interval.high = interval.low + rng->randi_range(0, 200);
+		interval.id = i + 1;
+		r_intervals.push_back(interval);
+		r_tree->insert(interval.low, interval.high, ObjectID(uint64_t(interval.id)));
+	}
+}
+
+// Ids of every interval overlapping [p_low, p_high], sorted so they can be compared with query results
+static LocalVector<int64_t> _brute_force(const LocalVector<TestInterval> &p_intervals, int64_t p_low, int64_t p_high) {
+	LocalVector<int64_t> ids;
+	for (const TestInterval &interval : p_intervals) {
+		if (interval.low <= p_high && interval.high >= p_low) {
+			ids.push_back(interval.id);
+		}
+	}
+	ids.sort();
+	return ids;
+}
+
+static bool _same_ids(LocalVector<int64_t> p_a, const LocalVector<int64_t> &p_b) {
+	p_a.sort();
+	if (p_a.size() != p_b.size()) {
+		return false;
+	}
+	for (uint32_t i = 0; i < p_a.size(); i++) {
+		if (p_a[i] != p_b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct ConcurrentQueries {
+	Ref<HBIntervalTree> tree;
+	const LocalVector<TestInterval> *intervals = nullptr;
+	SafeNumeric<uint32_t> mismatches;
+
+	static void query(void *p_userdata, uint32_t p_index) {
+		ConcurrentQueries *queries = (ConcurrentQueries *)p_userdata;
+		const int64_t point = int64_t(p_index) * 7 - 1100;
+		LocalVector<int64_t> ids;
+		queries->tree->query_range_ids(point, point, ids);
+		if (!_same_ids(ids, _brute_force(*queries->intervals, point, point))) {
+			queries->mismatches.increment();
+		}
+	}
+};
+
+TEST_SUITE("[HBIntervalTree]") {
+	TEST_CASE("[HBIntervalTree] Point and range queries match a brute force search") {
+		Ref<HBIntervalTree> tree;
+		tree.instantiate();
+		LocalVector<TestInterval> intervals;
+		_fill_random(tree, intervals, 500, 42);
+		CHECK(tree->get_interval_count() == 500);
+
+		LocalVector<int64_t> ids;
+		for (int64_t point = -1100; point <= 1300; point += 13) {
+			tree->query_range_ids(point, point, ids);
+			INFO("Point: ", point);
+			CHECK(_same_ids(ids, _brute_force(intervals, point, point)));
+		}
+		for (int64_t low = -1200; low <= 1200; low += 97) {
+			for (int64_t length = 0; length <= 300; length += 50) {
+				tree->query_range_ids(low, low + length, ids);
+				INFO("Range: ", low, " to ", low + length);
+				CHECK(_same_ids(ids, _brute_force(intervals, low, low + length)));
+			}
+		}
+
+		// Range queries come out in order of their low end
+		tree->query_range_ids(-1200, 1300, ids);
+		REQUIRE(ids.size() == intervals.size());
+		for (uint32_t i = 1; i < ids.size(); i++) {
+			CHECK(intervals[ids[i - 1] - 1].low <= intervals[ids[i] - 1].low);
+		}
+	}
+
+	TEST_CASE("[HBIntervalTree] Queries see erased intervals go") {
+		Ref<HBIntervalTree> tree;
+		tree.instantiate();
+		LocalVector<TestInterval> intervals;
+		_fill_random(tree, intervals, 200, 7);
+
+		LocalVector<int64_t> ids;
+		tree->query_range_ids(0, 0, ids);
+		for (int64_t i = intervals.size() - 1; i >= 0; i -= 2) {
+			tree->erase(intervals[i].low, intervals[i].high, ObjectID(uint64_t(intervals[i].id)));
+			intervals.remove_at(i);
+		}
+		CHECK(tree->get_interval_count() == int(intervals.size()));
+		for (int64_t point = -1000; point <= 1200; point += 31) {
+			tree->query_range_ids(point, point, ids);
+			CHECK(_same_ids(ids, _brute_force(intervals, point, point)));
+		}
+
+		tree->clear();
+		tree->query_range_ids(-2000, 2000, ids);
+		CHECK(ids.is_empty());
+	}
+
+	TEST_CASE("[HBIntervalTree] Sweeps match point queries") {
+		Ref<HBIntervalTree> tree;
+		tree.instantiate();
+		LocalVector<TestInterval> intervals;
+		_fill_random(tree, intervals, 300, 1234);
+
+		LocalVector<int64_t> points;
+		for (int64_t point = -1100; point <= 1300; point += 17) {
+			points.push_back(point);
+			// Repeated points get the same hits
+			if (point % 5 == 0) {
+				points.push_back(point);
+			}
+		}
+		LocalVector<int64_t> ids;
+		LocalVector<uint32_t> offsets;
+		tree->query_sweep(points.ptr(), points.size(), ids, offsets);
+		REQUIRE(offsets.size() == points.size() + 1);
+		for (uint32_t i = 0; i < points.size(); i++) {
+			LocalVector<int64_t> hits;
+			for (uint32_t j = offsets[i]; j < offsets[i + 1]; j++) {
+				hits.push_back(ids[j]);
+			}
+			INFO("Point: ", points[i]);
+			CHECK(_same_ids(hits, _brute_force(intervals, points[i], points[i])));
+		}
+
+		// Unsorted points are refused
+		const int64_t unsorted[] = { 5, 3 };
+		ERR_PRINT_OFF;
+		tree->query_sweep(unsorted, 2, ids, offsets);
+		ERR_PRINT_ON;
+		CHECK(ids.is_empty());
+		CHECK(offsets.is_empty());
+	}
+
+	TEST_CASE("[HBIntervalTree] Concurrent queries on a freshly modified tree") {
+		ConcurrentQueries queries;
+		queries.tree.instantiate();
+		LocalVector<TestInterval> intervals;
+		_fill_random(queries.tree, intervals, 1000, 99);
+		queries.intervals = &intervals;
+
+		// The first queries all race to rebuild the flat copy
+		WorkerThreadPool::GroupID group = WorkerThreadPool::get_singleton()->add_native_group_task(&ConcurrentQueries::query, &queries, 350, -1, true);
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group);
+		CHECK(queries.mismatches.get() == 0);
+	}
+}
+
+} // namespace TestIntervalTree
+
+#endif // TEST_INTERVAL_TREE_H
@@ -0,0 +1,126 @@
+#ifndef TEST_KV_TABLE_H
+#define TEST_KV_TABLE_H
+
+#include "../diva/kv_table.h"
+#include "core/io/file_access.h"
+#include "tests/test_macros.h"
+#include "tests/test_utils.h"
+
+namespace TestKVTable {
+
+static const char *TEST_TABLE = "# comment line\n"
+								"cos.0.id=12\n"
+								"cos.0.item.0=301\n"
+								"cos.0.item.1=302\n"
+								"cos.1.id=13\n"
+								"cos.length=2\n"
+								"  name = padded value  \n"
+								"broken=line=ignored\n"
+								"no equals here\n"
+								"utf8.名前=ミク\n";
+
+static void _parse_test_table(KVTable &r_table) {
+	r_table.parse_utf8((const uint8_t *)TEST_TABLE, strlen(TEST_TABLE));
+}
+
+static void _check_test_table(const KVTable &p_table) {
+	CHECK(p_table.has_key("cos"));
+	CHECK(p_table.has_key("cos.0.item"));
+	CHECK_FALSE(p_table.has_key("co"));
+	CHECK_FALSE(p_table.has_key("broken"));
+	CHECK_FALSE(p_table.has_key("no equals here"));
+
+	// Children keep the order they first appeared in, values included
+	CHECK(p_table.get_children_count("cos") == 3);
+	CHECK(p_table.get_children_count("cos.0.item") == 2);
+	CHECK(p_table.child_get_value("cos", 0, "id") == "12");
+	CHECK(p_table.child_get_value("cos", 1, "id") == "13");
+	CHECK(p_table.child_has_key("cos", 2, "length") == false);
+	CHECK(p_table.child_get_path("cos", 0, "item") == StringName("cos.0.item"));
+
+	CHECK(p_table.get_value("cos.length") == "2");
+	CHECK(p_table.get_value("cos.0.item.1") == "302");
+	// Lines are trimmed, the text around = isn't
+	CHECK(p_table.get_value("name ") == " padded value");
+	CHECK(p_table.get_value(String::utf8("utf8.名前")) == String::utf8("ミク"));
+}
+
+TEST_SUITE("[KVTable]") {
+	TEST_CASE("[KVTable] Parsing and lookups") {
+		KVTable table;
+		_parse_test_table(table);
+		_check_test_table(table);
+
+		// Same result through the String entry point
+		KVTable from_string;
+		from_string.parse(String::utf8(TEST_TABLE));
+		CHECK(from_string.get_index_data() == table.get_index_data());
+	}
+
+	TEST_CASE("[KVTable] Empty input has no keys") {
+		KVTable table;
+		table.parse_utf8(nullptr, 0);
+		CHECK_FALSE(table.has_key("cos"));
+	}
+
+	TEST_CASE("[KVTable] Saved indices load back and are checked against their source") {
+		const String index_path = TestUtils::get_temp_path("test_kv_table.kvti");
+		const uint8_t *data = (const uint8_t *)TEST_TABLE;
+		const uint64_t length = strlen(TEST_TABLE);
+		const uint32_t source_hash = KVTable::hash_source(data, length);
+
+		KVTable table;
+		_parse_test_table(table);
+		REQUIRE(table.save_index(index_path) == OK);
+
+		KVTable loaded;
+		REQUIRE(loaded.load_index(index_path, source_hash) == OK);
+		CHECK(loaded.get_index_data() == table.get_index_data());
+		_check_test_table(loaded);
+
+		KVTable stale;
+		CHECK(stale.load_index(index_path, source_hash + 1) == ERR_INVALID_DATA);
+		CHECK(stale.load_index(TestUtils::get_temp_path("test_kv_table_missing.kvti"), source_hash) == ERR_FILE_NOT_FOUND);
+
+		// parse_utf8_cached takes the saved index when it matches
+		KVTable cached;
+		cached.parse_utf8_cached(data, length, index_path);
+		_check_test_table(cached);
+	}
+
+	TEST_CASE("[KVTable] Corrupt indices are rejected") {
+		const String index_path = TestUtils::get_temp_path("test_kv_table_corrupt.kvti");
+		const uint8_t *data = (const uint8_t *)TEST_TABLE;
+		const uint64_t length = strlen(TEST_TABLE);
+		const uint32_t source_hash = KVTable::hash_source(data, length);
+
+		KVTable table;
+		_parse_test_table(table);
+		PackedByteArray index = table.get_index_data();
+
+		// Cut off the string arena, the header still claims it's there
+		{
+			Ref<FileAccess> file = FileAccess::open(index_path, FileAccess::WRITE);
+			REQUIRE(file.is_valid());
+			file->store_buffer(index.ptr(), index.size() - 4);
+		}
+		KVTable loaded;
+		ERR_PRINT_OFF;
+		CHECK(loaded.load_index(index_path, source_hash) == ERR_FILE_CORRUPT);
+		ERR_PRINT_ON;
+		CHECK_FALSE(loaded.has_key("cos"));
+
+		// A broken index gets replaced by a fresh parse
+		KVTable cached;
+		ERR_PRINT_OFF;
+		cached.parse_utf8_cached(data, length, index_path);
+		ERR_PRINT_ON;
+		_check_test_table(cached);
+		KVTable reloaded;
+		CHECK(reloaded.load_index(index_path, source_hash) == OK);
+	}
+}
+
+} // namespace TestKVTable
+
+#endif // TEST_KV_TABLE_H
@@ -0,0 +1,113 @@
+#ifndef TEST_RECT_ATLAS_H
+#define TEST_RECT_ATLAS_H
+
+#include "../rectpack/rectpack.h"
+#include "tests/test_macros.h"
+
+namespace TestRectAtlas {
+
+struct PackedRects {
+	LocalVector<Size2i> sizes;
+	LocalVector<Vector2i> positions;
+	LocalVector<int32_t> pages;
+};
+
+static Error _add(Ref<HBRectAtlas> &r_atlas, PackedRects &r_rects, const Size2i &p_size, uint32_t p_count) {
+	LocalVector<Size2i> sizes;
+	for (uint32_t i = 0; i < p_count; i++) {
+		sizes.push_back(p_size);
+	}
+	LocalVector<Vector2i> positions;
+	positions.resize(p_count);
+	LocalVector<int32_t> pages;
+	pages.resize(p_count);
+	Error err = r_atlas->add_rects(sizes.ptr(), p_count, positions.ptr(), pages.ptr());
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_rects.sizes.push_back(sizes[i]);
+		r_rects.positions.push_back(positions[i]);
+		r_rects.pages.push_back(pages[i]);
+	}
+	return err;
+}
+
+// Every packed rect lies inside its page and overlaps no other rect of the same page
+static bool _layout_valid(const PackedRects &p_rects, const Size2i &p_page_size) {
+	for (uint32_t i = 0; i < p_rects.sizes.size(); i++) {
+		if (p_rects.pages[i] < 0) {
+			continue;
+		}
+		const Rect2i rect(p_rects.positions[i], p_rects.sizes[i]);
+		if (!Rect2i(Vector2i(), p_page_size).encloses(rect)) {
+			return false;
+		}
+		for (uint32_t j = i + 1; j < p_rects.sizes.size(); j++) {
+			if (p_rects.pages[j] == p_rects.pages[i] && rect.intersects(Rect2i(p_rects.positions[j], p_rects.sizes[j]))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+TEST_SUITE("[HBRectAtlas]") {
+	TEST_CASE("[HBRectAtlas] Rects that don't fit spill into a new page") {
+		Ref<HBRectAtlas> atlas;
+		atlas.instantiate();
+		const Size2i page_size(64, 64);
+		atlas->set_page_size(page_size);
+		PackedRects rects;
+
+		// Exactly fills the first page
+		CHECK(_add(atlas, rects, Size2i(32, 32), 4) == OK);
+		CHECK(atlas->get_page_count() == 1);
+		for (int32_t page : rects.pages) {
+			CHECK(page == 0);
+		}
+
+		CHECK(_add(atlas, rects, Size2i(32, 32), 1) == OK);
+		CHECK(atlas->get_page_count() == 2);
+		CHECK(rects.pages[4] == 1);
+
+		// The second page has room left, so it's filled before a third one is opened
+		CHECK(_add(atlas, rects, Size2i(32, 32), 3) == OK);
+		CHECK(atlas->get_page_count() == 2);
+		for (uint32_t i = 4; i < 8; i++) {
+			CHECK(rects.pages[i] == 1);
+		}
+
+		// One batch can spill over several pages at once
+		CHECK(_add(atlas, rects, Size2i(64, 32), 5) == OK);
+		CHECK(atlas->get_page_count() == 5);
+		CHECK(atlas->get_rect_count() == 13);
+		CHECK(_layout_valid(rects, page_size));
+
+		atlas->clear();
+		CHECK(atlas->get_page_count() == 0);
+		CHECK(atlas->get_rect_count() == 0);
+	}
+
+	TEST_CASE("[HBRectAtlas] Rects bigger than a page are refused without blocking the rest") {
+		Ref<HBRectAtlas> atlas;
+		atlas.instantiate();
+		atlas->set_page_size(Size2i(64, 64));
+
+		const Size2i sizes[] = { Size2i(16, 16), Size2i(65, 8), Size2i(16, 16) };
+		Vector2i positions[3];
+		int32_t pages[3];
+		CHECK(atlas->add_rects(sizes, 3, positions, pages) == ERR_PARAMETER_RANGE_ERROR);
+		CHECK(pages[0] == 0);
+		CHECK(pages[1] == -1);
+		CHECK(pages[2] == 0);
+		CHECK(atlas->get_rect_count() == 2);
+
+		// Page size is fixed while the atlas holds rects
+		ERR_PRINT_OFF;
+		atlas->set_page_size(Size2i(128, 128));
+		ERR_PRINT_ON;
+		CHECK(atlas->get_page_size() == Size2i(64, 64));
+	}
+}
+
+} // namespace TestRectAtlas
+
+#endif // TEST_RECT_ATLAS_H
@@ -0,0 +1,132 @@
+#ifndef TEST_THREEN_H
+#define TEST_THREEN_H
+
+#include "../threen.h"
+#include "scene/2d/node_2d.h"
+#include "scene/gui/control.h"
+#include "scene/main/window.h"
+#include "tests/test_macros.h"
+
+namespace TestThreen {
+
+static const real_t TOLERANCE = 1e-4;
+
+static void _free_object(Object *p_object) {
+	memdelete(p_object);
+}
+
+static void _process(real_t p_delta) {
+	SceneTree::get_singleton()->process(p_delta);
+}
+
+TEST_SUITE("[Threen]") {
+	TEST_CASE("[Threen] Batched equations match run_equation") {
+		const float initial = 2.0;
+		const float delta = -5.0;
+		const float duration = 1.5;
+		// Counts that leave a tail after the vectorized part
+		const int counts[] = { 1, 2, 3, 5, 7, 13, 67 };
+
+		LocalVector<float> times;
+		LocalVector<float> values;
+		for (int count : counts) {
+			times.resize(count);
+			values.resize(count);
+			for (int i = 0; i < count; i++) {
+				times[i] = count == 1 ? 0.0f : duration * i / (count - 1);
+			}
+			for (int trans = 0; trans < Threen::TRANS_COUNT; trans++) {
+				for (int ease = 0; ease < Threen::EASE_COUNT; ease++) {
+					Threen::run_equation_batch(Threen::TransitionType(trans), Threen::EaseType(ease), times.ptr(), values.ptr(), count, initial, delta, duration);
+					for (int i = 0; i < count; i++) {
+						const real_t expected = Threen::run_equation(Threen::TransitionType(trans), Threen::EaseType(ease), times[i], initial, delta, duration);
+						INFO("trans ", trans, " ease ", ease, " count ", count, " t ", times[i]);
+						CHECK(Math::is_equal_approx(values[i], expected, TOLERANCE * Math::abs(delta)));
+					}
+				}
+			}
+		}
+	}
+
+	TEST_CASE("[SceneTree][Threen] Batched tweens follow their easing curves") {
+		Window *root = SceneTree::get_singleton()->get_root();
+		Threen *threen = memnew(Threen);
+		root->add_child(threen);
+		Node2D *node = memnew(Node2D);
+		root->add_child(node);
+
+		// Native setters for every lane type, and set_indexed for the subpath
+		CHECK(threen->interpolate_property_batched(node, NodePath("position"), Vector2(), Vector2(100, -50), 1.0, Threen::TRANS_QUAD, Threen::EASE_IN));
+		CHECK(threen->interpolate_property_batched(node, NodePath("modulate"), Color(1, 1, 1, 1), Color(0, 0.5, 0, 0), 1.0, Threen::TRANS_SINE, Threen::EASE_OUT));
+		CHECK(threen->interpolate_property_batched(node, NodePath("rotation"), 0.0, 2.0, 0.5, Threen::TRANS_CUBIC, Threen::EASE_IN_OUT, 0.5));
+		CHECK(threen->interpolate_property_batched(node, NodePath("scale:y"), 1.0, 3.0, 1.0, Threen::TRANS_LINEAR, Threen::EASE_IN));
+		CHECK(threen->get_batched_tween_count() == 4);
+		REQUIRE(threen->start());
+
+		_process(0.25);
+		const real_t position_eased = Threen::run_equation(Threen::TRANS_QUAD, Threen::EASE_IN, 0.25, 0, 1, 1);
+		CHECK(Math::is_equal_approx(node->get_position().x, 100 * position_eased, TOLERANCE));
+		CHECK(Math::is_equal_approx(node->get_position().y, -50 * position_eased, TOLERANCE));
+		const real_t modulate_eased = Threen::run_equation(Threen::TRANS_SINE, Threen::EASE_OUT, 0.25, 0, 1, 1);
+		CHECK(Math::is_equal_approx(node->get_modulate().r, 1 - modulate_eased, TOLERANCE));
+		CHECK(Math::is_equal_approx(node->get_modulate().g, 1 - (real_t)0.5 * modulate_eased, TOLERANCE));
+		CHECK(Math::is_equal_approx(node->get_modulate().a, 1 - modulate_eased, TOLERANCE));
+		// Still in its delay
+		CHECK(node->get_rotation() == 0);
+		CHECK(Math::is_equal_approx(node->get_scale().y, (real_t)1.5, TOLERANCE));
+
+		_process(0.5);
+		CHECK(Math::is_equal_approx(node->get_rotation(), Threen::run_equation(Threen::TRANS_CUBIC, Threen::EASE_IN_OUT, 0.25, 0, 2, 0.5), TOLERANCE));
+		CHECK(threen->get_batched_tween_count() == 4);
+
+		SIGNAL_WATCH(threen, "tween_all_completed");
+		_process(0.5);
+		CHECK(node->get_position() == Vector2(100, -50));
+		CHECK(node->get_modulate() == Color(0, 0.5, 0, 0));
+		CHECK(node->get_rotation() == 2);
+		CHECK(node->get_scale().y == 3);
+		CHECK(threen->get_batched_tween_count() == 0);
+		Array empty_signal_args;
+		empty_signal_args.push_back(Array());
+		SIGNAL_CHECK("tween_all_completed", empty_signal_args);
+		SIGNAL_UNWATCH(threen, "tween_all_completed");
+
+		memdelete(node);
+		memdelete(threen);
+	}
+
+	TEST_CASE("[SceneTree][Threen] Batched tweens whose target is freed by another tween are dropped") {
+		Window *root = SceneTree::get_singleton()->get_root();
+		Threen *threen = memnew(Threen);
+		root->add_child(threen);
+		Control *control = memnew(Control);
+		root->add_child(control);
+		Node2D *node = memnew(Node2D);
+
+		// Moving the control frees the node while the lane is being written out
+		control->connect(SNAME("item_rect_changed"), callable_mp_static(&_free_object).bind(node), Object::CONNECT_ONE_SHOT);
+		CHECK(threen->interpolate_property_batched(control, NodePath("position"), Vector2(), Vector2(10, 10), 1.0));
+		CHECK(threen->interpolate_property_batched(node, NodePath("position"), Vector2(), Vector2(10, 10), 1.0));
+		REQUIRE(threen->start());
+
+		SIGNAL_WATCH(threen, "tween_completed");
+		_process(0.5);
+		CHECK(threen->get_batched_tween_count() == 1);
+		SIGNAL_CHECK_FALSE("tween_completed");
+
+		_process(0.5);
+		CHECK(control->get_position() == Vector2(10, 10));
+		CHECK(threen->get_batched_tween_count() == 0);
+		Array completed_args;
+		completed_args.push_back(varray(control, NodePath(":position")));
+		SIGNAL_CHECK("tween_completed", completed_args);
+		SIGNAL_UNWATCH(threen, "tween_completed");
+
+		memdelete(control);
+		memdelete(threen);
+	}
+}
+
+} // namespace TestThreen
+
+#endif // TEST_THREEN_H
@@ -69,6 +69,20 @@ Threen::interpolater Threen::interpolaters[Threen::TRANS_COUNT][Threen::EASE_COU
 	{ &back::in, &back::out, &back::in_out, &back::out_in },
 };
 
+Threen::batch_interpolater Threen::batch_interpolaters[Threen::TRANS_COUNT][Threen::EASE_COUNT] = {
+	{ &batch::polynomial<1, batch::SHAPE_IN>, &batch::polynomial<1, batch::SHAPE_IN>, &batch::polynomial<1, batch::SHAPE_IN>, &batch::polynomial<1, batch::SHAPE_IN> },
+	{ &batch::scalar<&sine::in>, &batch::scalar<&sine::out>, &batch::scalar<&sine::in_out>, &batch::scalar<&sine::out_in> },
+	{ &batch::polynomial<5, batch::SHAPE_IN>, &batch::polynomial<5, batch::SHAPE_OUT>, &batch::polynomial<5, batch::SHAPE_IN_OUT>, &batch::polynomial<5, batch::SHAPE_OUT_IN> },
+	{ &batch::polynomial<4, batch::SHAPE_IN>, &batch::polynomial<4, batch::SHAPE_OUT>, &batch::polynomial<4, batch::SHAPE_IN_OUT>, &batch::polynomial<4, batch::SHAPE_OUT_IN> },
+	{ &batch::polynomial<2, batch::SHAPE_IN>, &batch::polynomial<2, batch::SHAPE_OUT>, &batch::polynomial<2, batch::SHAPE_IN_OUT>, &batch::polynomial<2, batch::SHAPE_OUT_IN> },
+	{ &batch::scalar<&expo::in>, &batch::scalar<&expo::out>, &batch::scalar<&expo::in_out>, &batch::scalar<&expo::out_in> },
+	{ &batch::scalar<&elastic::in>, &batch::scalar<&elastic::out>, &batch::scalar<&elastic::in_out>, &batch::scalar<&elastic::out_in> },
+	{ &batch::polynomial<3, batch::SHAPE_IN>, &batch::polynomial<3, batch::SHAPE_OUT>, &batch::polynomial<3, batch::SHAPE_IN_OUT>, &batch::polynomial<3, batch::SHAPE_OUT_IN> },
+	{ &batch::scalar<&circ::in>, &batch::scalar<&circ::out>, &batch::scalar<&circ::in_out>, &batch::scalar<&circ::out_in> },
+	{ &batch::scalar<&bounce::in>, &batch::scalar<&bounce::out>, &batch::scalar<&bounce::in_out>, &batch::scalar<&bounce::out_in> },
+	{ &batch::scalar<&back::in>, &batch::scalar<&back::out>, &batch::scalar<&back::in_out>, &batch::scalar<&back::out_in> },
+};
+
 real_t Threen::run_equation(Threen::TransitionType p_trans_type, Threen::EaseType p_ease_type, real_t p_time, real_t p_initial, real_t p_delta, real_t p_duration) {
 	if (p_duration == 0) {
 		// Special case to avoid dividing by 0 in equations.
@@ -80,6 +94,26 @@ real_t Threen::run_equation(Threen::TransitionType p_trans_type, Threen::EaseTyp
 	return func(p_time, p_initial, p_delta, p_duration);
 }
 
+void Threen::run_equation_batch(TransitionType p_trans_type, EaseType p_ease_type, const float *p_times, float *r_values, int p_count, float p_initial, float p_delta, float p_duration) {
+	ERR_FAIL_INDEX(p_trans_type, TRANS_COUNT);
+	ERR_FAIL_INDEX(p_ease_type, EASE_COUNT);
+	if (p_duration == 0) {
+		// Special case to avoid dividing by 0 in equations.
+		for (int i = 0; i < p_count; i++) {
+			r_values[i] = p_initial + p_delta;
+		}
+		return;
+	}
+	batch_interpolaters[p_trans_type][p_ease_type](p_times, r_values, p_count, p_initial, p_delta, p_duration);
+}
+
+PackedFloat32Array Threen::_run_equation_batch_bind(TransitionType p_trans_type, EaseType p_ease_type, const PackedFloat32Array &p_times, float p_initial, float p_delta, float p_duration) {
+	PackedFloat32Array values;
+	values.resize(p_times.size());
+	run_equation_batch(p_trans_type, p_ease_type, p_times.ptr(), values.ptrw(), p_times.size(), p_initial, p_delta, p_duration);
+	return values;
+}
+
 void Threen::_add_pending_command(StringName p_key, const Variant &p_arg1, const Variant &p_arg2, const Variant &p_arg3, const Variant &p_arg4, const Variant &p_arg5, const Variant &p_arg6, const Variant &p_arg7, const Variant &p_arg8, const Variant &p_arg9, const Variant &p_arg10) {
 	// Add a new pending command and reference it
 	pending_commands.push_back(PendingCommand());
@@ -307,6 +341,8 @@ void Threen::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_tween_process_mode", "mode"), &Threen::set_tween_process_mode);
 	ClassDB::bind_method(D_METHOD("get_tween_process_mode"), &Threen::get_tween_process_mode);
 
+	ClassDB::bind_static_method("Threen", D_METHOD("run_equation_batch", "trans_type", "ease_type", "times", "initial", "delta", "duration"), &Threen::_run_equation_batch_bind);
+
 	// Bind the various Threen control methods
 	ClassDB::bind_method(D_METHOD("start"), &Threen::start);
 	ClassDB::bind_method(D_METHOD("reset", "object", "key"), &Threen::reset, DEFVAL(""));
@@ -331,6 +367,8 @@ void Threen::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("follow_method", "object", "method", "initial_val", "target", "target_method", "duration", "trans_type", "ease_type", "delay"), &Threen::follow_method, DEFVAL(TRANS_LINEAR), DEFVAL(EASE_IN_OUT), DEFVAL(0));
 	ClassDB::bind_method(D_METHOD("targeting_property", "object", "property", "initial", "initial_val", "final_val", "duration", "trans_type", "ease_type", "delay"), &Threen::targeting_property, DEFVAL(TRANS_LINEAR), DEFVAL(EASE_IN_OUT), DEFVAL(0));
 	ClassDB::bind_method(D_METHOD("targeting_method", "object", "method", "initial", "initial_method", "final_val", "duration", "trans_type", "ease_type", "delay"), &Threen::targeting_method, DEFVAL(TRANS_LINEAR), DEFVAL(EASE_IN_OUT), DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("interpolate_property_batched", "object", "property", "initial_val", "final_val", "duration", "trans_type", "ease_type", "delay"), &Threen::interpolate_property_batched, DEFVAL(TRANS_LINEAR), DEFVAL(EASE_IN_OUT), DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("get_batched_tween_count"), &Threen::get_batched_tween_count);
 
 	// Add the Threen signals
 	ADD_SIGNAL(MethodInfo("tween_started", PropertyInfo(Variant::OBJECT, "object"), PropertyInfo(Variant::NODE_PATH, "key")));
@@ -754,7 +792,7 @@ void Threen::_tween_process(float p_delta) {
 		}
 
 		// If we are all finished, we can reset all of the tweens
-		if (repeats_finished) {
+		if (repeats_finished && _batch_all_finished()) {
 			reset_all();
 		}
 	}
@@ -897,6 +935,11 @@ void Threen::_tween_process(float p_delta) {
 			all_finished = all_finished && interp_data.finish;
 		}
 	}
+
+	// Batched tweens are advanced all at once, only then do we know whether they are done
+	_process_batch_lanes(p_delta);
+	all_finished = all_finished && _batch_all_finished();
+
 	// One less update left to go
 	pending_update--;
 
@@ -967,6 +1010,11 @@ bool Threen::start() {
 		InterpolateData &interp_data = E->get();
 		interp_data.active = true;
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			lane.flags[i] |= BATCH_ACTIVE;
+		}
+	}
 	pending_update--;
 
 	// We want to be activated
@@ -1004,6 +1052,17 @@ bool Threen::reset(Object *p_object, StringName p_key) {
 			}
 		}
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			if (p_object && _batch_matches(lane, i, p_object->get_instance_id(), p_key)) {
+				lane.elapsed[i] = 0;
+				lane.flags[i] &= ~BATCH_FINISHED;
+				if (lane.delay[i] == 0) {
+					_batch_apply(lane, i, p_object, &lane.initial[i * lane.components]);
+				}
+			}
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1022,6 +1081,18 @@ bool Threen::reset_all() {
 			_apply_tween_value(interp_data, interp_data.initial_val);
 		}
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			lane.elapsed[i] = 0;
+			lane.flags[i] &= ~BATCH_FINISHED;
+			if (lane.delay[i] == 0) {
+				Object *object = ObjectDB::get_instance(lane.ids[i]);
+				if (object) {
+					_batch_apply(lane, i, object, &lane.initial[i * lane.components]);
+				}
+			}
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1043,6 +1114,13 @@ bool Threen::stop(Object *p_object, StringName p_key) {
 			interp_data.active = false;
 		}
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			if (p_object && _batch_matches(lane, i, p_object->get_instance_id(), p_key)) {
+				lane.flags[i] &= ~BATCH_ACTIVE;
+			}
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1059,6 +1137,11 @@ bool Threen::stop_all() {
 		InterpolateData &interp_data = E->get();
 		interp_data.active = false;
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			lane.flags[i] &= ~BATCH_ACTIVE;
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1083,6 +1166,13 @@ bool Threen::resume(Object *p_object, StringName p_key) {
 			interp_data.active = true;
 		}
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			if (p_object && _batch_matches(lane, i, p_object->get_instance_id(), p_key)) {
+				lane.flags[i] |= BATCH_ACTIVE;
+			}
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1099,6 +1189,11 @@ bool Threen::resume_all() {
 		InterpolateData &interp_data = E->get();
 		interp_data.active = true;
 	}
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			lane.flags[i] |= BATCH_ACTIVE;
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1131,6 +1226,15 @@ bool Threen::remove(Object *p_object, StringName p_key) {
 		// Erase it
 		interpolates.erase(E->get());
 	}
+
+	// Batched tweens can be dropped in place, walking backwards keeps the unvisited ones in front
+	for (BatchLane &lane : batch_lanes) {
+		for (int64_t i = int64_t(lane.size()) - 1; i >= 0; i--) {
+			if (p_object && _batch_matches(lane, i, p_object->get_instance_id(), p_key)) {
+				lane.remove_at_unordered(i);
+			}
+		}
+	}
 	return true;
 }
 
@@ -1172,6 +1276,9 @@ bool Threen::remove_all() {
 
 	// Clear out all interpolations and reset the uid
 	interpolates.clear();
+	for (BatchLane &lane : batch_lanes) {
+		lane.clear();
+	}
 	uid = 0;
 
 	return true;
@@ -1210,6 +1317,29 @@ bool Threen::seek(real_t p_time) {
 		Variant result = _run_equation(interp_data);
 		_apply_tween_value(interp_data, result);
 	}
+
+	real_t value[4];
+	for (BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			lane.elapsed[i] = p_time;
+			if (lane.elapsed[i] < lane.delay[i]) {
+				lane.flags[i] &= ~BATCH_FINISHED;
+				continue;
+			} else if (lane.elapsed[i] >= (lane.delay[i] + lane.duration[i])) {
+				lane.elapsed[i] = lane.delay[i] + lane.duration[i];
+				lane.flags[i] |= BATCH_FINISHED;
+			} else {
+				lane.flags[i] &= ~BATCH_FINISHED;
+			}
+
+			Object *object = ObjectDB::get_instance(lane.ids[i]);
+			if (object == nullptr) {
+				continue;
+			}
+			_batch_evaluate(lane, i, value);
+			_batch_apply(lane, i, object, value);
+		}
+	}
 	pending_update--;
 	return true;
 }
@@ -1228,6 +1358,11 @@ real_t Threen::tell() const {
 			pos = interp_data.elapsed;
 		}
 	}
+	for (const BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			pos = MAX(pos, lane.elapsed[i]);
+		}
+	}
 	pending_update--;
 	return pos;
 }
@@ -1251,6 +1386,11 @@ real_t Threen::get_runtime() const {
 			runtime = t;
 		}
 	}
+	for (const BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			runtime = MAX(runtime, lane.delay[i] + lane.duration[i]);
+		}
+	}
 	pending_update--;
 
 	// Adjust the runtime for the current speed scale
@@ -1938,6 +2078,390 @@ bool Threen::targeting_method(Object *p_object, StringName p_method, Object *p_i
 	return true;
 }
 
+void Threen::BatchLane::remove_at_unordered(uint32_t p_index) {
+	ids.remove_at_unordered(p_index);
+	setters.remove_at_unordered(p_index);
+	keys.remove_at_unordered(p_index);
+	concatenated_keys.remove_at_unordered(p_index);
+	elapsed.remove_at_unordered(p_index);
+	delay.remove_at_unordered(p_index);
+	duration.remove_at_unordered(p_index);
+	trans_types.remove_at_unordered(p_index);
+	ease_types.remove_at_unordered(p_index);
+	flags.remove_at_unordered(p_index);
+
+	// Move the values of the last tween into the freed slot, same as remove_at_unordered does
+	const uint32_t last = ids.size();
+	if (p_index != last) {
+		for (uint32_t c = 0; c < components; c++) {
+			initial[p_index * components + c] = initial[last * components + c];
+			delta[p_index * components + c] = delta[last * components + c];
+			final[p_index * components + c] = final[last * components + c];
+		}
+	}
+	initial.resize(last * components);
+	delta.resize(last * components);
+	final.resize(last * components);
+}
+
+void Threen::BatchLane::clear() {
+	ids.clear();
+	setters.clear();
+	keys.clear();
+	concatenated_keys.clear();
+	elapsed.clear();
+	delay.clear();
+	duration.clear();
+	trans_types.clear();
+	ease_types.clear();
+	flags.clear();
+	initial.clear();
+	delta.clear();
+	final.clear();
+	eased.clear();
+}
+
+MethodBind *Threen::_resolve_batch_setter(Object *p_object, const Vector<StringName> &p_key, Variant::Type p_type) {
+	// Only plain properties bound in ClassDB can skip set_indexed, scripts may shadow them and
+	// subpaths (position:x) or indexed properties need the generic path
+	if (p_key.size() != 1 || p_object->get_script_instance() != nullptr) {
+		return nullptr;
+	}
+
+	const StringName &class_name = p_object->get_class_name();
+	if (ClassDB::get_property_index(class_name, p_key[0]) != -1) {
+		return nullptr;
+	}
+
+	StringName setter_name = ClassDB::get_property_setter(class_name, p_key[0]);
+	if (setter_name == StringName()) {
+		return nullptr;
+	}
+
+	MethodBind *setter = ClassDB::get_method(class_name, setter_name);
+	if (setter == nullptr || setter->is_vararg() || setter->get_argument_count() != 1 || setter->get_argument_type(0) != p_type) {
+		return nullptr;
+	}
+	return setter;
+}
+
+bool Threen::_batch_matches(const BatchLane &p_lane, uint32_t p_index, ObjectID p_id, const StringName &p_key) {
+	return p_lane.ids[p_index] == p_id && (p_lane.concatenated_keys[p_index] == p_key || p_key == StringName());
+}
+
+void Threen::_batch_evaluate(const BatchLane &p_lane, uint32_t p_index, real_t *r_value) const {
+	const uint32_t components = p_lane.components;
+	const real_t *initial = &p_lane.initial[p_index * components];
+	const real_t *delta = &p_lane.delta[p_index * components];
+
+	if (p_lane.flags[p_index] & BATCH_FINISHED) {
+		const real_t *final = &p_lane.final[p_index * components];
+		for (uint32_t c = 0; c < components; c++) {
+			r_value[c] = final[c];
+		}
+		return;
+	}
+
+	real_t eased = 1.0;
+	if (p_lane.duration[p_index] > 0) {
+		eased = interpolaters[p_lane.trans_types[p_index]][p_lane.ease_types[p_index]](p_lane.elapsed[p_index] - p_lane.delay[p_index], 0, 1, p_lane.duration[p_index]);
+	}
+
+	for (uint32_t c = 0; c < components; c++) {
+		r_value[c] = initial[c] + delta[c] * eased;
+	}
+}
+
+void Threen::_batch_apply(const BatchLane &p_lane, uint32_t p_index, Object *p_object, const real_t *p_value) {
+	MethodBind *setter = p_lane.setters[p_index];
+
+	switch (p_lane.variant_type) {
+		case Variant::FLOAT: {
+			// Float arguments always travel as double through ptrcall
+			double value = p_value[0];
+			if (setter) {
+				const void *args[1] = { &value };
+				setter->ptrcall(p_object, args, nullptr);
+			} else {
+				p_object->set_indexed(p_lane.keys[p_index], value);
+			}
+		} break;
+
+		case Variant::VECTOR2: {
+			Vector2 value(p_value[0], p_value[1]);
+			if (setter) {
+				const void *args[1] = { &value };
+				setter->ptrcall(p_object, args, nullptr);
+			} else {
+				p_object->set_indexed(p_lane.keys[p_index], value);
+			}
+		} break;
+
+		case Variant::COLOR: {
+			Color value(p_value[0], p_value[1], p_value[2], p_value[3]);
+			if (setter) {
+				const void *args[1] = { &value };
+				setter->ptrcall(p_object, args, nullptr);
+			} else {
+				p_object->set_indexed(p_lane.keys[p_index], value);
+			}
+		} break;
+
+		default: {
+			ERR_FAIL_MSG("Invalid batched Threen lane.");
+		} break;
+	}
+}
+
+bool Threen::_batch_all_finished() const {
+	for (const BatchLane &lane : batch_lanes) {
+		for (uint32_t i = 0; i < lane.size(); i++) {
+			if (!(lane.flags[i] & BATCH_FINISHED)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Threen::_process_batch_lanes(real_t p_delta) {
+	real_t value[4];
+
+	for (BatchLane &lane : batch_lanes) {
+		const uint32_t count = lane.size();
+		if (count == 0) {
+			continue;
+		}
+		const uint32_t components = lane.components;
+		lane.eased.resize(count);
+
+		// Advance time and flag the tweens that need their value written this frame
+		for (uint32_t i = 0; i < count; i++) {
+			uint8_t flags = lane.flags[i] & (BATCH_ACTIVE | BATCH_FINISHED);
+			if (flags != BATCH_ACTIVE) {
+				lane.flags[i] = flags;
+				continue;
+			}
+
+			const bool prev_delaying = lane.elapsed[i] <= lane.delay[i];
+			real_t elapsed = lane.elapsed[i] + p_delta;
+			const real_t end = lane.delay[i] + lane.duration[i];
+			if (elapsed < lane.delay[i]) {
+				lane.elapsed[i] = elapsed;
+				lane.flags[i] = flags;
+				continue;
+			}
+
+			if (prev_delaying) {
+				flags |= BATCH_STARTED;
+			}
+			if (elapsed > end) {
+				elapsed = end;
+				flags |= BATCH_FINISHED;
+			}
+			lane.elapsed[i] = elapsed;
+			lane.flags[i] = flags | BATCH_APPLY;
+		}
+
+		// Easing equations are all linear in their initial and delta arguments and only depend on
+		// elapsed / duration, so a single normalized evaluation per tween covers every component of
+		// its value. Tweens are bucketed by curve so each bucket is one pass of its batch kernel.
+		uint32_t offsets[TRANS_COUNT * EASE_COUNT + 1] = {};
+		for (uint32_t i = 0; i < count; i++) {
+			lane.eased[i] = 1.0;
+			if ((lane.flags[i] & (BATCH_APPLY | BATCH_FINISHED)) == BATCH_APPLY && lane.duration[i] > 0) {
+				offsets[lane.trans_types[i] * EASE_COUNT + lane.ease_types[i] + 1]++;
+			}
+		}
+		for (int curve = 0; curve < TRANS_COUNT * EASE_COUNT; curve++) {
+			offsets[curve + 1] += offsets[curve];
+		}
+		const uint32_t evaluated = offsets[TRANS_COUNT * EASE_COUNT];
+		if (evaluated > 0) {
+			batch_order.resize(evaluated);
+			batch_times.resize(evaluated);
+			batch_values.resize(evaluated);
+			uint32_t cursor[TRANS_COUNT * EASE_COUNT];
+			memcpy(cursor, offsets, sizeof(cursor));
+			for (uint32_t i = 0; i < count; i++) {
+				if ((lane.flags[i] & (BATCH_APPLY | BATCH_FINISHED)) == BATCH_APPLY && lane.duration[i] > 0) {
+					const uint32_t slot = cursor[lane.trans_types[i] * EASE_COUNT + lane.ease_types[i]]++;
+					batch_order[slot] = i;
+					batch_times[slot] = (lane.elapsed[i] - lane.delay[i]) / lane.duration[i];
+				}
+			}
+			for (int curve = 0; curve < TRANS_COUNT * EASE_COUNT; curve++) {
+				const uint32_t begin = offsets[curve];
+				const uint32_t end = offsets[curve + 1];
+				if (begin != end) {
+					run_equation_batch(TransitionType(curve / EASE_COUNT), EaseType(curve % EASE_COUNT), &batch_times[begin], &batch_values[begin], end - begin, 0.0f, 1.0f, 1.0f);
+				}
+			}
+			for (uint32_t slot = 0; slot < evaluated; slot++) {
+				lane.eased[batch_order[slot]] = batch_values[slot];
+			}
+		}
+
+		// Write the values out. The object is looked up again for every tween, any setter may emit
+		// a signal that ends up freeing it
+		for (uint32_t i = 0; i < count; i++) {
+			const uint8_t flags = lane.flags[i];
+			if (!(flags & BATCH_APPLY)) {
+				continue;
+			}
+
+			Object *object = ObjectDB::get_instance(lane.ids[i]);
+			if (object == nullptr) {
+				// The target is gone, nothing will ever observe this tween again
+				lane.flags[i] = BATCH_FINISHED | BATCH_ORPHANED;
+				continue;
+			}
+
+			const real_t *result;
+			if (flags & BATCH_FINISHED) {
+				result = &lane.final[i * components];
+			} else {
+				const real_t *initial = &lane.initial[i * components];
+				const real_t *delta = &lane.delta[i * components];
+				const real_t eased = lane.eased[i];
+				for (uint32_t c = 0; c < components; c++) {
+					value[c] = initial[c] + delta[c] * eased;
+				}
+				result = value;
+			}
+			_batch_apply(lane, i, object, result);
+
+			if (flags & BATCH_STARTED) {
+				BatchEvent event;
+				event.id = lane.ids[i];
+				event.key = lane.keys[i];
+				batch_events.push_back(event);
+			}
+			if (flags & BATCH_FINISHED) {
+				BatchEvent event;
+				event.id = lane.ids[i];
+				event.key = lane.keys[i];
+				event.completed = true;
+				batch_events.push_back(event);
+			}
+		}
+
+		// Drop the tweens that are done, unlike interpolates there is no uid to defer the removal on
+		for (int64_t i = int64_t(count) - 1; i >= 0; i--) {
+			const uint8_t flags = lane.flags[i];
+			if ((flags & BATCH_ORPHANED) || (!repeat && (flags & (BATCH_APPLY | BATCH_FINISHED)) == (BATCH_APPLY | BATCH_FINISHED))) {
+				lane.remove_at_unordered(i);
+			}
+		}
+	}
+
+	// Signals go out last, anything they trigger is queued as a pending command
+	for (uint32_t i = 0; i < batch_events.size(); i++) {
+		Object *object = ObjectDB::get_instance(batch_events[i].id);
+		if (object == nullptr) {
+			continue;
+		}
+		emit_signal(batch_events[i].completed ? SNAME("tween_completed") : SNAME("tween_started"), object, nodepath_from_subnames(batch_events[i].key));
+	}
+	batch_events.clear();
+}
+
+bool Threen::interpolate_property_batched(Object *p_object, NodePath p_property, Variant p_initial_val, Variant p_final_val, real_t p_duration, TransitionType p_trans_type, EaseType p_ease_type, real_t p_delay) {
+	// If we are busy updating, call this function again later
+	if (pending_update != 0) {
+		_add_pending_command("interpolate_property_batched", p_object, p_property, p_initial_val, p_final_val, p_duration, p_trans_type, p_ease_type, p_delay);
+		return true;
+	}
+
+	// Check that the target object is valid
+	ERR_FAIL_COND_V_MSG(p_object == nullptr, false, vformat("The Threen \"%s\"'s target node is `null`. Is the node reference correct?", get_name()));
+
+	// Get the property from the node path
+	p_property = p_property.get_as_property_path();
+	Vector<StringName> key = nodepath_get_subnames(p_property);
+
+	// If no initial value given, grab the initial value from the object
+	if (p_initial_val.get_type() == Variant::NIL) {
+		p_initial_val = p_object->get_indexed(key);
+	}
+
+	// Convert any integers into REALs as they are better for interpolation
+	if (p_initial_val.get_type() == Variant::INT) {
+		p_initial_val = p_initial_val.operator real_t();
+	}
+	if (p_final_val.get_type() == Variant::INT) {
+		p_final_val = p_final_val.operator real_t();
+	}
+
+	ERR_FAIL_COND_V_MSG(p_initial_val.get_type() != p_final_val.get_type(), false, "Threen initial and final values must be of the same type.");
+	ERR_FAIL_COND_V_MSG(p_duration < 0, false, "Only non-negative duration values allowed in Threens.");
+	ERR_FAIL_COND_V_MSG(p_delay < 0, false, "Only non-negative delay values allowed in Threens.");
+	ERR_FAIL_COND_V_MSG(p_trans_type < 0 || p_trans_type >= TRANS_COUNT, false, "Invalid transition type provided to Threen.");
+	ERR_FAIL_COND_V_MSG(p_ease_type < 0 || p_ease_type >= EASE_COUNT, false, "Invalid easing type provided to Threen.");
+
+	// Unpack both ends into plain components
+	real_t initial[4];
+	real_t final[4];
+	BatchLaneType lane_type;
+	switch (p_initial_val.get_type()) {
+		case Variant::FLOAT: {
+			lane_type = BATCH_LANE_FLOAT;
+			initial[0] = p_initial_val;
+			final[0] = p_final_val;
+		} break;
+
+		case Variant::VECTOR2: {
+			lane_type = BATCH_LANE_VECTOR2;
+			Vector2 i = p_initial_val;
+			Vector2 f = p_final_val;
+			initial[0] = i.x;
+			initial[1] = i.y;
+			final[0] = f.x;
+			final[1] = f.y;
+		} break;
+
+		case Variant::COLOR: {
+			lane_type = BATCH_LANE_COLOR;
+			Color i = p_initial_val;
+			Color f = p_final_val;
+			for (int c = 0; c < 4; c++) {
+				initial[c] = i.components[c];
+				final[c] = f.components[c];
+			}
+		} break;
+
+		default: {
+			ERR_FAIL_V_MSG(false, "Batched Threens only support float, Vector2 and Color values, use interpolate_property for anything else.");
+		} break;
+	}
+
+	BatchLane &lane = batch_lanes[lane_type];
+	lane.ids.push_back(p_object->get_instance_id());
+	lane.setters.push_back(_resolve_batch_setter(p_object, key, lane.variant_type));
+	lane.keys.push_back(key);
+	lane.concatenated_keys.push_back(p_property.get_concatenated_subnames());
+	lane.elapsed.push_back(0);
+	lane.delay.push_back(p_delay);
+	lane.duration.push_back(p_duration);
+	lane.trans_types.push_back(p_trans_type);
+	lane.ease_types.push_back(p_ease_type);
+	lane.flags.push_back(BATCH_ACTIVE);
+	for (uint32_t c = 0; c < lane.components; c++) {
+		lane.initial.push_back(initial[c]);
+		lane.delta.push_back(final[c] - initial[c]);
+		lane.final.push_back(final[c]);
+	}
+	return true;
+}
+
+int Threen::get_batched_tween_count() const {
+	int count = 0;
+	for (const BatchLane &lane : batch_lanes) {
+		count += lane.size();
+	}
+	return count;
+}
+
 Threen::Threen() {
 	// Initialize tween attributes
 	tween_process_mode = TWEEN_PROCESS_IDLE;
@@ -1945,6 +2469,13 @@ Threen::Threen() {
 	speed_scale = 1;
 	pending_update = 0;
 	uid = 0;
+
+	batch_lanes[BATCH_LANE_FLOAT].variant_type = Variant::FLOAT;
+	batch_lanes[BATCH_LANE_FLOAT].components = 1;
+	batch_lanes[BATCH_LANE_VECTOR2].variant_type = Variant::VECTOR2;
+	batch_lanes[BATCH_LANE_VECTOR2].components = 2;
+	batch_lanes[BATCH_LANE_COLOR].variant_type = Variant::COLOR;
+	batch_lanes[BATCH_LANE_COLOR].components = 4;
 }
 
 Threen::~Threen() {
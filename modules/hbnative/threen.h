@@ -32,6 +32,7 @@
 #define THREEN_H
 
 #include "core/object/object.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/vector.h"
 #include "core/variant/variant.h"
 #include "scene/main/node.h"
@@ -131,11 +132,80 @@ private:
 	};
 	List<PendingCommand> pending_commands;
 
+	// Tweens created with interpolate_property_batched live here instead of in interpolates, packed
+	// into one lane per value type so a frame is a few flat loops over plain arrays rather than
+	// Variant math and set_indexed for every tween.
+	enum BatchLaneType {
+		BATCH_LANE_FLOAT,
+		BATCH_LANE_VECTOR2,
+		BATCH_LANE_COLOR,
+		BATCH_LANE_MAX,
+	};
+
+	enum BatchFlags {
+		BATCH_ACTIVE = 1,
+		BATCH_FINISHED = 2,
+		// Per frame scratch bits, cleared when time advances
+		BATCH_APPLY = 4,
+		BATCH_STARTED = 8,
+		BATCH_ORPHANED = 16,
+	};
+
+	struct BatchLane {
+		Variant::Type variant_type = Variant::NIL;
+		uint32_t components = 0;
+
+		LocalVector<ObjectID> ids;
+		// Setter resolved once when the tween is created, nullptr falls back to set_indexed
+		LocalVector<MethodBind *> setters;
+		LocalVector<Vector<StringName>> keys;
+		LocalVector<StringName> concatenated_keys;
+		LocalVector<real_t> elapsed;
+		LocalVector<real_t> delay;
+		LocalVector<real_t> duration;
+		LocalVector<uint8_t> trans_types;
+		LocalVector<uint8_t> ease_types;
+		LocalVector<uint8_t> flags;
+		// components values per tween
+		LocalVector<real_t> initial;
+		LocalVector<real_t> delta;
+		LocalVector<real_t> final;
+		// Eased progress of each tween for the current frame
+		LocalVector<real_t> eased;
+
+		uint32_t size() const { return ids.size(); }
+		void remove_at_unordered(uint32_t p_index);
+		void clear();
+	};
+
+	struct BatchEvent {
+		ObjectID id;
+		Vector<StringName> key;
+		bool completed = false;
+	};
+
+	BatchLane batch_lanes[BATCH_LANE_MAX];
+	LocalVector<BatchEvent> batch_events;
+	// Scratch for _process_batch_lanes, normalized times grouped by transition and ease so each
+	// group goes through one run_equation_batch kernel
+	LocalVector<uint32_t> batch_order;
+	LocalVector<float> batch_times;
+	LocalVector<float> batch_values;
+
+	static MethodBind *_resolve_batch_setter(Object *p_object, const Vector<StringName> &p_key, Variant::Type p_type);
+	static bool _batch_matches(const BatchLane &p_lane, uint32_t p_index, ObjectID p_id, const StringName &p_key);
+	void _batch_evaluate(const BatchLane &p_lane, uint32_t p_index, real_t *r_value) const;
+	void _batch_apply(const BatchLane &p_lane, uint32_t p_index, Object *p_object, const real_t *p_value);
+	bool _batch_all_finished() const;
+	void _process_batch_lanes(real_t p_delta);
+
 	void _add_pending_command(StringName p_key, const Variant &p_arg1 = Variant(), const Variant &p_arg2 = Variant(), const Variant &p_arg3 = Variant(), const Variant &p_arg4 = Variant(), const Variant &p_arg5 = Variant(), const Variant &p_arg6 = Variant(), const Variant &p_arg7 = Variant(), const Variant &p_arg8 = Variant(), const Variant &p_arg9 = Variant(), const Variant &p_arg10 = Variant());
 	void _process_pending_commands();
 
 	typedef real_t (*interpolater)(real_t t, real_t b, real_t c, real_t d);
 	static interpolater interpolaters[TRANS_COUNT][EASE_COUNT];
+	typedef void (*batch_interpolater)(const float *p_times, float *r_values, int p_count, float b, float c, float d);
+	static batch_interpolater batch_interpolaters[TRANS_COUNT][EASE_COUNT];
 
 	Variant &_get_delta_val(InterpolateData &p_data);
 	Variant _get_initial_val(const InterpolateData &p_data) const;
@@ -156,9 +226,12 @@ protected:
 	void _notification(int p_what);
 
 	static void _bind_methods();
+	static PackedFloat32Array _run_equation_batch_bind(TransitionType p_trans_type, EaseType p_ease_type, const PackedFloat32Array &p_times, float p_initial, float p_delta, float p_duration);
 
 public:
 	static real_t run_equation(Threen::TransitionType p_trans_type, Threen::EaseType p_ease_type, real_t p_time, real_t p_initial, real_t p_delta, real_t p_duration);
+	// Evaluates one transition/ease pair for every time in p_times, dispatching once for the whole array
+	static void run_equation_batch(TransitionType p_trans_type, EaseType p_ease_type, const float *p_times, float *r_values, int p_count, float p_initial, float p_delta, float p_duration);
 
 	bool is_active() const;
 	void set_active(bool p_active);
@@ -195,6 +268,9 @@ public:
 	bool targeting_property(Object *p_object, NodePath p_property, Object *p_initial, NodePath p_initial_property, Variant p_final_val, real_t p_duration, TransitionType p_trans_type = TRANS_LINEAR, EaseType p_ease_type = EASE_IN_OUT, real_t p_delay = 0);
 	bool targeting_method(Object *p_object, StringName p_method, Object *p_initial, StringName p_initial_method, Variant p_final_val, real_t p_duration, TransitionType p_trans_type = TRANS_LINEAR, EaseType p_ease_type = EASE_IN_OUT, real_t p_delay = 0);
 
+	bool interpolate_property_batched(Object *p_object, NodePath p_property, Variant p_initial_val, Variant p_final_val, real_t p_duration, TransitionType p_trans_type = TRANS_LINEAR, EaseType p_ease_type = EASE_IN_OUT, real_t p_delay = 0);
+	int get_batched_tween_count() const;
+
 	Threen();
 	~Threen();
 };
@@ -16,7 +16,9 @@ void initialize_shinobu_module(ModuleInitializationLevel p_level) {
 	GDREGISTER_ABSTRACT_CLASS(ShinobuSoundPlayer);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuSoundSource);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuSoundSourceMemory);
+	GDREGISTER_ABSTRACT_CLASS(ShinobuSoundSourceFile);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuGroup);
+	GDREGISTER_ABSTRACT_CLASS(ShinobuVoicePool);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuEffect);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuChannelRemapEffect);
 	GDREGISTER_ABSTRACT_CLASS(ShinobuPitchShiftEffect);
@@ -15,6 +15,7 @@
 #include "shinobu_spectrum_analyzer.h"
 /* clang-format on */
 
+#include "core/io/file_access.h"
 #include "core/os/os.h"
 #include "miniaudio/extras/miniaudio_libvorbis.h"
 #include "shinobu_macros.h"
@@ -24,11 +25,18 @@ SafeNumeric<uint64_t> Shinobu::sound_source_uid;
 
 void Shinobu::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("create_group", "group_name", "parent_group"), &Shinobu::create_group);
+	ClassDB::bind_method(D_METHOD("create_voice_pool", "sound_source", "group", "voice_count"), &Shinobu::create_voice_pool);
 	ClassDB::bind_method(D_METHOD("initialize"), &Shinobu::godot_initialize);
+	ClassDB::bind_method(D_METHOD("initialize_offline", "sample_rate"), &Shinobu::initialize_offline, DEFVAL(48000));
+	ClassDB::bind_method(D_METHOD("render_offline", "frame_count"), &Shinobu::render_offline);
+	ClassDB::bind_method(D_METHOD("render_offline_to_file", "path", "frame_count"), &Shinobu::render_offline_to_file);
+	ClassDB::bind_method(D_METHOD("is_offline_rendering"), &Shinobu::is_offline_rendering);
+	ADD_SIGNAL(MethodInfo("offline_render_finished", PropertyInfo(Variant::STRING, "path"), PropertyInfo(Variant::INT, "error")));
 	ClassDB::bind_method(D_METHOD("get_initialization_error"), &Shinobu::get_initialization_error);
 	ClassDB::bind_method(D_METHOD("register_sound_from_memory", "name_hint", "data"), &Shinobu::register_sound_from_memory);
+	ClassDB::bind_method(D_METHOD("register_sound_from_path", "path"), &Shinobu::register_sound_from_path);
 	ClassDB::bind_method(D_METHOD("instantiate_spectrum_analyzer_effect"), &Shinobu::instantiate_spectrum_analyzer_effect);
-	ClassDB::bind_method(D_METHOD("instantiate_pitch_shift"), &Shinobu::instantiate_pitch_shift);
+	ClassDB::bind_method(D_METHOD("instantiate_pitch_shift", "fft_size", "oversampling"), &Shinobu::instantiate_pitch_shift, DEFVAL(2048), DEFVAL(4));
 	ClassDB::bind_method(D_METHOD("instantiate_channel_remap", "channel_count_in", "channel_count_out"), &Shinobu::instantiate_channel_remap);
 	ClassDB::bind_method(D_METHOD("set_desired_buffer_size_msec", "desired_buffer_size"), &Shinobu::set_desired_buffer_size_msec);
 	ClassDB::bind_method(D_METHOD("get_desired_buffer_size_msec"), &Shinobu::get_desired_buffer_size_msec);
@@ -40,6 +48,26 @@ void Shinobu::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_dsp_time"), &Shinobu::get_dsp_time);
 	ClassDB::bind_method(D_METHOD("get_actual_buffer_size"), &Shinobu::get_actual_buffer_size);
 	ClassDB::bind_method(D_METHOD("get_current_backend_name"), &Shinobu::get_current_backend_name);
+	ClassDB::bind_method(D_METHOD("get_estimated_output_latency_usec"), &Shinobu::get_estimated_output_latency_usec);
+	ClassDB::bind_method(D_METHOD("set_clock_regression_enabled", "enabled"), &Shinobu::set_clock_regression_enabled);
+	ClassDB::bind_method(D_METHOD("is_clock_regression_enabled"), &Shinobu::is_clock_regression_enabled);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "clock_regression_enabled"), "set_clock_regression_enabled", "is_clock_regression_enabled");
+	ClassDB::bind_method(D_METHOD("get_clock_jitter_histogram"), &Shinobu::get_clock_jitter_histogram);
+	ClassDB::bind_method(D_METHOD("get_clock_max_jitter_usec"), &Shinobu::get_clock_max_jitter_usec);
+	ClassDB::bind_method(D_METHOD("get_clock_drift_ppm"), &Shinobu::get_clock_drift_ppm);
+	ClassDB::bind_method(D_METHOD("reset_clock_stats"), &Shinobu::reset_clock_stats);
+	ClassDB::bind_method(D_METHOD("set_loudness_cache_path", "path"), &Shinobu::set_loudness_cache_path);
+	ClassDB::bind_method(D_METHOD("get_loudness_cache_path"), &Shinobu::get_loudness_cache_path);
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "loudness_cache_path"), "set_loudness_cache_path", "get_loudness_cache_path");
+	ClassDB::bind_method(D_METHOD("clear_loudness_cache"), &Shinobu::clear_loudness_cache);
+	ClassDB::bind_method(D_METHOD("set_pcm_cache_budget_bytes", "budget_bytes"), &Shinobu::set_pcm_cache_budget_bytes);
+	ClassDB::bind_method(D_METHOD("get_pcm_cache_budget_bytes"), &Shinobu::get_pcm_cache_budget_bytes);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "pcm_cache_budget_bytes"), "set_pcm_cache_budget_bytes", "get_pcm_cache_budget_bytes");
+	ClassDB::bind_method(D_METHOD("set_pcm_cache_max_length_msec", "max_length_msec"), &Shinobu::set_pcm_cache_max_length_msec);
+	ClassDB::bind_method(D_METHOD("get_pcm_cache_max_length_msec"), &Shinobu::get_pcm_cache_max_length_msec);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "pcm_cache_max_length_msec"), "set_pcm_cache_max_length_msec", "get_pcm_cache_max_length_msec");
+	ClassDB::bind_method(D_METHOD("get_pcm_cache_size_bytes"), &Shinobu::get_pcm_cache_size_bytes);
+	ClassDB::bind_method(D_METHOD("clear_pcm_cache"), &Shinobu::clear_pcm_cache);
 }
 
 String Shinobu::get_initialization_error() const {
@@ -119,6 +147,111 @@ static ma_decoding_backend_vtable g_ma_decoding_backend_vtable_libvorbis = {
 	ma_decoding_backend_uninit__libvorbis
 };
 
+/*
+Custom backend vtables
+*/
+static ma_decoding_backend_vtable *g_shinobu_custom_backend_vtables[] = {
+	&g_ma_decoding_backend_vtable_libvorbis
+};
+
+// VFS backed by Godot's FileAccess, this lets the resource manager stream files directly from
+// the filesystem or from inside a PCK without ever holding the encoded file in memory.
+struct ShinobuVFSFile {
+	Ref<FileAccess> file;
+};
+
+static ma_result ma_vfs_open__godot(ma_vfs *pVFS, const char *pFilePath, ma_uint32 openMode, ma_vfs_file *pFile) {
+	(void)pVFS;
+
+	if (pFile == NULL) {
+		return MA_INVALID_ARGS;
+	}
+
+	*pFile = NULL;
+
+	// Writing is only used for offline renders, which always create the file from scratch
+	int mode_flags = (openMode & MA_OPEN_MODE_WRITE) != 0 ? FileAccess::WRITE : FileAccess::READ;
+
+	Error err;
+	Ref<FileAccess> file = FileAccess::open(String::utf8(pFilePath), mode_flags, &err);
+	if (file.is_null()) {
+		return err == ERR_FILE_NOT_FOUND ? MA_DOES_NOT_EXIST : MA_ERROR;
+	}
+
+	ShinobuVFSFile *vfs_file = memnew(ShinobuVFSFile);
+	vfs_file->file = file;
+	*pFile = vfs_file;
+
+	return MA_SUCCESS;
+}
+
+static ma_result ma_vfs_close__godot(ma_vfs *pVFS, ma_vfs_file file) {
+	(void)pVFS;
+	memdelete((ShinobuVFSFile *)file);
+	return MA_SUCCESS;
+}
+
+static ma_result ma_vfs_read__godot(ma_vfs *pVFS, ma_vfs_file file, void *pDst, size_t sizeInBytes, size_t *pBytesRead) {
+	(void)pVFS;
+
+	Ref<FileAccess> fa = ((ShinobuVFSFile *)file)->file;
+	uint64_t bytes_read = fa->get_buffer((uint8_t *)pDst, sizeInBytes);
+
+	if (pBytesRead != NULL) {
+		*pBytesRead = bytes_read;
+	}
+
+	if (bytes_read == 0 && sizeInBytes > 0) {
+		return MA_AT_END;
+	}
+
+	return MA_SUCCESS;
+}
+
+static ma_result ma_vfs_write__godot(ma_vfs *pVFS, ma_vfs_file file, const void *pSrc, size_t sizeInBytes, size_t *pBytesWritten) {
+	(void)pVFS;
+
+	Ref<FileAccess> fa = ((ShinobuVFSFile *)file)->file;
+	fa->store_buffer((const uint8_t *)pSrc, sizeInBytes);
+
+	if (pBytesWritten != NULL) {
+		*pBytesWritten = sizeInBytes;
+	}
+
+	return fa->get_error() == OK ? MA_SUCCESS : MA_IO_ERROR;
+}
+
+static ma_result ma_vfs_seek__godot(ma_vfs *pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin) {
+	(void)pVFS;
+
+	Ref<FileAccess> fa = ((ShinobuVFSFile *)file)->file;
+	switch (origin) {
+		case ma_seek_origin_start: {
+			fa->seek(offset);
+		} break;
+		case ma_seek_origin_current: {
+			fa->seek(fa->get_position() + offset);
+		} break;
+		case ma_seek_origin_end: {
+			fa->seek_end(offset);
+		} break;
+	}
+
+	return MA_SUCCESS;
+}
+
+static ma_result ma_vfs_tell__godot(ma_vfs *pVFS, ma_vfs_file file, ma_int64 *pCursor) {
+	(void)pVFS;
+	*pCursor = ((ShinobuVFSFile *)file)->file->get_position();
+	return MA_SUCCESS;
+}
+
+static ma_result ma_vfs_info__godot(ma_vfs *pVFS, ma_vfs_file file, ma_file_info *pInfo) {
+	(void)pVFS;
+	pInfo->sizeInBytes = ((ShinobuVFSFile *)file)->file->get_length();
+	return MA_SUCCESS;
+}
+
 Error Shinobu::godot_initialize() {
 	return initialize(ma_backend_null);
 }
@@ -168,6 +301,7 @@ Error Shinobu::initialize(ma_backend forced_backend) {
 #endif
 
 	bool shinobu_clock_mix_size_compensation = true;
+	bool shinobu_clock_regression = clock->is_using_regression();
 
 	List<String>::Element *I = args.front();
 	while (I) {
@@ -179,11 +313,14 @@ Error Shinobu::initialize(ma_backend forced_backend) {
 			}
 		} else if (I->get() == "--shinobu-dev-disable-clock-msc") {
 			shinobu_clock_mix_size_compensation = false;
+		} else if (I->get() == "--shinobu-clock-regression") {
+			shinobu_clock_regression = true;
 		}
 		I = N;
 	}
 
 	clock->set_use_mix_size_compensation(shinobu_clock_mix_size_compensation);
+	clock->set_use_regression(shinobu_clock_regression);
 
 	clock->measure(0);
 
@@ -231,31 +368,39 @@ Error Shinobu::initialize(ma_backend forced_backend) {
 		engine_config.periodSizeInMilliseconds = desired_buffer_size_msec;
 	}
 
+	has_device = true;
+
+	return _initialize_engine(&engine_config);
+}
+
+Error Shinobu::_initialize_engine(ma_engine_config *p_engine_config) {
+	ma_result result;
+
 	// Setup libvorbis
 
 	ma_resource_manager_config resourceManagerConfig;
 
-	/*
-	Custom backend vtables
-	*/
-	ma_decoding_backend_vtable *pCustomBackendVTables[] = {
-		&g_ma_decoding_backend_vtable_libvorbis
-	};
-
 	/* Using custom decoding backends requires a resource manager. */
 	resourceManagerConfig = ma_resource_manager_config_init();
-	resourceManagerConfig.ppCustomDecodingBackendVTables = pCustomBackendVTables;
-	resourceManagerConfig.customDecodingBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
+	resourceManagerConfig.ppCustomDecodingBackendVTables = g_shinobu_custom_backend_vtables;
+	resourceManagerConfig.customDecodingBackendCount = sizeof(g_shinobu_custom_backend_vtables) / sizeof(g_shinobu_custom_backend_vtables[0]);
 	resourceManagerConfig.pCustomDecodingBackendUserData = NULL;
 	resourceManagerConfig.decodedFormat = ma_format_f32;
+	resourceManagerConfig.pVFS = &vfs;
+	if (offline_mode) {
+		// Streams would otherwise be decoded by the job thread at its own pace, which a faster than realtime
+		// render outruns, leaving silent gaps that change from run to run
+		resourceManagerConfig.jobThreadCount = 0;
+		resourceManagerConfig.flags |= MA_RESOURCE_MANAGER_FLAG_NO_THREADING;
+	}
 
 	result = ma_resource_manager_init(&resourceManagerConfig, &resource_manager);
 
 	MA_ERR_RET(result, "Resource manager init failed!");
 
-	engine_config.pResourceManager = &resource_manager;
+	p_engine_config->pResourceManager = &resource_manager;
 
-	result = ma_engine_init(&engine_config, &engine);
+	result = ma_engine_init(p_engine_config, &engine);
 
 	MA_ERR_RET(result, "Audio engine init failed!");
 
@@ -264,8 +409,26 @@ Error Shinobu::initialize(ma_backend forced_backend) {
 	return OK;
 }
 
+// Sets up the engine without any device, nothing is mixed unless render_offline is called.
+// Meant for headless tools and tests, everything else (groups, effects, sources) works the same.
+Error Shinobu::initialize_offline(uint32_t m_sample_rate) {
+	ERR_FAIL_COND_V_MSG(initialized, ERR_ALREADY_IN_USE, "Shinobu is already initialized.");
+	ma_engine_config engine_config = ma_engine_config_init();
+	engine_config.noDevice = MA_TRUE;
+	engine_config.channels = 2;
+	engine_config.sampleRate = m_sample_rate;
+	clock->measure(0);
+	offline_mode = true;
+	return _initialize_engine(&engine_config);
+}
+
 void Shinobu::ma_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
 	Shinobu *shinobu = (Shinobu *)pDevice->pUserData;
+	if (shinobu != NULL && shinobu->offline_render_active.is_set()) {
+		// The device is stopped while rendering offline, this only covers the callback that was running when it started
+		ma_silence_pcm_frames(pOutput, frameCount, ma_format_f32, pDevice->playback.channels);
+		return;
+	}
 	if (shinobu != NULL) {
 		ma_engine_read_pcm_frames(&shinobu->engine, pOutput, frameCount, NULL);
 		uint32_t sample_size_nsec = (frameCount * 1e+9) / ma_engine_get_sample_rate(&shinobu->engine);
@@ -274,6 +437,14 @@ void Shinobu::ma_data_callback(ma_device *pDevice, void *pOutput, const void *pI
 }
 
 Shinobu::Shinobu() {
+	vfs.onOpen = ma_vfs_open__godot;
+	vfs.onOpenW = NULL;
+	vfs.onClose = ma_vfs_close__godot;
+	vfs.onRead = ma_vfs_read__godot;
+	vfs.onWrite = ma_vfs_write__godot;
+	vfs.onSeek = ma_vfs_seek__godot;
+	vfs.onTell = ma_vfs_tell__godot;
+	vfs.onInfo = ma_vfs_info__godot;
 	clock.instantiate();
 	singleton = this;
 	sound_source_uid.set(0);
@@ -287,24 +458,119 @@ ma_engine *Shinobu::get_engine() {
 	return &engine;
 }
 
+ma_vfs *Shinobu::get_vfs() {
+	return &vfs;
+}
+
+ma_decoder_config Shinobu::get_decoder_config() const {
+	ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);
+	config.ppCustomBackendVTables = g_shinobu_custom_backend_vtables;
+	config.customBackendCount = sizeof(g_shinobu_custom_backend_vtables) / sizeof(g_shinobu_custom_backend_vtables[0]);
+	config.pCustomBackendUserData = NULL;
+	return config;
+}
+
+String Shinobu::get_decoder_codec_name(const ma_decoder *p_decoder) {
+	const ma_decoding_backend_vtable *vtable = p_decoder->pBackendVTable;
+	if (vtable == &g_ma_decoding_backend_vtable_libvorbis) {
+		return "vorbis";
+	}
+#ifdef MA_HAS_WAV
+	if (vtable == &g_ma_decoding_backend_vtable_wav) {
+		return "wav";
+	}
+#endif
+#ifdef MA_HAS_FLAC
+	if (vtable == &g_ma_decoding_backend_vtable_flac) {
+		return "flac";
+	}
+#endif
+#ifdef MA_HAS_MP3
+	if (vtable == &g_ma_decoding_backend_vtable_mp3) {
+		return "mp3";
+	}
+#endif
+	return "unknown";
+}
+
+ShinobuLoudnessCache *Shinobu::get_loudness_cache() {
+	return &loudness_cache;
+}
+
+ShinobuPCMCache *Shinobu::get_pcm_cache() {
+	return &pcm_cache;
+}
+
+void Shinobu::set_pcm_cache_budget_bytes(uint64_t p_budget_bytes) {
+	pcm_cache.set_budget_bytes(p_budget_bytes);
+}
+
+uint64_t Shinobu::get_pcm_cache_budget_bytes() {
+	return pcm_cache.get_budget_bytes();
+}
+
+void Shinobu::set_pcm_cache_max_length_msec(uint64_t p_max_length_msec) {
+	pcm_cache.set_max_length_msec(p_max_length_msec);
+}
+
+uint64_t Shinobu::get_pcm_cache_max_length_msec() {
+	return pcm_cache.get_max_length_msec();
+}
+
+uint64_t Shinobu::get_pcm_cache_size_bytes() {
+	return pcm_cache.get_size_bytes();
+}
+
+void Shinobu::clear_pcm_cache() {
+	pcm_cache.clear();
+}
+
+void Shinobu::set_loudness_cache_path(const String &p_path) {
+	loudness_cache.set_path(p_path);
+}
+
+String Shinobu::get_loudness_cache_path() const {
+	return loudness_cache.get_path();
+}
+
+void Shinobu::clear_loudness_cache() {
+	loudness_cache.clear();
+}
+
 Ref<ShinobuSoundSourceMemory> Shinobu::register_sound_from_memory(String m_name_hint, PackedByteArray m_data) {
 	Ref<ShinobuSoundSourceMemory> source;
 	source.instantiate(m_name_hint, m_data);
 	return source;
 }
 
+Ref<ShinobuSoundSourceFile> Shinobu::register_sound_from_path(String m_path) {
+	Ref<ShinobuSoundSourceFile> source;
+	source.instantiate(m_path);
+	return source;
+}
+
 Ref<ShinobuGroup> Shinobu::create_group(String m_group_name, Ref<ShinobuGroup> m_parent_group) {
 	Ref<ShinobuGroup> out_group = memnew(ShinobuGroup(m_group_name, m_parent_group));
 	groups.push_back(out_group);
 	return out_group;
 }
 
+Ref<ShinobuVoicePool> Shinobu::create_voice_pool(Ref<ShinobuSoundSource> m_sound_source, Ref<ShinobuGroup> m_group, int m_voice_count) {
+	ERR_FAIL_COND_V(m_sound_source.is_null(), Ref<ShinobuVoicePool>());
+	ERR_FAIL_COND_V(m_group.is_null(), Ref<ShinobuVoicePool>());
+	ERR_FAIL_COND_V(m_voice_count <= 0, Ref<ShinobuVoicePool>());
+	return memnew(ShinobuVoicePool(m_sound_source, m_group, m_voice_count));
+}
+
 Ref<ShinobuSpectrumAnalyzerEffect> Shinobu::instantiate_spectrum_analyzer_effect() {
 	return memnew(ShinobuSpectrumAnalyzerEffect(2));
 }
 
-Ref<ShinobuPitchShiftEffect> Shinobu::instantiate_pitch_shift() {
-	return memnew(ShinobuPitchShiftEffect(2));
+Ref<ShinobuPitchShiftEffect> Shinobu::instantiate_pitch_shift(uint32_t m_fft_size, uint32_t m_oversampling) {
+	ERR_FAIL_COND_V_MSG(!ShinobuPitchShiftEffect::is_valid_config(m_fft_size, m_oversampling), Ref<ShinobuPitchShiftEffect>(), vformat("Unsupported pitch shift configuration, the FFT size must be a power of two from 256 to 4096 and the oversampling must divide it (got %d and %d).", m_fft_size, m_oversampling));
+	Ref<ShinobuPitchShiftEffect> effect = memnew(ShinobuPitchShiftEffect(2, m_fft_size, m_oversampling));
+	ERR_FAIL_COND_V(!effect->is_initialized(), Ref<ShinobuPitchShiftEffect>());
+	return effect;
 }
 
 Ref<ShinobuChannelRemapEffect> Shinobu::instantiate_channel_remap(uint32_t channel_count_in, uint32_t channel_count_out) {
@@ -340,17 +606,165 @@ Error Shinobu::set_dsp_time(uint64_t m_new_time_msec) {
 }
 
 String Shinobu::get_current_backend_name() const {
+	if (!has_device) {
+		return "Offline";
+	}
 	return ma_get_backend_name(context.backend);
 }
 
 uint64_t Shinobu::get_actual_buffer_size() const {
+	if (!has_device) {
+		return 0;
+	}
 	return device.playback.internalPeriodSizeInFrames / (double)(device.playback.internalSampleRate / 1000.0);
 }
 
+uint64_t Shinobu::get_estimated_output_latency_usec() const {
+	if (!has_device) {
+		return 0;
+	}
+	// Everything queued in the device buffer has to be played before a newly mixed frame is heard
+	uint64_t buffered_frames = (uint64_t)device.playback.internalPeriodSizeInFrames * device.playback.internalPeriods;
+	return buffered_frames * 1000000 / MAX(device.playback.internalSampleRate, 1u);
+}
+
+void Shinobu::_begin_offline_render() {
+	offline_render_active.set();
+	// Stopping waits for the data callback to return, so the device thread stays out of the node graph for the whole render
+	offline_render_device_was_started = has_device && ma_device_is_started(&device);
+	if (offline_render_device_was_started) {
+		MA_ERR(ma_device_stop(&device), "Error stopping the device for an offline render");
+	}
+}
+
+void Shinobu::_end_offline_render() {
+	if (offline_render_device_was_started) {
+		MA_ERR(ma_device_start(&device), "Error restarting the device after an offline render");
+		offline_render_device_was_started = false;
+	}
+	offline_render_active.clear();
+}
+
+// Runs on the worker thread pool for file renders, so errors are reported through the thread safe error macros
+Error Shinobu::_render_offline(uint64_t m_frame_count, float *r_buffer, ma_encoder *p_encoder) {
+	const uint32_t channel_count = ma_engine_get_channels(&engine);
+	// Has to stay below the resource manager's stream page size, so streams never run out between job runs
+	const uint64_t FRAMES_PER_CHUNK = 4096;
+	Vector<float> chunk;
+	if (r_buffer == nullptr) {
+		chunk.resize(FRAMES_PER_CHUNK * channel_count);
+	}
+
+	uint64_t frames_rendered = 0;
+	while (frames_rendered < m_frame_count) {
+		if (offline_mode) {
+			// Load whatever stream pages and sounds the previous chunk asked for before mixing the next one
+			while (ma_resource_manager_process_next_job(&resource_manager) == MA_SUCCESS) {
+			}
+		}
+		uint64_t frames_to_render = MIN(FRAMES_PER_CHUNK, m_frame_count - frames_rendered);
+		float *out = r_buffer != nullptr ? r_buffer + frames_rendered * channel_count : chunk.ptrw();
+		ma_uint64 frames_read = 0;
+		ma_result result = ma_engine_read_pcm_frames(&engine, out, frames_to_render, &frames_read);
+		ERR_FAIL_COND_V_MSG(result != MA_SUCCESS, FAILED, vformat("Error rendering offline (%s).", ma_result_description(result)));
+		if (p_encoder != nullptr) {
+			result = ma_encoder_write_pcm_frames(p_encoder, out, frames_read, nullptr);
+			ERR_FAIL_COND_V_MSG(result != MA_SUCCESS, FAILED, vformat("Error writing offline render (%s).", ma_result_description(result)));
+		}
+		frames_rendered += frames_read;
+		clock->measure((frames_read * 1e+9) / ma_engine_get_sample_rate(&engine));
+	}
+	// Nothing rendered here is waiting to be played, so there is no mix to compensate for
+	clock->measure(0);
+	return OK;
+}
+
+void Shinobu::_offline_render_task(void *p_userdata) {
+	Shinobu *shinobu = (Shinobu *)p_userdata;
+	ma_encoder_config encoder_config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, ma_engine_get_channels(&shinobu->engine), ma_engine_get_sample_rate(&shinobu->engine));
+	ma_encoder encoder;
+	ma_result result = ma_encoder_init_vfs(&shinobu->vfs, shinobu->offline_render_path.utf8(), &encoder_config, &encoder);
+	if (result != MA_SUCCESS) {
+		shinobu->offline_render_error = ERR_FILE_CANT_WRITE;
+	} else {
+		shinobu->offline_render_error = shinobu->_render_offline(shinobu->offline_render_frame_count, nullptr, &encoder);
+		ma_encoder_uninit(&encoder);
+	}
+	callable_mp(shinobu, &Shinobu::_offline_render_done).call_deferred();
+}
+
+void Shinobu::_offline_render_done() {
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(offline_render_task_id);
+	offline_render_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	_end_offline_render();
+	emit_signal(SNAME("offline_render_finished"), offline_render_path, offline_render_error);
+}
+
+// Mixes the next m_frame_count frames of the engine as fast as possible and returns them interleaved.
+// The device (if any) is stopped while this runs and the engine clock advances by the rendered amount.
+// Output is only deterministic after initialize_offline, with a device streamed sources are still decoded
+// by the resource manager's job thread in real time.
+PackedFloat32Array Shinobu::render_offline(uint64_t m_frame_count) {
+	PackedFloat32Array out;
+	ERR_FAIL_COND_V_MSG(!initialized, out, "Shinobu is not initialized.");
+	ERR_FAIL_COND_V_MSG(offline_render_task_id != WorkerThreadPool::INVALID_TASK_ID, out, "An offline render is already running.");
+	out.resize(m_frame_count * ma_engine_get_channels(&engine));
+	_begin_offline_render();
+	Error err = _render_offline(m_frame_count, out.ptrw(), nullptr);
+	_end_offline_render();
+	ERR_FAIL_COND_V(err != OK, PackedFloat32Array());
+	return out;
+}
+
+// Same as render_offline but writes a WAV file from the worker thread pool, offline_render_finished is emitted when done.
+Error Shinobu::render_offline_to_file(String m_path, uint64_t m_frame_count) {
+	ERR_FAIL_COND_V_MSG(!initialized, ERR_UNCONFIGURED, "Shinobu is not initialized.");
+	ERR_FAIL_COND_V_MSG(offline_render_task_id != WorkerThreadPool::INVALID_TASK_ID, ERR_BUSY, "An offline render is already running.");
+	offline_render_path = m_path;
+	offline_render_frame_count = m_frame_count;
+	offline_render_error = OK;
+	_begin_offline_render();
+	offline_render_task_id = WorkerThreadPool::get_singleton()->add_native_task(&Shinobu::_offline_render_task, this, false, "Shinobu offline render");
+	return OK;
+}
+
+bool Shinobu::is_offline_rendering() const {
+	return offline_render_active.is_set();
+}
+
+void Shinobu::set_clock_regression_enabled(bool m_enabled) {
+	clock->set_use_regression(m_enabled);
+}
+
+bool Shinobu::is_clock_regression_enabled() const {
+	return clock->is_using_regression();
+}
+
+PackedInt32Array Shinobu::get_clock_jitter_histogram() const {
+	return clock->get_jitter_histogram();
+}
+
+uint64_t Shinobu::get_clock_max_jitter_usec() const {
+	return clock->get_max_jitter_nsec() / 1000;
+}
+
+double Shinobu::get_clock_drift_ppm() const {
+	return clock->get_estimated_drift_ppm();
+}
+
+void Shinobu::reset_clock_stats() {
+	clock->reset_jitter_stats();
+}
+
 Shinobu::~Shinobu() {
+	// Players may still hold cached buffers, unregister all of them while the resource manager is still around
+	pcm_cache.clear();
+	ShinobuDecodedAudio::unregister_all();
 	if (initialized) {
 		ma_engine_uninit(&engine);
 		ma_resource_manager_uninit(&resource_manager);
+	}
+	if (has_device) {
 		ma_device_uninit(&device);
 		ma_context_uninit(&context);
 	}
@@ -5,11 +5,15 @@
 #include <vector>
 
 #include "core/object/object.h"
+#include "core/object/worker_thread_pool.h"
 #include "core/object/ref_counted.h"
 #include "core/string/ustring.h"
 #include "shinobu_clock.h"
 #include "shinobu_group.h"
+#include "shinobu_loudness_cache.h"
+#include "shinobu_pcm_cache.h"
 #include "shinobu_sound_source.h"
+#include "shinobu_voice_pool.h"
 #include "miniaudio/miniaudio.h"
 
 class Shinobu : public Object {
@@ -28,6 +32,9 @@ private:
 	ma_device device;
 	ma_resource_manager resource_manager;
 	ma_context context;
+	ma_vfs_callbacks vfs;
+	ShinobuLoudnessCache loudness_cache;
+	ShinobuPCMCache pcm_cache;
 	String error_message;
 	uint64_t desired_buffer_size_msec = 10;
 
@@ -37,6 +44,23 @@ private:
 
 	float master_volume = 1.0f;
 	bool initialized = false;
+	bool has_device = false;
+	// Set by initialize_offline, the resource manager has no job thread and its jobs run inline with the render
+	bool offline_mode = false;
+
+	SafeFlag offline_render_active;
+	bool offline_render_device_was_started = false;
+	WorkerThreadPool::TaskID offline_render_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	String offline_render_path;
+	uint64_t offline_render_frame_count = 0;
+	Error offline_render_error = OK;
+
+	Error _initialize_engine(ma_engine_config *p_engine_config);
+	void _begin_offline_render();
+	void _end_offline_render();
+	Error _render_offline(uint64_t m_frame_count, float *r_buffer, ma_encoder *p_encoder);
+	static void _offline_render_task(void *p_userdata);
+	void _offline_render_done();
 
 protected:
 	static void _bind_methods();
@@ -48,15 +72,28 @@ public:
 
 	Ref<ShinobuClock> get_clock();
 	ma_engine *get_engine();
+	ma_vfs *get_vfs();
+	// Config for standalone decoders that bypass the resource manager, always decodes to f32
+	ma_decoder_config get_decoder_config() const;
+	static String get_decoder_codec_name(const ma_decoder *p_decoder);
+	ShinobuLoudnessCache *get_loudness_cache();
+	ShinobuPCMCache *get_pcm_cache();
 	Error initialize(ma_backend forced_backend);
 	Error godot_initialize();
+	Error initialize_offline(uint32_t m_sample_rate = 48000);
+
+	PackedFloat32Array render_offline(uint64_t m_frame_count);
+	Error render_offline_to_file(String m_path, uint64_t m_frame_count);
+	bool is_offline_rendering() const;
 	_FORCE_INLINE_ static uint64_t get_inc_sound_source_uid() { return sound_source_uid.postincrement(); };
 
 	Ref<ShinobuSoundSourceMemory> register_sound_from_memory(String m_name_hint, PackedByteArray m_data);
+	Ref<ShinobuSoundSourceFile> register_sound_from_path(String m_path);
 	Ref<ShinobuGroup> create_group(String m_group_name, Ref<ShinobuGroup> m_parent_group = nullptr);
+	Ref<ShinobuVoicePool> create_voice_pool(Ref<ShinobuSoundSource> m_sound_source, Ref<ShinobuGroup> m_group, int m_voice_count);
 
 	Ref<ShinobuSpectrumAnalyzerEffect> instantiate_spectrum_analyzer_effect();
-	Ref<ShinobuPitchShiftEffect> instantiate_pitch_shift();
+	Ref<ShinobuPitchShiftEffect> instantiate_pitch_shift(uint32_t m_fft_size = 2048, uint32_t m_oversampling = 4);
 	Ref<ShinobuChannelRemapEffect> instantiate_channel_remap(uint32_t channel_count_in, uint32_t channel_count_out);
 
 	void set_desired_buffer_size_msec(uint64_t m_new_buffer_size);
@@ -69,8 +106,27 @@ public:
 	Error set_dsp_time(uint64_t m_new_time_msec);
 
 	uint64_t get_actual_buffer_size() const;
+	uint64_t get_estimated_output_latency_usec() const;
+
+	void set_clock_regression_enabled(bool m_enabled);
+	bool is_clock_regression_enabled() const;
+	PackedInt32Array get_clock_jitter_histogram() const;
+	uint64_t get_clock_max_jitter_usec() const;
+	double get_clock_drift_ppm() const;
+	void reset_clock_stats();
 	String get_current_backend_name() const;
 
+	void set_loudness_cache_path(const String &p_path);
+	String get_loudness_cache_path() const;
+	void clear_loudness_cache();
+
+	void set_pcm_cache_budget_bytes(uint64_t p_budget_bytes);
+	uint64_t get_pcm_cache_budget_bytes();
+	void set_pcm_cache_max_length_msec(uint64_t p_max_length_msec);
+	uint64_t get_pcm_cache_max_length_msec();
+	uint64_t get_pcm_cache_size_bytes();
+	void clear_pcm_cache();
+
 	Shinobu();
 	~Shinobu();
 };
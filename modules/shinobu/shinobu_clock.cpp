@@ -0,0 +1,188 @@
+#include "shinobu_clock.h"
+
+#include "core/math/math_funcs.h"
+
+void ShinobuClock::_update_fit() {
+	const Sample &base = samples[(sample_pos - sample_count + REGRESSION_WINDOW_SIZE) % REGRESSION_WINDOW_SIZE];
+	const Sample &last = samples[(sample_pos - 1 + REGRESSION_WINDOW_SIZE) % REGRESSION_WINDOW_SIZE];
+
+	double slope = 1.0;
+	double intercept = (last.mixed_nsec - base.mixed_nsec) - (double)(last.wall_nsec - base.wall_nsec);
+
+	if (sample_count >= REGRESSION_MIN_SAMPLES) {
+		// Least squares fit of mixed time vs wall time, relative to the oldest sample to keep precision
+		double mean_t = 0.0;
+		double mean_y = 0.0;
+		for (int i = 0; i < sample_count; i++) {
+			const Sample &s = samples[(sample_pos - sample_count + i + REGRESSION_WINDOW_SIZE) % REGRESSION_WINDOW_SIZE];
+			mean_t += s.wall_nsec - base.wall_nsec;
+			mean_y += s.mixed_nsec - base.mixed_nsec;
+		}
+		mean_t /= sample_count;
+		mean_y /= sample_count;
+
+		double var_t = 0.0;
+		double cov_ty = 0.0;
+		for (int i = 0; i < sample_count; i++) {
+			const Sample &s = samples[(sample_pos - sample_count + i + REGRESSION_WINDOW_SIZE) % REGRESSION_WINDOW_SIZE];
+			double dt = (s.wall_nsec - base.wall_nsec) - mean_t;
+			double dy = (s.mixed_nsec - base.mixed_nsec) - mean_y;
+			var_t += dt * dt;
+			cov_ty += dt * dy;
+		}
+
+		// A sane device never drifts anywhere near this much, if it does the window is garbage
+		if (var_t > 0.0 && cov_ty / var_t > 0.5 && cov_ty / var_t < 2.0) {
+			slope = cov_ty / var_t;
+			intercept = mean_y - slope * mean_t;
+		}
+	}
+
+	uint32_t sequence = fit_sequence.load(std::memory_order_relaxed);
+	fit_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	fit_base_wall_nsec.store(base.wall_nsec, std::memory_order_relaxed);
+	fit_base_mixed_nsec.store(base.mixed_nsec, std::memory_order_relaxed);
+	fit_intercept.store(intercept, std::memory_order_relaxed);
+	fit_slope.store(slope, std::memory_order_relaxed);
+	fit_last_mixed_nsec.store(last.mixed_nsec, std::memory_order_relaxed);
+	fit_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+int64_t ShinobuClock::_get_smoothed_mixed_nsec(int64_t p_wall_nsec, int64_t *r_last_mixed_nsec, bool p_monotonic) {
+	int64_t base_wall_nsec;
+	int64_t base_mixed_nsec;
+	double intercept;
+	double slope;
+
+	for (;;) {
+		uint32_t sequence = fit_sequence.load(std::memory_order_acquire);
+		base_wall_nsec = fit_base_wall_nsec.load(std::memory_order_relaxed);
+		base_mixed_nsec = fit_base_mixed_nsec.load(std::memory_order_relaxed);
+		intercept = fit_intercept.load(std::memory_order_relaxed);
+		slope = fit_slope.load(std::memory_order_relaxed);
+		*r_last_mixed_nsec = fit_last_mixed_nsec.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if ((sequence & 1) == 0 && sequence == fit_sequence.load(std::memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	int64_t smoothed = base_mixed_nsec + (int64_t)(intercept + slope * (p_wall_nsec - base_wall_nsec));
+	if (!p_monotonic) {
+		return smoothed;
+	}
+
+	// Never go backwards, no matter which thread is asking
+	int64_t previous = last_smoothed_nsec.load(std::memory_order_relaxed);
+	while (smoothed > previous) {
+		if (last_smoothed_nsec.compare_exchange_weak(previous, smoothed, std::memory_order_relaxed)) {
+			return smoothed;
+		}
+	}
+	return MAX(smoothed, previous);
+}
+
+int64_t ShinobuClock::_get_offset_nsec(int64_t p_wall_nsec, bool p_monotonic) {
+	if (use_regression.load(std::memory_order_relaxed) && fit_sequence.load(std::memory_order_acquire) != 0) {
+		int64_t last_mixed_nsec;
+		int64_t offset = _get_smoothed_mixed_nsec(p_wall_nsec, &last_mixed_nsec, p_monotonic) - last_mixed_nsec;
+		if (use_mix_size_compensation) {
+			return offset - last_mix_length_nsec.get();
+		}
+		return offset;
+	}
+
+	int64_t diff = p_wall_nsec - (int64_t)last_recorded_time.get();
+	if (use_mix_size_compensation) {
+		return diff - (int64_t)last_mix_length_nsec.get();
+	}
+	return diff;
+}
+
+int64_t ShinobuClock::get_current_offset_nsec() {
+	return _get_offset_nsec(now_nsec(), true);
+}
+
+int64_t ShinobuClock::get_offset_nsec_at(int64_t p_wall_nsec) {
+	return _get_offset_nsec(p_wall_nsec, false);
+}
+
+void ShinobuClock::measure(uint64_t p_mix_length_nsec) {
+	int64_t ns_count = now_nsec();
+	uint64_t previous_time = last_recorded_time.get();
+	uint64_t previous_mix_length_nsec = last_mix_length_nsec.get();
+	last_recorded_time.set(ns_count);
+	last_mix_length_nsec.set(p_mix_length_nsec);
+
+	if (p_mix_length_nsec == 0) {
+		return;
+	}
+
+	if (previous_mix_length_nsec != 0) {
+		int64_t interval = ns_count - previous_time;
+		uint64_t jitter = ABS(interval - (int64_t)p_mix_length_nsec);
+		uint32_t bucket = MIN(jitter / (JITTER_HISTOGRAM_BUCKET_USEC * 1000), (uint64_t)JITTER_HISTOGRAM_BUCKETS - 1);
+		jitter_histogram[bucket].increment();
+		max_jitter_nsec.exchange_if_greater(jitter);
+
+		if (interval > (int64_t)p_mix_length_nsec * REGRESSION_RESET_PERIODS) {
+			// The device stalled, old samples describe a timeline that no longer exists
+			sample_count = 0;
+			last_smoothed_nsec.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	mixed_nsec_total += p_mix_length_nsec;
+	samples[sample_pos].wall_nsec = ns_count;
+	samples[sample_pos].mixed_nsec = mixed_nsec_total;
+	sample_pos = (sample_pos + 1) % REGRESSION_WINDOW_SIZE;
+	sample_count = MIN(sample_count + 1, (int)REGRESSION_WINDOW_SIZE);
+
+	if (use_regression.load(std::memory_order_relaxed)) {
+		_update_fit();
+	}
+}
+
+void ShinobuClock::set_use_mix_size_compensation(bool p_use_mix_size_compensation) {
+	print_line("Using mix size compensation:", p_use_mix_size_compensation);
+	use_mix_size_compensation = p_use_mix_size_compensation;
+}
+
+void ShinobuClock::set_use_regression(bool p_use_regression) {
+	use_regression.store(p_use_regression, std::memory_order_relaxed);
+}
+
+bool ShinobuClock::is_using_regression() const {
+	return use_regression.load(std::memory_order_relaxed);
+}
+
+double ShinobuClock::get_estimated_drift_ppm() const {
+	return (fit_slope.load(std::memory_order_relaxed) - 1.0) * 1e+6;
+}
+
+PackedInt32Array ShinobuClock::get_jitter_histogram() const {
+	PackedInt32Array histogram;
+	histogram.resize(JITTER_HISTOGRAM_BUCKETS);
+	int32_t *histogram_ptr = histogram.ptrw();
+	for (int i = 0; i < JITTER_HISTOGRAM_BUCKETS; i++) {
+		histogram_ptr[i] = jitter_histogram[i].get();
+	}
+	return histogram;
+}
+
+uint64_t ShinobuClock::get_max_jitter_nsec() const {
+	return max_jitter_nsec.get();
+}
+
+void ShinobuClock::reset_jitter_stats() {
+	for (int i = 0; i < JITTER_HISTOGRAM_BUCKETS; i++) {
+		jitter_histogram[i].set(0);
+	}
+	max_jitter_nsec.set(0);
+}
+
+ShinobuClock::ShinobuClock() {
+	last_recorded_time.set(0);
+	last_mix_length_nsec.set(0);
+}
@@ -2,12 +2,11 @@
 #define SHINOBU_CLOCK_H
 
 #include <atomic>
-#include <chrono>
 
 #include "core/object/ref_counted.h"
+#include "core/os/os.h"
 #include "core/templates/safe_refcount.h"
-
-typedef std::chrono::nanoseconds nanoseconds;
+#include "core/variant/variant.h"
 
 class ShinobuClockLocal : public RefCounted {
 	SafeNumeric<uint64_t> last_recorded_time;
@@ -15,35 +14,72 @@ class ShinobuClockLocal : public RefCounted {
 };
 
 class ShinobuClock : public RefCounted {
+public:
+	enum {
+		// Amount of callbacks used for the linear fit of mixed time vs wall time
+		REGRESSION_WINDOW_SIZE = 64,
+		REGRESSION_MIN_SAMPLES = 4,
+		// If a callback arrives this many periods late we assume the device was stalled and restart the fit
+		REGRESSION_RESET_PERIODS = 8,
+		JITTER_HISTOGRAM_BUCKETS = 32,
+		JITTER_HISTOGRAM_BUCKET_USEC = 250,
+	};
+
+private:
 	SafeNumeric<uint64_t> last_recorded_time;
 	SafeNumeric<uint64_t> last_mix_length_nsec;
 	bool use_mix_size_compensation = true;
+	std::atomic<bool> use_regression = { false };
+
+	// Audio thread only
+	struct Sample {
+		int64_t wall_nsec;
+		int64_t mixed_nsec;
+	};
+	Sample samples[REGRESSION_WINDOW_SIZE];
+	int sample_count = 0;
+	int sample_pos = 0;
+	int64_t mixed_nsec_total = 0;
+
+	// Fit published by the audio thread, guarded by a seqlock so readers never block it
+	std::atomic<uint32_t> fit_sequence = { 0 };
+	std::atomic<int64_t> fit_base_wall_nsec = { 0 };
+	std::atomic<int64_t> fit_base_mixed_nsec = { 0 };
+	std::atomic<double> fit_intercept = { 0.0 };
+	std::atomic<double> fit_slope = { 1.0 };
+	std::atomic<int64_t> fit_last_mixed_nsec = { 0 };
+
+	std::atomic<int64_t> last_smoothed_nsec = { 0 };
+
+	SafeNumeric<uint32_t> jitter_histogram[JITTER_HISTOGRAM_BUCKETS];
+	SafeNumeric<uint64_t> max_jitter_nsec;
+
+	void _update_fit();
+	int64_t _get_smoothed_mixed_nsec(int64_t p_wall_nsec, int64_t *r_last_mixed_nsec, bool p_monotonic);
+	int64_t _get_offset_nsec(int64_t p_wall_nsec, bool p_monotonic);
 
 public:
-	ShinobuClock() {
-		last_recorded_time.set(0);
-		last_mix_length_nsec.set(0);
+	// Wall time is OS ticks, the same timebase input events are stamped in
+	_FORCE_INLINE_ static int64_t now_nsec() {
+		return OS::get_singleton()->get_ticks_nsec();
 	}
 
-	int64_t get_current_offset_nsec() {
-		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
-		std::chrono::high_resolution_clock::time_point lrt(nanoseconds(last_recorded_time.get()));
-		auto diff = std::chrono::duration_cast<nanoseconds>(now - lrt);
-		if (use_mix_size_compensation) {
-			return diff.count() - nanoseconds(last_mix_length_nsec.get()).count();
-		}
-		return diff.count();
-	}
+	int64_t get_current_offset_nsec();
+	// Offset at any wall time, used to place input events that happened before the current frame.
+	// Unlike get_current_offset_nsec this doesn't hold the value back when reads race the audio thread.
+	int64_t get_offset_nsec_at(int64_t p_wall_nsec);
+	void measure(uint64_t p_mix_length_nsec);
 
-	void measure(uint64_t p_mix_length_nsec) {
-		uint64_t ns_count = std::chrono::time_point_cast<nanoseconds>(std::chrono::high_resolution_clock::now()).time_since_epoch().count();
-		last_recorded_time.set(ns_count);
-		last_mix_length_nsec.set(p_mix_length_nsec);
-	}
+	void set_use_mix_size_compensation(bool p_use_mix_size_compensation);
 
-	void set_use_mix_size_compensation(bool p_use_mix_size_compensation) {
-		print_line("Using mix size compensation:", p_use_mix_size_compensation);
-		use_mix_size_compensation = p_use_mix_size_compensation;
-	}
+	void set_use_regression(bool p_use_regression);
+	bool is_using_regression() const;
+
+	double get_estimated_drift_ppm() const;
+	PackedInt32Array get_jitter_histogram() const;
+	uint64_t get_max_jitter_nsec() const;
+	void reset_jitter_stats();
+
+	ShinobuClock();
 };
-#endif
\ No newline at end of file
+#endif
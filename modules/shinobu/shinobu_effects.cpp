@@ -57,29 +57,62 @@ void ShinobuPitchShiftEffect::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_pitch_scale", "pitch_scale"), &ShinobuPitchShiftEffect::set_pitch_scale);
 	ClassDB::bind_method(D_METHOD("get_pitch_scale"), &ShinobuPitchShiftEffect::get_pitch_scale);
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "pitch_scale"), "set_pitch_scale", "get_pitch_scale");
+	ClassDB::bind_method(D_METHOD("get_latency_msec"), &ShinobuPitchShiftEffect::get_latency_msec);
 }
 
 void ShinobuPitchShiftEffect::set_pitch_scale(float m_pitch_scale) {
+	ERR_FAIL_COND(!initialized);
 	ma_pitch_shift_node_set_pitch_scale(&pitch_shift_node, m_pitch_scale);
 }
 
 float ShinobuPitchShiftEffect::get_pitch_scale() {
+	ERR_FAIL_COND_V(!initialized, 1.0f);
 	return ma_pitch_shift_node_get_pitch_scale(&pitch_shift_node);
 }
 
+float ShinobuPitchShiftEffect::get_latency_msec() {
+	ERR_FAIL_COND_V(!initialized, 0.0f);
+	return ma_pitch_shift_node_get_latency_in_frames(&pitch_shift_node) * 1000.0f / pitch_shift_node.sampleRate;
+}
+
 ma_node *ShinobuPitchShiftEffect::get_node() {
 	return &pitch_shift_node;
 }
 
-ShinobuPitchShiftEffect::ShinobuPitchShiftEffect(uint32_t channel_count) {
+// Memory and latency scale with the FFT size, smaller sizes trade quality for both
+static const uint32_t PITCH_SHIFT_FFT_SIZES[FFT_SIZE_MAX] = { 256, 512, 1024, 2048, 4096 };
+
+bool ShinobuPitchShiftEffect::is_valid_config(uint32_t p_fft_size, uint32_t p_oversampling) {
+	bool fft_size_found = false;
+	for (int i = 0; i < FFT_SIZE_MAX; i++) {
+		fft_size_found |= PITCH_SHIFT_FFT_SIZES[i] == p_fft_size;
+	}
+	return fft_size_found && p_oversampling >= 1 && p_oversampling <= p_fft_size && (p_fft_size % p_oversampling) == 0;
+}
+
+bool ShinobuPitchShiftEffect::is_initialized() const {
+	return initialized;
+}
+
+ShinobuPitchShiftEffect::ShinobuPitchShiftEffect(uint32_t channel_count, uint32_t m_fft_size, uint32_t m_oversampling) {
+	ERR_FAIL_COND_MSG(!is_valid_config(m_fft_size, m_oversampling), vformat("Unsupported pitch shift configuration, FFT size %d with %dx oversampling.", m_fft_size, m_oversampling));
 	ma_engine *engine = Shinobu::get_singleton()->get_engine();
 	ma_pitch_shift_node_config pitch_shift_config = ma_pitch_shift_node_config_init(ma_engine_get_sample_rate(engine));
+	for (int i = 0; i < FFT_SIZE_MAX; i++) {
+		if (PITCH_SHIFT_FFT_SIZES[i] == m_fft_size) {
+			pitch_shift_config.fftSize = (ma_sps_fft_size)i;
+		}
+	}
+	pitch_shift_config.oversampling = m_oversampling;
 	ma_result result = ma_pitch_shift_node_init(ma_engine_get_node_graph(engine), &pitch_shift_config, NULL, &pitch_shift_node);
 	MA_ERR(result, "Error creating pitch shift effect");
+	initialized = result == MA_SUCCESS;
 }
 
 ShinobuPitchShiftEffect::~ShinobuPitchShiftEffect() {
-	ma_pitch_shift_node_uninit(&pitch_shift_node, NULL);
+	if (initialized) {
+		ma_pitch_shift_node_uninit(&pitch_shift_node, NULL);
+	}
 }
 
 ShinobuSpectrumAnalyzerEffect::ShinobuSpectrumAnalyzerEffect(uint32_t m_channel_count) {
@@ -90,6 +123,7 @@ ShinobuSpectrumAnalyzerEffect::ShinobuSpectrumAnalyzerEffect(uint32_t m_channel_
 }
 void ShinobuSpectrumAnalyzerEffect::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_magnitude_for_frequency_range", "begin", "end", "mode"), &ShinobuSpectrumAnalyzerEffect::get_magnitude_for_frequency_range, DEFVAL(MAGNITUDE_MAX));
+	ClassDB::bind_method(D_METHOD("get_magnitudes_for_bands", "edges", "mode"), &ShinobuSpectrumAnalyzerEffect::get_magnitudes_for_bands, DEFVAL(MAGNITUDE_MAX));
 	BIND_ENUM_CONSTANT(MAGNITUDE_AVERAGE);
 	BIND_ENUM_CONSTANT(MAGNITUDE_MAX);
 }
@@ -102,6 +136,22 @@ Vector2 ShinobuSpectrumAnalyzerEffect::get_magnitude_for_frequency_range(float m
 	return Vector2(res.l, res.r);
 }
 
+// Every band comes from the same FFT frame, edges are frequencies in Hz, N edges give N - 1 bands
+PackedVector2Array ShinobuSpectrumAnalyzerEffect::get_magnitudes_for_bands(const PackedFloat32Array &p_edges, ma_spectrum_magnitude_mode mode) {
+	PackedVector2Array out;
+	ERR_FAIL_COND_V_MSG(p_edges.size() < 2, out, "At least two band edges are required.");
+	int band_count = p_edges.size() - 1;
+	band_results.resize(band_count);
+	ma_spectrum_analyzer_get_magnitudes_for_bands(p_edges.ptr(), band_count, mode, &analyzer_node, band_results.ptr());
+
+	out.resize(band_count);
+	Vector2 *out_ptr = out.ptrw();
+	for (int i = 0; i < band_count; i++) {
+		out_ptr[i] = Vector2(band_results[i].l, band_results[i].r);
+	}
+	return out;
+}
+
 ShinobuSpectrumAnalyzerEffect::~ShinobuSpectrumAnalyzerEffect() {
 	ma_spectrum_analyzer_node_uninit(&analyzer_node, NULL);
 }
\ No newline at end of file
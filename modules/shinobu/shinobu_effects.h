@@ -2,6 +2,7 @@
 #define SHINOBU_EFFECTS_H
 
 #include "core/object/ref_counted.h"
+#include "core/templates/local_vector.h"
 
 #include "shinobu_channel_remap.h"
 #include "shinobu_pitch_shift.h"
@@ -44,16 +45,22 @@ public:
 class ShinobuPitchShiftEffect : public ShinobuEffect {
 	GDCLASS(ShinobuPitchShiftEffect, ShinobuEffect);
 	ma_pitch_shift_node pitch_shift_node;
+	bool initialized = false;
 
 protected:
 	static void _bind_methods();
 
 public:
-	ShinobuPitchShiftEffect(uint32_t m_channel_count);
+	// Power of two FFT sizes from 256 to 4096, oversampling has to divide the FFT size
+	static bool is_valid_config(uint32_t p_fft_size, uint32_t p_oversampling);
+	bool is_initialized() const;
+
+	ShinobuPitchShiftEffect(uint32_t m_channel_count, uint32_t m_fft_size = 2048, uint32_t m_oversampling = 4);
 	~ShinobuPitchShiftEffect();
 
 	void set_pitch_scale(float m_pitch_scale);
 	float get_pitch_scale();
+	float get_latency_msec();
 
 	virtual ma_node *get_node() override;
 };
@@ -61,6 +68,7 @@ public:
 class ShinobuSpectrumAnalyzerEffect : public ShinobuEffect {
 	GDCLASS(ShinobuSpectrumAnalyzerEffect, ShinobuEffect);
 	ma_spectrum_analyzer_node analyzer_node;
+	LocalVector<MagnitudeResult> band_results;
 
 protected:
 	static void _bind_methods();
@@ -70,6 +78,7 @@ public:
 	~ShinobuSpectrumAnalyzerEffect();
 
 	Vector2 get_magnitude_for_frequency_range(float pBegin, float pEnd, ma_spectrum_magnitude_mode mode = MAGNITUDE_MAX);
+	PackedVector2Array get_magnitudes_for_bands(const PackedFloat32Array &p_edges, ma_spectrum_magnitude_mode mode = MAGNITUDE_MAX);
 
 	virtual ma_node *get_node() override;
 };
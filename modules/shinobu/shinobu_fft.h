@@ -1,63 +1,388 @@
-#ifndef SHINOBU_FFT
-#define SHINOBU_FFT
+#ifndef SHINOBU_FFT_H
+#define SHINOBU_FFT_H
+#include "miniaudio/miniaudio.h"
 
-/* Thirdparty code, so disable clang-format with Godot style */
-/* clang-format off */
-static void smbFft(float *fftBuffer, long fftFrameSize, long sign)
 /*
-	FFT routine, (C)1996 S.M.Bernsee. Sign = -1 is FFT, 1 is iFFT (inverse)
-	Fills fftBuffer[0...2*fftFrameSize-1] with the Fourier transform of the
-	time domain data in fftBuffer[0...2*fftFrameSize-1]. The FFT array takes
-	and returns the cosine and sine parts in an interleaved manner, ie.
-	fftBuffer[0] = cosPart[0], fftBuffer[1] = sinPart[0], asf. fftFrameSize
-	must be a power of 2. It expects a complex input signal (see footnote 2),
-	ie. when working with 'common' audio signals our input signal has to be
-	passed as {in[0],0.,in[1],0.,in[2],0.,...} asf. In that case, the transform
-	of the frequencies of interest is in fftBuffer[0...fftFrameSize].
+	Real input FFT shared by the spectrum analyzer and the pitch shifter.
+
+	A real transform of size N is computed as a complex transform of size N/2 (even samples in
+	the real part, odd samples in the imaginary part) followed by a split pass. The complex
+	transform is an iterative radix-4 decimation in time FFT (with a leading radix-2 stage when
+	log2(N/2) is odd) working on split real/imaginary arrays, so the butterflies of every stage
+	run over contiguous memory and can be done 4 at a time with SSE2/NEON.
+
+	Everything that depends only on the size (bit reversal permutation, per stage twiddles, split
+	twiddles and the Hann window) is computed once in shinobu_fft_init(), nothing is allocated or
+	evaluated with cos()/sin() while processing.
+
+	Spectra are stored as separate real and imaginary arrays of N/2 + 1 bins. Transforms are not
+	normalized, shinobu_fft_inverse(shinobu_fft_forward(x)) == N * x.
+
+	The implementation is compiled together with the miniaudio implementation.
 */
-{
-	float wr, wi, arg, *p1, *p2, temp;
-	float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-	long i, bitm, j, le, le2, k;
-
-	for (i = 2; i < 2*fftFrameSize-2; i += 2) {
-		for (bitm = 2, j = 0; bitm < 2*fftFrameSize; bitm <<= 1) {
-			if (i & bitm) { j++;
-}
-			j <<= 1;
-		}
-		if (i < j) {
-			p1 = fftBuffer+i; p2 = fftBuffer+j;
-			temp = *p1; *(p1++) = *p2;
-			*(p2++) = temp; temp = *p1;
-			*p1 = *p2; *p2 = temp;
-		}
-	}
-	for (k = 0, le = 2; k < (long)(log((double)fftFrameSize)/log(2.)+.5); k++) {
-		le <<= 1;
-		le2 = le>>1;
-		ur = 1.0;
-		ui = 0.0;
-		arg = Math_PI / (le2>>1);
-		wr = cos(arg);
-		wi = sign*sin(arg);
-		for (j = 0; j < le2; j += 2) {
-			p1r = fftBuffer+j; p1i = p1r+1;
-			p2r = p1r+le2; p2i = p2r+1;
-			for (i = j; i < 2*fftFrameSize; i += le) {
-				tr = *p2r * ur - *p2i * ui;
-				ti = *p2r * ui + *p2i * ur;
-				*p2r = *p1r - tr; *p2i = *p1i - ti;
-				*p1r += tr; *p1i += ti;
-				p1r += le; p1i += le;
-				p2r += le; p2i += le;
-			}
-			tr = ur*wr - ui*wi;
-			ui = ur*wi + ui*wr;
-			ur = tr;
-		}
-	}
-}
-/* clang-format on */
-
-#endif
\ No newline at end of file
+
+typedef struct {
+	int size; /* N, real samples */
+	int half; /* N / 2, complex points */
+	ma_bool32 useSIMD;
+	int *bitrev;
+	float *twiddles; /* Radix-4 stages one after the other, 4 arrays of L floats per stage: w1 re, w1 im, w2 re, w2 im */
+	float *splitRe; /* e^(-2 pi i k / N) for k < N / 2 */
+	float *splitIm;
+	float *window; /* Periodic Hann window of N samples */
+	float *workRe;
+	float *workIm;
+	size_t allocationSize;
+	void *allocation;
+} shinobu_fft;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+MA_API ma_result shinobu_fft_init(shinobu_fft *pFFT, int size, const ma_allocation_callbacks *pAllocationCallbacks);
+MA_API void shinobu_fft_uninit(shinobu_fft *pFFT, const ma_allocation_callbacks *pAllocationCallbacks);
+MA_API void shinobu_fft_forward(shinobu_fft *pFFT, const float *pIn, ma_bool32 applyWindow, float *pOutRe, float *pOutIm);
+MA_API void shinobu_fft_inverse(shinobu_fft *pFFT, const float *pInRe, const float *pInIm, float *pOut);
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#if (defined(MINIAUDIO_IMPLEMENTATION) || defined(MA_IMPLEMENTATION)) && !defined(SHINOBU_FFT_IMPLEMENTATION)
+#define SHINOBU_FFT_IMPLEMENTATION
+
+MA_API ma_result shinobu_fft_init(shinobu_fft *pFFT, int size, const ma_allocation_callbacks *pAllocationCallbacks) {
+	if (pFFT == NULL || size < 4 || (size & (size - 1)) != 0) {
+		return MA_INVALID_ARGS;
+	}
+
+	MA_ZERO_OBJECT(pFFT);
+
+	const int half = size / 2;
+	int log2Half = 0;
+	while ((1 << log2Half) < half) {
+		log2Half++;
+	}
+
+	// Twiddle storage for the radix-4 stages, L goes 1 (or 2), 4 (or 8)... up to half / 4
+	size_t twiddleCount = 0;
+	for (int L = (log2Half & 1) ? 2 : 1; L * 4 <= half; L *= 4) {
+		twiddleCount += 4 * L;
+	}
+
+	size_t floatCount = twiddleCount + half * 2 + size + half * 2;
+	pFFT->allocationSize = sizeof(int) * half + sizeof(float) * floatCount;
+	pFFT->allocation = ma_malloc(pFFT->allocationSize, pAllocationCallbacks);
+	if (pFFT->allocation == NULL) {
+		return MA_OUT_OF_MEMORY;
+	}
+
+	pFFT->size = size;
+	pFFT->half = half;
+	pFFT->bitrev = (int *)pFFT->allocation;
+	pFFT->twiddles = (float *)(pFFT->bitrev + half);
+	pFFT->splitRe = pFFT->twiddles + twiddleCount;
+	pFFT->splitIm = pFFT->splitRe + half;
+	pFFT->window = pFFT->splitIm + half;
+	pFFT->workRe = pFFT->window + size;
+	pFFT->workIm = pFFT->workRe + half;
+
+#if defined(MA_SUPPORT_SSE2)
+	pFFT->useSIMD = ma_has_sse2();
+#elif defined(MA_SUPPORT_NEON)
+	pFFT->useSIMD = ma_has_neon();
+#else
+	pFFT->useSIMD = MA_FALSE;
+#endif
+
+	for (int i = 0; i < half; i++) {
+		int reversed = 0;
+		for (int bit = 0; bit < log2Half; bit++) {
+			reversed |= ((i >> bit) & 1) << (log2Half - 1 - bit);
+		}
+		pFFT->bitrev[i] = reversed;
+	}
+
+	float *twiddles = pFFT->twiddles;
+	for (int L = (log2Half & 1) ? 2 : 1; L * 4 <= half; L *= 4) {
+		for (int j = 0; j < L; j++) {
+			double angle = -2.0 * MA_PI_D * (double)j / (double)(4 * L);
+			twiddles[j] = (float)cos(angle);
+			twiddles[L + j] = (float)sin(angle);
+			twiddles[2 * L + j] = (float)cos(2.0 * angle);
+			twiddles[3 * L + j] = (float)sin(2.0 * angle);
+		}
+		twiddles += 4 * L;
+	}
+
+	for (int k = 0; k < half; k++) {
+		double angle = -2.0 * MA_PI_D * (double)k / (double)size;
+		pFFT->splitRe[k] = (float)cos(angle);
+		pFFT->splitIm[k] = (float)sin(angle);
+	}
+
+	for (int i = 0; i < size; i++) {
+		pFFT->window[i] = (float)(-0.5 * cos(2.0 * MA_PI_D * (double)i / (double)size) + 0.5);
+	}
+
+	return MA_SUCCESS;
+}
+
+MA_API void shinobu_fft_uninit(shinobu_fft *pFFT, const ma_allocation_callbacks *pAllocationCallbacks) {
+	if (pFFT == NULL) {
+		return;
+	}
+	ma_free(pFFT->allocation, pAllocationCallbacks);
+	MA_ZERO_OBJECT(pFFT);
+}
+
+/* Radix-4 butterflies of every block of 4L points. */
+static void shinobu_fft_radix4_scalar(float *re, float *im, int half, int L, const float *w1r, const float *w1i, const float *w2r, const float *w2i) {
+	for (int block = 0; block < half; block += 4 * L) {
+		float *ar = re + block, *ai = im + block;
+		float *br = ar + L, *bi = ai + L;
+		float *cr = br + L, *ci = bi + L;
+		float *dr = cr + L, *di = ci + L;
+		for (int j = 0; j < L; j++) {
+			float bwr = br[j] * w2r[j] - bi[j] * w2i[j];
+			float bwi = br[j] * w2i[j] + bi[j] * w2r[j];
+			float dwr = dr[j] * w2r[j] - di[j] * w2i[j];
+			float dwi = dr[j] * w2i[j] + di[j] * w2r[j];
+
+			float t0r = ar[j] + bwr, t0i = ai[j] + bwi;
+			float t1r = ar[j] - bwr, t1i = ai[j] - bwi;
+			float ur = cr[j] + dwr, ui = ci[j] + dwi;
+			float vr = cr[j] - dwr, vi = ci[j] - dwi;
+
+			float t2r = ur * w1r[j] - ui * w1i[j];
+			float t2i = ur * w1i[j] + ui * w1r[j];
+			float t3r = vr * w1r[j] - vi * w1i[j];
+			float t3i = vr * w1i[j] + vi * w1r[j];
+
+			ar[j] = t0r + t2r;
+			ai[j] = t0i + t2i;
+			cr[j] = t0r - t2r;
+			ci[j] = t0i - t2i;
+			// t1 -/+ i * t3
+			br[j] = t1r + t3i;
+			bi[j] = t1i - t3r;
+			dr[j] = t1r - t3i;
+			di[j] = t1i + t3r;
+		}
+	}
+}
+
+#if defined(MA_SUPPORT_SSE2)
+static void shinobu_fft_radix4_sse2(float *re, float *im, int half, int L, const float *w1r, const float *w1i, const float *w2r, const float *w2i) {
+	for (int block = 0; block < half; block += 4 * L) {
+		float *ar = re + block, *ai = im + block;
+		float *br = ar + L, *bi = ai + L;
+		float *cr = br + L, *ci = bi + L;
+		float *dr = cr + L, *di = ci + L;
+		for (int j = 0; j < L; j += 4) {
+			__m128 vw1r = _mm_loadu_ps(w1r + j), vw1i = _mm_loadu_ps(w1i + j);
+			__m128 vw2r = _mm_loadu_ps(w2r + j), vw2i = _mm_loadu_ps(w2i + j);
+			__m128 var = _mm_loadu_ps(ar + j), vai = _mm_loadu_ps(ai + j);
+			__m128 vbr = _mm_loadu_ps(br + j), vbi = _mm_loadu_ps(bi + j);
+			__m128 vcr = _mm_loadu_ps(cr + j), vci = _mm_loadu_ps(ci + j);
+			__m128 vdr = _mm_loadu_ps(dr + j), vdi = _mm_loadu_ps(di + j);
+
+			__m128 bwr = _mm_sub_ps(_mm_mul_ps(vbr, vw2r), _mm_mul_ps(vbi, vw2i));
+			__m128 bwi = _mm_add_ps(_mm_mul_ps(vbr, vw2i), _mm_mul_ps(vbi, vw2r));
+			__m128 dwr = _mm_sub_ps(_mm_mul_ps(vdr, vw2r), _mm_mul_ps(vdi, vw2i));
+			__m128 dwi = _mm_add_ps(_mm_mul_ps(vdr, vw2i), _mm_mul_ps(vdi, vw2r));
+
+			__m128 t0r = _mm_add_ps(var, bwr), t0i = _mm_add_ps(vai, bwi);
+			__m128 t1r = _mm_sub_ps(var, bwr), t1i = _mm_sub_ps(vai, bwi);
+			__m128 ur = _mm_add_ps(vcr, dwr), ui = _mm_add_ps(vci, dwi);
+			__m128 vr = _mm_sub_ps(vcr, dwr), vi = _mm_sub_ps(vci, dwi);
+
+			__m128 t2r = _mm_sub_ps(_mm_mul_ps(ur, vw1r), _mm_mul_ps(ui, vw1i));
+			__m128 t2i = _mm_add_ps(_mm_mul_ps(ur, vw1i), _mm_mul_ps(ui, vw1r));
+			__m128 t3r = _mm_sub_ps(_mm_mul_ps(vr, vw1r), _mm_mul_ps(vi, vw1i));
+			__m128 t3i = _mm_add_ps(_mm_mul_ps(vr, vw1i), _mm_mul_ps(vi, vw1r));
+
+			_mm_storeu_ps(ar + j, _mm_add_ps(t0r, t2r));
+			_mm_storeu_ps(ai + j, _mm_add_ps(t0i, t2i));
+			_mm_storeu_ps(cr + j, _mm_sub_ps(t0r, t2r));
+			_mm_storeu_ps(ci + j, _mm_sub_ps(t0i, t2i));
+			_mm_storeu_ps(br + j, _mm_add_ps(t1r, t3i));
+			_mm_storeu_ps(bi + j, _mm_sub_ps(t1i, t3r));
+			_mm_storeu_ps(dr + j, _mm_sub_ps(t1r, t3i));
+			_mm_storeu_ps(di + j, _mm_add_ps(t1i, t3r));
+		}
+	}
+}
+#endif
+
+#if defined(MA_SUPPORT_NEON)
+static void shinobu_fft_radix4_neon(float *re, float *im, int half, int L, const float *w1r, const float *w1i, const float *w2r, const float *w2i) {
+	for (int block = 0; block < half; block += 4 * L) {
+		float *ar = re + block, *ai = im + block;
+		float *br = ar + L, *bi = ai + L;
+		float *cr = br + L, *ci = bi + L;
+		float *dr = cr + L, *di = ci + L;
+		for (int j = 0; j < L; j += 4) {
+			float32x4_t vw1r = vld1q_f32(w1r + j), vw1i = vld1q_f32(w1i + j);
+			float32x4_t vw2r = vld1q_f32(w2r + j), vw2i = vld1q_f32(w2i + j);
+			float32x4_t var = vld1q_f32(ar + j), vai = vld1q_f32(ai + j);
+			float32x4_t vbr = vld1q_f32(br + j), vbi = vld1q_f32(bi + j);
+			float32x4_t vcr = vld1q_f32(cr + j), vci = vld1q_f32(ci + j);
+			float32x4_t vdr = vld1q_f32(dr + j), vdi = vld1q_f32(di + j);
+
+			float32x4_t bwr = vmlsq_f32(vmulq_f32(vbr, vw2r), vbi, vw2i);
+			float32x4_t bwi = vmlaq_f32(vmulq_f32(vbr, vw2i), vbi, vw2r);
+			float32x4_t dwr = vmlsq_f32(vmulq_f32(vdr, vw2r), vdi, vw2i);
+			float32x4_t dwi = vmlaq_f32(vmulq_f32(vdr, vw2i), vdi, vw2r);
+
+			float32x4_t t0r = vaddq_f32(var, bwr), t0i = vaddq_f32(vai, bwi);
+			float32x4_t t1r = vsubq_f32(var, bwr), t1i = vsubq_f32(vai, bwi);
+			float32x4_t ur = vaddq_f32(vcr, dwr), ui = vaddq_f32(vci, dwi);
+			float32x4_t vr = vsubq_f32(vcr, dwr), vi = vsubq_f32(vci, dwi);
+
+			float32x4_t t2r = vmlsq_f32(vmulq_f32(ur, vw1r), ui, vw1i);
+			float32x4_t t2i = vmlaq_f32(vmulq_f32(ur, vw1i), ui, vw1r);
+			float32x4_t t3r = vmlsq_f32(vmulq_f32(vr, vw1r), vi, vw1i);
+			float32x4_t t3i = vmlaq_f32(vmulq_f32(vr, vw1i), vi, vw1r);
+
+			vst1q_f32(ar + j, vaddq_f32(t0r, t2r));
+			vst1q_f32(ai + j, vaddq_f32(t0i, t2i));
+			vst1q_f32(cr + j, vsubq_f32(t0r, t2r));
+			vst1q_f32(ci + j, vsubq_f32(t0i, t2i));
+			vst1q_f32(br + j, vaddq_f32(t1r, t3i));
+			vst1q_f32(bi + j, vsubq_f32(t1i, t3r));
+			vst1q_f32(dr + j, vsubq_f32(t1r, t3i));
+			vst1q_f32(di + j, vaddq_f32(t1i, t3r));
+		}
+	}
+}
+#endif
+
+/* In place forward complex transform of the work arrays, which must already be in bit reversed order. */
+static void shinobu_fft_complex(shinobu_fft *pFFT) {
+	float *re = pFFT->workRe;
+	float *im = pFFT->workIm;
+	const int half = pFFT->half;
+
+	int L = 1;
+	if ((half & 0x55555555) == 0) {
+		// log2(half) is odd, do a radix-2 stage first so the rest is all radix-4
+		for (int i = 0; i < half; i += 2) {
+			float r = re[i + 1];
+			float m = im[i + 1];
+			re[i + 1] = re[i] - r;
+			im[i + 1] = im[i] - m;
+			re[i] += r;
+			im[i] += m;
+		}
+		L = 2;
+	}
+
+	const float *twiddles = pFFT->twiddles;
+	for (; L * 4 <= half; L *= 4) {
+		const float *w1r = twiddles;
+		const float *w1i = twiddles + L;
+		const float *w2r = twiddles + 2 * L;
+		const float *w2i = twiddles + 3 * L;
+		twiddles += 4 * L;
+
+#if defined(MA_SUPPORT_SSE2)
+		if (pFFT->useSIMD && L >= 4) {
+			shinobu_fft_radix4_sse2(re, im, half, L, w1r, w1i, w2r, w2i);
+			continue;
+		}
+#elif defined(MA_SUPPORT_NEON)
+		if (pFFT->useSIMD && L >= 4) {
+			shinobu_fft_radix4_neon(re, im, half, L, w1r, w1i, w2r, w2i);
+			continue;
+		}
+#endif
+		shinobu_fft_radix4_scalar(re, im, half, L, w1r, w1i, w2r, w2i);
+	}
+}
+
+/*
+	Forward transform of N real samples into N / 2 + 1 bins. If applyWindow is set the input is
+	multiplied by the Hann window on the way in.
+*/
+MA_API void shinobu_fft_forward(shinobu_fft *pFFT, const float *pIn, ma_bool32 applyWindow, float *pOutRe, float *pOutIm) {
+	const int half = pFFT->half;
+	float *re = pFFT->workRe;
+	float *im = pFFT->workIm;
+
+	if (applyWindow) {
+		const float *window = pFFT->window;
+		for (int n = 0; n < half; n++) {
+			int target = pFFT->bitrev[n];
+			re[target] = pIn[2 * n] * window[2 * n];
+			im[target] = pIn[2 * n + 1] * window[2 * n + 1];
+		}
+	} else {
+		for (int n = 0; n < half; n++) {
+			int target = pFFT->bitrev[n];
+			re[target] = pIn[2 * n];
+			im[target] = pIn[2 * n + 1];
+		}
+	}
+
+	shinobu_fft_complex(pFFT);
+
+	// Split the transform of the packed even/odd sequence into the transform of the real input
+	pOutRe[0] = re[0] + im[0];
+	pOutIm[0] = 0.0f;
+	pOutRe[half] = re[0] - im[0];
+	pOutIm[half] = 0.0f;
+
+	for (int k = 1; k < half; k++) {
+		float zr = re[k];
+		float zi = im[k];
+		float cr = re[half - k];
+		float ci = -im[half - k];
+
+		float evenRe = 0.5f * (zr + cr);
+		float evenIm = 0.5f * (zi + ci);
+		float oddRe = 0.5f * (zi - ci);
+		float oddIm = -0.5f * (zr - cr);
+
+		pOutRe[k] = evenRe + oddRe * pFFT->splitRe[k] - oddIm * pFFT->splitIm[k];
+		pOutIm[k] = evenIm + oddRe * pFFT->splitIm[k] + oddIm * pFFT->splitRe[k];
+	}
+}
+
+/* Inverse of shinobu_fft_forward, the spectrum is assumed to be hermitian so only N / 2 + 1 bins are read. */
+MA_API void shinobu_fft_inverse(shinobu_fft *pFFT, const float *pInRe, const float *pInIm, float *pOut) {
+	const int half = pFFT->half;
+	float *re = pFFT->workRe;
+	float *im = pFFT->workIm;
+
+	// Undo the split, then do the inverse through the forward transform: ifft(z) = conj(fft(conj(z)))
+	for (int k = 0; k < half; k++) {
+		float xr = pInRe[k];
+		float xi = pInIm[k];
+		float cr = pInRe[half - k];
+		float ci = -pInIm[half - k];
+
+		float evenRe = xr + cr;
+		float evenIm = xi + ci;
+		float diffRe = xr - cr;
+		float diffIm = xi - ci;
+
+		// Rotate the odd part back by the conjugate twiddle
+		float oddRe = diffRe * pFFT->splitRe[k] + diffIm * pFFT->splitIm[k];
+		float oddIm = diffIm * pFFT->splitRe[k] - diffRe * pFFT->splitIm[k];
+
+		int target = pFFT->bitrev[k];
+		re[target] = evenRe - oddIm;
+		im[target] = -(evenIm + oddRe);
+	}
+
+	shinobu_fft_complex(pFFT);
+
+	for (int n = 0; n < half; n++) {
+		pOut[2 * n] = re[n];
+		pOut[2 * n + 1] = -im[n];
+	}
+}
+
+#endif
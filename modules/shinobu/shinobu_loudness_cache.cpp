@@ -0,0 +1,107 @@
+#include "shinobu_loudness_cache.h"
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+
+void ShinobuLoudnessCache::_load() {
+	loaded = true;
+	file_valid = false;
+	entries.clear();
+
+	Ref<FileAccess> file = FileAccess::open(path, FileAccess::READ);
+	if (file.is_null()) {
+		return;
+	}
+
+	if (file->get_32() != FILE_MAGIC || file->get_32() != FILE_VERSION) {
+		WARN_PRINT(vformat("Discarding outdated loudness cache at %s.", path));
+		return;
+	}
+
+	const uint64_t file_length = file->get_length();
+	while (file->get_position() < file_length) {
+		// A record cut short by a crash or a corrupt hash length ends the file, it's rewritten on the next store
+		// so new records don't end up after the garbage
+		if (file_length - file->get_position() < sizeof(uint32_t)) {
+			return;
+		}
+		const uint32_t hash_length = file->get_32();
+		if (hash_length > MAX_HASH_LENGTH || file_length - file->get_position() < hash_length + sizeof(float) * 2) {
+			return;
+		}
+		Vector<uint8_t> hash_utf8 = file->get_buffer(hash_length);
+		String content_hash = String::utf8((const char *)hash_utf8.ptr(), hash_utf8.size());
+		Entry entry;
+		entry.integrated_lufs = file->get_float();
+		entry.true_peak_dbtp = file->get_float();
+		entries.insert(content_hash, entry);
+	}
+	file_valid = true;
+}
+
+void ShinobuLoudnessCache::set_path(const String &p_path) {
+	MutexLock lock(mutex);
+	path = p_path;
+	loaded = false;
+}
+
+String ShinobuLoudnessCache::get_path() const {
+	MutexLock lock(mutex);
+	return path;
+}
+
+bool ShinobuLoudnessCache::lookup(const String &p_content_hash, Entry *r_entry) {
+	MutexLock lock(mutex);
+	if (!loaded) {
+		_load();
+	}
+	HashMap<String, Entry>::Iterator it = entries.find(p_content_hash);
+	if (!it) {
+		return false;
+	}
+	*r_entry = it->value;
+	return true;
+}
+
+void ShinobuLoudnessCache::store(const String &p_content_hash, const Entry &p_entry) {
+	MutexLock lock(mutex);
+	if (!loaded) {
+		_load();
+	}
+	entries.insert(p_content_hash, p_entry);
+
+	Ref<FileAccess> file;
+	if (file_valid) {
+		file = FileAccess::open(path, FileAccess::READ_WRITE);
+		ERR_FAIL_COND_MSG(file.is_null(), vformat("Can't open loudness cache at %s.", path));
+		file->seek_end();
+	} else {
+		// Start over, writing back everything we know so far
+		file = FileAccess::open(path, FileAccess::WRITE);
+		ERR_FAIL_COND_MSG(file.is_null(), vformat("Can't create loudness cache at %s.", path));
+		file->store_32(FILE_MAGIC);
+		file->store_32(FILE_VERSION);
+		for (const KeyValue<String, Entry> &E : entries) {
+			if (E.key == p_content_hash) {
+				continue;
+			}
+			file->store_pascal_string(E.key);
+			file->store_float(E.value.integrated_lufs);
+			file->store_float(E.value.true_peak_dbtp);
+		}
+		file_valid = true;
+	}
+	file->store_pascal_string(p_content_hash);
+	file->store_float(p_entry.integrated_lufs);
+	file->store_float(p_entry.true_peak_dbtp);
+}
+
+void ShinobuLoudnessCache::clear() {
+	MutexLock lock(mutex);
+	entries.clear();
+	loaded = true;
+	file_valid = false;
+	if (FileAccess::exists(path)) {
+		DirAccess::remove_absolute(path);
+	}
+}
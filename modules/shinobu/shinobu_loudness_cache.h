@@ -0,0 +1,42 @@
+#ifndef SHINOBU_LOUDNESS_CACHE_H
+#define SHINOBU_LOUDNESS_CACHE_H
+
+#include "core/os/mutex.h"
+#include "core/string/ustring.h"
+#include "core/templates/hash_map.h"
+
+// Persistent store of EBU R128 results keyed by the SHA-256 of the encoded audio, so a song only
+// ever has to be decoded for normalization once, no matter how many times it is registered.
+// The file is append only, every result is written out as soon as it is known.
+class ShinobuLoudnessCache {
+public:
+	struct Entry {
+		float integrated_lufs = 0.0f;
+		float true_peak_dbtp = 0.0f;
+	};
+
+private:
+	static const uint32_t FILE_MAGIC = 0x434c4853; // SHLC
+	static const uint32_t FILE_VERSION = 1;
+	// Hashes are 64 hex digits, anything much longer means the file is corrupt
+	static const uint32_t MAX_HASH_LENGTH = 256;
+
+	mutable Mutex mutex;
+	String path = "user://shinobu_loudness_cache.bin";
+	bool loaded = false;
+	// False when the file on disk is missing or from an older version and must be started over
+	bool file_valid = false;
+	HashMap<String, Entry> entries;
+
+	void _load();
+
+public:
+	void set_path(const String &p_path);
+	String get_path() const;
+
+	bool lookup(const String &p_content_hash, Entry *r_entry);
+	void store(const String &p_content_hash, const Entry &p_entry);
+	void clear();
+};
+
+#endif // SHINOBU_LOUDNESS_CACHE_H
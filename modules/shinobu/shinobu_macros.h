@@ -8,17 +8,24 @@
 #define __SHINOBU_PRINT_ERR(error_message)
 #endif
 
-#define MA_ERR_RET(result, string)                                                 \
-	if (result != MA_SUCCESS) {                                                    \
-		error_message = vformat("%s (%s)", string, ma_result_description(result)); \
-		__SHINOBU_PRINT_ERR(error_message);                                        \
-		return FAILED;                                                             \
+// The result expression is evaluated once, it's often the call that failed
+#define MA_ERR_RET(result, string)                                                             \
+	{                                                                                          \
+		const ma_result _ma_err_result = (result);                                             \
+		if (_ma_err_result != MA_SUCCESS) {                                                    \
+			error_message = vformat("%s (%s)", string, ma_result_description(_ma_err_result)); \
+			__SHINOBU_PRINT_ERR(error_message);                                                \
+			return FAILED;                                                                     \
+		}                                                                                      \
 	}
 
-#define MA_ERR(result, string)                                                     \
-	if (result != MA_SUCCESS) {                                                    \
-		error_message = vformat("%s (%s)", string, ma_result_description(result)); \
-		__SHINOBU_PRINT_ERR(error_message);                                        \
+#define MA_ERR(result, string)                                                                 \
+	{                                                                                          \
+		const ma_result _ma_err_result = (result);                                             \
+		if (_ma_err_result != MA_SUCCESS) {                                                    \
+			error_message = vformat("%s (%s)", string, ma_result_description(_ma_err_result)); \
+			__SHINOBU_PRINT_ERR(error_message);                                                \
+		}                                                                                      \
 	}
 
 #endif
\ No newline at end of file
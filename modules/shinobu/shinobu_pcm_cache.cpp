@@ -0,0 +1,119 @@
+#include "shinobu_pcm_cache.h"
+
+Mutex ShinobuDecodedAudio::registry_mutex;
+HashSet<ShinobuDecodedAudio *> ShinobuDecodedAudio::registry;
+
+const String &ShinobuDecodedAudio::get_name() const {
+	return name;
+}
+
+uint64_t ShinobuDecodedAudio::get_size_bytes() const {
+	return pcm.size() * sizeof(float);
+}
+
+bool ShinobuDecodedAudio::is_registered() const {
+	MutexLock lock(registry_mutex);
+	return registered;
+}
+
+void ShinobuDecodedAudio::unregister_all() {
+	MutexLock lock(registry_mutex);
+	for (ShinobuDecodedAudio *audio : registry) {
+		ma_resource_manager_unregister_data(audio->resource_manager, audio->name.utf8());
+		audio->registered = false;
+	}
+	registry.clear();
+}
+
+ShinobuDecodedAudio::ShinobuDecodedAudio(const String &p_name, const Vector<float> &p_pcm, uint32_t p_channel_count, uint32_t p_sample_rate, ma_resource_manager *p_resource_manager) {
+	name = p_name;
+	pcm = p_pcm;
+	channel_count = p_channel_count;
+	sample_rate = p_sample_rate;
+	resource_manager = p_resource_manager;
+	ERR_FAIL_COND(channel_count == 0);
+	ERR_FAIL_NULL(resource_manager);
+
+	MutexLock lock(registry_mutex);
+	ma_result result = ma_resource_manager_register_decoded_data(resource_manager, name.utf8(), pcm.ptr(), pcm.size() / channel_count, ma_format_f32, channel_count, sample_rate);
+	ERR_FAIL_COND_MSG(result != MA_SUCCESS, vformat("Error registering decoded audio %s (%s)", name, ma_result_description(result)));
+	registered = true;
+	registry.insert(this);
+}
+
+ShinobuDecodedAudio::~ShinobuDecodedAudio() {
+	MutexLock lock(registry_mutex);
+	if (registered) {
+		ma_resource_manager_unregister_data(resource_manager, name.utf8());
+		registry.erase(this);
+	}
+}
+
+void ShinobuPCMCache::_evict_to_budget() {
+	while (size_bytes > budget_bytes && lru.size() > 0) {
+		String key = lru.back()->get();
+		lru.pop_back();
+		size_bytes -= entries[key].audio->get_size_bytes();
+		entries.erase(key);
+	}
+}
+
+Ref<ShinobuDecodedAudio> ShinobuPCMCache::get(const String &p_key) {
+	MutexLock lock(mutex);
+	HashMap<String, Entry>::Iterator it = entries.find(p_key);
+	if (!it) {
+		return Ref<ShinobuDecodedAudio>();
+	}
+	lru.move_to_front(it->value.lru_element);
+	return it->value.audio;
+}
+
+void ShinobuPCMCache::insert(const String &p_key, const Ref<ShinobuDecodedAudio> &p_audio) {
+	ERR_FAIL_COND(p_audio.is_null());
+	MutexLock lock(mutex);
+	HashMap<String, Entry>::Iterator it = entries.find(p_key);
+	if (it) {
+		size_bytes -= it->value.audio->get_size_bytes();
+		lru.erase(it->value.lru_element);
+		entries.remove(it);
+	}
+	Entry entry;
+	entry.audio = p_audio;
+	entry.lru_element = lru.push_front(p_key);
+	entries.insert(p_key, entry);
+	size_bytes += p_audio->get_size_bytes();
+	_evict_to_budget();
+}
+
+void ShinobuPCMCache::clear() {
+	MutexLock lock(mutex);
+	entries.clear();
+	lru.clear();
+	size_bytes = 0;
+}
+
+void ShinobuPCMCache::set_budget_bytes(uint64_t p_budget_bytes) {
+	MutexLock lock(mutex);
+	budget_bytes = p_budget_bytes;
+	_evict_to_budget();
+}
+
+uint64_t ShinobuPCMCache::get_budget_bytes() {
+	MutexLock lock(mutex);
+	return budget_bytes;
+}
+
+void ShinobuPCMCache::set_max_length_msec(uint64_t p_max_length_msec) {
+	MutexLock lock(mutex);
+	max_length_msec = p_max_length_msec;
+}
+
+uint64_t ShinobuPCMCache::get_max_length_msec() {
+	MutexLock lock(mutex);
+	return max_length_msec;
+}
+
+uint64_t ShinobuPCMCache::get_size_bytes() {
+	MutexLock lock(mutex);
+	return size_bytes;
+}
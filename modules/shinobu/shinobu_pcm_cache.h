@@ -0,0 +1,73 @@
+#ifndef SHINOBU_PCM_CACHE_H
+#define SHINOBU_PCM_CACHE_H
+
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/string/ustring.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/hash_set.h"
+#include "core/templates/list.h"
+#include "miniaudio/miniaudio.h"
+
+// Fully decoded f32 PCM registered with the resource manager, every sound created from it reads
+// straight from this buffer. Sounds must hold a reference for as long as they are initialized,
+// the data is unregistered and freed with the last one.
+// The buffer owns its PCM and never goes through the Shinobu singleton once created, so references
+// that outlive the engine only free memory.
+class ShinobuDecodedAudio : public RefCounted {
+	GDCLASS(ShinobuDecodedAudio, RefCounted);
+
+	String name;
+	Vector<float> pcm;
+	uint32_t channel_count = 0;
+	uint32_t sample_rate = 0;
+	ma_resource_manager *resource_manager = nullptr;
+	bool registered = false;
+
+	// Every buffer currently registered, so they can all be unregistered before the resource manager goes away
+	static Mutex registry_mutex;
+	static HashSet<ShinobuDecodedAudio *> registry;
+
+public:
+	const String &get_name() const;
+	uint64_t get_size_bytes() const;
+	bool is_registered() const;
+
+	// Must be called before the resource manager is uninitialized
+	static void unregister_all();
+
+	ShinobuDecodedAudio(const String &p_name, const Vector<float> &p_pcm, uint32_t p_channel_count, uint32_t p_sample_rate, ma_resource_manager *p_resource_manager);
+	~ShinobuDecodedAudio();
+};
+
+// Keeps recently used decoded sources around up to a byte budget, least recently used first out.
+// Evicted entries stay alive until the sounds using them are gone, they just won't be handed out again.
+class ShinobuPCMCache {
+	struct Entry {
+		Ref<ShinobuDecodedAudio> audio;
+		List<String>::Element *lru_element = nullptr;
+	};
+
+	Mutex mutex;
+	HashMap<String, Entry> entries;
+	// Front is the most recently used
+	List<String> lru;
+	uint64_t size_bytes = 0;
+	uint64_t budget_bytes = 32 * 1024 * 1024;
+	uint64_t max_length_msec = 10000;
+
+	void _evict_to_budget();
+
+public:
+	Ref<ShinobuDecodedAudio> get(const String &p_key);
+	void insert(const String &p_key, const Ref<ShinobuDecodedAudio> &p_audio);
+	void clear();
+
+	void set_budget_bytes(uint64_t p_budget_bytes);
+	uint64_t get_budget_bytes();
+	void set_max_length_msec(uint64_t p_max_length_msec);
+	uint64_t get_max_length_msec();
+	uint64_t get_size_bytes();
+};
+
+#endif // SHINOBU_PCM_CACHE_H
@@ -1,6 +1,7 @@
 #ifndef SHINOBU_PITCH_SHIFT_H
 #define SHINOBU_PITCH_SHIFT_H
 #include "miniaudio/miniaudio.h"
+#include "shinobu_fft.h"
 
 #define SPS_PI 3.14159265358979323846
 #define SPS_TAU 6.2831853071795864769252867666
@@ -8,9 +9,6 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-enum {
-	SMB_PS_MAX_FRAME_LENGTH = 8192
-};
 
 typedef enum {
 	FFT_SIZE_256,
@@ -21,20 +19,19 @@ typedef enum {
 	FFT_SIZE_MAX
 } ma_sps_fft_size;
 
+/* Per channel phase vocoder state, every buffer is sized for the configured FFT size. */
 typedef struct {
-	float gInFIFO[SMB_PS_MAX_FRAME_LENGTH];
-	float gOutFIFO[SMB_PS_MAX_FRAME_LENGTH];
-	float gFFTworksp[2 * SMB_PS_MAX_FRAME_LENGTH];
-	float gLastPhase[SMB_PS_MAX_FRAME_LENGTH / 2 + 1];
-	float gSumPhase[SMB_PS_MAX_FRAME_LENGTH / 2 + 1];
-	float gOutputAccum[2 * SMB_PS_MAX_FRAME_LENGTH];
-	float gAnaFreq[SMB_PS_MAX_FRAME_LENGTH];
-	float gAnaMagn[SMB_PS_MAX_FRAME_LENGTH];
-	float gSynFreq[SMB_PS_MAX_FRAME_LENGTH];
-	float gSynMagn[SMB_PS_MAX_FRAME_LENGTH];
-	int32_t gRover;
-	float lastPitchShift;
-} SMBPitchShift;
+	float *inFIFO; /* fftSize */
+	float *outFIFO; /* stepSize */
+	float *outputAccum; /* fftSize */
+	float *lastPhase; /* fftSize / 2 + 1 each from here on */
+	float *sumPhase;
+	float *anaFreq;
+	float *anaMagn;
+	float *synFreq;
+	float *synMagn;
+	ma_int32 rover;
+} ma_pitch_shift_channel;
 
 typedef struct {
 	ma_node_config nodeConfig;
@@ -48,15 +45,22 @@ typedef struct {
 	int fft_size;
 	float pitchScale;
 	int oversampling;
-	SMBPitchShift shiftL;
-	SMBPitchShift shiftR;
+	shinobu_fft fft;
+	float *fftRe; /* Scratch shared by both channels, they are processed one after the other */
+	float *fftIm;
+	float *fftOut;
+	ma_pitch_shift_channel channels[2];
 	float sampleRate;
+	size_t allocationSize;
+	void *allocation;
 } ma_pitch_shift_node;
 
 MA_API ma_result ma_pitch_shift_node_init(ma_node_graph *pNodeGraph, const ma_pitch_shift_node_config *pConfig, const ma_allocation_callbacks *pAllocationCallbacks, ma_pitch_shift_node *node);
 MA_API ma_pitch_shift_node_config ma_pitch_shift_node_config_init(ma_uint32 sampleRate);
 MA_API void ma_pitch_shift_node_set_pitch_scale(ma_pitch_shift_node *node, float pitchScale);
 MA_API float ma_pitch_shift_node_get_pitch_scale(ma_pitch_shift_node *node);
+MA_API ma_uint32 ma_pitch_shift_node_get_latency_in_frames(const ma_pitch_shift_node *node);
+MA_API size_t ma_pitch_shift_node_get_memory_usage(const ma_pitch_shift_node *node);
 MA_API void ma_pitch_shift_node_uninit(ma_pitch_shift_node *pPitchShiftNode, const ma_allocation_callbacks *pAllocationCallbacks);
 #ifdef __cplusplus
 }
@@ -67,216 +71,155 @@ MA_API void ma_pitch_shift_node_uninit(ma_pitch_shift_node *pPitchShiftNode, con
 
 #include "shinobu_fft.h"
 
-static void ma_smb_pitch_shift_init(SMBPitchShift *pitch_shift) {
-	pitch_shift->gRover = 0;
-	memset(pitch_shift->gInFIFO, 0, SMB_PS_MAX_FRAME_LENGTH * sizeof(float));
-	memset(pitch_shift->gOutFIFO, 0, SMB_PS_MAX_FRAME_LENGTH * sizeof(float));
-	memset(pitch_shift->gFFTworksp, 0, 2 * SMB_PS_MAX_FRAME_LENGTH * sizeof(double));
-	memset(pitch_shift->gLastPhase, 0, (SMB_PS_MAX_FRAME_LENGTH / 2 + 1) * sizeof(double));
-	memset(pitch_shift->gSumPhase, 0, (SMB_PS_MAX_FRAME_LENGTH / 2 + 1) * sizeof(double));
-	memset(pitch_shift->gOutputAccum, 0, 2 * SMB_PS_MAX_FRAME_LENGTH * sizeof(double));
-	memset(pitch_shift->gAnaFreq, 0, SMB_PS_MAX_FRAME_LENGTH * sizeof(double));
-	memset(pitch_shift->gAnaMagn, 0, SMB_PS_MAX_FRAME_LENGTH * sizeof(double));
-	pitch_shift->lastPitchShift = 1.0;
-}
-
-/* clang-format off */
-/****************************************************************************
-*
-* NAME: smbPitchShift.cpp
-* VERSION: 1.2
-* HOME URL: http://blogs.zynaptiq.com/bernsee
-* KNOWN BUGS: none
-*
-* SYNOPSIS: Routine for doing pitch shifting while maintaining
-* duration using the Short Time Fourier Transform.
-*
-* DESCRIPTION: The routine takes a pitchShift factor value which is between 0.5
-* (one octave down) and 2. (one octave up). A value of exactly 1 does not change
-* the pitch. numSampsToProcess tells the routine how many samples in indata[0...
-* numSampsToProcess-1] should be pitch shifted and moved to outdata[0 ...
-* numSampsToProcess-1]. The two buffers can be identical (ie. it can process the
-* data in-place). fftFrameSize defines the FFT frame size used for the
-* processing. Typical values are 1024, 2048 and 4096. It may be any value <=
-* MAX_FRAME_LENGTH but it MUST be a power of 2. osamp is the STFT
-* oversampling factor which also determines the overlap between adjacent STFT
-* frames. It should at least be 4 for moderate scaling ratios. A value of 32 is
-* recommended for best quality. sampleRate takes the sample rate for the signal
-* in unit Hz, ie. 44100 for 44.1 kHz audio. The data passed to the routine in
-* indata[] should be in the range [-1.0, 1.0), which is also the output range
-* for the data, make sure you scale the data accordingly (for 16bit signed integers
-* you would have to divide (and multiply) by 32768).
-*
-* COPYRIGHT 1999-2015 Stephan M. Bernsee <s.bernsee [AT] zynaptiq [DOT] com>
-*
-* 						The Wide Open License (WOL)
-*
-* Permission to use, copy, modify, distribute and sell this software and its
-* documentation for any purpose is hereby granted without fee, provided that
-* the above copyright notice and this license appear in all source copies.
-* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF
-* ANY KIND. See https://dspguru.com/wide-open-license/ for more information.
-*
-*****************************************************************************/
-
-static void PitchShift(SMBPitchShift *smbPitchShift, float pitchShift, long numSampsToProcess, long fftFrameSize, long osamp, float sampleRate, const float *indata, float *outdata,int stride) {
-
-
-	/*
-		Routine smbPitchShift(). See top of file for explanation
-		Purpose: doing pitch shifting while maintaining duration using the Short
-		Time Fourier Transform.
-		Author: (c)1999-2015 Stephan M. Bernsee <s.bernsee [AT] zynaptiq [DOT] com>
-	*/
-
-	double magn, phase, tmp, window, real, imag;
-	double freqPerBin, expct;
-	long i,k, qpd, index, inFifoLatency, stepSize, fftFrameSize2;
-	unsigned long fftFrameBufferSize;
-
-	/* set up some handy variables */
-	fftFrameBufferSize = (unsigned long)fftFrameSize*sizeof(float);
-	fftFrameSize2 = fftFrameSize/2;
-	stepSize = fftFrameSize/osamp;
-	freqPerBin = sampleRate/(double)fftFrameSize;
-	expct = 2.*Math_PI*(double)stepSize/(double)fftFrameSize;
-	inFifoLatency = fftFrameSize-stepSize;
-	if (smbPitchShift->gRover == 0) { smbPitchShift->gRover = inFifoLatency;
-}
+/*
+	Phase vocoder pitch shifting, based on smbPitchShift by Stephan M. Bernsee.
 
-	/* initialize our static arrays */
+	COPYRIGHT 1999-2015 Stephan M. Bernsee <s.bernsee [AT] zynaptiq [DOT] com>
 
-	/* main processing loop */
-	for (i = 0; i < numSampsToProcess; i++){
-		/* As long as we have not yet collected enough data just read in */
-		smbPitchShift->gInFIFO[smbPitchShift->gRover] = indata[i*stride];
-		outdata[i*stride] = smbPitchShift->gOutFIFO[smbPitchShift->gRover-inFifoLatency];
-		smbPitchShift->gRover++;
+							The Wide Open License (WOL)
 
-		/* now we have enough data for processing */
-		if (smbPitchShift->gRover >= fftFrameSize) {
-			smbPitchShift->gRover = inFifoLatency;
+	Permission to use, copy, modify, distribute and sell this software and its
+	documentation for any purpose is hereby granted without fee, provided that
+	the above copyright notice and this license appear in all source copies.
+	THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF
+	ANY KIND. See https://dspguru.com/wide-open-license/ for more information.
 
-			/* do windowing and re,im interleave */
-			for (k = 0; k < fftFrameSize;k++) {
-				window = -.5*cos(2.*Math_PI*(double)k/(double)fftFrameSize)+.5;
-				smbPitchShift->gFFTworksp[2*k] = smbPitchShift->gInFIFO[k] * window;
-				smbPitchShift->gFFTworksp[2*k+1] = 0.;
-			}
+	Unlike the original the per bin math is done in float with branchless approximations of
+	atan2/sin/cos over whole arrays so the compiler can vectorize the loops, input is consumed
+	in blocks rather than sample by sample, and frequencies are kept in units of bins which
+	removes a couple of divisions per bin.
+*/
 
+/* Wraps to [-pi, pi] */
+static MA_INLINE float ma_sps_wrap_phase(float phase) {
+	return phase - (float)SPS_TAU * floorf(phase * (float)(1.0 / SPS_TAU) + 0.5f);
+}
 
-			/* ***************** ANALYSIS ******************* */
-			/* do transform */
-			smbFft(smbPitchShift->gFFTworksp, fftFrameSize, -1);
+/* Max error around 1e-5 radians */
+static MA_INLINE float ma_sps_atan2(float y, float x) {
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	float a = ma_min(ax, ay) / (ma_max(ax, ay) + 1e-30f);
+	float s = a * a;
+	float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+	r = ay > ax ? (float)(SPS_PI * 0.5) - r : r;
+	r = x < 0.0f ? (float)SPS_PI - r : r;
+	return y < 0.0f ? -r : r;
+}
 
-			/* this is the analysis step */
-			for (k = 0; k <= fftFrameSize2; k++) {
-				/* de-interlace FFT buffer */
-				real = smbPitchShift->gFFTworksp[2*k];
-				imag = smbPitchShift->gFFTworksp[2*k+1];
+/* Valid for x in [-pi/2, 3pi/2], max error around 4e-6 */
+static MA_INLINE float ma_sps_sin(float x) {
+	x = x > (float)(SPS_PI * 0.5) ? (float)SPS_PI - x : x;
+	float x2 = x * x;
+	return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f)))));
+}
 
-				/* compute magnitude and phase */
-				magn = 2.*sqrt(real*real + imag*imag);
-				phase = atan2(imag,real);
+static void ma_pitch_shift_process_frame(ma_pitch_shift_node *node, ma_pitch_shift_channel *channel, float pitchShift) {
+	const int fftFrameSize = node->fft_size;
+	const int fftFrameSize2 = fftFrameSize / 2;
+	const int osamp = node->oversampling;
+	const int stepSize = fftFrameSize / osamp;
+	const float expct = (float)(SPS_TAU * (double)stepSize / (double)fftFrameSize);
+	const float osampOverTau = (float)(osamp / SPS_TAU);
+	const float tauOverOsamp = (float)(SPS_TAU / osamp);
+
+	float *fftRe = node->fftRe;
+	float *fftIm = node->fftIm;
+
+	/* ***************** ANALYSIS ******************* */
+	shinobu_fft_forward(&node->fft, channel->inFIFO, MA_TRUE, fftRe, fftIm);
+
+	for (int k = 0; k <= fftFrameSize2; k++) {
+		float real = fftRe[k];
+		float imag = fftIm[k];
+		float phase = ma_sps_atan2(imag, real);
+
+		/* phase difference minus the expected advance, mapped to +/- pi */
+		float delta = ma_sps_wrap_phase(phase - channel->lastPhase[k] - (float)k * expct);
+		channel->lastPhase[k] = phase;
+
+		/* true frequency of the partial, in bins */
+		channel->anaMagn[k] = 2.0f * sqrtf(real * real + imag * imag);
+		channel->anaFreq[k] = (float)k + delta * osampOverTau;
+	}
 
-				/* compute phase difference */
-				tmp = phase - smbPitchShift->gLastPhase[k];
-				smbPitchShift->gLastPhase[k] = phase;
+	/* ***************** PROCESSING ******************* */
+	memset(channel->synMagn, 0, (fftFrameSize2 + 1) * sizeof(float));
+	memset(channel->synFreq, 0, (fftFrameSize2 + 1) * sizeof(float));
+	for (int k = 0; k <= fftFrameSize2; k++) {
+		int index = k * pitchShift;
+		if (index <= fftFrameSize2) {
+			channel->synMagn[index] += channel->anaMagn[k];
+			channel->synFreq[index] = channel->anaFreq[k] * pitchShift;
+		}
+	}
 
-				/* subtract expected phase difference */
-				tmp -= (double)k*expct;
+	/* ***************** SYNTHESIS ******************* */
+	for (int k = 0; k <= fftFrameSize2; k++) {
+		/* accumulate the bin deviation plus the overlap advance */
+		float phase = ma_sps_wrap_phase(channel->sumPhase[k] + (channel->synFreq[k] - (float)k) * tauOverOsamp + (float)k * expct);
+		channel->sumPhase[k] = phase;
 
-				/* map delta phase into +/- Pi interval */
-				qpd = tmp/Math_PI;
-				if (qpd >= 0) { qpd += qpd&1;
-				} else { qpd -= qpd&1;
-}
-				tmp -= Math_PI*(double)qpd;
-
-				/* get deviation from bin frequency from the +/- Pi interval */
-				tmp = osamp*tmp/(2.*Math_PI);
-
-				/* compute the k-th partials' true frequency */
-				tmp = (double)k*freqPerBin + tmp*freqPerBin;
-
-				/* store magnitude and true frequency in analysis arrays */
-				smbPitchShift->gAnaMagn[k] = magn;
-				smbPitchShift->gAnaFreq[k] = tmp;
-
-			}
-
-			/* ***************** PROCESSING ******************* */
-			/* this does the actual pitch shifting */
-			memset(smbPitchShift->gSynMagn, 0, fftFrameBufferSize);
-			memset(smbPitchShift->gSynFreq, 0, fftFrameBufferSize);
-			for (k = 0; k <= fftFrameSize2; k++) {
-				index = k*pitchShift;
-				if (index <= fftFrameSize2) {
-					smbPitchShift->gSynMagn[index] += smbPitchShift->gAnaMagn[k];
-					smbPitchShift->gSynFreq[index] = smbPitchShift->gAnaFreq[k] * pitchShift;
-				}
-			}
-
-			/* ***************** SYNTHESIS ******************* */
-			/* this is the synthesis step */
-			for (k = 0; k <= fftFrameSize2; k++) {
-				/* get magnitude and true frequency from synthesis arrays */
-				magn = smbPitchShift->gSynMagn[k];
-				tmp = smbPitchShift->gSynFreq[k];
-
-				/* subtract bin mid frequency */
-				tmp -= (double)k*freqPerBin;
-
-				/* get bin deviation from freq deviation */
-				tmp /= freqPerBin;
-
-				/* take osamp into account */
-				tmp = 2.*Math_PI*tmp/osamp;
-
-				/* add the overlap phase advance back in */
-				tmp += (double)k*expct;
-
-				/* accumulate delta phase to get bin phase */
-				smbPitchShift->gSumPhase[k] += tmp;
-				phase = smbPitchShift->gSumPhase[k];
-
-				/* get real and imag part and re-interleave */
-				smbPitchShift->gFFTworksp[2*k] = magn*cos(phase);
-				smbPitchShift->gFFTworksp[2*k+1] = magn*sin(phase);
-			}
-
-			/* zero negative frequencies */
-			for (k = fftFrameSize+2; k < 2*fftFrameSize; k++) { smbPitchShift->gFFTworksp[k] = 0.;
-}
+		float magn = channel->synMagn[k];
+		fftRe[k] = magn * ma_sps_sin(phase + (float)(SPS_PI * 0.5));
+		fftIm[k] = magn * ma_sps_sin(phase < (float)(-SPS_PI * 0.5) ? (float)-SPS_PI - phase : phase);
+	}
 
-			/* do inverse transform */
-			smbFft(smbPitchShift->gFFTworksp, fftFrameSize, 1);
+	/* the real transform mirrors the negative frequencies, which doubles the output. smbPitchShift kept only the
+	   real part of a one sided inverse, which doubled the DC and Nyquist bins as well and dropped their imaginary
+	   parts, do the same so the output level doesn't change */
+	fftRe[0] *= 2.0f;
+	fftIm[0] = 0.0f;
+	fftRe[fftFrameSize2] *= 2.0f;
+	fftIm[fftFrameSize2] = 0.0f;
+	shinobu_fft_inverse(&node->fft, fftRe, fftIm, node->fftOut);
+
+	const float *window = node->fft.window;
+	const float *fftOut = node->fftOut;
+	const float scale = 1.0f / (float)(fftFrameSize2 * osamp);
+	for (int k = 0; k < fftFrameSize; k++) {
+		channel->outputAccum[k] += window[k] * fftOut[k] * scale;
+	}
+	memcpy(channel->outFIFO, channel->outputAccum, stepSize * sizeof(float));
 
-			/* do windowing and add to output accumulator */
-			for(k=0; k < fftFrameSize; k++) {
-				window = -.5*cos(2.*Math_PI*(double)k/(double)fftFrameSize)+.5;
-				smbPitchShift->gOutputAccum[k] += 2.*window*smbPitchShift->gFFTworksp[2*k]/(fftFrameSize2*osamp);
-			}
-			for (k = 0; k < stepSize; k++) { smbPitchShift->gOutFIFO[k] = smbPitchShift->gOutputAccum[k];
+	/* shift accumulator and input FIFO */
+	memmove(channel->outputAccum, channel->outputAccum + stepSize, (fftFrameSize - stepSize) * sizeof(float));
+	memset(channel->outputAccum + fftFrameSize - stepSize, 0, stepSize * sizeof(float));
+	memmove(channel->inFIFO, channel->inFIFO + stepSize, (fftFrameSize - stepSize) * sizeof(float));
 }
 
-			/* shift accumulator */
-			memmove(smbPitchShift->gOutputAccum, smbPitchShift->gOutputAccum+stepSize, fftFrameBufferSize);
+static void ma_pitch_shift_channel_process(ma_pitch_shift_node *node, ma_pitch_shift_channel *channel, float pitchShift, const float *indata, float *outdata, ma_uint32 frameCount, int stride) {
+	const int fftFrameSize = node->fft_size;
+	const int inFifoLatency = fftFrameSize - fftFrameSize / node->oversampling;
+
+	ma_uint32 i = 0;
+	while (i < frameCount) {
+		int count = ma_min(frameCount - i, (ma_uint32)(fftFrameSize - channel->rover));
+
+		float *inFIFO = channel->inFIFO + channel->rover;
+		const float *outFIFO = channel->outFIFO + (channel->rover - inFifoLatency);
+		const float *in = indata + i * stride;
+		float *out = outdata + i * stride;
+		for (int j = 0; j < count; j++) {
+			inFIFO[j] = in[j * stride];
+			out[j * stride] = outFIFO[j];
+		}
+
+		channel->rover += count;
+		i += count;
 
-			/* move input FIFO */
-			for (k = 0; k < inFifoLatency; k++) { smbPitchShift->gInFIFO[k] = smbPitchShift->gInFIFO[k+stepSize];
-}
+		if (channel->rover >= fftFrameSize) {
+			channel->rover = inFifoLatency;
+			ma_pitch_shift_process_frame(node, channel, pitchShift);
 		}
 	}
 }
 
-/* Godot code again */
-/* clang-format on */
-
 static void ma_pitch_shift_node_process_pcm_frames(ma_node *pNode, const float **ppFramesIn, ma_uint32 *pFrameCountIn, float **ppFramesOut, ma_uint32 *pFrameCountOut) {
 	ma_pitch_shift_node *pPitchShift = (ma_pitch_shift_node *)pNode;
 
-	float tolerance = 0.00001 * abs(pPitchShift->pitchScale);
+	float pitchScale = c89atomic_load_f32(&pPitchShift->pitchScale);
+	float tolerance = 0.00001 * fabsf(pitchScale);
 	if (tolerance < 0.00001) {
 		tolerance = 0.00001;
 	}
@@ -284,35 +227,14 @@ static void ma_pitch_shift_node_process_pcm_frames(ma_node *pNode, const float *
 	pFrameCountOut[0] = pFrameCountIn[0];
 
 	// For pitch_scale 1.0 it's cheaper to just pass samples without processing them.
-	if (abs(pPitchShift->pitchScale - 1.0f) < tolerance) {
+	if (fabsf(pitchScale - 1.0f) < tolerance) {
 		ma_copy_pcm_frames(ppFramesOut[0], ppFramesIn[0], pFrameCountIn[0], ma_format_f32, ma_node_get_output_channels(pNode, 0));
 		return;
 	}
 
-	const float *in_l = ppFramesIn[0];
-	const float *in_r = in_l + 1;
-
-	float *out_l = ppFramesOut[0];
-	float *out_r = out_l + 1;
-
-	PitchShift(&pPitchShift->shiftL,
-			pPitchShift->pitchScale,
-			pFrameCountIn[0],
-			pPitchShift->fft_size,
-			pPitchShift->oversampling,
-			pPitchShift->sampleRate,
-			in_l,
-			out_l,
-			2);
-	PitchShift(&pPitchShift->shiftR,
-			pPitchShift->pitchScale,
-			pFrameCountIn[0],
-			pPitchShift->fft_size,
-			pPitchShift->oversampling,
-			pPitchShift->sampleRate,
-			in_r,
-			out_r,
-			2);
+	for (int channel = 0; channel < 2; channel++) {
+		ma_pitch_shift_channel_process(pPitchShift, &pPitchShift->channels[channel], pitchScale, ppFramesIn[0] + channel, ppFramesOut[0] + channel, pFrameCountIn[0], 2);
+	}
 }
 
 static ma_node_vtable g_ma_pitch_shift_node_vtable = {
@@ -336,14 +258,67 @@ MA_API ma_pitch_shift_node_config ma_pitch_shift_node_config_init(ma_uint32 samp
 }
 
 MA_API ma_result ma_pitch_shift_node_init(ma_node_graph *pNodeGraph, const ma_pitch_shift_node_config *pConfig, const ma_allocation_callbacks *pAllocationCallbacks, ma_pitch_shift_node *node) {
-	ma_smb_pitch_shift_init(&node->shiftL);
-	ma_smb_pitch_shift_init(&node->shiftR);
-	node->pitchScale = 1.0f;
+	if (node == NULL) {
+		return MA_INVALID_ARGS;
+	}
+
+	MA_ZERO_OBJECT(node);
+
+	if (pConfig == NULL || pConfig->fftSize >= FFT_SIZE_MAX) {
+		return MA_INVALID_ARGS;
+	}
+
 	static const int fft_sizes[FFT_SIZE_MAX] = { 256, 512, 1024, 2048, 4096 };
-	node->fft_size = fft_sizes[pConfig->fftSize];
+	const int fftFrameSize = fft_sizes[pConfig->fftSize];
+	if (pConfig->oversampling < 1 || pConfig->oversampling > fftFrameSize || (fftFrameSize % pConfig->oversampling) != 0) {
+		return MA_INVALID_ARGS;
+	}
+
+	node->pitchScale = 1.0f;
+	node->fft_size = fftFrameSize;
 	node->oversampling = pConfig->oversampling;
 	node->sampleRate = pConfig->sampleRate;
 
+	ma_result result = shinobu_fft_init(&node->fft, node->fft_size, pAllocationCallbacks);
+	if (result != MA_SUCCESS) {
+		return result;
+	}
+
+	// One block for everything, sized for the FFT we were asked for
+	const size_t fftSize = node->fft_size;
+	const size_t binCount = fftSize / 2 + 1;
+	const size_t stepSize = fftSize / node->oversampling;
+	const size_t sharedFloats = binCount * 2 + fftSize;
+	const size_t channelFloats = fftSize + stepSize + fftSize + binCount * 6;
+	node->allocationSize = sizeof(float) * (sharedFloats + channelFloats * 2);
+	node->allocation = ma_malloc(node->allocationSize, pAllocationCallbacks);
+	if (node->allocation == NULL) {
+		shinobu_fft_uninit(&node->fft, pAllocationCallbacks);
+		return MA_OUT_OF_MEMORY;
+	}
+	memset(node->allocation, 0, node->allocationSize);
+
+	float *memory = (float *)node->allocation;
+	node->fftRe = memory;
+	node->fftIm = node->fftRe + binCount;
+	node->fftOut = node->fftIm + binCount;
+	memory = node->fftOut + fftSize;
+
+	for (int i = 0; i < 2; i++) {
+		ma_pitch_shift_channel *channel = &node->channels[i];
+		channel->inFIFO = memory;
+		channel->outFIFO = channel->inFIFO + fftSize;
+		channel->outputAccum = channel->outFIFO + stepSize;
+		channel->lastPhase = channel->outputAccum + fftSize;
+		channel->sumPhase = channel->lastPhase + binCount;
+		channel->anaFreq = channel->sumPhase + binCount;
+		channel->anaMagn = channel->anaFreq + binCount;
+		channel->synFreq = channel->anaMagn + binCount;
+		channel->synMagn = channel->synFreq + binCount;
+		channel->rover = fftSize - stepSize;
+		memory = channel->synMagn + binCount;
+	}
+
 	ma_node_config baseConfig;
 
 	baseConfig = pConfig->nodeConfig;
@@ -359,9 +334,11 @@ MA_API ma_result ma_pitch_shift_node_init(ma_node_graph *pNodeGraph, const ma_pi
 	baseConfig.pInputChannels = inputChannels;
 	baseConfig.pOutputChannels = outputChannels;
 
-	ma_result result = ma_node_init(pNodeGraph, &baseConfig, pAllocationCallbacks, &node->baseNode);
+	result = ma_node_init(pNodeGraph, &baseConfig, pAllocationCallbacks, &node->baseNode);
 
 	if (result != MA_SUCCESS) {
+		ma_free(node->allocation, pAllocationCallbacks);
+		shinobu_fft_uninit(&node->fft, pAllocationCallbacks);
 		return result;
 	}
 
@@ -376,8 +353,22 @@ MA_API float ma_pitch_shift_node_get_pitch_scale(ma_pitch_shift_node *node) {
 	return c89atomic_load_f32((float *)&node->pitchScale);
 }
 
+MA_API ma_uint32 ma_pitch_shift_node_get_latency_in_frames(const ma_pitch_shift_node *node) {
+	if (node->oversampling < 1) {
+		return 0;
+	}
+	// A frame has to be fully collected before its first hop comes out
+	return node->fft_size - node->fft_size / node->oversampling;
+}
+
+MA_API size_t ma_pitch_shift_node_get_memory_usage(const ma_pitch_shift_node *node) {
+	return sizeof(ma_pitch_shift_node) + node->allocationSize + node->fft.allocationSize;
+}
+
 MA_API void ma_pitch_shift_node_uninit(ma_pitch_shift_node *pPitchShiftNode, const ma_allocation_callbacks *pAllocationCallbacks) {
 	ma_node_uninit(pPitchShiftNode, pAllocationCallbacks);
+	ma_free(pPitchShiftNode->allocation, pAllocationCallbacks);
+	shinobu_fft_uninit(&pPitchShiftNode->fft, pAllocationCallbacks);
 }
 
 #endif
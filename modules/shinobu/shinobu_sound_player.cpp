@@ -1,6 +1,7 @@
 #include "shinobu_sound_player.h"
 #include "shinobu.h"
 #include "shinobu_macros.h"
+#include "shinobu_sound_source.h"
 
 void ShinobuSoundPlayer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("start"), &ShinobuSoundPlayer::start);
@@ -12,6 +13,8 @@ void ShinobuSoundPlayer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("schedule_stop_time", "global_time_msec"), &ShinobuSoundPlayer::schedule_stop_time);
 	ClassDB::bind_method(D_METHOD("get_playback_position_nsec"), &ShinobuSoundPlayer::get_playback_position_nsec);
 	ClassDB::bind_method(D_METHOD("get_playback_position_msec"), &ShinobuSoundPlayer::get_playback_position_msec);
+	ClassDB::bind_method(D_METHOD("get_playback_position_nsec_at", "ticks_usec"), &ShinobuSoundPlayer::get_playback_position_nsec_at);
+	ClassDB::bind_method(D_METHOD("get_playback_position_msec_at", "ticks_usec"), &ShinobuSoundPlayer::get_playback_position_msec_at);
 	ClassDB::bind_method(D_METHOD("is_at_stream_end"), &ShinobuSoundPlayer::is_at_stream_end);
 	ClassDB::bind_method(D_METHOD("is_playing"), &ShinobuSoundPlayer::is_playing);
 	ClassDB::bind_method(D_METHOD("set_volume", "linear_volume"), &ShinobuSoundPlayer::set_volume);
@@ -34,6 +37,7 @@ Error ShinobuSoundPlayer::start() {
 }
 
 Error ShinobuSoundPlayer::stop() {
+	last_playback_position_nsec = INT64_MIN;
 	MA_ERR_RET(ma_sound_stop(&sound), "Error stopping sound");
 	return OK;
 }
@@ -55,7 +59,7 @@ void ShinobuSoundPlayer::schedule_stop_time(uint64_t m_global_time_msec) {
 	ma_sound_set_stop_time_in_milliseconds(&sound, m_global_time_msec);
 }
 
-int64_t ShinobuSoundPlayer::get_playback_position_nsec() {
+int64_t ShinobuSoundPlayer::_get_playback_position_nsec(int64_t p_wall_nsec, bool p_is_now) {
 	Ref<ShinobuClock> clock = Shinobu::get_singleton()->get_clock();
 	ma_engine *engine = Shinobu::get_singleton()->get_engine();
 
@@ -77,22 +81,51 @@ int64_t ShinobuSoundPlayer::get_playback_position_nsec() {
 	uint64_t start_time_nsec = start_time_msec * 1e+6;
 
 	if (!is_playing() && start_time_nsec > dsp_time_nsec) {
-		return dsp_time_nsec - start_time_nsec + out_pos;
+		int64_t out = dsp_time_nsec - start_time_nsec + out_pos;
+		if (!p_is_now) {
+			out += p_wall_nsec - ShinobuClock::now_nsec();
+		}
+		return out;
 	}
 
 	if (is_playing()) {
-		int64_t engine_offset = clock->get_current_offset_nsec();
+		int64_t engine_offset = p_is_now ? clock->get_current_offset_nsec() : clock->get_offset_nsec_at(p_wall_nsec);
 		engine_offset = ma_sound_get_pitch(&sound) * engine_offset;
 		out_pos += engine_offset;
+
+		if (p_is_now && clock->is_using_regression()) {
+			// We can race the audio thread advancing the cursor, hold the last position instead of going back
+			// in time. Big jumps backwards are real discontinuities (looping) and are let through.
+			if (out_pos < last_playback_position_nsec && last_playback_position_nsec - out_pos < MAX_BACKWARDS_CORRECTION_NSEC) {
+				out_pos = last_playback_position_nsec;
+			}
+			last_playback_position_nsec = out_pos;
+		}
 	}
 
 	return out_pos;
 }
 
+int64_t ShinobuSoundPlayer::get_playback_position_nsec() {
+	return _get_playback_position_nsec(0, true);
+}
+
 int64_t ShinobuSoundPlayer::get_playback_position_msec() {
 	return get_playback_position_nsec() / 1e+6;
 }
 
+int64_t ShinobuSoundPlayer::get_playback_position_nsec_at(uint64_t p_ticks_usec) {
+	// Events without a timestamp are placed at the current position
+	if (p_ticks_usec == UINT64_MAX) {
+		return get_playback_position_nsec();
+	}
+	return _get_playback_position_nsec(p_ticks_usec * 1000, false);
+}
+
+int64_t ShinobuSoundPlayer::get_playback_position_msec_at(uint64_t p_ticks_usec) {
+	return get_playback_position_nsec_at(p_ticks_usec) / 1e+6;
+}
+
 bool ShinobuSoundPlayer::is_at_stream_end() const {
 	return (bool)ma_sound_at_end(&sound);
 }
@@ -123,6 +156,9 @@ Error ShinobuSoundPlayer::connect_sound_to_effect(Ref<ShinobuEffect> m_effect) {
 }
 
 uint64_t ShinobuSoundPlayer::get_channel_count() {
+	if (sound_source->get_cached_format_info().valid) {
+		return sound_source->get_channel_count();
+	}
 	ma_uint32 channel_count;
 	ma_sound_get_data_format(&sound, NULL, &channel_count, NULL, NULL, 0);
 	return channel_count;
@@ -154,6 +190,7 @@ void ShinobuSoundPlayer::_notification(int p_notification) {
 }
 
 Error ShinobuSoundPlayer::seek(int64_t to_time_msec) {
+	last_playback_position_nsec = INT64_MIN;
 	// Sound MUST be stopped before seeking or we crash
 	if (ma_sound_is_playing(&sound) == MA_TRUE) {
 		ma_sound_stop(&sound);
@@ -170,6 +207,12 @@ uint64_t ShinobuSoundPlayer::get_length_msec() {
 		return cached_length;
 	}
 
+	// The source only knows the length once its length task is done
+	if (sound_source->get_cached_format_info().length_in_frames != 0) {
+		cached_length = sound_source->get_length_msec();
+		return cached_length;
+	}
+
 	ma_uint64 p_length = 0;
 	ma_sound_get_length_in_pcm_frames(&sound, &p_length);
 	uint32_t sample_rate;
@@ -182,7 +225,7 @@ uint64_t ShinobuSoundPlayer::get_length_msec() {
 }
 
 ShinobuSoundPlayer::ShinobuSoundPlayer(Ref<ShinobuSoundSource> m_sound_source, Ref<ShinobuGroup> m_group, bool m_use_source_channel_count) {
-	m_sound_source->instantiate_sound(m_group, m_use_source_channel_count, &sound);
+	m_sound_source->instantiate_sound(m_group, m_use_source_channel_count, &sound, &sound_data);
 	sound_source = m_sound_source;
 }
 
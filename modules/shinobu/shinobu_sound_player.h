@@ -13,14 +13,21 @@ class ShinobuSoundPlayer : public Node {
 	GDCLASS(ShinobuSoundPlayer, Node);
 	// Forward declare shinobu sound source
 
+	static constexpr int64_t MAX_BACKWARDS_CORRECTION_NSEC = 50000000;
+
 	Ref<ShinobuSoundSource> sound_source;
+	// Shared decoded data the sound reads from, if any, released after the sound is uninitialized
+	Ref<RefCounted> sound_data;
 	ma_sound sound;
 	String error_message;
 	uint64_t start_time_msec = 0;
 	uint64_t cached_length = -1;
+	int64_t last_playback_position_nsec = INT64_MIN;
 	// HACK-ish way of dealing with tree pauses
 	bool was_playing_before_pause = false;
 
+	int64_t _get_playback_position_nsec(int64_t p_wall_nsec, bool p_is_now);
+
 protected:
 	void _notification(int p_notification);
 	static void _bind_methods();
@@ -36,6 +43,9 @@ public:
 
 	int64_t get_playback_position_nsec();
 	int64_t get_playback_position_msec();
+	// Where playback was at the given Time.get_ticks_usec() time, such as an InputEvent timestamp
+	int64_t get_playback_position_nsec_at(uint64_t p_ticks_usec);
+	int64_t get_playback_position_msec_at(uint64_t p_ticks_usec);
 	bool is_at_stream_end() const;
 	bool is_playing() const;
 
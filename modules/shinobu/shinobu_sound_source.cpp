@@ -1,4 +1,6 @@
 #include "shinobu_sound_source.h"
+#include "core/crypto/crypto_core.h"
+#include "core/io/file_access.h"
 #include "shinobu.h"
 #include "shinobu_macros.h"
 #include "thirdparty/ebur128/ebur128.h"
@@ -6,51 +8,210 @@
 void ShinobuSoundSource::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("instantiate", "group", "use_source_channel_count"), &ShinobuSoundSource::instantiate, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("get_channel_count"), &ShinobuSoundSource::get_channel_count);
+	ClassDB::bind_method(D_METHOD("get_format_info"), &ShinobuSoundSource::get_format_info);
+	ClassDB::bind_method(D_METHOD("get_length_msec"), &ShinobuSoundSource::get_length_msec);
 	ClassDB::bind_method(D_METHOD("ebur128_get_loudness"), &ShinobuSoundSource::ebur128_get_loudness);
+	ClassDB::bind_method(D_METHOD("analyze_loudness"), &ShinobuSoundSource::analyze_loudness);
+	ClassDB::bind_method(D_METHOD("is_loudness_analyzed"), &ShinobuSoundSource::is_loudness_analyzed);
+	ClassDB::bind_method(D_METHOD("get_integrated_loudness"), &ShinobuSoundSource::get_integrated_loudness);
+	ClassDB::bind_method(D_METHOD("get_true_peak"), &ShinobuSoundSource::get_true_peak);
+	ADD_SIGNAL(MethodInfo("loudness_analyzed", PropertyInfo(Variant::FLOAT, "integrated_lufs"), PropertyInfo(Variant::FLOAT, "true_peak_dbtp")));
 }
 
 ShinobuSoundSource::ShinobuSoundSource(String m_name) {
 	name = m_name;
 };
 
-float ShinobuSoundSource::ebur128_get_loudness() {
+Error ShinobuSoundSource::_compute_loudness(ShinobuLoudnessCache::Entry *r_entry) {
+	ShinobuLoudnessCache *cache = Shinobu::get_singleton()->get_loudness_cache();
+	String content_hash = get_content_hash();
+	if (!content_hash.is_empty() && cache->lookup(content_hash, r_entry)) {
+		return OK;
+	}
+
 	uint64_t start = OS::get_singleton()->get_ticks_usec();
-	ma_sound sound;
-	ma_format format;
-	uint32_t channel_count;
-	uint32_t sample_rate;
-	ERR_FAIL_COND_V(instantiate_sound(Ref<ShinobuGroup>(), true, &sound) != OK, 0.0f);
-	ma_sound_get_data_format(&sound, &format, &channel_count, &sample_rate, nullptr, 0);
-	ebur128_state *state = ebur128_init(channel_count, sample_rate, EBUR128_MODE_I);
-
-	const uint64_t FRAMES_PER_CHUNK = 300000;
+	ma_decoder decoder;
+	ma_decoder_config decoder_config = Shinobu::get_singleton()->get_decoder_config();
+	// Runs on worker threads, so errors go through the thread safe error macros rather than error_message
+	ma_result decoder_result = init_decoder(&decoder_config, &decoder);
+	ERR_FAIL_COND_V_MSG(decoder_result != MA_SUCCESS, FAILED, vformat("Error initializing decoder for loudness analysis (%s).", ma_result_description(decoder_result)));
+	uint32_t channel_count = decoder.outputChannels;
+	ebur128_state *state = ebur128_init(channel_count, decoder.outputSampleRate, EBUR128_MODE_I | EBUR128_MODE_TRUE_PEAK);
+	if (state == nullptr) {
+		ma_decoder_uninit(&decoder);
+		ERR_FAIL_V_MSG(FAILED, "Error initializing EBU R128 state.");
+	}
+
+	const uint64_t FRAMES_PER_CHUNK = 16384;
 	Vector<float> chunk_data;
 	chunk_data.resize(FRAMES_PER_CHUNK * channel_count);
 	float *chunk_data_ptr = chunk_data.ptrw();
-	ma_data_source *data_source = ma_sound_get_data_source(&sound);
-	int frame_count = 0;
-	uint64_t frames_read;
-	while (ma_data_source_read_pcm_frames(data_source, chunk_data_ptr, (ma_uint64)FRAMES_PER_CHUNK, (ma_uint64 *)&frames_read) != MA_AT_END) {
-		ebur128_add_frames_float(state, chunk_data_ptr, frames_read);
-		frame_count += frames_read;
-	}
+	ma_uint64 frames_read = 0;
+	do {
+		ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk_data_ptr, FRAMES_PER_CHUNK, &frames_read);
+		if (frames_read > 0) {
+			ebur128_add_frames_float(state, chunk_data_ptr, frames_read);
+		}
+		if (result != MA_SUCCESS) {
+			break;
+		}
+	} while (frames_read > 0);
 
 	double loudness_global;
 	ebur128_loudness_global(state, &loudness_global);
+	double true_peak = 0.0;
+	for (uint32_t i = 0; i < channel_count; i++) {
+		double channel_peak;
+		if (ebur128_true_peak(state, i, &channel_peak) == EBUR128_SUCCESS) {
+			true_peak = MAX(true_peak, channel_peak);
+		}
+	}
 	ebur128_destroy(&state);
-	ma_sound_uninit(&sound);
+	ma_decoder_uninit(&decoder);
+
+	r_entry->integrated_lufs = loudness_global;
+	r_entry->true_peak_dbtp = Math::linear_to_db(true_peak);
 	print_line("Normalization done, took", (OS::get_singleton()->get_ticks_usec() - start) * 0.001, "milliseconds");
-	return loudness_global;
+
+	if (!content_hash.is_empty()) {
+		cache->store(content_hash, *r_entry);
+	}
+	return OK;
+}
+
+void ShinobuSoundSource::_loudness_task(void *p_userdata) {
+	ShinobuSoundSource *source = (ShinobuSoundSource *)p_userdata;
+	ShinobuLoudnessCache::Entry entry;
+	if (source->_compute_loudness(&entry) == OK) {
+		MutexLock lock(source->loudness_mutex);
+		source->loudness = entry;
+		source->loudness_analyzed = true;
+	}
+	callable_mp(source, &ShinobuSoundSource::_loudness_task_done).call_deferred();
+}
+
+void ShinobuSoundSource::_loudness_task_done() {
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(loudness_task_id);
+	loudness_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	if (is_loudness_analyzed()) {
+		emit_signal(SNAME("loudness_analyzed"), get_integrated_loudness(), get_true_peak());
+	}
+	// Might free this source, nothing may come after this
+	loudness_task_keep_alive.unref();
+}
+
+// Kicks off the analysis on the worker thread pool, loudness_analyzed is emitted on the main thread when done.
+// Results are cached on disk by content, so analyzing a known song again only costs hashing it.
+Error ShinobuSoundSource::analyze_loudness() {
+	ERR_FAIL_COND_V_MSG(loudness_task_id != WorkerThreadPool::INVALID_TASK_ID, ERR_BUSY, "Loudness analysis is already running for this source.");
+	if (is_loudness_analyzed()) {
+		call_deferred(SNAME("emit_signal"), SNAME("loudness_analyzed"), get_integrated_loudness(), get_true_peak());
+		return OK;
+	}
+	loudness_task_keep_alive = Ref<RefCounted>(this);
+	loudness_task_id = WorkerThreadPool::get_singleton()->add_native_task(&ShinobuSoundSource::_loudness_task, this, false, "Shinobu loudness analysis");
+	return OK;
+}
+
+bool ShinobuSoundSource::is_loudness_analyzed() const {
+	MutexLock lock(loudness_mutex);
+	return loudness_analyzed;
+}
+
+float ShinobuSoundSource::get_integrated_loudness() const {
+	MutexLock lock(loudness_mutex);
+	return loudness.integrated_lufs;
+}
+
+float ShinobuSoundSource::get_true_peak() const {
+	MutexLock lock(loudness_mutex);
+	return loudness.true_peak_dbtp;
+}
+
+// Blocking version of analyze_loudness, kept for callers that need the value right away
+float ShinobuSoundSource::ebur128_get_loudness() {
+	if (is_loudness_analyzed()) {
+		return get_integrated_loudness();
+	}
+	ShinobuLoudnessCache::Entry entry;
+	ERR_FAIL_COND_V(_compute_loudness(&entry) != OK, 0.0f);
+	MutexLock lock(loudness_mutex);
+	loudness = entry;
+	loudness_analyzed = true;
+	return loudness.integrated_lufs;
+}
+
+void ShinobuSoundSource::probe_format() {
+	format_info = FormatInfo();
+	if (result != MA_SUCCESS) {
+		return;
+	}
+	// A standalone decoder only parses the headers, unlike a resource manager data source it doesn't
+	// start any decoding jobs
+	ma_decoder decoder;
+	ma_decoder_config decoder_config = Shinobu::get_singleton()->get_decoder_config();
+	ma_result probe_result = init_decoder(&decoder_config, &decoder);
+	MA_ERR(probe_result, "Error probing sound format");
+	if (probe_result != MA_SUCCESS) {
+		return;
+	}
+	format_info.channel_count = decoder.outputChannels;
+	format_info.sample_rate = decoder.outputSampleRate;
+	format_info.codec = Shinobu::get_decoder_codec_name(&decoder);
+	format_info.valid = true;
+	ma_decoder_uninit(&decoder);
+
+	// Formats without a frame count in their headers (MP3) are scanned from start to end to get it
+	length_task_keep_alive = Ref<RefCounted>(this);
+	length_task_id = WorkerThreadPool::get_singleton()->add_native_task(&ShinobuSoundSource::_length_task, this, false, "Shinobu length probe");
+}
+
+void ShinobuSoundSource::_length_task(void *p_userdata) {
+	ShinobuSoundSource *source = (ShinobuSoundSource *)p_userdata;
+	ma_decoder decoder;
+	ma_decoder_config decoder_config = Shinobu::get_singleton()->get_decoder_config();
+	if (source->init_decoder(&decoder_config, &decoder) == MA_SUCCESS) {
+		ma_uint64 length_in_frames = 0;
+		if (ma_decoder_get_length_in_pcm_frames(&decoder, &length_in_frames) == MA_SUCCESS) {
+			source->probed_length_in_frames = length_in_frames;
+		}
+		ma_decoder_uninit(&decoder);
+	}
+	callable_mp(source, &ShinobuSoundSource::_length_task_done).call_deferred();
+}
+
+void ShinobuSoundSource::_length_task_done() {
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(length_task_id);
+	length_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	format_info.length_in_frames = probed_length_in_frames;
+	// Might free this source, nothing may come after this
+	length_task_keep_alive.unref();
+}
+
+const ShinobuSoundSource::FormatInfo &ShinobuSoundSource::get_cached_format_info() const {
+	return format_info;
+}
+
+Dictionary ShinobuSoundSource::get_format_info() const {
+	Dictionary info;
+	info["valid"] = format_info.valid;
+	info["channel_count"] = format_info.channel_count;
+	info["sample_rate"] = format_info.sample_rate;
+	info["length_in_frames"] = format_info.length_in_frames;
+	info["length_msec"] = get_length_msec();
+	info["codec"] = format_info.codec;
+	return info;
+}
+
+uint64_t ShinobuSoundSource::get_length_msec() const {
+	if (format_info.sample_rate == 0) {
+		return 0;
+	}
+	return format_info.length_in_frames * 1000 / format_info.sample_rate;
 }
 
 uint32_t ShinobuSoundSource::get_channel_count() const {
-	uint32_t channel_count;
-	// data sources cannot be reused, so this is the best we can do
-	ma_resource_manager_data_source source;
-	ma_resource_manager_data_source_init(ma_engine_get_resource_manager(Shinobu::get_singleton()->get_engine()), name.utf8(), 0, nullptr, &source);
-	ma_resource_manager_data_source_get_data_format(&source, nullptr, &channel_count, nullptr, nullptr, 0);
-	ma_resource_manager_data_source_uninit(&source);
-	return channel_count;
+	return format_info.channel_count;
 }
 
 const String ShinobuSoundSource::get_name() const {
@@ -69,11 +230,99 @@ ShinobuSoundPlayer *ShinobuSoundSource::instantiate(Ref<ShinobuGroup> m_group, b
 	return memnew(ShinobuSoundPlayer(this, m_group, m_use_source_channel_count));
 }
 
-ShinobuSoundSource::~ShinobuSoundSource(){};
+ma_uint32 ShinobuSoundSource::get_sound_flags() const {
+	return 0;
+}
+
+Ref<ShinobuDecodedAudio> ShinobuSoundSource::_decode_to_pcm(uint64_t p_max_length_msec) {
+	ma_decoder decoder;
+	ma_decoder_config config = Shinobu::get_singleton()->get_decoder_config();
+	ma_engine *engine = Shinobu::get_singleton()->get_engine();
+	// Resample up front as well, so the mixer does nothing but copy
+	config.sampleRate = ma_engine_get_sample_rate(engine);
+	// Runs on worker threads, so errors go through the thread safe error macros rather than error_message
+	ma_result decoder_result = init_decoder(&config, &decoder);
+	ERR_FAIL_COND_V_MSG(decoder_result != MA_SUCCESS, Ref<ShinobuDecodedAudio>(), vformat("Error initializing decoder for PCM cache (%s).", ma_result_description(decoder_result)));
+
+	const uint32_t channel_count = decoder.outputChannels;
+	const uint64_t FRAMES_PER_CHUNK = 16384;
+	// The length in the headers may be wrong, never decode more than the cache would accept
+	const uint64_t max_frames = p_max_length_msec * decoder.outputSampleRate / 1000 + FRAMES_PER_CHUNK;
+	Vector<float> pcm;
+	uint64_t frame_count = 0;
+	ma_uint64 frames_read = 0;
+	do {
+		if (frame_count > max_frames) {
+			ma_decoder_uninit(&decoder);
+			ERR_FAIL_V_MSG(Ref<ShinobuDecodedAudio>(), vformat("%s decodes to more than %d ms, not caching it.", name, p_max_length_msec));
+		}
+		pcm.resize((frame_count + FRAMES_PER_CHUNK) * channel_count);
+		ma_result result = ma_decoder_read_pcm_frames(&decoder, pcm.ptrw() + frame_count * channel_count, FRAMES_PER_CHUNK, &frames_read);
+		frame_count += frames_read;
+		if (result != MA_SUCCESS) {
+			break;
+		}
+	} while (frames_read > 0);
+	pcm.resize(frame_count * channel_count);
+	uint32_t sample_rate = decoder.outputSampleRate;
+	ma_decoder_uninit(&decoder);
+
+	ERR_FAIL_COND_V(frame_count == 0, Ref<ShinobuDecodedAudio>());
+	String pcm_name = vformat("%s_pcm_%d", name, Shinobu::get_inc_sound_source_uid());
+	Ref<ShinobuDecodedAudio> audio = memnew(ShinobuDecodedAudio(pcm_name, pcm, channel_count, sample_rate, ma_engine_get_resource_manager(engine)));
+	if (!audio->is_registered()) {
+		return Ref<ShinobuDecodedAudio>();
+	}
+	return audio;
+}
+
+void ShinobuSoundSource::_pcm_decode_task(void *p_userdata) {
+	ShinobuSoundSource *source = (ShinobuSoundSource *)p_userdata;
+	ShinobuPCMCache *cache = Shinobu::get_singleton()->get_pcm_cache();
+	Ref<ShinobuDecodedAudio> audio = source->_decode_to_pcm(cache->get_max_length_msec());
+	if (audio.is_valid()) {
+		cache->insert(source->name, audio);
+	} else {
+		source->pcm_decode_failed = true;
+	}
+	callable_mp(source, &ShinobuSoundSource::_pcm_decode_task_done).call_deferred();
+}
+
+void ShinobuSoundSource::_pcm_decode_task_done() {
+	WorkerThreadPool::get_singleton()->wait_for_task_completion(pcm_task_id);
+	pcm_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	// Might free this source, nothing may come after this
+	pcm_task_keep_alive.unref();
+}
+
+// Short sources are decoded once on the worker pool and then shared by every sound. Until the decoded
+// audio is ready, and for long sources or ones of unknown length, sounds go through the encoded path.
+Ref<ShinobuDecodedAudio> ShinobuSoundSource::_get_decoded_audio() {
+	ShinobuPCMCache *cache = Shinobu::get_singleton()->get_pcm_cache();
+	if (!format_info.valid || format_info.length_in_frames == 0 || cache->get_budget_bytes() == 0 || get_length_msec() > cache->get_max_length_msec()) {
+		return Ref<ShinobuDecodedAudio>();
+	}
+	Ref<ShinobuDecodedAudio> audio = cache->get(name);
+	if (audio.is_null() && pcm_task_id == WorkerThreadPool::INVALID_TASK_ID && !pcm_decode_failed) {
+		pcm_task_keep_alive = Ref<RefCounted>(this);
+		pcm_task_id = WorkerThreadPool::get_singleton()->add_native_task(&ShinobuSoundSource::_pcm_decode_task, this, false, "Shinobu PCM decode");
+	}
+	return audio;
+}
 
-Error ShinobuSoundSourceMemory::instantiate_sound(Ref<ShinobuGroup> m_group, bool use_source_channel_count, ma_sound *p_sound) {
+Error ShinobuSoundSource::instantiate_sound(Ref<ShinobuGroup> m_group, bool use_source_channel_count, ma_sound *p_sound, Ref<RefCounted> *r_sound_data) {
 	ma_sound_config config = ma_sound_config_init();
-	CharString string_data = name.utf8();
+	Ref<ShinobuDecodedAudio> decoded_audio;
+	if (r_sound_data != nullptr) {
+		decoded_audio = _get_decoded_audio();
+	}
+	CharString string_data;
+	if (decoded_audio.is_valid()) {
+		string_data = decoded_audio->get_name().utf8();
+	} else {
+		string_data = name.utf8();
+		config.flags = config.flags | get_sound_flags();
+	}
 	config.pFilePath = string_data.ptr();
 	config.flags = config.flags | MA_SOUND_FLAG_NO_SPATIALIZATION;
 	if (use_source_channel_count) {
@@ -86,18 +335,56 @@ Error ShinobuSoundSourceMemory::instantiate_sound(Ref<ShinobuGroup> m_group, boo
 	ma_engine *engine = Shinobu::get_singleton()->get_engine();
 
 	MA_ERR_RET(ma_sound_init_ex(engine, &config, p_sound), "Error initializing sound");
+	if (r_sound_data != nullptr) {
+		*r_sound_data = decoded_audio;
+	}
 	return OK;
 }
 
+ShinobuSoundSource::~ShinobuSoundSource(){};
+
+ma_result ShinobuSoundSourceMemory::init_decoder(const ma_decoder_config *p_config, ma_decoder *r_decoder) {
+	return ma_decoder_init_memory(data.ptr(), data.size(), p_config, r_decoder);
+}
+
+String ShinobuSoundSourceMemory::get_content_hash() const {
+	unsigned char hash[32];
+	ERR_FAIL_COND_V(CryptoCore::sha256(data.ptr(), data.size(), hash) != OK, String());
+	return String::hex_encode_buffer(hash, 32);
+}
+
 ShinobuSoundSourceMemory::ShinobuSoundSourceMemory(String m_name, PackedByteArray m_in_data) :
 		ShinobuSoundSource(m_name) {
 	data = m_in_data;
 	ma_engine *engine = Shinobu::get_singleton()->get_engine();
 	name = vformat("%s_%d", name, Shinobu::get_singleton()->get_inc_sound_source_uid());
 	result = ma_resource_manager_register_encoded_data(ma_engine_get_resource_manager(engine), name.utf8(), (void *)data.ptr(), data.size());
+	probe_format();
 }
 
 ShinobuSoundSourceMemory::~ShinobuSoundSourceMemory() {
 	ma_engine *engine = Shinobu::get_singleton()->get_engine();
 	ma_resource_manager_unregister_data(ma_engine_get_resource_manager(engine), name.utf8());
-}
\ No newline at end of file
+}
+
+ma_result ShinobuSoundSourceFile::init_decoder(const ma_decoder_config *p_config, ma_decoder *r_decoder) {
+	return ma_decoder_init_vfs(Shinobu::get_singleton()->get_vfs(), name.utf8(), p_config, r_decoder);
+}
+
+String ShinobuSoundSourceFile::get_content_hash() const {
+	return FileAccess::get_sha256(name);
+}
+
+ma_uint32 ShinobuSoundSourceFile::get_sound_flags() const {
+	return MA_SOUND_FLAG_STREAM;
+}
+
+ShinobuSoundSourceFile::ShinobuSoundSourceFile(String p_path) :
+		ShinobuSoundSource(p_path) {
+	// Nothing is registered with the resource manager, the file is opened through the VFS when a sound is created
+	result = FileAccess::exists(p_path) ? MA_SUCCESS : MA_DOES_NOT_EXIST;
+	probe_format();
+}
+
+ShinobuSoundSourceFile::~ShinobuSoundSourceFile() {
+}
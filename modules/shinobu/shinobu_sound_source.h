@@ -8,19 +8,74 @@
 #include <string>
 #include <vector>
 
+#include "core/object/worker_thread_pool.h"
+#include "core/os/mutex.h"
 #include "core/string/ustring.h"
+#include "core/variant/dictionary.h"
 #include "shinobu_group.h"
+#include "shinobu_loudness_cache.h"
+#include "shinobu_pcm_cache.h"
 #include "shinobu_sound_player.h"
 
 class ShinobuSoundSource : public RefCounted {
 	GDCLASS(ShinobuSoundSource, RefCounted);
 
+public:
+	struct FormatInfo {
+		bool valid = false;
+		uint32_t channel_count = 0;
+		uint32_t sample_rate = 0;
+		// 0 until the length task has been collected, getting it may mean decoding the whole file
+		uint64_t length_in_frames = 0;
+		String codec;
+	};
+
 protected:
 	String error_message;
 	String name;
 	ma_result result;
+	FormatInfo format_info;
+
+	// Reads the format once, must be called by subclasses once the data is ready to be decoded.
+	// Only the headers are parsed here, the length is found on the worker pool.
+	void probe_format();
 
 	static void _bind_methods();
+	virtual ma_uint32 get_sound_flags() const;
+	// Standalone decoder over the encoded data, safe to use from any thread
+	virtual ma_result init_decoder(const ma_decoder_config *p_config, ma_decoder *r_decoder) = 0;
+	// Hash of the encoded data, identifies the audio itself regardless of name or path
+	virtual String get_content_hash() const = 0;
+
+private:
+	mutable Mutex loudness_mutex;
+	bool loudness_analyzed = false;
+	ShinobuLoudnessCache::Entry loudness;
+	WorkerThreadPool::TaskID loudness_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	// Keeps the source alive until the main thread has collected the task
+	Ref<RefCounted> loudness_task_keep_alive;
+
+	WorkerThreadPool::TaskID pcm_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	Ref<RefCounted> pcm_task_keep_alive;
+	// Written by the decode task, only read once the task has been collected
+	bool pcm_decode_failed = false;
+
+	WorkerThreadPool::TaskID length_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	Ref<RefCounted> length_task_keep_alive;
+	// Written by the length task, only read once the task has been collected
+	uint64_t probed_length_in_frames = 0;
+
+	static void _length_task(void *p_userdata);
+	void _length_task_done();
+
+	Ref<ShinobuDecodedAudio> _decode_to_pcm(uint64_t p_max_length_msec);
+	Ref<ShinobuDecodedAudio> _get_decoded_audio();
+	static void _pcm_decode_task(void *p_userdata);
+	void _pcm_decode_task_done();
+
+	Error _compute_loudness(ShinobuLoudnessCache::Entry *r_entry);
+	static void _loudness_task(void *p_userdata);
+	void _loudness_task_done();
 
 public:
 	virtual const String get_name() const;
@@ -32,9 +87,18 @@ public:
 
 	ShinobuSoundSource(String m_name);
 
+	const FormatInfo &get_cached_format_info() const;
+	Dictionary get_format_info() const;
+	uint64_t get_length_msec() const;
+
 	float ebur128_get_loudness();
+	Error analyze_loudness();
+	bool is_loudness_analyzed() const;
+	float get_integrated_loudness() const;
+	float get_true_peak() const;
 	uint32_t get_channel_count() const;
-	virtual Error instantiate_sound(Ref<ShinobuGroup> m_group, bool use_source_channel_count, ma_sound *p_sound) = 0;
+	// r_sound_data must be kept alive for as long as p_sound is initialized
+	Error instantiate_sound(Ref<ShinobuGroup> m_group, bool use_source_channel_count, ma_sound *p_sound, Ref<RefCounted> *r_sound_data);
 
 	virtual ~ShinobuSoundSource();
 };
@@ -43,11 +107,29 @@ class ShinobuSoundSourceMemory : public ShinobuSoundSource {
 	GDCLASS(ShinobuSoundSourceMemory, ShinobuSoundSource);
 	PackedByteArray data;
 
+protected:
+	virtual ma_result init_decoder(const ma_decoder_config *p_config, ma_decoder *r_decoder) override;
+	virtual String get_content_hash() const override;
+
 public:
-	virtual Error instantiate_sound(Ref<ShinobuGroup> m_group, bool use_source_channel_count, ma_sound *p_sound) override;
 	ShinobuSoundSourceMemory(String p_name, PackedByteArray p_in_data);
 	~ShinobuSoundSourceMemory();
 	friend class ShinobuSoundPlayer;
 };
 
+// Streams the sound from disk (or from inside a PCK) through the resource manager job thread
+// instead of keeping the whole encoded file in memory, only a couple of decoded pages are buffered.
+class ShinobuSoundSourceFile : public ShinobuSoundSource {
+	GDCLASS(ShinobuSoundSourceFile, ShinobuSoundSource);
+
+protected:
+	virtual ma_uint32 get_sound_flags() const override;
+	virtual ma_result init_decoder(const ma_decoder_config *p_config, ma_decoder *r_decoder) override;
+	virtual String get_content_hash() const override;
+
+public:
+	ShinobuSoundSourceFile(String p_path);
+	~ShinobuSoundSourceFile();
+};
+
 #endif // SHINOBU_SOUND_SOURCE_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef SHINOBU_SPECTRUM_ANALYZER_H
 #define SHINOBU_SPECTRUM_ANALYZER_H
 #include "miniaudio/miniaudio.h"
+#include "shinobu_fft.h"
 
 #include <math.h>
 
@@ -38,25 +39,45 @@ typedef struct {
 
 } ma_spectrum_analyzer_config;
 
+#define MA_SPECTRUM_SNAPSHOT_FRESH 0x4
+
+typedef struct {
+	float *magnitudes; /* fftSize * 2, interleaved L/R */
+	ma_uint64 fftTime; /* Node time in usec of the last sample that went into the FFT, 0 if never written */
+} ma_spectrum_snapshot;
+
 typedef struct
 {
 	ma_node_base baseNode;
 	ma_uint32 bufferLengthInMilliseconds;
 	int fftSize;
-	float *temporalFft;
+	shinobu_fft fft;
+	float *temporalFft; /* Left then right input, fftSize * 2 samples each */
+	float *fftRe;
+	float *fftIm;
 	float **fftHistory;
 	int temporalFftPos;
 	int fftCount;
 	int fftPos;
 	ma_uint32 sampleRate;
-	ma_uint64 lastFftTime;
 	float tapBackPos;
+	/*
+	Triple buffer shared with the reader, the audio thread fills snapshotBack and swaps it with
+	snapshotMiddle, the reader swaps snapshotFront with snapshotMiddle when the fresh bit is set.
+	Neither side ever waits on the other. Only one thread may read at a time.
+	*/
+	ma_spectrum_snapshot snapshots[3];
+	MA_ATOMIC(4, ma_uint32) snapshotMiddle; /* Snapshot index | MA_SPECTRUM_SNAPSHOT_FRESH */
+	ma_uint32 snapshotBack; /* Audio thread only */
+	ma_uint32 snapshotFront; /* Reader only */
 } ma_spectrum_analyzer_node;
 
 MA_API ma_result ma_spectrum_analyzer_node_init(ma_node_graph *pNodeGraph, const ma_spectrum_analyzer_config *pConfig, const ma_allocation_callbacks *pAllocationCallbacks, ma_spectrum_analyzer_node *pSpectrumNode);
 MA_API ma_spectrum_analyzer_config ma_spectrum_analyzer_config_init(ma_uint32 sampleRate);
 MA_API void ma_spectrum_analyzer_node_uninit(ma_spectrum_analyzer_node *pSpectrumNode, const ma_allocation_callbacks *pAllocationCallbacks);
 MagnitudeResult ma_spectrum_analyzer_get_magnitude_for_frequency_range(float pBegin, float pEnd, ma_spectrum_magnitude_mode pMagnitudeMode, ma_spectrum_analyzer_node *pSpectrumNode);
+/* pEdges holds bandCount + 1 frequencies, band i spans pEdges[i] to pEdges[i + 1]. All bands are read from the same snapshot. */
+void ma_spectrum_analyzer_get_magnitudes_for_bands(const float *pEdges, int bandCount, ma_spectrum_magnitude_mode pMagnitudeMode, ma_spectrum_analyzer_node *pSpectrumNode, MagnitudeResult *pOut);
 
 #ifdef __cplusplus
 }
@@ -67,9 +88,67 @@ MagnitudeResult ma_spectrum_analyzer_get_magnitude_for_frequency_range(float pBe
 
 #include "shinobu_fft.h"
 
+static void ma_spectrum_analyzer_publish_snapshot(ma_spectrum_analyzer_node *pSpectrumNode, ma_uint64 fftTime) {
+	// Apply the tap back here so the reader only ever has to look at a single frame
+	int frameSize = pSpectrumNode->fftSize * 2;
+	int stepsBack = (int)(pSpectrumNode->tapBackPos * pSpectrumNode->sampleRate / frameSize + 0.5f);
+	stepsBack = ma_clamp(stepsBack, 0, pSpectrumNode->fftCount - 1);
+	int fftIndex = (pSpectrumNode->fftPos - stepsBack + pSpectrumNode->fftCount) % pSpectrumNode->fftCount;
+
+	ma_spectrum_snapshot *pSnapshot = &pSpectrumNode->snapshots[pSpectrumNode->snapshotBack];
+	MA_COPY_MEMORY(pSnapshot->magnitudes, pSpectrumNode->fftHistory[fftIndex], sizeof(float) * frameSize);
+	pSnapshot->fftTime = fftTime;
+
+	ma_uint32 previous = c89atomic_exchange_32(&pSpectrumNode->snapshotMiddle, pSpectrumNode->snapshotBack | MA_SPECTRUM_SNAPSHOT_FRESH);
+	pSpectrumNode->snapshotBack = previous & ~MA_SPECTRUM_SNAPSHOT_FRESH;
+}
+
+static const ma_spectrum_snapshot *ma_spectrum_analyzer_acquire_snapshot(ma_spectrum_analyzer_node *pSpectrumNode) {
+	if (c89atomic_load_32(&pSpectrumNode->snapshotMiddle) & MA_SPECTRUM_SNAPSHOT_FRESH) {
+		ma_uint32 previous = c89atomic_exchange_32(&pSpectrumNode->snapshotMiddle, pSpectrumNode->snapshotFront);
+		pSpectrumNode->snapshotFront = previous & ~MA_SPECTRUM_SNAPSHOT_FRESH;
+	}
+	return &pSpectrumNode->snapshots[pSpectrumNode->snapshotFront];
+}
+
+static MagnitudeResult ma_spectrum_analyzer_get_band_magnitude(const float *r, int fftSize, ma_uint32 sampleRate, float pBegin, float pEnd, ma_spectrum_magnitude_mode pMagnitudeMode) {
+	MagnitudeResult out;
+	out.l = 0.0f;
+	out.r = 0.0f;
+
+	int beginPos = pBegin * fftSize / ((double)sampleRate * 0.5);
+	int endPos = pEnd * fftSize / ((double)sampleRate * 0.5);
+
+	beginPos = ma_clamp(beginPos, 0, fftSize - 1);
+	endPos = ma_clamp(endPos, 0, fftSize - 1);
+
+	if (beginPos > endPos) {
+		int temp = beginPos;
+		beginPos = endPos;
+		endPos = temp;
+	}
+
+	if (pMagnitudeMode == MAGNITUDE_AVERAGE) {
+		for (int i = beginPos; i <= endPos; i++) {
+			out.l += r[i * 2];
+			out.r += r[i * 2 + 1];
+		}
+
+		out.l /= float(endPos - beginPos + 1);
+		out.r /= float(endPos - beginPos + 1);
+
+	} else {
+		for (int i = beginPos; i <= endPos; i++) {
+			out.l = ma_max(out.l, r[i * 2]);
+			out.r = ma_max(out.r, r[i * 2 + 1]);
+		}
+	}
+	return out;
+}
+
 static void ma_spectrum_analyzer_process_pcm_frames(ma_node *pNode, const float **ppFramesIn, ma_uint32 *pFrameCountIn, float **ppFramesOut, ma_uint32 *pFrameCountOut) {
 	ma_spectrum_analyzer_node *pSpectrumNode = (ma_spectrum_analyzer_node *)pNode;
-	ma_uint64 time_usec = (double)ma_node_get_time(pNode) / (double)pSpectrumNode->sampleRate * 1000000.0;
+	ma_uint64 blockTime = ma_node_get_time(pNode);
 
 	ma_uint32 frameCount = *pFrameCountIn;
 
@@ -79,48 +158,42 @@ static void ma_spectrum_analyzer_process_pcm_frames(ma_node *pNode, const float
 		int toFill = pSpectrumNode->fftSize * 2 - pSpectrumNode->temporalFftPos;
 		toFill = ma_min(toFill, frameCount);
 
-		float *fftw = pSpectrumNode->temporalFft;
+		const int frameSize = pSpectrumNode->fftSize * 2;
+		float *inL = pSpectrumNode->temporalFft;
+		float *inR = inL + frameSize;
 
 		for (int i = 0; i < toFill; i++) {
-			float window = -0.5 * cos(2.0 * SSA_PI * (double)pSpectrumNode->temporalFftPos / (double)pSpectrumNode->fftSize) + 0.5;
-			fftw[pSpectrumNode->temporalFftPos * 2] = window * ppFramesIn[0][frameInPos]; // left channel
-			fftw[pSpectrumNode->temporalFftPos * 2 + 1] = 0;
-			fftw[(pSpectrumNode->temporalFftPos + pSpectrumNode->fftSize * 2) * 2] = window * ppFramesIn[0][frameInPos + 1]; // right channel
-			fftw[(pSpectrumNode->temporalFftPos + pSpectrumNode->fftSize * 2) * 2 + 1] = 0;
+			inL[pSpectrumNode->temporalFftPos] = ppFramesIn[0][frameInPos]; // left channel
+			inR[pSpectrumNode->temporalFftPos] = ppFramesIn[0][frameInPos + 1]; // right channel
 			frameInPos += 2;
 			++pSpectrumNode->temporalFftPos;
 		}
 
 		frameCount -= toFill;
 
-		if (pSpectrumNode->temporalFftPos == pSpectrumNode->fftSize * 2) {
+		if (pSpectrumNode->temporalFftPos == frameSize) {
 			//time to do a FFT
-			smbFft(fftw, pSpectrumNode->fftSize * 2, -1);
-			smbFft(fftw + pSpectrumNode->fftSize * 4, pSpectrumNode->fftSize * 2, -1);
 			int next = (pSpectrumNode->fftPos + 1) % pSpectrumNode->fftCount;
 
 			float *hw = pSpectrumNode->fftHistory[next];
-			float x;
-			float y;
-
-			for (int i = 0; i < pSpectrumNode->fftSize; i++) {
-				x = fftw[i * 2];
-				y = fftw[i * 2 + 1];
-				hw[i] = sqrt(x * x + y * y) / (float)pSpectrumNode->fftSize;
-
-				x = fftw[pSpectrumNode->fftSize * 4 + i * 2];
-				y = fftw[pSpectrumNode->fftSize * 4 + i * 2 + 1];
-				hw[i + 1] = sqrt(x * x + y * y) / (float)pSpectrumNode->fftSize;
+			const float *re = pSpectrumNode->fftRe;
+			const float *im = pSpectrumNode->fftIm;
+			const float scale = 1.0f / (float)pSpectrumNode->fftSize;
+
+			for (int channel = 0; channel < 2; channel++) {
+				shinobu_fft_forward(&pSpectrumNode->fft, channel == 0 ? inL : inR, MA_TRUE, pSpectrumNode->fftRe, pSpectrumNode->fftIm);
+				for (int i = 0; i < pSpectrumNode->fftSize; i++) {
+					hw[i * 2 + channel] = sqrtf(re[i] * re[i] + im[i] * im[i]) * scale;
+				}
 			}
 
 			pSpectrumNode->fftPos = next;
 			pSpectrumNode->temporalFftPos = 0;
+
+			ma_uint64 fftTime = (double)(blockTime + frameInPos / 2) / (double)pSpectrumNode->sampleRate * 1000000.0;
+			ma_spectrum_analyzer_publish_snapshot(pSpectrumNode, ma_max(fftTime, 1));
 		}
 	}
-
-	//determine time of capture
-	double remainerSec = (pSpectrumNode->temporalFftPos / (double)pSpectrumNode->sampleRate); //subtract remainder from mix time
-	pSpectrumNode->lastFftTime = time_usec - (ma_uint64)(remainerSec * 1000000.0);
 }
 
 MA_API ma_spectrum_analyzer_config ma_spectrum_analyzer_config_init(ma_uint32 sampleRate) {
@@ -163,9 +236,10 @@ MA_API ma_result ma_spectrum_analyzer_node_init(ma_node_graph *pNodeGraph, const
 	pSpectrumNode->sampleRate = pConfig->sampleRate;
 	pSpectrumNode->fftCount = ((pConfig->bufferLengthInMilliseconds / 1000.0f) / (((float)pSpectrumNode->fftSize) / (float)pSpectrumNode->sampleRate)) + 1;
 	pSpectrumNode->fftPos = 0;
-	pSpectrumNode->lastFftTime = 0;
 	pSpectrumNode->fftHistory = (float **)ma_malloc(sizeof(float **) * pSpectrumNode->fftCount, pAllocationCallbacks); // Yes we are assuming stereo... bad idea
-	pSpectrumNode->temporalFft = (float *)ma_malloc(sizeof(float) * pSpectrumNode->fftSize * 8, pAllocationCallbacks); // x2 stereo, x2 amount of samples for freqs, x2 for input
+	pSpectrumNode->temporalFft = (float *)ma_malloc(sizeof(float) * pSpectrumNode->fftSize * 4, pAllocationCallbacks); // x2 stereo, x2 amount of samples for freqs
+	pSpectrumNode->fftRe = (float *)ma_malloc(sizeof(float) * (pSpectrumNode->fftSize + 1) * 2, pAllocationCallbacks);
+	pSpectrumNode->fftIm = pSpectrumNode->fftRe + pSpectrumNode->fftSize + 1;
 	pSpectrumNode->temporalFftPos = 0;
 	pSpectrumNode->tapBackPos = pConfig->tapBackPos;
 
@@ -177,6 +251,19 @@ MA_API ma_result ma_spectrum_analyzer_node_init(ma_node_graph *pNodeGraph, const
 		}
 	}
 
+	for (int i = 0; i < 3; i++) {
+		pSpectrumNode->snapshots[i].magnitudes = (float *)ma_calloc(sizeof(float) * pSpectrumNode->fftSize * 2, pAllocationCallbacks);
+		pSpectrumNode->snapshots[i].fftTime = 0;
+	}
+	pSpectrumNode->snapshotBack = 0;
+	c89atomic_store_32(&pSpectrumNode->snapshotMiddle, 1);
+	pSpectrumNode->snapshotFront = 2;
+
+	result = shinobu_fft_init(&pSpectrumNode->fft, pSpectrumNode->fftSize * 2, pAllocationCallbacks);
+	if (result != MA_SUCCESS) {
+		return result;
+	}
+
 	baseConfig = pConfig->nodeConfig;
 	baseConfig.vtable = &g_ma_spectrum_node_vtable;
 	ma_uint32 inputChannels[1];
@@ -199,56 +286,25 @@ MA_API ma_result ma_spectrum_analyzer_node_init(ma_node_graph *pNodeGraph, const
 
 MagnitudeResult ma_spectrum_analyzer_get_magnitude_for_frequency_range(float pBegin, float pEnd, ma_spectrum_magnitude_mode pMagnitudeMode, ma_spectrum_analyzer_node *pSpectrumNode) {
 	MagnitudeResult out;
-	out.l = 0.0f;
-	out.r = 0.0f;
-	if (pSpectrumNode->lastFftTime == 0) {
+	const ma_spectrum_snapshot *pSnapshot = ma_spectrum_analyzer_acquire_snapshot(pSpectrumNode);
+	if (pSnapshot->fftTime == 0) {
+		out.l = 0.0f;
+		out.r = 0.0f;
 		return out;
 	}
+	return ma_spectrum_analyzer_get_band_magnitude(pSnapshot->magnitudes, pSpectrumNode->fftSize, pSpectrumNode->sampleRate, pBegin, pEnd, pMagnitudeMode);
+}
 
-	double time_useconds = ma_node_get_time(pSpectrumNode) / (double)(pSpectrumNode->sampleRate / 1000000.0);
-	float diff = double(time_useconds - pSpectrumNode->lastFftTime) / 1000000.0 + pSpectrumNode->tapBackPos;
-	float fftTimeSize = float(pSpectrumNode->fftSize) / (double)pSpectrumNode->sampleRate;
-
-	int fftIndex = pSpectrumNode->fftPos;
-
-	while (diff > fftTimeSize) {
-		diff -= fftTimeSize;
-		fftIndex -= 1;
-		if (fftIndex < 0) {
-			fftIndex = pSpectrumNode->fftCount - 1;
-		}
-	}
-
-	int beginPos = pBegin * pSpectrumNode->fftSize / ((double)pSpectrumNode->sampleRate * 0.5);
-	int endPos = pEnd * pSpectrumNode->fftSize / ((double)pSpectrumNode->sampleRate * 0.5);
-
-	beginPos = ma_clamp(beginPos, 0, pSpectrumNode->fftSize - 1);
-	endPos = ma_clamp(endPos, 0, pSpectrumNode->fftSize - 1);
-
-	if (beginPos > endPos) {
-		int temp = beginPos;
-		beginPos = endPos;
-		endPos = temp;
-	}
-
-	float *r = pSpectrumNode->fftHistory[fftIndex];
-
-	if (pMagnitudeMode == MAGNITUDE_AVERAGE) {
-		for (int i = beginPos; i <= endPos; i++) {
-			out.l += r[i];
-			out.r += r[i + 1];
-		}
-
-		out.l /= float(endPos - beginPos + 1);
-		out.r /= float(endPos - beginPos + 1);
-
-	} else {
-		for (int i = beginPos; i <= endPos; i++) {
-			out.l = ma_max(out.l, r[i]);
-			out.r = ma_max(out.r, r[i + 1]);
+void ma_spectrum_analyzer_get_magnitudes_for_bands(const float *pEdges, int bandCount, ma_spectrum_magnitude_mode pMagnitudeMode, ma_spectrum_analyzer_node *pSpectrumNode, MagnitudeResult *pOut) {
+	const ma_spectrum_snapshot *pSnapshot = ma_spectrum_analyzer_acquire_snapshot(pSpectrumNode);
+	for (int i = 0; i < bandCount; i++) {
+		if (pSnapshot->fftTime == 0) {
+			pOut[i].l = 0.0f;
+			pOut[i].r = 0.0f;
+		} else {
+			pOut[i] = ma_spectrum_analyzer_get_band_magnitude(pSnapshot->magnitudes, pSpectrumNode->fftSize, pSpectrumNode->sampleRate, pEdges[i], pEdges[i + 1], pMagnitudeMode);
 		}
 	}
-	return out;
 }
 
 MA_API void ma_spectrum_analyzer_node_uninit(ma_spectrum_analyzer_node *pSpectrumNode, const ma_allocation_callbacks *pAllocationCallbacks) {
@@ -257,6 +313,11 @@ MA_API void ma_spectrum_analyzer_node_uninit(ma_spectrum_analyzer_node *pSpectru
 	}
 	ma_free(pSpectrumNode->fftHistory, pAllocationCallbacks);
 	ma_free(pSpectrumNode->temporalFft, pAllocationCallbacks);
+	ma_free(pSpectrumNode->fftRe, pAllocationCallbacks);
+	for (int i = 0; i < 3; i++) {
+		ma_free(pSpectrumNode->snapshots[i].magnitudes, pAllocationCallbacks);
+	}
+	shinobu_fft_uninit(&pSpectrumNode->fft, pAllocationCallbacks);
 	ma_node_uninit(pSpectrumNode, pAllocationCallbacks);
 }
 
@@ -0,0 +1,125 @@
+#include "shinobu_voice_pool.h"
+#include "shinobu.h"
+#include "shinobu_macros.h"
+#include "shinobu_sound_source.h"
+
+void ShinobuVoicePool::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("play", "global_time_msec", "priority", "linear_volume"), &ShinobuVoicePool::play, DEFVAL(0), DEFVAL(1.0f));
+	ClassDB::bind_method(D_METHOD("stop_voice", "voice"), &ShinobuVoicePool::stop_voice);
+	ClassDB::bind_method(D_METHOD("stop_all"), &ShinobuVoicePool::stop_all);
+	ClassDB::bind_method(D_METHOD("get_voice_count"), &ShinobuVoicePool::get_voice_count);
+	ClassDB::bind_method(D_METHOD("get_active_voice_count"), &ShinobuVoicePool::get_active_voice_count);
+	ClassDB::bind_method(D_METHOD("get_stolen_voice_count"), &ShinobuVoicePool::get_stolen_voice_count);
+}
+
+bool ShinobuVoicePool::_is_voice_free(Voice &p_voice) const {
+	if (!p_voice.active) {
+		return true;
+	}
+	// A voice that was scheduled but hasn't started yet is neither playing nor at the end, so it stays taken
+	if (ma_sound_at_end(&p_voice.sound)) {
+		p_voice.active = false;
+		return true;
+	}
+	return false;
+}
+
+// Returns the voice that will play the sound, or -1 if every voice is busy with something more important.
+int ShinobuVoicePool::play(uint64_t m_global_time_msec, int m_priority, float m_linear_volume) {
+	int chosen = -1;
+	for (int i = 0; i < voice_count; i++) {
+		if (voices[i].initialized && _is_voice_free(voices[i])) {
+			chosen = i;
+			break;
+		}
+	}
+
+	if (chosen == -1) {
+		for (int i = 0; i < voice_count; i++) {
+			if (!voices[i].initialized || voices[i].priority > m_priority) {
+				continue;
+			}
+			if (chosen == -1 || voices[i].priority < voices[chosen].priority || (voices[i].priority == voices[chosen].priority && voices[i].trigger_serial < voices[chosen].trigger_serial)) {
+				chosen = i;
+			}
+		}
+		if (chosen == -1) {
+			return -1;
+		}
+		stolen_voice_count++;
+	}
+
+	Voice &voice = voices[chosen];
+	// Sound MUST be stopped before seeking
+	ma_sound_stop(&voice.sound);
+	ma_sound_seek_to_pcm_frame(&voice.sound, 0);
+	ma_sound_set_volume(&voice.sound, m_linear_volume);
+	ma_sound_set_stop_time_in_pcm_frames(&voice.sound, ~(ma_uint64)0);
+	ma_sound_set_start_time_in_milliseconds(&voice.sound, m_global_time_msec);
+	ma_result result = ma_sound_start(&voice.sound);
+	MA_ERR(result, "Error starting pooled voice");
+	if (result != MA_SUCCESS) {
+		voice.active = false;
+		return -1;
+	}
+
+	voice.active = true;
+	voice.priority = m_priority;
+	voice.trigger_serial = trigger_serial++;
+	return chosen;
+}
+
+void ShinobuVoicePool::stop_voice(int m_voice) {
+	ERR_FAIL_INDEX(m_voice, voice_count);
+	if (voices[m_voice].initialized) {
+		ma_sound_stop(&voices[m_voice].sound);
+	}
+	voices[m_voice].active = false;
+}
+
+void ShinobuVoicePool::stop_all() {
+	for (int i = 0; i < voice_count; i++) {
+		stop_voice(i);
+	}
+}
+
+int ShinobuVoicePool::get_voice_count() const {
+	return voice_count;
+}
+
+int ShinobuVoicePool::get_active_voice_count() {
+	int active_count = 0;
+	for (int i = 0; i < voice_count; i++) {
+		if (voices[i].initialized && !_is_voice_free(voices[i])) {
+			active_count++;
+		}
+	}
+	return active_count;
+}
+
+uint64_t ShinobuVoicePool::get_stolen_voice_count() const {
+	return stolen_voice_count;
+}
+
+ShinobuVoicePool::ShinobuVoicePool(Ref<ShinobuSoundSource> m_sound_source, Ref<ShinobuGroup> m_group, int m_voice_count) {
+	ERR_FAIL_COND(m_sound_source.is_null());
+	ERR_FAIL_COND(m_voice_count <= 0);
+	sound_source = m_sound_source;
+	voice_count = m_voice_count;
+	// ma_sound can't be moved once initialized, so the array is never resized
+	voices = memnew_arr(Voice, voice_count);
+	for (int i = 0; i < voice_count; i++) {
+		voices[i].initialized = sound_source->instantiate_sound(m_group, false, &voices[i].sound, &voices[i].sound_data) == OK;
+	}
+}
+
+ShinobuVoicePool::~ShinobuVoicePool() {
+	for (int i = 0; i < voice_count; i++) {
+		if (voices[i].initialized) {
+			ma_sound_uninit(&voices[i].sound);
+		}
+	}
+	if (voices) {
+		memdelete_arr(voices);
+	}
+}
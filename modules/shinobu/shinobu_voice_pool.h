@@ -0,0 +1,52 @@
+#ifndef SHINOBU_VOICE_POOL_H
+#define SHINOBU_VOICE_POOL_H
+
+#include "core/object/ref_counted.h"
+#include "miniaudio/miniaudio.h"
+
+class ShinobuGroup;
+class ShinobuSoundSource;
+
+// A fixed set of sounds for a single source that get reused for every trigger, meant for hitsounds
+// and other short one shots that fire constantly, nothing is allocated after the pool is created.
+// When every voice is busy the least important one is stolen, oldest first among equals.
+class ShinobuVoicePool : public RefCounted {
+	GDCLASS(ShinobuVoicePool, RefCounted);
+
+	struct Voice {
+		ma_sound sound;
+		// Shared decoded data the sound reads from, if any, released after the sound is uninitialized
+		Ref<RefCounted> sound_data;
+		bool initialized = false;
+		bool active = false;
+		int priority = 0;
+		// Monotonic trigger counter, used to find the oldest voice when stealing
+		uint64_t trigger_serial = 0;
+	};
+
+	Ref<ShinobuSoundSource> sound_source;
+	Voice *voices = nullptr;
+	int voice_count = 0;
+	uint64_t trigger_serial = 0;
+	uint64_t stolen_voice_count = 0;
+	String error_message;
+
+	bool _is_voice_free(Voice &p_voice) const;
+
+protected:
+	static void _bind_methods();
+
+public:
+	int play(uint64_t m_global_time_msec, int m_priority = 0, float m_linear_volume = 1.0f);
+	void stop_voice(int m_voice);
+	void stop_all();
+
+	int get_voice_count() const;
+	int get_active_voice_count();
+	uint64_t get_stolen_voice_count() const;
+
+	ShinobuVoicePool(Ref<ShinobuSoundSource> m_sound_source, Ref<ShinobuGroup> m_group, int m_voice_count);
+	~ShinobuVoicePool();
+};
+
+#endif // SHINOBU_VOICE_POOL_H
@@ -0,0 +1,98 @@
+#ifndef TEST_SHINOBU_FFT_H
+#define TEST_SHINOBU_FFT_H
+
+#include "core/math/math_funcs.h"
+#include "core/math/random_number_generator.h"
+#include "core/templates/local_vector.h"
+#include "modules/shinobu/shinobu_fft.h"
+#include "tests/test_macros.h"
+
+namespace TestShinobuFFT {
+
+static void _fill_noise(LocalVector<float> &r_samples, uint32_t p_count, uint64_t p_seed) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instantiate();
+	rng->set_seed(p_seed);
+	r_samples.resize(p_count);
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_samples[i] = rng->randf_range(-1.0f, 1.0f);
+	}
+}
+
+TEST_SUITE("[Shinobu][FFT]") {
+	TEST_CASE("[Shinobu][FFT] Rejects sizes that aren't powers of two") {
+		shinobu_fft fft;
+		CHECK(shinobu_fft_init(&fft, 0, nullptr) != MA_SUCCESS);
+		CHECK(shinobu_fft_init(&fft, 2, nullptr) != MA_SUCCESS);
+		CHECK(shinobu_fft_init(&fft, 48, nullptr) != MA_SUCCESS);
+	}
+
+	TEST_CASE("[Shinobu][FFT] Forward then inverse gives back the input times N") {
+		// Both parities of log2(N / 2), so the leading radix-2 stage and the SIMD stages are covered
+		const int sizes[] = { 4, 8, 64, 256, 2048, 4096 };
+		for (int size : sizes) {
+			shinobu_fft fft;
+			REQUIRE(shinobu_fft_init(&fft, size, nullptr) == MA_SUCCESS);
+
+			LocalVector<float> input;
+			_fill_noise(input, size, size);
+			LocalVector<float> re;
+			LocalVector<float> im;
+			re.resize(size / 2 + 1);
+			im.resize(size / 2 + 1);
+			LocalVector<float> output;
+			output.resize(size);
+
+			shinobu_fft_forward(&fft, input.ptr(), MA_FALSE, re.ptr(), im.ptr());
+			shinobu_fft_inverse(&fft, re.ptr(), im.ptr(), output.ptr());
+
+			float max_error = 0.0f;
+			for (int i = 0; i < size; i++) {
+				max_error = MAX(max_error, Math::abs(output[i] / size - input[i]));
+			}
+			INFO("FFT size: ", size);
+			CHECK(max_error < 1e-5f);
+
+			shinobu_fft_uninit(&fft, nullptr);
+		}
+	}
+
+	TEST_CASE("[Shinobu][FFT] Forward transform matches a direct DFT") {
+		const int size = 128;
+		shinobu_fft fft;
+		REQUIRE(shinobu_fft_init(&fft, size, nullptr) == MA_SUCCESS);
+
+		LocalVector<float> input;
+		_fill_noise(input, size, 1234);
+		LocalVector<float> re;
+		LocalVector<float> im;
+		re.resize(size / 2 + 1);
+		im.resize(size / 2 + 1);
+
+		for (int windowed = 0; windowed < 2; windowed++) {
+			shinobu_fft_forward(&fft, input.ptr(), windowed, re.ptr(), im.ptr());
+
+			double max_error = 0.0;
+			for (int k = 0; k <= size / 2; k++) {
+				double expected_re = 0.0;
+				double expected_im = 0.0;
+				for (int n = 0; n < size; n++) {
+					// Periodic Hann window, as documented for shinobu_fft_forward
+					const double window = windowed ? 0.5 - 0.5 * Math::cos(Math_TAU * n / size) : 1.0;
+					const double angle = -Math_TAU * k * n / size;
+					expected_re += input[n] * window * Math::cos(angle);
+					expected_im += input[n] * window * Math::sin(angle);
+				}
+				max_error = MAX(max_error, MAX(Math::abs(re[k] - expected_re), Math::abs(im[k] - expected_im)));
+			}
+			INFO("Windowed: ", windowed);
+			CHECK(max_error < 1e-3);
+		}
+
+		shinobu_fft_uninit(&fft, nullptr);
+	}
+}
+
+} // namespace TestShinobuFFT
+
+#endif // TEST_SHINOBU_FFT_H
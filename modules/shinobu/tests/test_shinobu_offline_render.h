@@ -0,0 +1,73 @@
+#ifndef TEST_SHINOBU_OFFLINE_RENDER_H
+#define TEST_SHINOBU_OFFLINE_RENDER_H
+
+#include "core/io/marshalls.h"
+#include "core/object/message_queue.h"
+#include "core/os/os.h"
+#include "modules/shinobu/shinobu.h"
+#include "modules/shinobu/shinobu_sound_source.h"
+#include "tests/test_macros.h"
+
+namespace TestShinobuOfflineRender {
+
+const uint32_t SAMPLE_RATE = 48000;
+
+// Mono 16 bit silence
+static PackedByteArray _make_wav(uint32_t p_frame_count) {
+	const uint32_t data_size = p_frame_count * 2;
+	PackedByteArray wav;
+	wav.resize(44 + data_size);
+	wav.fill(0);
+	uint8_t *w = wav.ptrw();
+	memcpy(w, "RIFF", 4);
+	encode_uint32(36 + data_size, w + 4);
+	memcpy(w + 8, "WAVEfmt ", 8);
+	encode_uint32(16, w + 16);
+	encode_uint16(1, w + 20);
+	encode_uint16(1, w + 22);
+	encode_uint32(SAMPLE_RATE, w + 24);
+	encode_uint32(SAMPLE_RATE * 2, w + 28);
+	encode_uint16(2, w + 32);
+	encode_uint16(16, w + 34);
+	memcpy(w + 36, "data", 4);
+	encode_uint32(data_size, w + 40);
+	return wav;
+}
+
+TEST_SUITE("[Shinobu][OfflineRender]") {
+	TEST_CASE("[Shinobu][OfflineRender] Players are where the rendered frames put them") {
+		Shinobu *shinobu = Shinobu::get_singleton();
+		ERR_PRINT_OFF;
+		const Error err = shinobu->initialize_offline(SAMPLE_RATE);
+		ERR_PRINT_ON;
+		REQUIRE((err == OK || err == ERR_ALREADY_IN_USE));
+
+		Ref<ShinobuSoundSource> source = shinobu->register_sound_from_memory("test_offline_render", _make_wav(SAMPLE_RATE));
+		REQUIRE(source->get_result() == MA_SUCCESS);
+		Ref<ShinobuGroup> group = shinobu->create_group("test_offline_render");
+		ShinobuSoundPlayer *player = source->instantiate(group);
+		REQUIRE(player->start() == OK);
+
+		// Wall time passing before the render must not count as played audio
+		OS::get_singleton()->delay_usec(100000);
+		const PackedFloat32Array out = shinobu->render_offline(SAMPLE_RATE / 2);
+		CHECK(out.size() == SAMPLE_RATE / 2 * 2);
+		CHECK(player->is_playing());
+		const int64_t position_msec = player->get_playback_position_msec();
+		CHECK(position_msec >= 500);
+		CHECK(position_msec < 520);
+
+		memdelete(player);
+
+		// The length is found on the worker pool and published on the main thread
+		for (int i = 0; i < 1000 && source->get_cached_format_info().length_in_frames == 0; i++) {
+			OS::get_singleton()->delay_usec(1000);
+			MessageQueue::get_singleton()->flush();
+		}
+		CHECK(source->get_length_msec() == 1000);
+	}
+}
+
+} // namespace TestShinobuOfflineRender
+
+#endif // TEST_SHINOBU_OFFLINE_RENDER_H
@@ -33,11 +33,13 @@
 #include "joypad_linux.h"
 
 #include "core/os/os.h"
+#include "drivers/unix/os_unix.h"
 
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/input.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef UDEV_ENABLED
@@ -75,6 +77,7 @@ JoypadLinux::Joypad::~Joypad() {
 void JoypadLinux::Joypad::reset() {
 	dpad = 0;
 	fd = -1;
+	monotonic_timestamps = false;
 	for (int i = 0; i < MAX_ABS; i++) {
 		abs_map[i] = -1;
 		curr_axis[i] = 0;
@@ -400,6 +403,9 @@ void JoypadLinux::open_joypad(const char *p_path) {
 		joypad.reset();
 		joypad.fd = fd;
 		joypad.devpath = String(p_path);
+		// Events default to realtime stamps, which jump with the wall clock and can't be converted to ticks
+		int clock_id = CLOCK_MONOTONIC;
+		joypad.monotonic_timestamps = ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0;
 		setup_joypad_properties(joypad);
 		sprintf(uid, "%04x%04x", BSWAP16(inpid.bustype), 0);
 		if (inpid.vendor && inpid.product && inpid.version) {
@@ -507,7 +513,12 @@ void JoypadLinux::joypad_events_thread_run() {
 				joypad_event.type = event.type;
 				joypad_event.code = event.code;
 				joypad_event.value = event.value;
-				joypad_event.timestamp = OS::get_singleton()->get_ticks_usec();
+				if (joypad.monotonic_timestamps) {
+					// The time the device reported the change, not when we got around to reading it
+					joypad_event.timestamp = OS_Unix::clock_monotonic_to_ticks_usec((uint64_t)event.input_event_sec * 1000000 + event.input_event_usec);
+				} else {
+					joypad_event.timestamp = OS::get_singleton()->get_ticks_usec();
+				}
 				joypad.events.push_back(joypad_event);
 			}
 			if (errno != EAGAIN) {
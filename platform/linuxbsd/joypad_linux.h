@@ -66,6 +66,8 @@ private:
 		int abs_map[MAX_ABS];
 		BitField<HatMask> dpad;
 		int fd = -1;
+		// The kernel stamps events on CLOCK_MONOTONIC, otherwise they are stamped when read
+		bool monotonic_timestamps = false;
 
 		String devpath;
 		input_absinfo *abs_info[MAX_ABS] = {};
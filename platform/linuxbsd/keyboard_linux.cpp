@@ -0,0 +1,218 @@
+/**************************************************************************/
+/*  keyboard_linux.cpp                                                    */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#include "keyboard_linux.h"
+
+#ifdef JOYDEV_ENABLED
+
+#include "core/os/os.h"
+#include "drivers/unix/os_unix.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LONG_BITS (sizeof(long) * 8)
+#define test_bit(nr, addr) (((1UL << ((nr) % LONG_BITS)) & ((addr)[(nr) / LONG_BITS])) != 0)
+#define NBITS(x) ((((x) - 1) / LONG_BITS) + 1)
+
+KeyboardLinux *KeyboardLinux::singleton = nullptr;
+
+KeyboardLinux *KeyboardLinux::get_singleton() {
+	return singleton;
+}
+
+void KeyboardLinux::_thread_func(void *p_user) {
+	KeyboardLinux *keyboard = static_cast<KeyboardLinux *>(p_user);
+	keyboard->_thread_run();
+}
+
+void KeyboardLinux::_open_device(const String &p_path) {
+	checked_paths.insert(p_path);
+
+	int fd = open(p_path.utf8().get_data(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (fd == -1) {
+		if (errno == EACCES) {
+			print_verbose(vformat("KeyboardLinux: No permission to read %s, its key timestamps won't be used.", p_path));
+		}
+		return;
+	}
+
+	unsigned long evbit[NBITS(EV_MAX)] = { 0 };
+	unsigned long keybit[NBITS(KEY_MAX)] = { 0 };
+	if ((ioctl(fd, EVIOCGBIT(0, sizeof(evbit)), evbit) < 0) ||
+			(ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybit)), keybit) < 0)) {
+		close(fd);
+		return;
+	}
+
+	// Keyboards autorepeat and have letter keys, joypads (which JoypadLinux reads) report axes
+	if (!test_bit(EV_KEY, evbit) || !test_bit(EV_REP, evbit) || test_bit(EV_ABS, evbit) ||
+			!test_bit(KEY_A, keybit) || !test_bit(KEY_SPACE, keybit)) {
+		close(fd);
+		return;
+	}
+
+	Device device;
+	device.fd = fd;
+	device.path = p_path;
+	int clock_id = CLOCK_MONOTONIC;
+	device.monotonic_timestamps = ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0;
+	devices.push_back(device);
+
+	char namebuf[128] = {};
+	ioctl(fd, EVIOCGNAME(sizeof(namebuf) - 1), namebuf);
+	print_verbose(vformat("KeyboardLinux: Reading key timestamps from %s (%s).", p_path, String::utf8(namebuf)));
+}
+
+void KeyboardLinux::_close_device(uint32_t p_index) {
+	close(devices[p_index].fd);
+	// The path may be reused by a different device later
+	checked_paths.erase(devices[p_index].path);
+	devices.remove_at_unordered(p_index);
+}
+
+void KeyboardLinux::_scan_devices() {
+	DIR *input_directory = opendir("/dev/input");
+	if (!input_directory) {
+		return;
+	}
+	struct dirent *current;
+	while ((current = readdir(input_directory)) != nullptr) {
+		if (strncmp(current->d_name, "event", 5) != 0) {
+			continue;
+		}
+		String path = String("/dev/input/") + current->d_name;
+		if (!checked_paths.has(path)) {
+			_open_device(path);
+		}
+	}
+	closedir(input_directory);
+}
+
+void KeyboardLinux::_thread_run() {
+	LocalVector<struct pollfd> poll_fds;
+	while (!exit.is_set()) {
+		uint64_t now = OS::get_singleton()->get_ticks_usec();
+		if (last_scan_usec == 0 || now - last_scan_usec >= RESCAN_INTERVAL_USEC) {
+			_scan_devices();
+			last_scan_usec = now;
+		}
+
+		poll_fds.resize(devices.size());
+		for (uint32_t i = 0; i < devices.size(); i++) {
+			poll_fds[i].fd = devices[i].fd;
+			poll_fds[i].events = POLLIN;
+			poll_fds[i].revents = 0;
+		}
+
+		// Wakes up as soon as a key changes, the timeout is only there to rescan and notice exit
+		if (poll(poll_fds.ptr(), poll_fds.size(), POLL_TIMEOUT_MSEC) <= 0) {
+			continue;
+		}
+
+		for (int64_t i = poll_fds.size() - 1; i >= 0; i--) {
+			if (poll_fds[i].revents == 0) {
+				continue;
+			}
+			Device &device = devices[i];
+			input_event event;
+			ssize_t read_size;
+			while ((read_size = read(device.fd, &event, sizeof(event))) == sizeof(event)) {
+				// Value 2 is autorepeat, which the display server reports as echo events
+				if (event.type != EV_KEY || event.code > MAX_KEY || event.value > 1) {
+					continue;
+				}
+				uint64_t ticks;
+				if (device.monotonic_timestamps) {
+					ticks = OS_Unix::clock_monotonic_to_ticks_usec((uint64_t)event.input_event_sec * 1000000 + event.input_event_usec);
+				} else {
+					ticks = OS::get_singleton()->get_ticks_usec();
+				}
+				// 0 means nothing was recorded
+				ticks = MAX(ticks, (uint64_t)1);
+
+				MutexLock lock(key_ticks_mutex);
+				if (event.value) {
+					press_ticks[event.code] = ticks;
+				} else {
+					release_ticks[event.code] = ticks;
+				}
+			}
+			if ((read_size == -1 && errno != EAGAIN) || (poll_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))) {
+				// Unplugged
+				_close_device(i);
+			}
+		}
+	}
+}
+
+uint64_t KeyboardLinux::take_key_ticks_usec(uint32_t p_code, bool p_pressed, uint64_t p_event_ticks_usec) {
+	ERR_FAIL_UNSIGNED_INDEX_V(p_code, (uint32_t)MAX_KEY + 1, 0);
+
+	uint64_t ticks;
+	{
+		MutexLock lock(key_ticks_mutex);
+		uint64_t &stored = p_pressed ? press_ticks[p_code] : release_ticks[p_code];
+		ticks = stored;
+		stored = 0;
+	}
+
+	if (ticks == 0) {
+		return 0;
+	}
+	// A change after the display server event, or long before it, belongs to another press of the same key
+	// (or the event came from a server that isn't on this machine's clock)
+	if (ticks > p_event_ticks_usec + MATCH_STAMP_RESOLUTION_USEC || ticks + MAX_MATCH_WINDOW_USEC < p_event_ticks_usec) {
+		return 0;
+	}
+	return ticks;
+}
+
+KeyboardLinux::KeyboardLinux() {
+	singleton = this;
+	thread.start(_thread_func, this);
+}
+
+KeyboardLinux::~KeyboardLinux() {
+	exit.set();
+	thread.wait_to_finish();
+	for (const Device &device : devices) {
+		close(device.fd);
+	}
+	devices.clear();
+	singleton = nullptr;
+}
+
+#endif // JOYDEV_ENABLED
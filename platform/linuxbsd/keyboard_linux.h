@@ -0,0 +1,96 @@
+/**************************************************************************/
+/*  keyboard_linux.h                                                      */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef KEYBOARD_LINUX_H
+#define KEYBOARD_LINUX_H
+
+#ifdef JOYDEV_ENABLED
+
+#include "core/os/mutex.h"
+#include "core/os/thread.h"
+#include "core/templates/hash_set.h"
+#include "core/templates/local_vector.h"
+
+// Reads keyboards straight from evdev on its own thread to get the kernel time of every key press and release.
+// Key events still come from the display server, which has the layout, IME and focus, but they are stamped
+// with the kernel time of the matching key change instead of whenever the display server got them.
+// Needs read access to /dev/input/event*, usually by being in the input group, does nothing otherwise.
+class KeyboardLinux {
+	enum {
+		MAX_KEY = 767, // Hack because <linux/input.h> can't be included here
+		// A key change is only taken for a display server event stamped within this long after it
+		MAX_MATCH_WINDOW_USEC = 20'000,
+		// Display server stamps are truncated to milliseconds, so the kernel time may be up to this much after them
+		MATCH_STAMP_RESOLUTION_USEC = 1'000,
+		RESCAN_INTERVAL_USEC = 2'000'000,
+		POLL_TIMEOUT_MSEC = 100,
+	};
+
+	struct Device {
+		int fd = -1;
+		String path;
+		bool monotonic_timestamps = false;
+	};
+
+	static KeyboardLinux *singleton;
+
+	// Reader thread only
+	LocalVector<Device> devices;
+	HashSet<String> checked_paths;
+	uint64_t last_scan_usec = 0;
+
+	Mutex key_ticks_mutex;
+	uint64_t press_ticks[MAX_KEY + 1] = {};
+	uint64_t release_ticks[MAX_KEY + 1] = {};
+
+	SafeFlag exit;
+	Thread thread;
+
+	static void _thread_func(void *p_user);
+	void _thread_run();
+	void _scan_devices();
+	void _open_device(const String &p_path);
+	void _close_device(uint32_t p_index);
+
+public:
+	static KeyboardLinux *get_singleton();
+
+	// Kernel time of the last press or release of an evdev key code in Time.get_ticks_usec() time, or 0 if it
+	// didn't change shortly before p_event_ticks_usec, the display server's own stamp for the event converted
+	// to ticks. Each change is handed out once, so key repeats don't reuse the original press.
+	uint64_t take_key_ticks_usec(uint32_t p_code, bool p_pressed, uint64_t p_event_ticks_usec);
+
+	KeyboardLinux();
+	~KeyboardLinux();
+};
+
+#endif // JOYDEV_ENABLED
+
+#endif // KEYBOARD_LINUX_H
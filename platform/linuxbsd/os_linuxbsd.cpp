@@ -30,6 +30,7 @@
 
 #include "os_linuxbsd.h"
 
+#include "core/config/project_settings.h"
 #include "core/io/certs_compressed.gen.h"
 #include "core/io/dir_access.h"
 #include "drivers/sdl/joypad_sdl.h"
@@ -142,6 +143,11 @@ void OS_LinuxBSD::initialize() {
 }
 
 void OS_LinuxBSD::initialize_joypads() {
+#ifdef JOYDEV_ENABLED
+	if (GLOBAL_GET("input_devices/keyboard/use_evdev_timestamps")) {
+		keyboard = memnew(KeyboardLinux);
+	}
+#endif
 #ifdef SDL_ENABLED
 	joypad_sdl = memnew(JoypadSDL(Input::get_singleton()));
 	if (joypad_sdl->initialize() == OK) {
@@ -238,6 +244,9 @@ void OS_LinuxBSD::finalize() {
 	if (joypad) {
 		memdelete(joypad);
 	}
+	if (keyboard) {
+		memdelete(keyboard);
+	}
 #endif
 
 #ifdef SDL_ENABLED
@@ -33,6 +33,7 @@
 
 #include "crash_handler_linuxbsd.h"
 #include "joypad_linux.h"
+#include "keyboard_linux.h"
 
 #include "core/input/input.h"
 #include "drivers/alsa/audio_driver_alsa.h"
@@ -63,6 +64,7 @@ class OS_LinuxBSD : public OS_Unix {
 
 #ifdef JOYDEV_ENABLED
 	JoypadLinux *joypad = nullptr;
+	KeyboardLinux *keyboard = nullptr;
 #endif
 
 #ifdef SDL_ENABLED
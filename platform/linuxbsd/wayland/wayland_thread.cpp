@@ -32,6 +32,9 @@
 
 #ifdef WAYLAND_ENABLED
 
+#include "drivers/unix/os_unix.h"
+#include "keyboard_linux.h"
+
 // FIXME: Does this cause issues with *BSDs?
 #include <linux/input-event-codes.h>
 
@@ -1855,6 +1858,21 @@ void WaylandThread::_wl_keyboard_on_key(void *data, struct wl_keyboard *wl_keybo
 		return;
 	}
 
+	// Compositors stamp key events with CLOCK_MONOTONIC in milliseconds, like Xorg
+	uint64_t timestamp = OS_Unix::clock_monotonic_msec_to_ticks_usec(time, MAX_EVENT_AGE_MSEC);
+	if (timestamp == 0) {
+		timestamp = OS::get_singleton()->get_ticks_usec();
+	}
+#ifdef JOYDEV_ENABLED
+	if (KeyboardLinux::get_singleton()) {
+		uint64_t kernel_ticks = KeyboardLinux::get_singleton()->take_key_ticks_usec(key, pressed, timestamp);
+		if (kernel_ticks != 0) {
+			timestamp = kernel_ticks;
+		}
+	}
+#endif
+	k->set_timestamp(timestamp);
+
 	Ref<InputEventMessage> msg;
 	msg.instantiate();
 	msg->event = k;
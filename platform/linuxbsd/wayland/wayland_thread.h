@@ -474,6 +474,9 @@ public:
 	};
 
 private:
+	// Key events older than this are assumed to come from a compositor on a different clock
+	static constexpr uint32_t MAX_EVENT_AGE_MSEC = 1000;
+
 	struct ThreadData {
 		SafeFlag thread_done;
 		Mutex mutex;
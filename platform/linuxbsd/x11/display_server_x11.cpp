@@ -40,6 +40,8 @@
 #include "core/string/print_string.h"
 #include "core/string/ustring.h"
 #include "drivers/png/png_driver_common.h"
+#include "drivers/unix/os_unix.h"
+#include "keyboard_linux.h"
 #include "main/main.h"
 
 #if defined(VULKAN_ENABLED)
@@ -57,6 +59,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #undef CursorShape
@@ -3401,6 +3404,16 @@ void DisplayServerX11::_get_key_modifier_state(unsigned int p_x11_state, Ref<Inp
 	state->set_meta_pressed((p_x11_state & Mod4Mask));
 }
 
+uint64_t DisplayServerX11::_get_event_ticks_usec(::Time p_time) const {
+	// Xorg stamps events with its CLOCK_MONOTONIC in milliseconds, truncated to 32 bits
+	uint64_t ticks = OS_Unix::clock_monotonic_msec_to_ticks_usec((uint32_t)p_time, MAX_EVENT_AGE_MSEC);
+	if (ticks == 0) {
+		// Remote server or one on another clock, the time we got the event is the best we have
+		return OS::get_singleton()->get_ticks_usec();
+	}
+	return ticks;
+}
+
 void DisplayServerX11::_handle_key_event(WindowID p_window, XKeyEvent *p_event, LocalVector<XEvent> &p_events, uint32_t &p_event_index, bool p_echo) {
 	WindowData &wd = windows[p_window];
 	// X11 functions don't know what const is
@@ -3409,6 +3422,17 @@ void DisplayServerX11::_handle_key_event(WindowID p_window, XKeyEvent *p_event,
 	if (wd.ime_in_progress) {
 		return;
 	}
+
+	uint64_t timestamp = _get_event_ticks_usec(xkeyevent->time);
+#ifdef JOYDEV_ENABLED
+	if (!p_echo && KeyboardLinux::get_singleton()) {
+		// X11 keycodes are evdev codes offset by 8
+		uint64_t kernel_ticks = KeyboardLinux::get_singleton()->take_key_ticks_usec(xkeyevent->keycode - 8, xkeyevent->type == KeyPress, timestamp);
+		if (kernel_ticks != 0) {
+			timestamp = kernel_ticks;
+		}
+	}
+#endif
 	if (wd.ime_suppress_next_keyup) {
 		wd.ime_suppress_next_keyup = false;
 		if (xkeyevent->type != KeyPress) {
@@ -3503,6 +3527,7 @@ void DisplayServerX11::_handle_key_event(WindowID p_window, XKeyEvent *p_event,
 				_get_key_modifier_state(xkeyevent->state, k);
 
 				k->set_window_id(p_window);
+				k->set_timestamp(timestamp);
 				k->set_pressed(keypress);
 
 				k->set_keycode(keycode);
@@ -3575,6 +3600,7 @@ void DisplayServerX11::_handle_key_event(WindowID p_window, XKeyEvent *p_event,
 					_get_key_modifier_state(xkeyevent->state, k);
 
 					k->set_window_id(p_window);
+					k->set_timestamp(timestamp);
 					k->set_pressed(keypress);
 
 					k->set_keycode(keycode);
@@ -3654,6 +3680,7 @@ void DisplayServerX11::_handle_key_event(WindowID p_window, XKeyEvent *p_event,
 	Ref<InputEventKey> k;
 	k.instantiate();
 	k->set_window_id(p_window);
+	k->set_timestamp(timestamp);
 
 	_get_key_modifier_state(xkeyevent->state, k);
 
@@ -4784,6 +4811,7 @@ void DisplayServerX11::process_events() {
 				mb.instantiate();
 
 				mb->set_window_id(window_id);
+				mb->set_timestamp(_get_event_ticks_usec(event.xbutton.time));
 				_get_key_modifier_state(event.xbutton.state, mb);
 				mb->set_button_index((MouseButton)event.xbutton.button);
 				if (mb->get_button_index() == MouseButton::RIGHT) {
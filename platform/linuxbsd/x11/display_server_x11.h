@@ -127,6 +127,9 @@ class DisplayServerX11 : public DisplayServer {
 
 	_THREAD_SAFE_CLASS_
 
+	// Events older than this are assumed to come from a server on a different clock
+	static constexpr uint32_t MAX_EVENT_AGE_MSEC = 1000;
+
 	Atom wm_delete;
 	Atom xdnd_enter;
 	Atom xdnd_position;
@@ -292,6 +295,8 @@ class DisplayServerX11 : public DisplayServer {
 	Rect2i _screen_get_rect(int p_screen) const;
 
 	void _get_key_modifier_state(unsigned int p_x11_state, Ref<InputEventWithModifiers> state);
+	// Converts X server event time to Time.get_ticks_usec() time, so events keep the time they happened at
+	uint64_t _get_event_ticks_usec(::Time p_time) const;
 	void _flush_mouse_motion();
 
 	MouseMode mouse_mode = MOUSE_MODE_VISIBLE;
@@ -727,6 +727,18 @@ uint64_t OS_Windows::get_ticks_usec() const {
 	return time;
 }
 
+uint64_t OS_Windows::get_ticks_nsec() const {
+	uint64_t ticks;
+	QueryPerformanceCounter((LARGE_INTEGER *)&ticks);
+	ticks -= ticks_start;
+
+	// Same split as get_ticks_usec to avoid overflowing
+	uint64_t seconds = ticks / ticks_per_second;
+	uint64_t leftover = ticks % ticks_per_second;
+
+	return (leftover * 1000000000L) / ticks_per_second + seconds * 1000000000L;
+}
+
 String OS_Windows::_quote_command_line_argument(const String &p_text) const {
 	for (int i = 0; i < p_text.size(); i++) {
 		char32_t c = p_text[i];
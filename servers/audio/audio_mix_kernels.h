@@ -0,0 +1,244 @@
+/**************************************************************************/
+/*  audio_mix_kernels.h                                                   */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef AUDIO_MIX_KERNELS_H
+#define AUDIO_MIX_KERNELS_H
+
+#include "core/math/audio_frame.h"
+#include "core/typedefs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MIX_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AUDIO_MIX_NEON
+#endif
+
+// Buffer kernels AudioServer mixes with. The vector paths work on two stereo frames at a time and leave the odd
+// frame to the scalar tail.
+class AudioMixKernels {
+public:
+	// Volume ramps from p_vol_start to p_vol_final over p_ramp_frames, for frames p_from to p_from + p_count of the ramp.
+	// Either adds the result to p_dst or replaces it.
+	template <bool ACCUMULATE>
+	static void ramp(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_from, uint32_t p_count, uint32_t p_ramp_frames) {
+		const float inv_ramp = 1.0f / p_ramp_frames;
+		const AudioFrame vol_delta = p_vol_final - p_vol_start;
+		[[maybe_unused]] float *dst = &p_dst[0].left;
+		[[maybe_unused]] const float *src = &p_src[0].left;
+		uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE2)
+		const __m128 start = _mm_setr_ps(p_vol_start.left, p_vol_start.right, p_vol_start.left, p_vol_start.right);
+		const __m128 delta = _mm_setr_ps(vol_delta.left, vol_delta.right, vol_delta.left, vol_delta.right);
+		const __m128 inv = _mm_set1_ps(inv_ramp);
+		const __m128 two = _mm_set1_ps(2.0f);
+		// Frame indices stay exact as floats, so the ramp doesn't drift over the buffer
+		__m128 index = _mm_setr_ps(p_from, p_from, p_from + 1, p_from + 1);
+		for (; i + 2 <= p_count; i += 2) {
+			const __m128 vol = _mm_add_ps(start, _mm_mul_ps(delta, _mm_mul_ps(index, inv)));
+			__m128 mixed = _mm_mul_ps(vol, _mm_loadu_ps(src + i * 2));
+			if (ACCUMULATE) {
+				mixed = _mm_add_ps(mixed, _mm_loadu_ps(dst + i * 2));
+			}
+			_mm_storeu_ps(dst + i * 2, mixed);
+			index = _mm_add_ps(index, two);
+		}
+#elif defined(AUDIO_MIX_NEON)
+		const float start_lanes[4] = { p_vol_start.left, p_vol_start.right, p_vol_start.left, p_vol_start.right };
+		const float delta_lanes[4] = { vol_delta.left, vol_delta.right, vol_delta.left, vol_delta.right };
+		const float index_lanes[4] = { (float)p_from, (float)p_from, (float)(p_from + 1), (float)(p_from + 1) };
+		const float32x4_t start = vld1q_f32(start_lanes);
+		const float32x4_t delta = vld1q_f32(delta_lanes);
+		const float32x4_t two = vdupq_n_f32(2.0f);
+		float32x4_t index = vld1q_f32(index_lanes);
+		for (; i + 2 <= p_count; i += 2) {
+			const float32x4_t vol = vmlaq_f32(start, delta, vmulq_n_f32(index, inv_ramp));
+			float32x4_t mixed = vmulq_f32(vol, vld1q_f32(src + i * 2));
+			if (ACCUMULATE) {
+				mixed = vaddq_f32(mixed, vld1q_f32(dst + i * 2));
+			}
+			vst1q_f32(dst + i * 2, mixed);
+			index = vaddq_f32(index, two);
+		}
+#endif
+		for (; i < p_count; i++) {
+			const float t = (p_from + i) * inv_ramp;
+			const AudioFrame mixed = (p_vol_start + vol_delta * t) * p_src[i];
+			if (ACCUMULATE) {
+				p_dst[i] += mixed;
+			} else {
+				p_dst[i] = mixed;
+			}
+		}
+	}
+
+	static void add(AudioFrame *p_dst, const AudioFrame *p_src, uint32_t p_count) {
+		[[maybe_unused]] float *dst = &p_dst[0].left;
+		[[maybe_unused]] const float *src = &p_src[0].left;
+		uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE2)
+		for (; i + 2 <= p_count; i += 2) {
+			_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_loadu_ps(src + i * 2)));
+		}
+#elif defined(AUDIO_MIX_NEON)
+		for (; i + 2 <= p_count; i += 2) {
+			vst1q_f32(dst + i * 2, vaddq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2)));
+		}
+#endif
+		for (; i < p_count; i++) {
+			p_dst[i] += p_src[i];
+		}
+	}
+
+	// Scales the buffer and returns the highest absolute sample of each side, NaNs are left out of the peak.
+	static AudioFrame scale_peak(AudioFrame *p_buf, float p_volume, uint32_t p_count) {
+		[[maybe_unused]] float *buf = &p_buf[0].left;
+		AudioFrame peak = AudioFrame(0, 0);
+		uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE2)
+		const __m128 volume = _mm_set1_ps(p_volume);
+		const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		__m128 peaks = _mm_setzero_ps();
+		for (; i + 2 <= p_count; i += 2) {
+			const __m128 scaled = _mm_mul_ps(_mm_loadu_ps(buf + i * 2), volume);
+			_mm_storeu_ps(buf + i * 2, scaled);
+			// maxps returns the second operand when either is NaN
+			peaks = _mm_max_ps(_mm_and_ps(scaled, abs_mask), peaks);
+		}
+		peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+		float peak_lanes[4];
+		_mm_storeu_ps(peak_lanes, peaks);
+		peak = AudioFrame(peak_lanes[0], peak_lanes[1]);
+#elif defined(AUDIO_MIX_NEON)
+		float32x4_t peaks = vdupq_n_f32(0.0f);
+		for (; i + 2 <= p_count; i += 2) {
+			const float32x4_t scaled = vmulq_n_f32(vld1q_f32(buf + i * 2), p_volume);
+			vst1q_f32(buf + i * 2, scaled);
+			const float32x4_t abs_scaled = vabsq_f32(scaled);
+			peaks = vbslq_f32(vcgtq_f32(abs_scaled, peaks), abs_scaled, peaks);
+		}
+		peak = AudioFrame(MAX(vgetq_lane_f32(peaks, 0), vgetq_lane_f32(peaks, 2)), MAX(vgetq_lane_f32(peaks, 1), vgetq_lane_f32(peaks, 3)));
+#endif
+		for (; i < p_count; i++) {
+			p_buf[i] *= p_volume;
+			const float l = ABS(p_buf[i].left);
+			if (l > peak.left) {
+				peak.left = l;
+			}
+			const float r = ABS(p_buf[i].right);
+			if (r > peak.right) {
+				peak.right = r;
+			}
+		}
+		return peak;
+	}
+
+	// Multiplies frame n of the range by p_base^(n + 1).
+	static void fade_out(AudioFrame *p_buf, uint32_t p_count, float p_base) {
+		[[maybe_unused]] float *buf = &p_buf[0].left;
+		float coefficient = p_base;
+		uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE2)
+		__m128 coefficients = _mm_setr_ps(p_base, p_base, p_base * p_base, p_base * p_base);
+		const __m128 step = _mm_set1_ps(p_base * p_base);
+		for (; i + 2 <= p_count; i += 2) {
+			_mm_storeu_ps(buf + i * 2, _mm_mul_ps(_mm_loadu_ps(buf + i * 2), coefficients));
+			coefficients = _mm_mul_ps(coefficients, step);
+		}
+		float coefficient_lanes[4];
+		_mm_storeu_ps(coefficient_lanes, coefficients);
+		coefficient = coefficient_lanes[0];
+#elif defined(AUDIO_MIX_NEON)
+		const float coefficient_lanes[4] = { p_base, p_base, p_base * p_base, p_base * p_base };
+		float32x4_t coefficients = vld1q_f32(coefficient_lanes);
+		for (; i + 2 <= p_count; i += 2) {
+			vst1q_f32(buf + i * 2, vmulq_f32(vld1q_f32(buf + i * 2), coefficients));
+			coefficients = vmulq_n_f32(coefficients, p_base * p_base);
+		}
+		coefficient = vgetq_lane_f32(coefficients, 0);
+#endif
+		for (; i < p_count; i++) {
+			p_buf[i] *= coefficient;
+			coefficient *= p_base;
+		}
+	}
+
+	// Converts to the drivers' 32 bit samples, p_stride is how many samples apart the output frames are.
+	// Samples are clamped and quantized to 21 bits, then shifted to the top of the int32 range.
+	static void to_int32(int32_t *p_dst, const AudioFrame *p_src, uint32_t p_count, uint32_t p_stride) {
+		[[maybe_unused]] const float *src = &p_src[0].left;
+		int32_t *dst = p_dst;
+		uint32_t i = 0;
+#if defined(AUDIO_MIX_SSE2)
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minus_one = _mm_set1_ps(-1.0f);
+		const __m128 scale = _mm_set1_ps((1 << 20) - 1);
+		for (; i + 2 <= p_count; i += 2) {
+			const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i * 2), minus_one), one);
+			// Truncates towards zero like the scalar cast, and the shift keeps the sign
+			const __m128i samples = _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(clamped, scale)), 11);
+			if (p_stride == 2) {
+				_mm_storeu_si128((__m128i *)dst, samples);
+			} else {
+				_mm_storel_epi64((__m128i *)dst, samples);
+				_mm_storel_epi64((__m128i *)(dst + p_stride), _mm_unpackhi_epi64(samples, samples));
+			}
+			dst += p_stride * 2;
+		}
+#elif defined(AUDIO_MIX_NEON)
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		const float32x4_t minus_one = vdupq_n_f32(-1.0f);
+		for (; i + 2 <= p_count; i += 2) {
+			const float32x4_t clamped = vminq_f32(vmaxq_f32(vld1q_f32(src + i * 2), minus_one), one);
+			const int32x4_t samples = vshlq_n_s32(vcvtq_s32_f32(vmulq_n_f32(clamped, (1 << 20) - 1)), 11);
+			if (p_stride == 2) {
+				vst1q_s32(dst, samples);
+			} else {
+				vst1_s32(dst, vget_low_s32(samples));
+				vst1_s32(dst + p_stride, vget_high_s32(samples));
+			}
+			dst += p_stride * 2;
+		}
+#endif
+		for (; i < p_count; i++) {
+			float l = CLAMP(p_src[i].left, -1.0, 1.0);
+			int32_t vl = l * ((1 << 20) - 1);
+			dst[0] = (vl < 0 ? -1 : 1) * (ABS(vl) << 11);
+
+			float r = CLAMP(p_src[i].right, -1.0, 1.0);
+			int32_t vr = r * ((1 << 20) - 1);
+			dst[1] = (vr < 0 ? -1 : 1) * (ABS(vr) << 11);
+			dst += p_stride;
+		}
+	}
+};
+
+#endif // AUDIO_MIX_KERNELS_H
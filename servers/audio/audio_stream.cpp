@@ -204,6 +204,14 @@ int AudioStreamPlaybackResampled::mix(AudioFrame *p_buffer, float p_rate_scale,
 	return mixed_frames_total;
 }
 
+int AudioStreamPlaybackResampled::mix_native(AudioFrame *p_buffer, int p_frames) {
+	return _mix_internal(p_buffer, p_frames);
+}
+
+float AudioStreamPlaybackResampled::get_native_sampling_rate() {
+	return get_stream_sampling_rate();
+}
+
 ////////////////////////////////
 
 Ref<AudioStreamPlayback> AudioStream::instantiate_playback() {
@@ -147,6 +147,11 @@ protected:
 public:
 	virtual int mix(AudioFrame *p_buffer, float p_rate_scale, int p_frames) override;
 
+	// Decode at the stream's own sampling rate, skipping the resampler. Meant for tools that want
+	// the source frames (waveform previews, analysis), not for playback. Don't mix them with mix().
+	int mix_native(AudioFrame *p_buffer, int p_frames);
+	float get_native_sampling_rate();
+
 	AudioStreamPlaybackResampled() { mix_offset = 0; }
 };
 
@@ -42,6 +42,7 @@
 #include "scene/resources/audio_stream_wav.h"
 #include "scene/scene_string_names.h"
 #include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/audio_mix_kernels.h"
 #include "servers/audio/effects/audio_effect_compressor.h"
 
 #include <cstring>
@@ -52,6 +53,9 @@
 #define MARK_EDITED
 #endif
 
+// Highshelf filtered playbacks are ramped into a stack buffer of this many frames before filtering
+static const uint32_t FILTER_MIX_CHUNK_FRAMES = 256;
+
 AudioDriver *AudioDriver::singleton = nullptr;
 AudioDriver *AudioDriver::get_singleton() {
 	return singleton;
@@ -297,21 +301,7 @@ void AudioServer::_driver_process(int p_frames, int32_t *p_buffer) {
 
 			if (master->channels[k].active) {
 				const AudioFrame *buf = master->channels[k].buffer.ptr();
-
-				for (int j = 0; j < to_copy; j++) {
-					float l = CLAMP(buf[from + j].left, -1.0, 1.0);
-					int32_t vl = l * ((1 << 20) - 1);
-					int32_t vl2 = (vl < 0 ? -1 : 1) * (ABS(vl) << 11);
-					*dest = vl2;
-					dest++;
-
-					float r = CLAMP(buf[from + j].right, -1.0, 1.0);
-					int32_t vr = r * ((1 << 20) - 1);
-					int32_t vr2 = (vr < 0 ? -1 : 1) * (ABS(vr) << 11);
-					*dest = vr2;
-					dest += stride_minus_one;
-				}
-
+				AudioMixKernels::to_int32(dest, &buf[from], to_copy, cs * 2);
 			} else {
 				// Bizarrely, profiling indicates that detecting the common case of cs == 1,
 				// k == 0, and using memset is SLOWER than setting them individually.
@@ -390,9 +380,7 @@ void AudioServer::_mix_step() {
 		AudioFrame *buf = mix_buffer.ptrw();
 
 		// Copy the lookeahead buffer into the mix buffer.
-		for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
-			buf[i] = playback->lookahead[i];
-		}
+		memcpy((void *)buf, playback->lookahead, sizeof(playback->lookahead));
 
 		// Mix the audio stream
 		unsigned int mixed_frames = playback->stream_playback->mix(&buf[LOOKAHEAD_BUFFER_SIZE], playback->pitch_scale.get(), buffer_size);
@@ -405,21 +393,17 @@ void AudioServer::_mix_step() {
 			// We know we have at least the size of our lookahead buffer for fade-out purposes.
 
 			float fadeout_base = 0.94;
-			float fadeout_coefficient = 1;
 			static_assert(LOOKAHEAD_BUFFER_SIZE == 64, "Update fadeout_base and comment here if you change LOOKAHEAD_BUFFER_SIZE.");
 			// 0.94 ^ 64 = 0.01906. There might still be a pop but it'll be way better than if we didn't do this.
-			for (unsigned int idx = mixed_frames; idx < buffer_size; idx++) {
-				fadeout_coefficient *= fadeout_base;
-				buf[idx] *= fadeout_coefficient;
+			if (mixed_frames < buffer_size) {
+				AudioMixKernels::fade_out(&buf[mixed_frames], buffer_size - mixed_frames, fadeout_base);
 			}
 			AudioStreamPlaybackListNode::PlaybackState new_state;
 			new_state = AudioStreamPlaybackListNode::AWAITING_DELETION;
 			playback->state.store(new_state);
 		} else {
 			// Move the last little bit of what we just mixed into our lookahead buffer.
-			for (int i = 0; i < LOOKAHEAD_BUFFER_SIZE; i++) {
-				playback->lookahead[i] = buf[buffer_size + i];
-			}
+			memcpy((void *)playback->lookahead, &buf[buffer_size], sizeof(playback->lookahead));
 		}
 
 		AudioStreamPlaybackBusDetails *ptr = playback->bus_details.load();
@@ -525,10 +509,7 @@ void AudioServer::_mix_step() {
 			if (bus->channels[k].active && !bus->channels[k].used) {
 				//buffer was not used, but it's still active, so it must be cleaned
 				AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
-
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					buf[j] = AudioFrame(0, 0);
-				}
+				memset((void *)buf, 0, buffer_size * sizeof(AudioFrame));
 			}
 		}
 
@@ -603,18 +584,7 @@ void AudioServer::_mix_step() {
 			}
 
 			//apply volume and compute peak
-			for (uint32_t j = 0; j < buffer_size; j++) {
-				buf[j] *= volume;
-
-				float l = ABS(buf[j].left);
-				if (l > peak.left) {
-					peak.left = l;
-				}
-				float r = ABS(buf[j].right);
-				if (r > peak.right) {
-					peak.right = r;
-				}
-			}
+			peak = AudioMixKernels::scale_peak(buf, volume, buffer_size);
 
 			bus->channels.write[k].peak_volume = AudioFrame(Math::linear_to_db(peak.left + AUDIO_PEAK_OFFSET), Math::linear_to_db(peak.right + AUDIO_PEAK_OFFSET));
 
@@ -632,10 +602,7 @@ void AudioServer::_mix_step() {
 			if (send) {
 				//if not master bus, send
 				AudioFrame *target_buf = thread_get_channel_mix_buffer(send->index_cache, k);
-
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					target_buf[j] += buf[j];
-				}
+				AudioMixKernels::add(target_buf, buf, buffer_size);
 			}
 		}
 	}
@@ -663,22 +630,22 @@ void AudioServer::_mix_step_for_channel(AudioFrame *p_out_buf, AudioFrame *p_sou
 		p_processor_r->set_filter(&filter, /* clear_history= */ is_just_started);
 		p_processor_r->update_coeffs(buffer_size);
 
-		for (unsigned int frame_idx = 0; frame_idx < buffer_size; frame_idx++) {
+		// The filter has to run sample by sample, so only the ramp and the final add are vectorized, a chunk at a time.
+		AudioFrame mixed[FILTER_MIX_CHUNK_FRAMES];
+		for (uint32_t chunk_from = 0; chunk_from < buffer_size; chunk_from += FILTER_MIX_CHUNK_FRAMES) {
+			const uint32_t chunk_frames = MIN(FILTER_MIX_CHUNK_FRAMES, buffer_size - chunk_from);
 			// Make this buffer size invariant if buffer_size ever becomes a project setting.
-			float lerp_param = (float)frame_idx / buffer_size;
-			AudioFrame vol = p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start;
-			AudioFrame mixed = vol * p_source_buf[frame_idx];
-			p_processor_l->process_one_interp(mixed.left);
-			p_processor_r->process_one_interp(mixed.right);
-			p_out_buf[frame_idx] += mixed;
+			AudioMixKernels::ramp<false>(mixed, &p_source_buf[chunk_from], p_vol_start, p_vol_final, chunk_from, chunk_frames, buffer_size);
+			for (uint32_t frame_idx = 0; frame_idx < chunk_frames; frame_idx++) {
+				p_processor_l->process_one_interp(mixed[frame_idx].left);
+				p_processor_r->process_one_interp(mixed[frame_idx].right);
+			}
+			AudioMixKernels::add(&p_out_buf[chunk_from], mixed, chunk_frames);
 		}
 
 	} else {
-		for (unsigned int frame_idx = 0; frame_idx < buffer_size; frame_idx++) {
-			// Make this buffer size invariant if buffer_size ever becomes a project setting.
-			float lerp_param = (float)frame_idx / buffer_size;
-			p_out_buf[frame_idx] += (p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start) * p_source_buf[frame_idx];
-		}
+		// Make this buffer size invariant if buffer_size ever becomes a project setting.
+		AudioMixKernels::ramp<true>(p_out_buf, p_source_buf, p_vol_start, p_vol_final, 0, buffer_size, buffer_size);
 	}
 }
 
@@ -0,0 +1,262 @@
+/**************************************************************************/
+/*  test_audio_mix_kernels.h                                              */
+/**************************************************************************/
+/*                         This file is part of:                          */
+/*                             GODOT ENGINE                               */
+/*                        https://godotengine.org                         */
+/**************************************************************************/
+/* Copyright (c) 2014-present Godot Engine contributors (see AUTHORS.md). */
+/* Copyright (c) 2007-2014 Juan Linietsky, Ariel Manzur.                  */
+/*                                                                        */
+/* Permission is hereby granted, free of charge, to any person obtaining  */
+/* a copy of this software and associated documentation files (the        */
+/* "Software"), to deal in the Software without restriction, including    */
+/* without limitation the rights to use, copy, modify, merge, publish,    */
+/* distribute, sublicense, and/or sell copies of the Software, and to     */
+/* permit persons to whom the Software is furnished to do so, subject to  */
+/* the following conditions:                                              */
+/*                                                                        */
+/* The above copyright notice and this permission notice shall be         */
+/* included in all copies or substantial portions of the Software.        */
+/*                                                                        */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,        */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF     */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. */
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY   */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,   */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE      */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                 */
+/**************************************************************************/
+
+#ifndef TEST_AUDIO_MIX_KERNELS_H
+#define TEST_AUDIO_MIX_KERNELS_H
+
+#include "core/math/random_number_generator.h"
+#include "core/os/os.h"
+#include "core/templates/local_vector.h"
+#include "servers/audio/audio_mix_kernels.h"
+#include "tests/test_macros.h"
+
+namespace TestAudioMixKernels {
+
+// The per-frame code AudioServer mixed with before the kernels
+
+template <bool ACCUMULATE>
+static void _ramp_reference(AudioFrame *p_dst, const AudioFrame *p_src, AudioFrame p_vol_start, AudioFrame p_vol_final, uint32_t p_from, uint32_t p_count, uint32_t p_ramp_frames) {
+	for (uint32_t i = 0; i < p_count; i++) {
+		float lerp_param = (float)(p_from + i) / p_ramp_frames;
+		AudioFrame mixed = (p_vol_final * lerp_param + (1 - lerp_param) * p_vol_start) * p_src[i];
+		if (ACCUMULATE) {
+			p_dst[i] += mixed;
+		} else {
+			p_dst[i] = mixed;
+		}
+	}
+}
+
+static AudioFrame _scale_peak_reference(AudioFrame *p_buf, float p_volume, uint32_t p_count) {
+	AudioFrame peak = AudioFrame(0, 0);
+	for (uint32_t i = 0; i < p_count; i++) {
+		p_buf[i] *= p_volume;
+		float l = ABS(p_buf[i].left);
+		if (l > peak.left) {
+			peak.left = l;
+		}
+		float r = ABS(p_buf[i].right);
+		if (r > peak.right) {
+			peak.right = r;
+		}
+	}
+	return peak;
+}
+
+static void _fade_out_reference(AudioFrame *p_buf, uint32_t p_count, float p_base) {
+	float coefficient = 1;
+	for (uint32_t i = 0; i < p_count; i++) {
+		coefficient *= p_base;
+		p_buf[i] *= coefficient;
+	}
+}
+
+static void _to_int32_reference(int32_t *p_dst, const AudioFrame *p_src, uint32_t p_count, uint32_t p_stride) {
+	for (uint32_t i = 0; i < p_count; i++) {
+		float l = CLAMP(p_src[i].left, -1.0, 1.0);
+		int32_t vl = l * ((1 << 20) - 1);
+		p_dst[i * p_stride] = (vl < 0 ? -1 : 1) * (ABS(vl) << 11);
+
+		float r = CLAMP(p_src[i].right, -1.0, 1.0);
+		int32_t vr = r * ((1 << 20) - 1);
+		p_dst[i * p_stride + 1] = (vr < 0 ? -1 : 1) * (ABS(vr) << 11);
+	}
+}
+
+// Odd counts leave a frame to the scalar tail of the vector paths
+static const uint32_t FRAME_COUNTS[] = { 1, 2, 3, 7, 64, 255, 1024 };
+
+static void _fill_noise(LocalVector<AudioFrame> &r_frames, uint32_t p_count, uint64_t p_seed, float p_range = 1.0f) {
+	Ref<RandomNumberGenerator> rng;
+	rng.instantiate();
+	rng->set_seed(p_seed);
+	r_frames.resize(p_count);
+	for (uint32_t i = 0; i < p_count; i++) {
+		r_frames[i] = AudioFrame(rng->randf_range(-p_range, p_range), rng->randf_range(-p_range, p_range));
+	}
+}
+
+static float _max_difference(const LocalVector<AudioFrame> &p_a, const LocalVector<AudioFrame> &p_b) {
+	float difference = 0.0f;
+	for (uint32_t i = 0; i < p_a.size(); i++) {
+		difference = MAX(difference, MAX(Math::abs(p_a[i].left - p_b[i].left), Math::abs(p_a[i].right - p_b[i].right)));
+	}
+	return difference;
+}
+
+TEST_SUITE("[Audio][AudioMixKernels]") {
+	TEST_CASE("[Audio][AudioMixKernels] Ramps match the per-frame code") {
+		const AudioFrame vol_start(0.25f, 1.0f);
+		const AudioFrame vol_final(0.75f, 0.0f);
+		for (uint32_t count : FRAME_COUNTS) {
+			LocalVector<AudioFrame> src;
+			_fill_noise(src, count, count);
+			// Starting partway through a longer ramp, like the filtered playback chunks do
+			const uint32_t from = count % 5;
+			const uint32_t ramp_frames = count + from;
+
+			LocalVector<AudioFrame> expected;
+			LocalVector<AudioFrame> result;
+			_fill_noise(expected, count, count + 1);
+			result = expected;
+			_ramp_reference<true>(expected.ptr(), src.ptr(), vol_start, vol_final, from, count, ramp_frames);
+			AudioMixKernels::ramp<true>(result.ptr(), src.ptr(), vol_start, vol_final, from, count, ramp_frames);
+			INFO("Frames: ", count);
+			CHECK(_max_difference(result, expected) < 1e-6f);
+
+			_ramp_reference<false>(expected.ptr(), src.ptr(), vol_start, vol_final, from, count, ramp_frames);
+			AudioMixKernels::ramp<false>(result.ptr(), src.ptr(), vol_start, vol_final, from, count, ramp_frames);
+			CHECK(_max_difference(result, expected) < 1e-6f);
+		}
+	}
+
+	TEST_CASE("[Audio][AudioMixKernels] Adding matches the per-frame code") {
+		for (uint32_t count : FRAME_COUNTS) {
+			LocalVector<AudioFrame> src;
+			_fill_noise(src, count, count);
+			LocalVector<AudioFrame> expected;
+			_fill_noise(expected, count, count + 1);
+			LocalVector<AudioFrame> result = expected;
+			for (uint32_t i = 0; i < count; i++) {
+				expected[i] += src[i];
+			}
+			AudioMixKernels::add(result.ptr(), src.ptr(), count);
+			INFO("Frames: ", count);
+			CHECK(_max_difference(result, expected) == 0.0f);
+		}
+	}
+
+	TEST_CASE("[Audio][AudioMixKernels] Scaling and peaks match the per-frame code") {
+		for (uint32_t count : FRAME_COUNTS) {
+			LocalVector<AudioFrame> expected;
+			_fill_noise(expected, count, count, 2.0f);
+			LocalVector<AudioFrame> result = expected;
+			const AudioFrame expected_peak = _scale_peak_reference(expected.ptr(), 0.8f, count);
+			const AudioFrame peak = AudioMixKernels::scale_peak(result.ptr(), 0.8f, count);
+			INFO("Frames: ", count);
+			CHECK(_max_difference(result, expected) == 0.0f);
+			CHECK(peak.left == expected_peak.left);
+			CHECK(peak.right == expected_peak.right);
+		}
+
+		// NaNs don't become the peak, wherever they are
+		for (uint32_t nan_index = 0; nan_index < 4; nan_index++) {
+			LocalVector<AudioFrame> frames;
+			_fill_noise(frames, 4, nan_index);
+			frames[nan_index].left = NAN;
+			const AudioFrame peak = AudioMixKernels::scale_peak(frames.ptr(), 1.0f, frames.size());
+			INFO("NaN at frame: ", nan_index);
+			CHECK_FALSE(Math::is_nan(peak.left));
+			CHECK(peak.left <= 1.0f);
+		}
+	}
+
+	TEST_CASE("[Audio][AudioMixKernels] Fade outs match the per-frame code") {
+		for (uint32_t count : FRAME_COUNTS) {
+			LocalVector<AudioFrame> expected;
+			_fill_noise(expected, count, count);
+			LocalVector<AudioFrame> result = expected;
+			const float base = 1.0f - 1.0f / 64;
+			_fade_out_reference(expected.ptr(), count, base);
+			AudioMixKernels::fade_out(result.ptr(), count, base);
+			INFO("Frames: ", count);
+			// The vector paths step the coefficient by base squared, so rounding differs slightly
+			CHECK(_max_difference(result, expected) < 1e-5f);
+		}
+	}
+
+	TEST_CASE("[Audio][AudioMixKernels] Int32 conversion is bit exact with the per-frame code") {
+		// Strides of one, two and four stereo channel pairs
+		const uint32_t strides[] = { 2, 4, 8 };
+		for (uint32_t stride : strides) {
+			for (uint32_t count : FRAME_COUNTS) {
+				LocalVector<AudioFrame> src;
+				// Past 1 so clamping is covered
+				_fill_noise(src, count, count, 1.5f);
+				LocalVector<int32_t> expected;
+				expected.resize(count * stride);
+				// Samples of the other channels must be left alone
+				for (uint32_t i = 0; i < expected.size(); i++) {
+					expected[i] = 0x5A5A5A5A;
+				}
+				LocalVector<int32_t> result = expected;
+				_to_int32_reference(expected.ptr(), src.ptr(), count, stride);
+				AudioMixKernels::to_int32(result.ptr(), src.ptr(), count, stride);
+
+				bool same = true;
+				for (uint32_t i = 0; i < expected.size(); i++) {
+					same = same && result[i] == expected[i];
+				}
+				INFO("Frames: ", count, ", stride: ", stride);
+				CHECK(same);
+			}
+		}
+	}
+
+	// Skipped by default since it only reports timings, run it with `--test --no-skip`.
+	TEST_CASE("[Audio][AudioMixKernels][Benchmark] Benchmark against the per-frame code" * doctest::skip()) {
+		// A second of 512 frame mixes at 48 kHz, only reported as the timings depend on the machine
+		const uint32_t count = 512;
+		const uint32_t iterations = 94;
+		LocalVector<AudioFrame> src;
+		_fill_noise(src, count, 1);
+		LocalVector<AudioFrame> dst;
+		dst.resize(count);
+		LocalVector<int32_t> samples;
+		samples.resize(count * 2);
+		const AudioFrame vol_start(0.5f, 0.5f);
+		const AudioFrame vol_final(1.0f, 0.25f);
+
+		uint64_t reference_usec = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < iterations; i++) {
+			_ramp_reference<false>(dst.ptr(), src.ptr(), vol_start, vol_final, 0, count, count);
+			_scale_peak_reference(dst.ptr(), 0.9f, count);
+			_to_int32_reference(samples.ptr(), dst.ptr(), count, 2);
+		}
+		reference_usec = OS::get_singleton()->get_ticks_usec() - reference_usec;
+		const int32_t reference_sample = samples[count];
+
+		uint64_t kernel_usec = OS::get_singleton()->get_ticks_usec();
+		for (uint32_t i = 0; i < iterations; i++) {
+			AudioMixKernels::ramp<false>(dst.ptr(), src.ptr(), vol_start, vol_final, 0, count, count);
+			AudioMixKernels::scale_peak(dst.ptr(), 0.9f, count);
+			AudioMixKernels::to_int32(samples.ptr(), dst.ptr(), count, 2);
+		}
+		kernel_usec = OS::get_singleton()->get_ticks_usec() - kernel_usec;
+
+		MESSAGE("Mixing ", iterations, " buffers of ", count, " frames: per-frame code ", reference_usec, " usec, kernels ", kernel_usec, " usec.");
+		// Also keeps both loops from being optimized out
+		CHECK(Math::abs(samples[count] - reference_sample) <= 2048);
+	}
+}
+
+} // namespace TestAudioMixKernels
+
+#endif // TEST_AUDIO_MIX_KERNELS_H